@@ -15,7 +15,7 @@ cdef extern from "hermes1d.h":
     cdef cppclass Element:
         double x1, x2
         int p
-        int *dof
+        int **dof
         double get_solution_value(double x_phys, int comp)
         double get_solution_deriv(double x_phys, int comp)
         void get_coeffs(int sln, int comp, double coeffs[])
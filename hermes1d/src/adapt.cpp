@@ -312,31 +312,6 @@ void calc_proj_coeffs_L2(int n_eq, int fns_num, int pts_num,
   }
 }
 
-// allocate and fill projection matrix
-double** get_proj_matrix_H1(int n_eq, int fns_num, int pts_num,
-                            double pol_val[MAX_QUAD_PTS_NUM][MAX_P+1],
-                            double pol_der[MAX_QUAD_PTS_NUM][MAX_P+1],
-                            double phys_weights[MAX_QUAD_PTS_NUM]) 
-{ 
-  // allocate
-  double** matrix = new_matrix<double>(MAX_P+1, MAX_P+1);
-
-  // fill
-  for (int i=0; i<fns_num; i++) {
-    for (int j=0; j<fns_num; j++) {
-      matrix[i][j] = 0;
-      for(int k=0; k < pts_num; k++) { // loop over integration points
-        double val_i = pol_val[k][i];
-        double val_j = pol_val[k][j];
-        double der_i = pol_der[k][i];
-        double der_j = pol_der[k][j];
-        matrix[i][j] += (val_i*val_j + der_i*der_j) * phys_weights[k];
-      }
-    }
-  }
-  return matrix;
-}
-
 // allocate and fill right-hand side
 void fill_proj_rhs_H1(int fns_num, int pts_num,
                       double phys_u_ref[MAX_QUAD_PTS_NUM], 
@@ -356,11 +331,53 @@ void fill_proj_rhs_H1(int fns_num, int pts_num,
   }
 }
 
+// H1 stiffness matrix of the (L2 normalized) Legendre polynomials in the 
+// reference interval (-1, 1). Their mass matrix is the identity, and since
+// the map to any interval (a, b) is affine, the H1 projection matrix of 
+// the transformed Legendre polynomials in (a, b) is I + (2/(b-a))^2 * K, 
+// so it does not have to be integrated for every candidate in every element.
+static double legendre_stiff_ref[MAX_P+1][MAX_P+1];
+static int legendre_stiff_ref_done = 0;
+
+void precalculate_proj_matrix_H1_ref()
+{
+  if (legendre_stiff_ref_done) return;
+  // exact for the derivatives of polynomials of degree MAX_P
+  int order = 2*MAX_P;
+  int pts_num = g_quad_1d_std.get_num_points(order);
+  double2 *ref_tab = g_quad_1d_std.get_points(order);
+  for (int i=0; i < MAX_P+1; i++) {
+    for (int j=0; j < MAX_P+1; j++) {
+      legendre_stiff_ref[i][j] = 0;
+      for(int k=0; k < pts_num; k++) { // loop over integration points
+        legendre_stiff_ref[i][j] += legendre_der_ref_tab[order][k][i] * 
+          legendre_der_ref_tab[order][k][j] * ref_tab[k][1];
+      }
+    }
+  }
+  legendre_stiff_ref_done = 1;
+}
+
+// fill the H1 projection matrix of the first 'fns_num' transformed 
+// Legendre polynomials in an interval of length 'h'
+void get_proj_matrix_H1_ref(int fns_num, double h, double **matrix)
+{
+  precalculate_proj_matrix_H1_ref();
+  double scale = (2./h) * (2./h);
+  for (int i=0; i<fns_num; i++) {
+    for (int j=0; j<fns_num; j++) {
+      matrix[i][j] = scale * legendre_stiff_ref[i][j];
+    }
+    matrix[i][i] += 1;
+  }
+}
+
 // Calculate the projection coefficients for every 
 // transformed Legendre polynomial and every solution 
 // component. The basis are the transformed Legendre 
-// which are NOT orthonormal in H1 (norm == 1)
-void calc_proj_coeffs_H1(int n_eq, int fns_num, int pts_num,
+// which are NOT orthonormal in H1 (norm == 1), 'h' is 
+// the length of the interval of the polynomials.
+void calc_proj_coeffs_H1(int n_eq, int fns_num, int pts_num, double h,
                          double phys_u_ref[MAX_EQN_NUM][MAX_QUAD_PTS_NUM], 
                          double phys_dudx_ref[MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
                          double pol_val[MAX_QUAD_PTS_NUM][MAX_P+1],
@@ -368,20 +385,21 @@ void calc_proj_coeffs_H1(int n_eq, int fns_num, int pts_num,
                          double phys_weights[MAX_QUAD_PTS_NUM], 
                          double proj_coeffs[MAX_EQN_NUM][MAX_P+1])
 { 
-  // allocate and fill projection matrix
-  double** matrix = get_proj_matrix_H1(n_eq, fns_num, pts_num,
-                                       pol_val, pol_der, 
-                                       phys_weights); 
+  // projection matrix (scaled from the reference one)
+  double matrix_data[MAX_P+1][MAX_P+1];
+  double *matrix[MAX_P+1];
+  for (int i=0; i<fns_num; i++) matrix[i] = matrix_data[i];
+  get_proj_matrix_H1_ref(fns_num, h, matrix);
 
   // replace matrix with its LU decomposition
   // permutations caused by partial pivoting are 
   // recorded in the vector indx
-  int *indx = new int[MAX_P+1];
+  int indx[MAX_P+1];
   double d;
   ludcmp(matrix, fns_num, indx, &d);
 
-  // allocate projection rhs vector
-  double *rhs = new double[MAX_P+1];
+  // projection rhs vector
+  double rhs[MAX_P+1];
 
   for(int c=0; c<n_eq; c++) {          // loop over solution components 
     // fill projection rhs
@@ -396,12 +414,6 @@ void calc_proj_coeffs_H1(int n_eq, int fns_num, int pts_num,
     // copy sol[] to proj_coeffs[c]
     for(int m=0; m < fns_num; m++) proj_coeffs[c][m] = rhs[m];
   }
-
-  // FIXME: can this frequent creation and deletion 
-  // of this matrix be avoided?
-  delete [] matrix;
-  delete [] indx;
-  delete [] rhs;
 }
 
 // Assumes that reference solution is defined on two half-elements 'e_ref_left'
@@ -456,6 +468,7 @@ void check_cand_coarse_hp_fine_hp(int norm, Element *e, Element *e_ref_left,
                                      phys_weights_left, 
                                      proj_coeffs_left);
   else calc_proj_coeffs_H1(n_eq, fns_num_left, pts_num_left,
+                           e_ref_left->x2 - e_ref_left->x1,
                            phys_u_ref_left, 
                            phys_dudx_ref_left, 
                            leg_pol_val_left, 
@@ -538,6 +551,7 @@ void check_cand_coarse_hp_fine_hp(int norm, Element *e, Element *e_ref_left,
                                      phys_weights_right, 
                                      proj_coeffs_right);
   else calc_proj_coeffs_H1(n_eq, fns_num_right, pts_num_right,  
+                           e_ref_right->x2 - e_ref_right->x1,
                            phys_u_ref_right, 
                            phys_dudx_ref_right, 
                            leg_pol_val_right, 
@@ -732,6 +746,7 @@ void check_cand_coarse_hp_fine_p(int norm, Element *e, Element *e_ref,
                                      phys_weights_left, 
                                      proj_coeffs_left);
   else calc_proj_coeffs_H1(n_eq, fns_num_left, pts_num_left,  
+                           (e->x2 - e->x1)/2.,
                            phys_u_ref_left, 
                            phys_dudx_ref_left, 
                            leg_pol_val_left, 
@@ -812,6 +827,7 @@ void check_cand_coarse_hp_fine_p(int norm, Element *e, Element *e_ref,
                                      phys_weights_right, 
                                      proj_coeffs_right);
   else calc_proj_coeffs_H1(n_eq, fns_num_right, pts_num_right,
+                           (e->x2 - e->x1)/2.,
                            phys_u_ref_right, 
                            phys_dudx_ref_right, 
                            leg_pol_val_right, 
@@ -1044,25 +1060,13 @@ void check_cand_coarse_p_fine_hp(int norm, Element *e, Element *e_ref_left,
     }
   }
   else { 
-    // calculate first part of the projection matrix
-    double** matrix_left;  
-    matrix_left = get_proj_matrix_H1(n_eq, fns_num, pts_num_left,
-                                     leg_pol_val_left, leg_pol_der_left, 
-                                     phys_weights_left); 
-    // calculate second part of the projection matrix
-    double** matrix_right;  
-    matrix_right = get_proj_matrix_H1(n_eq, fns_num, pts_num_right,
-                                      leg_pol_val_right, leg_pol_der_right, 
-                                      phys_weights_right); 
-    // add the two matrices 
-    double ** matrix = new_matrix<double>(MAX_P+1, MAX_P+1);
-    for(int i=0; i < fns_num; i++) { 
-      for(int j=0; j < fns_num; j++) { 
-        matrix[i][j] = matrix_left[i][j] + matrix_right[i][j];
-      }
-    }
+    // projection matrix of the polynomials in 'e' (both halves)
+    double matrix_data[MAX_P+1][MAX_P+1];
+    double *matrix[MAX_P+1];
+    for (int i=0; i < fns_num; i++) matrix[i] = matrix_data[i];
+    get_proj_matrix_H1_ref(fns_num, e->x2 - e->x1, matrix);
     // perform LU factorization (result stored in matrix and indx)
-    int *indx = new int[MAX_P+1];
+    int indx[MAX_P+1];
     double d;
     ludcmp(matrix, fns_num, indx, &d);
 
@@ -1083,9 +1087,6 @@ void check_cand_coarse_p_fine_hp(int norm, Element *e, Element *e_ref_left,
       lubksb(matrix, fns_num, indx, rhs);
       for(int m=0; m < fns_num; m++) proj_coeffs[c][m] = rhs[m];
     }
-    delete [] matrix_left;
-    delete [] matrix_right;
-    delete [] matrix;
     delete [] rhs_left;
     delete [] rhs_right;
     delete [] rhs;
@@ -1313,6 +1314,7 @@ void check_cand_coarse_p_fine_p(int norm, Element *e, Element *e_ref,
                                      phys_weights, 
                                      proj_coeffs);
   else calc_proj_coeffs_H1(n_eq, fns_num, pts_num,
+                           e->x2 - e->x1,
                            phys_u_ref, 
                            phys_dudx_ref, 
                            leg_pol_val, 
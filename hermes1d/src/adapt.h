@@ -93,6 +93,10 @@ double HERMES_API calc_solution_norm(int norm, exact_sol_type exact_sol,
                            double A, double B, int subdivision, 
                            int order);
 
+// Precalculates the reference H1 projection matrix of Legendre polynomials
+// used by the candidate checkers (only the first call does the work). 
+void HERMES_API precalculate_proj_matrix_H1_ref();
+
 // Selects best hp-refinement from the given list (distinguishes whether 
 // the reference refinement on that element was p- or hp-refinement). 
 // Each refinement candidate is a triple of integers. First one means 
@@ -22,6 +22,11 @@ space(space), is_linear(is_linear)
 {
   if(space->get_n_eq() != wf->get_neq())
         error("WeakForm does not have as many equations as Space in DiscreteProblem::DiscreteProblem()");
+  precalculate_shapefn_tables();
+}
+
+void precalculate_shapefn_tables()
+{
   if (_precalculated == 0) {
     // precalculating values and derivatives 
     // of all polynomials at all possible 
@@ -39,129 +44,211 @@ space(space), is_linear(is_linear)
   }
 }
 
+// values and derivatives of Lobatto shape functions in the Gauss points 
+// of order 'order' in the reference element, stored function by function:
+// the values of the k-th function start at k * pts_num, its derivatives 
+// at (MAX_P + 1 + k) * pts_num. The table is built on the first request.
+double *DiscreteProblem::get_ref_shapefn_tab(int order)
+{
+  std::vector<double> &tab = ref_shapefn_tab[order];
+  if (tab.empty()) {
+    int pts_num = g_quad_1d_std.get_num_points(order);
+    tab.resize(2 * (MAX_P + 1) * pts_num);
+    for(int k=0; k < MAX_P + 1; k++) {
+      for(int i=0; i < pts_num; i++) {
+        tab[k * pts_num + i] = lobatto_val_ref_tab[order][i][k];
+        tab[(MAX_P + 1 + k) * pts_num + i] = lobatto_der_ref_tab[order][i][k];
+      }
+    }
+  }
+  return &tab[0];
+}
+
 // process volumetric weak forms
+// The values of all forms in an element are first computed into a 
+// local buffer (elements are processed in parallel when Hermes is 
+// built with OpenMP, so the weak forms must be thread-safe), then 
+// they are added to the matrix and the vector element by element.
 void DiscreteProblem::process_vol_forms(SparseMatrix *mat, Vector *rhs) {
   int n_eq = space->get_n_eq();
-  Element *elems = space->get_base_elems();
-  int n_elem = space->get_n_base_elem();
-  Iterator *I = new Iterator(space);
-
-  Element *e;
-  while ((e = I->next_active_element()) != NULL) {
-    //printf("Processing elem %d\n", m);
-    int    pts_num;                                     // num of quad points
-    double phys_pts[MAX_QUAD_PTS_NUM];                  // quad points
-    double phys_weights[MAX_QUAD_PTS_NUM];              // quad weights
-    double phys_u[MAX_QUAD_PTS_NUM];                    // basis function 
-    double phys_dudx[MAX_QUAD_PTS_NUM];                 // basis function x-derivative
-    double phys_v[MAX_QUAD_PTS_NUM];                    // test function
-    double phys_dvdx[MAX_QUAD_PTS_NUM];                 // test function x-derivative
-    if (n_eq > MAX_EQN_NUM) error("number of equations exceeded in process_vol_forms().");
-    // all previous solutions (all components)
-    double phys_u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM];     
-    // x-derivatives of all previous solutions (all components)
-    double phys_du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM];  
-    // decide quadrature order and set up 
-    // quadrature weights and points in element m
+  if (n_eq > MAX_EQN_NUM) error("number of equations exceeded in process_vol_forms().");
+  Element **elems = space->get_active_elems();
+  int n_elem = 0;
+  while (elems[n_elem] != NULL) n_elem++;
+
+  // matrix forms are needed also for the Dirichlet lift of linear problems
+  bool do_mat = (mat != NULL) || (this->is_linear && rhs != NULL);
+  bool do_vec = (rhs != NULL);
+  int n_mfv = this->wf->matrix_forms_vol.size();
+  int n_vfv = this->wf->vector_forms_vol.size();
+
+  // reference tables of elements and offsets of their values in 'local'
+  std::vector<double *> elem_tab(n_elem);
+  std::vector<size_t> offset(n_elem + 1);
+  offset[0] = 0;
+  for(int m=0; m < n_elem; m++) {
+    Element *e = elems[m];
+    // decide quadrature order
     // CAUTION: This is heuristic
     int order = 4*e->p;
+    elem_tab[m] = get_ref_shapefn_tab(order);
+    size_t size = 0;
+    for (int ww = 0; do_mat && ww < n_mfv; ww++) {
+      WeakForm::MatrixFormVol *mfv = &this->wf->matrix_forms_vol[ww];
+      if (e->marker == mfv->marker ||  mfv->marker == ANY) size += (e->p + 1) * (e->p + 1);
+    }
+    for (int ww = 0; do_vec && ww < n_vfv; ww++) {
+      WeakForm::VectorFormVol *vfv = &this->wf->vector_forms_vol[ww];
+      if (e->marker == vfv->marker ||  vfv->marker == ANY) size += e->p + 1;
+    }
+    offset[m + 1] = offset[m] + size;
+  }
+  std::vector<double> local(offset[n_elem]);
 
-    // prepare quadrature points and weights in element 'e'
-    create_phys_element_quadrature(e->x1, e->x2,  
-                               order, phys_pts, phys_weights, &pts_num); 
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    // all previous solutions (all components)
+    double (*phys_u_prev)[MAX_EQN_NUM][MAX_QUAD_PTS_NUM] = new double[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM];
+    // x-derivatives of all previous solutions (all components)
+    double (*phys_du_prevdx)[MAX_EQN_NUM][MAX_QUAD_PTS_NUM] = new double[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM];
+    // x-derivatives of all shape functions in the element
+    double *phys_der = new double[(MAX_P + 1) * MAX_QUAD_PTS_NUM];
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic, 64)
+#endif
+    for(int m=0; m < n_elem; m++) {
+      Element *e = elems[m];
+      int order = 4*e->p;
+      int pts_num;                                     // num of quad points
+      double phys_pts[MAX_QUAD_PTS_NUM];               // quad points
+      double phys_weights[MAX_QUAD_PTS_NUM];           // quad weights
+
+      // prepare quadrature points and weights in element 'e'
+      create_phys_element_quadrature(e->x1, e->x2,  
+                                 order, phys_pts, phys_weights, &pts_num); 
+
+      // transform shape functions to element 'e' (only the derivatives change)
+      double *ref_val = elem_tab[m];
+      double *ref_der = elem_tab[m] + (MAX_P + 1) * pts_num;
+      double jac = (e->x2 - e->x1)/2.;
+      for(int k=0; k < (e->p + 1) * pts_num; k++) phys_der[k] = ref_der[k] / jac;
+
+      // evaluate previous solution and its derivative 
+      // at all quadrature points in the element, 
+      // for every solution component
+      // 0... in the entire element
+      for(int sln=0; sln < e->n_sln; sln++) {
+        e->get_solution_quad(0, order, phys_u_prev[sln], phys_du_prevdx[sln], sln); 
+      }
 
-    // evaluate previous solution and its derivative 
-    // at all quadrature points in the element, 
-    // for every solution component
-    // 0... in the entire element
-    for(int sln=0; sln < e->n_sln; sln++) {
-      e->get_solution_quad(0, order, phys_u_prev[sln], phys_du_prevdx[sln], sln); 
-    }
+      double *val = &local[0] + offset[m];
 
-    // volumetric bilinear forms
-    for (unsigned int ww = 0; ww < this->wf->matrix_forms_vol.size(); ww++) {
-	    WeakForm::MatrixFormVol *mfv = &this->wf->matrix_forms_vol[ww];
-	    if (e->marker == mfv->marker ||  mfv->marker == ANY) {
-  	    int c_i = mfv->i;  
-	      int c_j = mfv->j;  
-
-	      // loop over test functions (rows)
-	      for(int i=0; i<e->p + 1; i++) {
-	        // if i-th test function is active
-	        int pos_i = e->dof[c_i][i]; // row in matrix
-          //printf("elem (%g, %g): pos_i = %d\n", e->x1, e->x2, pos_i);
-	        if(pos_i != -1) {
-	          // transform i-th test function to element 'm'
-            //printf("Elem (%g, %g): i = %d, order = %d\n", e->x1, e->x2, i, order);
-	          element_shapefn(e->x1, e->x2, i, order, phys_v, phys_dvdx); 
-	          // if we are constructing the matrix
-            // loop over basis functions (columns)
-            for(int j=0; j < e->p + 1; j++) {
-	            int pos_j = e->dof[c_j][j]; // matrix column
-              //printf("elem (%g, %g): pos_j = %d\n", e->x1, e->x2, pos_j);
-	            // if j-th basis function is active
-	              // transform j-th basis function to element 'm'
-              element_shapefn(e->x1, e->x2,  
-		          j, order, phys_u, phys_dudx); 
-              // evaluate the bilinear form
-              double val_ij = mfv->fn(pts_num, phys_pts,
-	            phys_weights, phys_u, phys_dudx, phys_v, phys_dvdx,
-              phys_u_prev, phys_du_prevdx, mfv->space); 
-              //truncating
-              if (fabs(val_ij) < 1e-12) val_ij = 0.0; 
-              // add the result to the matrix
-              if (val_ij != 0) {
-                if(pos_j != -1) {
-                  if(mat != NULL) {
-                    mat->add(pos_i, pos_j, val_ij);
-                    if (DEBUG_MATRIX) {
-                      info("Adding to matrix pos %d, %d value %g (comp %d, %d)", 
-                      pos_i, pos_j, val_ij, c_i, c_j);
-                    }
-                  }
-                }
-                else
-                  if(this->is_linear && rhs != NULL)
-                    rhs->add(pos_i, -val_ij * e->coeffs[c_j][c_j][j]);
-	      }
-            }
+      // volumetric bilinear forms
+      for (int ww = 0; do_mat && ww < n_mfv; ww++) {
+        WeakForm::MatrixFormVol *mfv = &this->wf->matrix_forms_vol[ww];
+        if (e->marker != mfv->marker &&  mfv->marker != ANY) continue;
+        int c_i = mfv->i;  
+        // loop over test functions (rows)
+        for(int i=0; i<e->p + 1; i++) {
+          // if i-th test function is active
+          if (e->dof[c_i][i] == -1) {
+            for(int j=0; j < e->p + 1; j++) *val++ = 0;
+            continue;
+          }
+          double *phys_v = ref_val + i * pts_num, *phys_dvdx = phys_der + i * pts_num;
+          // loop over basis functions (columns)
+          for(int j=0; j < e->p + 1; j++) {
+            // evaluate the bilinear form
+            double val_ij = mfv->fn(pts_num, phys_pts, phys_weights, 
+                                    ref_val + j * pts_num, phys_der + j * pts_num, 
+                                    phys_v, phys_dvdx,
+                                    phys_u_prev, phys_du_prevdx, mfv->space); 
+            //truncating
+            if (fabs(val_ij) < 1e-12) val_ij = 0.0; 
+            *val++ = val_ij;
           }
         }
       }
-    }
 
-    // volumetric part of residual
-    for (unsigned int ww = 0; ww < this->wf->vector_forms_vol.size(); ww++) {
-      WeakForm::VectorFormVol *vfv = &this->wf->vector_forms_vol[ww];
-      if (e->marker == vfv->marker ||  vfv->marker == ANY) {
+      // volumetric part of residual
+      for (int ww = 0; do_vec && ww < n_vfv; ww++) {
+        WeakForm::VectorFormVol *vfv = &this->wf->vector_forms_vol[ww];
+        if (e->marker != vfv->marker &&  vfv->marker != ANY) continue;
         int c_i = vfv->i;  
         // loop over test functions (rows)
         for(int i=0; i<e->p + 1; i++) {
           // if i-th test function is active
-          int pos_i = e->dof[c_i][i]; // row in residual vector
-          if(pos_i != -1) {
-            // transform i-th test function to element 'm'
-            element_shapefn(e->x1, e->x2,  
-		        i, order, phys_v, phys_dvdx); 
-            // contribute to residual vector
-            double val_i = vfv->fn(pts_num, phys_pts, phys_weights, 
-			         phys_u_prev, phys_du_prevdx, phys_v,
-               phys_dvdx, vfv->space);
-            // truncating
-            if(fabs(val_i) < 1e-12) val_i = 0.0; 
-            // add the contribution to the residual vector
-            if (val_i != 0 && rhs != NULL) rhs->add(pos_i, val_i);
-            if (DEBUG_MATRIX)
-	            if (val_i != 0) {
-	              info("Adding to residual pos %d value %g (comp %d)", 
-                    pos_i, val_i, c_i);
-                }
+          if (e->dof[c_i][i] == -1) {
+            *val++ = 0;
+            continue;
           }
+          // contribute to residual vector
+          double val_i = vfv->fn(pts_num, phys_pts, phys_weights, 
+                                 phys_u_prev, phys_du_prevdx, 
+                                 ref_val + i * pts_num, phys_der + i * pts_num, 
+                                 vfv->space);
+          // truncating
+          if(fabs(val_i) < 1e-12) val_i = 0.0; 
+          *val++ = val_i;
         }
       }
     }
-  } // end while
-  delete I;
+
+    delete [] phys_u_prev;
+    delete [] phys_du_prevdx;
+    delete [] phys_der;
+  }
+
+  // add the results to the matrix and the vector
+  for(int m=0; m < n_elem; m++) {
+    Element *e = elems[m];
+    double *val = &local[0] + offset[m];
+    for (int ww = 0; do_mat && ww < n_mfv; ww++) {
+      WeakForm::MatrixFormVol *mfv = &this->wf->matrix_forms_vol[ww];
+      if (e->marker != mfv->marker &&  mfv->marker != ANY) continue;
+      int c_i = mfv->i;  
+      int c_j = mfv->j;  
+      for(int i=0; i<e->p + 1; i++) {
+        int pos_i = e->dof[c_i][i]; // row in matrix
+        for(int j=0; j < e->p + 1; j++) {
+          double val_ij = *val++;
+          if (pos_i == -1 || val_ij == 0) continue;
+          int pos_j = e->dof[c_j][j]; // matrix column
+          if(pos_j != -1) {
+            if(mat != NULL) {
+              mat->add(pos_i, pos_j, val_ij);
+              if (DEBUG_MATRIX) {
+                info("Adding to matrix pos %d, %d value %g (comp %d, %d)", 
+                pos_i, pos_j, val_ij, c_i, c_j);
+              }
+            }
+          }
+          else
+            if(this->is_linear && rhs != NULL)
+              rhs->add(pos_i, -val_ij * e->coeffs[0][c_j][j]);
+        }
+      }
+    }
+    for (int ww = 0; do_vec && ww < n_vfv; ww++) {
+      WeakForm::VectorFormVol *vfv = &this->wf->vector_forms_vol[ww];
+      if (e->marker != vfv->marker &&  vfv->marker != ANY) continue;
+      int c_i = vfv->i;  
+      for(int i=0; i<e->p + 1; i++) {
+        int pos_i = e->dof[c_i][i]; // row in residual vector
+        double val_i = *val++;
+        // add the contribution to the residual vector
+        if (pos_i == -1 || val_i == 0) continue;
+        rhs->add(pos_i, val_i);
+        if (DEBUG_MATRIX) {
+          info("Adding to residual pos %d value %g (comp %d)", 
+               pos_i, val_i, c_i);
+        }
+      }
+    }
+  }
 }
 
 // process boundary weak forms
@@ -291,9 +378,20 @@ void DiscreteProblem::assemble(scalar *coeff_vec, SparseMatrix *mat, Vector *rhs
   {
     mat->free();
     mat->prealloc(ndof);
-    for(int i = 0; i < ndof; i++)
-      for(int j = 0; j< ndof; j++)
-        mat->pre_add_ij(i, j);
+    // weak forms only couple basis functions of the same element, 
+    // so the matrix is block tridiagonal (up to the dof numbering)
+    Iterator I(space);
+    Element *e;
+    int dofs[MAX_EQN_NUM * (MAX_P + 1)];
+    while ((e = I.next_active_element()) != NULL) {
+      int n = 0;
+      for(int c = 0; c < n_eq; c++)
+        for(int j = 0; j < e->p + 1; j++)
+          if (e->dof[c][j] >= 0) dofs[n++] = e->dof[c][j];
+      for(int i = 0; i < n; i++)
+        for(int j = 0; j < n; j++)
+          mat->pre_add_ij(dofs[i], dofs[j]);
+    }
     mat->alloc();
     // Zero the matrix, which should be done by the appropriate implementation anyway.
     mat->zero();
@@ -7,6 +7,7 @@
 #define _DISCRETE_H_
 
 #include <vector>
+#include <map>
 
 #include "space.h"
 #include "quad_std.h"
@@ -44,8 +45,16 @@ private:
   WeakForm* wf;
   Space* space;
   bool is_linear;
+
+  // reference tables of shape functions for quadrature orders
+  std::map<int, std::vector<double> > ref_shapefn_tab;
+  double *get_ref_shapefn_tab(int order);
 };
 
+// precalculates values of Legendre polynomials and Lobatto shape 
+// functions in quadrature points (only the first call does the work)
+void HERMES_API precalculate_shapefn_tables();
+
 // return coefficients for all shape functions on the element m,
 // for all solution components
 void calculate_elem_coeffs(Element *e, double **coeffs, int n_eq);
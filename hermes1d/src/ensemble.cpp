@@ -0,0 +1,415 @@
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Distributed under the terms of the BSD license (see the LICENSE
+// file for the exact terms).
+// Email: hermes1d@googlegroups.com, home page: http://hpfem.org/
+
+#include "ensemble.h"
+#include "discrete_problem.h"
+#include "iterator.h"
+#include "quad_std.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "../../hermes_common/error.h"
+#include "../../hermes_common/solver/solver.h"
+
+Ensemble::Ensemble(WeakForm* wf, Space* space, int n_members, void **member_data,
+                   bool is_linear) : wf(wf), space(space), is_linear(is_linear),
+                   n_members(n_members), member_data(member_data)
+{
+  if(space->get_n_eq() != wf->get_neq())
+    error("WeakForm does not have as many equations as Space in Ensemble::Ensemble().");
+  if(n_members <= 0) error("Empty ensemble in Ensemble::Ensemble().");
+  precalculate_shapefn_tables();
+
+  this->n_eq = space->get_n_eq();
+  this->ndof = Space::get_num_dofs(space);
+  this->batch_size = 16;
+
+  // all members start from the solution in the space
+  this->coeffs = new double[(size_t) n_members * ndof];
+  this->converged = new int[n_members];
+  this->iters = new int[n_members];
+  this->residual = new double[n_members];
+  if (coeffs == NULL || converged == NULL || iters == NULL || residual == NULL)
+    error("Not enough memory in Ensemble::Ensemble().");
+  ::get_coeff_vector(space, coeffs);
+  for(int m=1; m < n_members; m++)
+    memcpy(coeffs + (size_t) m * ndof, coeffs, ndof * sizeof(double));
+  for(int m=0; m < n_members; m++) {
+    converged[m] = 0;
+    iters[m] = 0;
+    residual[m] = 0;
+  }
+
+  this->init_tables();
+}
+
+Ensemble::~Ensemble()
+{
+  delete [] coeffs;
+  delete [] converged;
+  delete [] iters;
+  delete [] residual;
+}
+
+void Ensemble::set_batch_size(int batch_size)
+{
+  if (batch_size < 1) error("Invalid batch size in Ensemble::set_batch_size().");
+  this->batch_size = batch_size;
+}
+
+void Ensemble::set_coeff_vector(int m, double *coeff_vec)
+{
+  memcpy(get_coeff_vector(m), coeff_vec, ndof * sizeof(double));
+}
+
+void Ensemble::copy_to_space(int m)
+{
+  ::set_coeff_vector(get_coeff_vector(m), space);
+}
+
+// Quadrature points and weights and values of all shape functions
+// in every element, the same quadrature as in DiscreteProblem is used.
+void Ensemble::init_tables()
+{
+  Iterator I(space);
+  Element *e;
+  size_t size = 0;
+  while ((e = I.next_active_element()) != NULL) {
+    ElemTab t;
+    t.e = e;
+    t.order = 4*e->p;    // CAUTION - the same heuristic as in DiscreteProblem
+    t.pts_num = g_quad_1d_std.get_num_points(t.order);
+    elem_tabs.push_back(t);
+    size += (2 + 2*(e->p + 1)) * t.pts_num;
+  }
+
+  // all tables are in one array, pointers are set once it is allocated
+  tab_data.resize(size);
+  double *p = tab_data.empty() ? NULL : &tab_data[0];
+  for (unsigned int k = 0; k < elem_tabs.size(); k++) {
+    ElemTab &t = elem_tabs[k];
+    int np = t.pts_num;
+    t.pts = p;      p += np;
+    t.weights = p;  p += np;
+    t.val = p;      p += (t.e->p + 1) * np;
+    t.der = p;      p += (t.e->p + 1) * np;
+    create_phys_element_quadrature(t.e->x1, t.e->x2, t.order, t.pts, t.weights, &np);
+    for(int j=0; j < t.e->p + 1; j++)
+      element_shapefn(t.e->x1, t.e->x2, j, t.order, t.val + j * np, t.der + j * np);
+  }
+}
+
+// weak forms only couple basis functions of the same element
+void Ensemble::create_sparse_structure(SparseMatrix *mat)
+{
+  mat->prealloc(ndof);
+  int dofs[MAX_EQN_NUM * (MAX_P + 1)];
+  for (unsigned int k = 0; k < elem_tabs.size(); k++) {
+    Element *e = elem_tabs[k].e;
+    int n = 0;
+    for(int c = 0; c < n_eq; c++)
+      for(int j = 0; j < e->p + 1; j++)
+        if (e->dof[c][j] >= 0) dofs[n++] = e->dof[c][j];
+    for(int i = 0; i < n; i++)
+      for(int j = 0; j < n; j++)
+        mat->pre_add_ij(dofs[i], dofs[j]);
+  }
+  mat->alloc();
+}
+
+// Assembles the Jacobi matrices and residual vectors of n members (the
+// same as DiscreteProblem::assemble() does for one). Every element is
+// visited once: the solutions of all members of the batch are evaluated
+// in it together (every row of the shared tables is used for all members
+// while it is in cache) and then the weak forms are evaluated per member.
+void Ensemble::assemble_batch(int n, int *members, SparseMatrix **mat, Vector **rhs)
+{
+  // all previous solutions (all components)
+  double phys_u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM];
+  // x-derivatives of all previous solutions (all components)
+  double phys_du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM];
+  // coefficients of all members in the element, [c][j][k]
+  std::vector<double> batch_coeffs(n_eq * (MAX_P + 1) * n);
+  // solutions of all members and their derivatives, [k][c][q]
+  std::vector<double> batch_u(n * n_eq * MAX_QUAD_PTS_NUM);
+  std::vector<double> batch_dudx(n * n_eq * MAX_QUAD_PTS_NUM);
+
+  for(int k=0; k < n; k++) {
+    mat[k]->zero();
+    rhs[k]->zero();
+  }
+
+  for (unsigned int t = 0; t < elem_tabs.size(); t++) {
+    ElemTab *tab = &elem_tabs[t];
+    Element *e = tab->e;
+    int np = tab->pts_num;
+
+    // further solutions are shared by all members
+    for(int sln=1; sln < e->n_sln; sln++)
+      e->get_solution_quad(0, tab->order, phys_u_prev[sln], phys_du_prevdx[sln], sln);
+
+    // solutions of the members (Dirichlet lift is stored in the element)
+    for(int c=0; c < n_eq; c++) {
+      for(int j=0; j < e->p + 1; j++) {
+        double *a = &batch_coeffs[(c * (MAX_P + 1) + j) * n];
+        for(int k=0; k < n; k++)
+          a[k] = (e->dof[c][j] >= 0) ? get_coeff_vector(members[k])[e->dof[c][j]]
+                                     : e->coeffs[0][c][j];
+      }
+      for(int k=0; k < n; k++) {
+        double *u = &batch_u[(k * n_eq + c) * MAX_QUAD_PTS_NUM];
+        double *dudx = &batch_dudx[(k * n_eq + c) * MAX_QUAD_PTS_NUM];
+        for(int q=0; q < np; q++) u[q] = dudx[q] = 0;
+      }
+      for(int j=0; j < e->p + 1; j++) {
+        double *a = &batch_coeffs[(c * (MAX_P + 1) + j) * n];
+        double *val = tab->val + j * np, *der = tab->der + j * np;
+        for(int k=0; k < n; k++) {
+          double *u = &batch_u[(k * n_eq + c) * MAX_QUAD_PTS_NUM];
+          double *dudx = &batch_dudx[(k * n_eq + c) * MAX_QUAD_PTS_NUM];
+          for(int q=0; q < np; q++) {
+            u[q] += a[k] * val[q];
+            dudx[q] += a[k] * der[q];
+          }
+        }
+      }
+    }
+
+    for(int k=0; k < n; k++) {
+      void *user_data = (member_data != NULL) ? member_data[members[k]] : NULL;
+      for(int c=0; c < n_eq; c++) {
+        memcpy(phys_u_prev[0][c], &batch_u[(k * n_eq + c) * MAX_QUAD_PTS_NUM], np * sizeof(double));
+        memcpy(phys_du_prevdx[0][c], &batch_dudx[(k * n_eq + c) * MAX_QUAD_PTS_NUM], np * sizeof(double));
+      }
+
+      // volumetric bilinear forms
+      for (unsigned int ww = 0; ww < wf->matrix_forms_vol.size(); ww++) {
+        WeakForm::MatrixFormVol *mfv = &wf->matrix_forms_vol[ww];
+        if (e->marker != mfv->marker && mfv->marker != ANY) continue;
+        int c_i = mfv->i;
+        int c_j = mfv->j;
+        void *data = (member_data != NULL) ? user_data : mfv->space;
+        for(int i=0; i < e->p + 1; i++) {
+          int pos_i = e->dof[c_i][i];
+          if(pos_i == -1) continue;
+          for(int j=0; j < e->p + 1; j++) {
+            int pos_j = e->dof[c_j][j];
+            double val_ij = mfv->fn(np, tab->pts, tab->weights,
+                                    tab->val + j * np, tab->der + j * np,
+                                    tab->val + i * np, tab->der + i * np,
+                                    phys_u_prev, phys_du_prevdx, data);
+            // truncating
+            if (fabs(val_ij) < 1e-12) val_ij = 0.0;
+            if (val_ij == 0) continue;
+            if (pos_j != -1) mat[k]->add(pos_i, pos_j, val_ij);
+            else if (is_linear) rhs[k]->add(pos_i, -val_ij * e->coeffs[0][c_j][j]);
+          }
+        }
+      }
+
+      // volumetric part of residual
+      for (unsigned int ww = 0; ww < wf->vector_forms_vol.size(); ww++) {
+        WeakForm::VectorFormVol *vfv = &wf->vector_forms_vol[ww];
+        if (e->marker != vfv->marker && vfv->marker != ANY) continue;
+        int c_i = vfv->i;
+        void *data = (member_data != NULL) ? user_data : vfv->space;
+        for(int i=0; i < e->p + 1; i++) {
+          int pos_i = e->dof[c_i][i];
+          if(pos_i == -1) continue;
+          double val_i = vfv->fn(np, tab->pts, tab->weights,
+                                 phys_u_prev, phys_du_prevdx,
+                                 tab->val + i * np, tab->der + i * np, data);
+          // truncating
+          if(fabs(val_i) < 1e-12) val_i = 0.0;
+          if (val_i != 0) rhs[k]->add(pos_i, val_i);
+        }
+      }
+    }
+  }
+
+  // surface forms at both end points
+  if (wf->matrix_forms_surf.empty() && wf->vector_forms_surf.empty()) return;
+  for (int bdy = 0; bdy < 2; bdy++) {
+    int bdy_index = (bdy == 0) ? BOUNDARY_LEFT : BOUNDARY_RIGHT;
+    Element *e = (bdy == 0) ? elem_tabs.front().e : elem_tabs.back().e;
+    double x_ref = (bdy == 0) ? -1 : 1;
+    double x_phys = (bdy == 0) ? space->get_left_endpoint() : space->get_right_endpoint();
+    double phys_v[MAX_P + 1], phys_dvdx[MAX_P + 1];
+    for(int j=0; j < e->p + 1; j++)
+      element_shapefn_point(x_ref, e->x1, e->x2, j, phys_v[j], phys_dvdx[j]);
+
+    // solution at the end point
+    double pt_u_prev[MAX_SLN_NUM][MAX_EQN_NUM], pt_du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM];
+    for(int sln=1; sln < e->n_sln; sln++)
+      e->get_solution_point(x_phys, pt_u_prev[sln], pt_du_prevdx[sln], sln);
+
+    for(int k=0; k < n; k++) {
+      double *y = get_coeff_vector(members[k]);
+      for(int c=0; c < n_eq; c++) {
+        pt_u_prev[0][c] = pt_du_prevdx[0][c] = 0;
+        for(int j=0; j < e->p + 1; j++) {
+          double a = (e->dof[c][j] >= 0) ? y[e->dof[c][j]] : e->coeffs[0][c][j];
+          pt_u_prev[0][c] += a * phys_v[j];
+          pt_du_prevdx[0][c] += a * phys_dvdx[j];
+        }
+      }
+      void *data = (member_data != NULL) ? member_data[members[k]] : NULL;
+
+      // surface bilinear forms
+      for (unsigned int ww = 0; ww < wf->matrix_forms_surf.size(); ww++) {
+        WeakForm::MatrixFormSurf *mfs = &wf->matrix_forms_surf[ww];
+        if (mfs->bdy_index != bdy_index) continue;
+        int c_i = mfs->i;
+        int c_j = mfs->j;
+        for(int i=0; i < e->p + 1; i++) {
+          int pos_i = e->dof[c_i][i];
+          if(pos_i == -1) continue;
+          for(int j=0; j < e->p + 1; j++) {
+            int pos_j = e->dof[c_j][j];
+            double val_ij_surf = mfs->fn(x_phys, phys_v[j], phys_dvdx[j], phys_v[i],
+                                         phys_dvdx[i], pt_u_prev, pt_du_prevdx, data);
+            // truncating
+            if(fabs(val_ij_surf) < 1e-12) val_ij_surf = 0.0;
+            if (val_ij_surf == 0) continue;
+            if (pos_j != -1) mat[k]->add(pos_i, pos_j, val_ij_surf);
+            else if (is_linear) rhs[k]->add(pos_i, -val_ij_surf);
+          }
+        }
+      }
+
+      // surface part of residual
+      for (unsigned int ww = 0; ww < wf->vector_forms_surf.size(); ww++) {
+        WeakForm::VectorFormSurf *vfs = &wf->vector_forms_surf[ww];
+        if (vfs->bdy_index != bdy_index) continue;
+        int c_i = vfs->i;
+        for(int i=0; i < e->p + 1; i++) {
+          int pos_i = e->dof[c_i][i];
+          if(pos_i == -1) continue;
+          double val_i_surf = vfs->fn(x_phys, pt_u_prev, pt_du_prevdx, phys_v[i],
+                                      phys_dvdx[i], data);
+          // truncating
+          if(fabs(val_i_surf) < 1e-12) val_i_surf = 0.0;
+          if (val_i_surf != 0) rhs[k]->add(pos_i, val_i_surf);
+        }
+      }
+    }
+  }
+}
+
+// Newton's method for members first, ..., first + n - 1, in lockstep,
+// mat[k], rhs[k] and solver[k] are used for the k-th member of the batch.
+// A member leaves the batch when it converges or fails.
+void Ensemble::solve_batch(int first, int n, double newton_tol, int newton_max_iter,
+                           SparseMatrix **mat, Vector **rhs, Solver **solver)
+{
+  // active members and their matrices
+  int *members = new int[n];
+  int *slots = new int[n];
+  SparseMatrix **act_mat = new SparseMatrix*[n];
+  Vector **act_rhs = new Vector*[n];
+  int n_active = n;
+  for(int k=0; k < n; k++) {
+    members[k] = first + k;
+    slots[k] = k;
+  }
+
+  for (int it = 1; n_active > 0; it++) {
+    for(int k=0; k < n_active; k++) {
+      act_mat[k] = mat[slots[k]];
+      act_rhs[k] = rhs[slots[k]];
+    }
+    assemble_batch(n_active, members, act_mat, act_rhs);
+
+    int n_left = 0;
+    for(int k=0; k < n_active; k++) {
+      int m = members[k];
+      Vector *r = act_rhs[k];
+      iters[m] = it;
+      residual[m] = get_l2_norm(r);
+
+      // NOTE: at least one full iteration forced
+      // (as in the Newton's loops of examples)
+      if (residual[m] < newton_tol && it > 1) {
+        converged[m] = 1;
+        continue;
+      }
+
+      // Multiply the residual vector with -1 since the matrix
+      // equation reads J(Y^n) \deltaY^{n+1} = -F(Y^n).
+      r->change_sign();
+      if (!solver[slots[k]]->solve()) {
+        warning("Matrix solver failed for ensemble member %d.", m);
+        continue;
+      }
+      double *y = get_coeff_vector(m);
+      scalar *sln = solver[slots[k]]->get_solution();
+      for (int i = 0; i < ndof; i++) y[i] += sln[i];
+
+      if (it >= newton_max_iter) continue;
+      members[n_left] = m;
+      slots[n_left] = slots[k];
+      n_left++;
+    }
+    n_active = n_left;
+  }
+
+  delete [] members;
+  delete [] slots;
+  delete [] act_mat;
+  delete [] act_rhs;
+}
+
+int Ensemble::solve_newton(double newton_tol, int newton_max_iter,
+                           MatrixSolverType matrix_solver)
+{
+  for(int m=0; m < n_members; m++) {
+    converged[m] = 0;
+    iters[m] = 0;
+  }
+
+  int n_batches = (n_members + batch_size - 1) / batch_size;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    // matrices and solvers of one batch (the sparse structure is 
+    // the same for all members, so they are set up only once)
+    int n = std::min(batch_size, n_members);
+    SparseMatrix **mat = new SparseMatrix*[n];
+    Vector **rhs = new Vector*[n];
+    Solver **solver = new Solver*[n];
+    for(int k=0; k < n; k++) {
+      mat[k] = create_matrix(matrix_solver);
+      rhs[k] = create_vector(matrix_solver);
+      solver[k] = create_linear_solver(matrix_solver, mat[k], rhs[k]);
+      create_sparse_structure(mat[k]);
+      rhs[k]->alloc(ndof);
+    }
+
+#ifdef _OPENMP
+#pragma omp for schedule(dynamic)
+#endif
+    for (int b = 0; b < n_batches; b++) {
+      int first = b * batch_size;
+      solve_batch(first, std::min(batch_size, n_members - first), newton_tol, 
+                  newton_max_iter, mat, rhs, solver);
+    }
+
+    for(int k=0; k < n; k++) {
+      delete solver[k];
+      delete mat[k];
+      delete rhs[k];
+    }
+    delete [] mat;
+    delete [] rhs;
+    delete [] solver;
+  }
+
+  int n_converged = 0;
+  for(int m=0; m < n_members; m++)
+    if (converged[m]) n_converged++;
+  return n_converged;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Distributed under the terms of the BSD license (see the LICENSE
+// file for the exact terms).
+// Email: hermes1d@googlegroups.com, home page: http://hpfem.org/
+
+#ifndef _ENSEMBLE_H_
+#define _ENSEMBLE_H_
+
+#include <vector>
+
+#include "space.h"
+#include "weakform.h"
+#include "../../hermes_common/matrix.h"
+#include "../../hermes_common/common.h"
+
+class Element;
+class Solver;
+
+// Ensemble of problems that share the space and the weak form, and
+// differ only in parameters of the weak forms (members). For example
+// the same ODE/BVP for many values of a coefficient.
+//
+// Quadrature points and values of shape functions are computed once
+// for every element of the space and used for all members. Members are
+// solved in batches of set_batch_size() members: the batch is assembled
+// element by element (every element is visited once for all members in
+// the batch), and the Newton's method runs in lockstep for members of
+// the batch until each of them converges. Batches are solved in
+// parallel when Hermes is built with OpenMP (the weak forms must then
+// be thread-safe).
+//
+// The weak forms get member_data[m] as user_data when assembling the
+// member m (when member_data is NULL, they get the same as with
+// DiscreteProblem). Only the first solution (sln = 0) is per member,
+// further solutions (e.g., from previous time steps) are taken from
+// the elements of the space and are the same for all members.
+//
+// NOTE: The space must not be refined during the life of the ensemble.
+class HERMES_API Ensemble {
+public:
+  // All members start from the solution stored in the elements of 'space'.
+  Ensemble(WeakForm* wf, Space* space, int n_members, void **member_data = NULL,
+           bool is_linear = false);
+  ~Ensemble();
+
+  // Newton's method for all members. Returns the number of members
+  // that converged, see is_converged() for the status of a member.
+  int solve_newton(double newton_tol, int newton_max_iter,
+                   MatrixSolverType matrix_solver = SOLVER_BANDED);
+
+  void set_batch_size(int batch_size);
+
+  int get_n_members() { return n_members; }
+  int get_num_dofs() { return ndof; }
+
+  // Coefficient vector of the member (length get_num_dofs()),
+  // it can be changed to set the initial guess.
+  double *get_coeff_vector(int m) { return coeffs + (size_t) m * ndof; }
+  void set_coeff_vector(int m, double *coeff_vec);
+
+  // Status of the member after solve_newton().
+  bool is_converged(int m) { return converged[m] != 0; }
+  int get_num_iters(int m) { return iters[m]; }
+  double get_residual_norm(int m) { return residual[m]; }
+
+  // Copies the solution of the member into the elements
+  // of the space (e.g., for Linearizer).
+  void copy_to_space(int m);
+
+protected:
+  WeakForm* wf;
+  Space* space;
+  bool is_linear;
+  int n_eq, ndof;
+  int n_members;
+  void **member_data;
+  int batch_size;
+
+  double *coeffs;     // coefficient vectors of all members
+  int *converged;
+  int *iters;
+  double *residual;
+
+  // Quadrature and shape functions in elements (shared by all members).
+  struct ElemTab {
+    Element *e;
+    int order, pts_num;
+    double *pts, *weights;  // [pts_num]
+    double *val, *der;      // [(p+1) * pts_num], values of the j-th shape function start at j * pts_num
+  };
+  std::vector<ElemTab> elem_tabs;
+  std::vector<double> tab_data;
+
+  void init_tables();
+  void create_sparse_structure(SparseMatrix *mat);
+  void assemble_batch(int n, int *members, SparseMatrix **mat, Vector **rhs);
+  void solve_batch(int first, int n, double newton_tol, int newton_max_iter,
+                   SparseMatrix **mat, Vector **rhs, Solver **solver);
+};
+
+#endif
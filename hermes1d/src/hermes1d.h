@@ -16,10 +16,13 @@
 #include "../../hermes_common/common.h"
 #include "space.h"
 #include "../../hermes_common/matrix.h"
+#include "../../hermes_common/solver/banded.h"
+#include "../../hermes_common/solver/mixed_precision.h"
 #include "quad_std.h"
 #include "legendre.h"
 #include "lobatto.h"
 #include "discrete_problem.h"
+#include "ensemble.h"
 #include "solution.h"
 #include "linearizer.h"
 #include "transforms.h"
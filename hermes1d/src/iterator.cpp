@@ -6,9 +6,7 @@
 #include "iterator.h"
 
 void Iterator::reset() {
-  current_coarse_elem_index = -1;
-  // clear the stack
-  while(!S.empty()) S.pop();
+  current_elem_index = -1;
 }
 
 Element* Iterator::first_active_element()
@@ -18,40 +16,17 @@ Element* Iterator::first_active_element()
 
 Element* Iterator::next_active_element()
 {
-  // Find the first element that has not been visited.
-  Element *e;
-  // Either it is the first coarse mesh element
-  if(current_coarse_elem_index == -1) { 
-    e = this->space->get_base_elems();
-    current_coarse_elem_index = 0; 
-  }
-  // or we take it from the stack
-  else {
-    if(S.empty()) {
-      // there is no new element to visit
-      if(current_coarse_elem_index == this->space->get_n_base_elem()-1) { 
-        return NULL;
-      }
-      // we take the next coarse mesh element
-      else { 
-        e = this->space->get_base_elems() + current_coarse_elem_index +1;
-        current_coarse_elem_index++; 
-      }
-    }
-    // if stack is not empty
-    else {
-      e = S.top();   // take the top element
-      S.pop();       // remove it from stack
-    }
-  }
-  // if this element is active, return it
-  if(e->is_active()) return e;
-
-  // descending to first active element
-  while(!e->is_active()) {
-    S.push(e->sons[1]);
-    e = e->sons[0];
+  // take the NULL-terminated list of active elements from the space
+  if(current_elem_index == -1) {
+    Element **e = this->space->get_active_elems();
+    int n = 0;
+    while (e[n] != NULL) n++;
+    elems.assign(e, e + n + 1);
+    current_elem_index = 0;
   }
+  // stay at the terminating NULL once all elements were visited
+  Element *e = elems[current_elem_index];
+  if(e != NULL) current_elem_index++;
   return e;
 }
 
@@ -59,7 +34,3 @@ Element* Iterator::last_active_element()
 {
   return this->space->last_active_element();
 }
-
-
-
-
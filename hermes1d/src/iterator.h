@@ -6,25 +6,29 @@
 #ifndef _ITERATOR_H_
 #define _ITERATOR_H_
 
-#include <stack>
+#include <vector>
 #include "hermes1d.h"
 
 class Space;
 class Element;
+// Visits active elements of a space from left to right. The list of 
+// active elements is taken from the space by the first call to 
+// next_active_element() after reset(), so elements may be refined 
+// during the traversal (their sons are not visited).
 class HERMES_API Iterator {
 public:
   Iterator(Space *space) 
   {
     this->space = space;
-    current_coarse_elem_index = -1;
+    current_elem_index = -1;
   }
   Space *space;
-  std::stack <Element*>S;  
+  std::vector<Element*> elems;
   void reset();
   Element *first_active_element();
   Element *next_active_element();
   Element *last_active_element();
-  int current_coarse_elem_index;
+  int current_elem_index;
 };
 
 #endif
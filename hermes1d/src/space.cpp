@@ -3,6 +3,7 @@
 // file for the exact terms).
 // Email: hermes1d@googlegroups.com, home page: http://hpfem.org/
 
+#include <map>
 #include "space.h"
 #include "iterator.h"
 #include "adapt.h"
@@ -13,18 +14,87 @@
 // debug - prints element dof arrays in assign_dofs()
 int DEBUG_ELEM_DOF = 0;
 
+unsigned Element::tree_version = 0;
+
+// Memory pool for elements and their dof and coeffs blocks. Blocks 
+// are carved one after another from large chunks, so that elements 
+// created together (in a Space constructor, by refinement or by 
+// replication) lie next to each other in memory. Released blocks go 
+// to a free list for their size and are reused by the next request 
+// of that size. Chunks are never returned, the pool lives until the 
+// end of the program (elements of static spaces may be destroyed 
+// after any static pool object would have been). Like tree_version, 
+// the pool is only used from serial code.
+class ElementPool {
+public:
+  ElementPool() : next(NULL), left(0) {}
+  void *alloc(size_t size);
+  void release(void *block, size_t size);
+
+private:
+  static const size_t CHUNK_SIZE = 1 << 20;
+  static size_t round_up(size_t size) 
+  {
+    size = (size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+    return size < sizeof(void *) ? sizeof(void *) : size;
+  }
+  char *next;                              // free part of the last chunk
+  size_t left;                             // its size
+  std::map<size_t, void *> free_blocks;    // heads of the free lists
+};
+
+void *ElementPool::alloc(size_t size)
+{
+  size = round_up(size);
+  std::map<size_t, void *>::iterator it = this->free_blocks.find(size);
+  if (it != this->free_blocks.end() && it->second != NULL) {
+    void *block = it->second;
+    it->second = *(void **) block;
+    return block;
+  }
+  if (size > this->left) {
+    // the rest of the chunk is dropped, blocks larger than 
+    // a chunk get a chunk of their own
+    size_t chunk_size = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+    this->next = new char[chunk_size];
+    if (this->next == NULL) error("Not enough memory in ElementPool::alloc().");
+    this->left = chunk_size;
+  }
+  void *block = this->next;
+  this->next += size;
+  this->left -= size;
+  return block;
+}
+
+void ElementPool::release(void *block, size_t size)
+{
+  if (block == NULL) return;
+  void *&head = this->free_blocks[round_up(size)];
+  *(void **) block = head;
+  head = block;
+}
+
+static ElementPool *element_pool = new ElementPool();
+
+void *Element::operator new(size_t size)
+{
+  return element_pool->alloc(size);
+}
+
+void Element::operator delete(void *e, size_t size)
+{
+  element_pool->release(e, size);
+}
+
 Element::Element() 
 {
   x1 = x2 = 0;
   p = 0; 
-  for (int j=0; j < MAX_EQN_NUM; j++) {
-    for (int k=0; k < MAX_P + 1; k++) {
-      dof[j][k] = 0;
-      for (int sln=0; sln < MAX_SLN_NUM; sln++) {
-        coeffs[sln][j][k] = 0;
-      }
-    }
-  }
+  dof = NULL;
+  coeffs = NULL;
+  storage = NULL;
+  storage_size = 0;
+  p_max = 0;
   sons[0] = sons[1] = NULL; 
   active = 1;
   level = 0;
@@ -41,20 +111,81 @@ Element::Element(double x_left, double x_right, int level, int deg, int n_eq, in
   p = deg; 
   this->n_eq = n_eq;
   this->n_sln = n_sln;
-  if (dof == NULL) error("Not enough memory in Element().");
+  this->storage = NULL;
+  this->storage_size = 0;
+  this->alloc_storage(n_eq, n_sln, deg);
   sons[0] = sons[1] = NULL; 
   active = 1;
   this->level = level;
   this->marker = marker;
   id = -1;
-  for(int i = 0; i < MAX_EQN_NUM; i++)
-    for(int j = 0; j < MAX_P + 1; j++)
-      this->dof[i][j] = 0;
-  
-  for(int i = 0; i < MAX_SLN_NUM; i++)
-    for(int j = 0; j < MAX_EQN_NUM; j++)
-      for(int k = 0; k < MAX_P + 1; k++)
-        this->coeffs[i][j][k] = 0;
+}
+
+// Allocates zeroed dof and coeffs arrays for n_eq components, n_sln 
+// solutions and poly degree up to p_max. The pointer tables and the 
+// values are all placed in one block taken from the element pool, so 
+// that an element makes one allocation and its data are contiguous 
+// in memory. 
+void Element::alloc_storage(int n_eq, int n_sln, int p_max)
+{
+  this->free_storage();
+  // vertex dofs are present even for the dummy degree used in replicate()
+  if (p_max < 1) p_max = 1;
+  this->p_max = p_max;
+  int n = p_max + 1;
+  size_t size = n_sln * sizeof(double **) + n_sln * n_eq * sizeof(double *) 
+              + n_eq * sizeof(int *) + n_sln * n_eq * n * sizeof(double) 
+              + n_eq * n * sizeof(int);
+  if (size == 0) return;
+  this->storage = (char *) element_pool->alloc(size);
+  this->storage_size = size;
+  memset(this->storage, 0, size);
+
+  this->coeffs = (double ***) this->storage;
+  double **coeffs_rows = (double **) (this->coeffs + n_sln);
+  this->dof = (int **) (coeffs_rows + n_sln * n_eq);
+  double *coeffs_vals = (double *) (this->dof + n_eq);
+  int *dof_vals = (int *) (coeffs_vals + n_sln * n_eq * n);
+  for(int sln=0; sln < n_sln; sln++) {
+    this->coeffs[sln] = coeffs_rows + sln * n_eq;
+    for(int c=0; c < n_eq; c++) 
+      this->coeffs[sln][c] = coeffs_vals + (sln * n_eq + c) * n;
+  }
+  for(int c=0; c < n_eq; c++) this->dof[c] = dof_vals + c * n;
+}
+
+void Element::free_storage()
+{
+  element_pool->release(this->storage, this->storage_size);
+  this->storage = NULL;
+  this->storage_size = 0;
+  this->dof = NULL;
+  this->coeffs = NULL;
+  this->p_max = 0;
+}
+
+// Changes the poly degree of the element. The dof and coeffs arrays 
+// grow if needed, their existing entries are kept and new ones are zero.
+void Element::set_p(int p)
+{
+  if (p > this->p_max) {
+    char *old_storage = this->storage;
+    size_t old_size = this->storage_size;
+    int **old_dof = this->dof;
+    double ***old_coeffs = this->coeffs;
+    int old_n = this->p_max + 1;
+    this->storage = NULL;
+    this->alloc_storage(this->n_eq, this->n_sln, p);
+    if (old_storage != NULL) {
+      for(int c=0; c < this->n_eq; c++) {
+        memcpy(this->dof[c], old_dof[c], old_n * sizeof(int));
+        for(int sln=0; sln < this->n_sln; sln++) 
+          memcpy(this->coeffs[sln][c], old_coeffs[sln][c], old_n * sizeof(double));
+      }
+      element_pool->release(old_storage, old_size);
+    }
+  }
+  this->p = p;
 }
 
 void Element::free_element() 
@@ -66,6 +197,7 @@ void Element::free_element()
 Element::~Element()
 {
   this->free_element();
+  this->free_storage();
 }
 
 unsigned Element::is_active() 
@@ -82,7 +214,7 @@ unsigned Element::is_active()
 void Element::refine(int type, int p_left, int p_right) 
 {
   if(type == 0) {         // p-refinement
-    this->p = p_left;
+    this->set_p(p_left);
   }
   else {
     double x1 = this->x1;
@@ -91,6 +223,7 @@ void Element::refine(int type, int p_left, int p_right)
     this->sons[0] = new Element(x1, midpoint, this->level + 1, p_left, this->n_eq, this->n_sln, this->marker);
     this->sons[1] = new Element(midpoint, x2, this->level + 1, 
                                 p_right, this->n_eq, this->n_sln, this->marker);
+    Element::tree_version++;
     // Copy Dirichtel boundary conditions to sons
     for(int c=0; c<this->n_eq; c++) {
       if (this->dof[c][0] < 0) {
@@ -124,6 +257,9 @@ void Element::refine(int3 cand)
 void Element::init(double x1, double x2, int p_init, 
                    int id, int active, int level, int n_eq, int n_sln, int marker)
 {
+  if (this->storage == NULL || n_eq != this->n_eq || n_sln != this->n_sln 
+      || p_init > this->p_max) 
+    this->alloc_storage(n_eq, n_sln, p_init);
   this->x1 = x1;
   this->x2 = x2;
   this->p = p_init;
@@ -348,8 +484,9 @@ void Element::copy_into(Element *e_trg)
               this->active, this->level, this->n_eq, this->n_sln, this->marker);
 
   // copy dof arrays for all solution components
+  int n = (this->p < 1 ? 1 : this->p) + 1;
   for(int c=0; c < this->n_eq; c++) {
-    for(int i=0; i < MAX_P + 1; i++) {
+    for(int i=0; i < n; i++) {
       e_trg->dof[c][i] = this->dof[c][i];
       for(int sln=0; sln < this->n_sln; sln++) {
         e_trg->coeffs[sln][c][i] = this->coeffs[sln][c][i];
@@ -369,6 +506,7 @@ void Element::copy_recursively_into(Element *e_trg)
   if(this->sons[0] != NULL) {          // element was split in space (sons will be replicated)
     e_trg->sons[0] = new Element();
     e_trg->sons[1] = new Element();
+    Element::tree_version++;
     // left son
     this->sons[0]->copy_recursively_into(e_trg->sons[0]);
     // right son
@@ -395,6 +533,7 @@ Space::Space() {
   n_active_elem = 0;
   n_dof = 0;
   base_elems = NULL;
+  active_elems_version = 0;
 }
 
 // Creates equidistant space with uniform polynomial degree of elements.
@@ -467,6 +606,7 @@ Space::Space(int n_macro_elem,
   this->n_eq = n_eq;
   this->n_sln = n_sln;
   this->n_active_elem = n_base_elem;
+  this->active_elems_version = 0;
 
   // allocate base element array
   this->base_elems = new Element[this->n_base_elem];     
@@ -525,6 +665,7 @@ Space::Space(int n_macro_elem,
   this->n_eq = n_eq;
   this->n_sln = n_sln;
   this->n_active_elem = n_base_elem;
+  this->active_elems_version = 0;
 
   // allocate base element array
   this->base_elems = new Element[this->n_base_elem];     
@@ -584,6 +725,7 @@ Space::Space(int n_macro_elem,
   this->n_eq = n_eq;
   this->n_sln = n_sln;
   this->n_active_elem = n_base_elem;
+  this->active_elems_version = 0;
 
   // allocate base element array
   this->base_elems = new Element[this->n_base_elem];     
@@ -624,6 +766,7 @@ void Space::init(double a, double b, int n_base_elem, int p_init, int n_eq, int
   this->n_eq = n_eq;
   this->n_sln = n_sln;
   this->n_active_elem = n_base_elem;
+  this->active_elems_version = 0;
 
   // allocate element array
   this->base_elems = new Element[this->n_base_elem];     
@@ -797,20 +940,42 @@ void Space::assign_elem_ids()
 
 Element* Space::first_active_element()
 {
-  Element *e = base_elems;
-  while(!e->is_active()) {
-    e = e->sons[0];
-  }
-  return e;
+  return this->get_active_elems()[0];
 }
 
 Element* Space::last_active_element()
 {
-  Element *e = base_elems + n_base_elem - 1;
-  while(!e->is_active()) {
-    e = e->sons[1];
+  this->get_active_elems();
+  return this->active_elems[this->active_elems.size() - 2];
+}
+
+// Collects active elements into a flat array by a depth-first 
+// traversal of the refinement trees of base elements. 
+void Space::update_active_elems()
+{
+  this->active_elems.clear();
+  std::vector<Element *> stack;
+  for(int i=0; i < this->n_base_elem; i++) {
+    stack.push_back(this->base_elems + i);
+    while (!stack.empty()) {
+      Element *e = stack.back();
+      stack.pop_back();
+      if (e->is_active()) this->active_elems.push_back(e);
+      else {
+        stack.push_back(e->sons[1]);
+        stack.push_back(e->sons[0]);
+      }
+    }
   }
-  return e;
+  this->active_elems.push_back(NULL);   // terminator
+  this->active_elems_version = Element::tree_version;
+}
+
+Element** Space::get_active_elems()
+{
+  if (this->active_elems.empty() || this->active_elems_version != Element::tree_version) 
+    this->update_active_elems();
+  return &this->active_elems[0];
 }
 
 // defining macro to check whether hp candidates are admissible
@@ -1393,6 +1558,35 @@ void create_ref_index_array(double threshold, double *err_array,
   */
 }
 
+// Selects the refinement candidate for each of the 'n' elements e[i]. 
+// e_ref_left[i] and e_ref_right[i] are the corresponding reference elements
+// (e_ref_right[i] is NULL if the reference refinement was p-refinement).
+// The elements are independent of each other, so they are processed in 
+// parallel when Hermes is built with OpenMP.
+static void select_hp_refinements(int norm, int adapt_type, int n, Element **e, 
+                                  Element **e_ref_left, Element **e_ref_right, 
+                                  int *choices)
+{
+  precalculate_proj_matrix_H1_ref();
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for (int i=0; i < n; i++) {
+    int3 cand_list[MAX_CAND_NUM];   
+    if (e_ref_right[i] == NULL) {
+      int num_cand = e[i]->create_cand_list(adapt_type, e_ref_left[i]->p, -1, cand_list);
+      choices[i] = select_hp_refinement(e[i], e_ref_left[i], NULL, num_cand, cand_list, 
+                                        0, norm);
+    }
+    else {
+      int num_cand = e[i]->create_cand_list(adapt_type, e_ref_left[i]->p, 
+                                            e_ref_right[i]->p, cand_list);
+      choices[i] = select_hp_refinement(e[i], e_ref_left[i], e_ref_right[i], 
+                                        num_cand, cand_list, 1, norm);
+    }
+  }
+}
+
 // Returns updated coarse and reference meshes, with the last 
 // coarse and reference space solutions on them, respectively. 
 // The coefficient vectors and numbers of degrees of freedom 
@@ -1409,6 +1603,38 @@ void adapt(int norm, int adapt_type, double threshold,
   int num_to_adapt;
   create_ref_index_array(threshold, err_array, n_elem, adapt_list, num_to_adapt);
 
+  // Select refinements of all elements to be adapted first. 
+  Element **sel_e = new Element*[num_to_adapt + 1];
+  Element **sel_e_ref_left = new Element*[num_to_adapt + 1];
+  Element **sel_e_ref_right = new Element*[num_to_adapt + 1];
+  int *choices = new int[num_to_adapt + 1];
+  {
+    Iterator I(space);
+    Iterator I_ref(space_ref);
+    Element *e = I.next_active_element();
+    Element *e_ref = I_ref.next_active_element();
+    int counter = 0;
+    while (counter != num_to_adapt) {
+      if (e->id == adapt_list[counter]) {
+        sel_e[counter] = e;
+        sel_e_ref_left[counter] = e_ref;
+        // Element 'e' was refined in space for reference solution.
+        if (e->level != e_ref->level) sel_e_ref_right[counter] = I_ref.next_active_element();
+        else sel_e_ref_right[counter] = NULL;
+        counter++;
+        e = I.next_active_element();
+        e_ref = I_ref.next_active_element();
+      }
+      else {
+        e = I.next_active_element();
+        e_ref = I_ref.next_active_element();
+        if (e->level != e_ref->level) e_ref = I_ref.next_active_element();
+      }
+    }
+  }
+  select_hp_refinements(norm, adapt_type, num_to_adapt, sel_e, sel_e_ref_left, 
+                        sel_e_ref_right, choices);
+
   // Replicate the coarse and fine meshes. The original meshes become
   // backup and refinements will only be done in the new ones.
   Space *space_new = space->replicate();
@@ -1450,8 +1676,7 @@ void adapt(int norm, int adapt_type, double threshold,
         // debug:
         //e->print_cand_list(num_cand, cand_list);
         // reference element was p-refined
-        choice = select_hp_refinement(e, e_ref, NULL, num_cand, cand_list, 
-                                      0, norm);
+        choice = choices[counter - 1];
       }
       // Element 'e' was refined in space for reference solution.
       else {
@@ -1459,10 +1684,8 @@ void adapt(int norm, int adapt_type, double threshold,
         e_ref_new_left = e_ref_new;
         e_ref_right = I_ref->next_active_element();
         e_ref_new_right = I_ref_new->next_active_element();
-        int num_cand = e->create_cand_list(adapt_type, e_ref_left->p, 
-                                           e_ref_right->p, cand_list);
-        choice = select_hp_refinement(e, e_ref_left, e_ref_right, 
-                                      num_cand, cand_list, 1, norm);
+        e->create_cand_list(adapt_type, e_ref_left->p, e_ref_right->p, cand_list);
+        choice = choices[counter - 1];
       }
 
       // Next we perform the refinement defined by cand_list[choice]
@@ -1538,6 +1761,10 @@ void adapt(int norm, int adapt_type, double threshold,
   delete I_new;
   delete I_ref;
   delete I_ref_new;
+  delete [] sel_e;
+  delete [] sel_e_ref_left;
+  delete [] sel_e_ref_right;
+  delete [] choices;
 
   // Enumerate dofs in both new spaces.
   int n_dof_new = space_new->assign_dofs();
@@ -1574,6 +1801,29 @@ void adapt(int norm, int adapt_type, double threshold,
   int num_to_adapt;
   create_ref_index_array(threshold, err_array, n_elem, adapt_list, num_to_adapt);
 
+  // Select refinements of all elements to be adapted first. 
+  Element **sel_e = new Element*[num_to_adapt + 1];
+  Element **sel_e_ref_left = new Element*[num_to_adapt + 1];
+  Element **sel_e_ref_right = new Element*[num_to_adapt + 1];
+  int *choices = new int[num_to_adapt + 1];
+  {
+    Iterator I(space);
+    Element *e;
+    int counter = 0;
+    while (counter != num_to_adapt && (e = I.next_active_element()) != NULL) {
+      if (e->id != adapt_list[counter]) continue;
+      sel_e[counter] = e;
+      sel_e_ref_left[counter] = ref_elem_pairs[e->id][0];
+      // Element 'e' was refined in space for reference solution.
+      if (e->level != sel_e_ref_left[counter]->level) 
+        sel_e_ref_right[counter] = ref_elem_pairs[e->id][1];
+      else sel_e_ref_right[counter] = NULL;
+      counter++;
+    }
+  }
+  select_hp_refinements(norm, adapt_type, num_to_adapt, sel_e, sel_e_ref_left, 
+                        sel_e_ref_right, choices);
+
   // Replicate the coarse mesh. The original coarse mesh becomes
   // backup and refinements will only be done in the new one.
   Space *space_new = space->replicate();
@@ -1606,17 +1856,14 @@ void adapt(int norm, int adapt_type, double threshold,
         // debug:
         //e->print_cand_list(num_cand, cand_list);
         // reference element was p-refined
-        choice = select_hp_refinement(e, e_ref, NULL, num_cand, cand_list, 
-                                      0, norm);
+        choice = choices[counter_adapt - 1];
       }
       // Element 'e' was refined in space for reference solution.
       else {
         e_ref_left = e_ref;
         e_ref_right = ref_elem_pairs[e->id][1];
-        int num_cand = e->create_cand_list(adapt_type, e_ref_left->p, 
-                                           e_ref_right->p, cand_list);
-        choice = select_hp_refinement(e, e_ref_left, e_ref_right, 
-                                      num_cand, cand_list, 1, norm);
+        e->create_cand_list(adapt_type, e_ref_left->p, e_ref_right->p, cand_list);
+        choice = choices[counter_adapt - 1];
       }
 
       // Next we perform the refinement defined by cand_list[choice]
@@ -1642,6 +1889,11 @@ void adapt(int norm, int adapt_type, double threshold,
       e_new = I_new->next_active_element();
     }
   }
+  delete [] sel_e;
+  delete [] sel_e_ref_left;
+  delete [] sel_e_ref_right;
+  delete [] choices;
+
   // Enumerate dofs in both new spaces.
   int n_dof_new = space_new->assign_dofs();
   info("New space has %d elements.",
@@ -6,6 +6,7 @@
 #ifndef _Space_H_
 #define _Space_H_
 
+#include <vector>
 #include "../../hermes_common/common.h"
 #include "../../hermes_common/matrix.h"
 #include "legendre.h"
@@ -46,6 +47,11 @@ public:
     void print_cand_list(int num_cand, int3 *cand_list);
     void refine(int3 cand);
     void refine(int type, int p_left, int p_right);
+    void set_p(int p);  // changes poly degree, keeps dof and coeffs arrays
+
+    // sons and replicated elements are allocated from the element pool
+    static void *operator new(size_t size);
+    static void operator delete(void *e, size_t size);
     unsigned is_active();
     unsigned active;   // flag used by assembling algorithm
     double x1, x2;     // endpoints
@@ -53,13 +59,29 @@ public:
     int marker;        // can be used to distinguish between material parameters
     int n_eq;          // number of equations (= number of solution components)
     int n_sln;         // number of solution copies
-    int dof[MAX_EQN_NUM][MAX_P + 1];   // connectivity array of length p+1 
-                                       // for every solution component
-    double coeffs[MAX_SLN_NUM][MAX_EQN_NUM][MAX_P + 1];   // solution coefficient array of length p+1 
-                                                          // for every component and every solution 
+    int **dof;         // connectivity array of length p+1 
+                       // for every solution component
+    double ***coeffs;  // solution coefficient array of length p+1 
+                       // for every component and every solution 
     int id;
     unsigned level;    // refinement level (zero for initial space elements) 
     Element *sons[2];  // for refinement
+
+    // incremented whenever some element is split, used to 
+    // invalidate the arrays of active elements in spaces
+    static unsigned tree_version;
+
+private:
+    // dof and coeffs arrays live in one pool block sized for 
+    // n_eq, n_sln and poly degree p_max
+    void alloc_storage(int n_eq, int n_sln, int p_max);
+    void free_storage();
+    char *storage;
+    size_t storage_size;
+    int p_max;
+
+    Element(const Element &e);               // not copyable (owns storage)
+    Element &operator=(const Element &e);
 };
 
 typedef Element* ElemPtr2[2];
@@ -165,6 +187,9 @@ class HERMES_API Space {
 
         Element* first_active_element();
         Element* last_active_element();
+        // NULL-terminated array of active elements (from left to right).
+        // It is rebuilt when some element was split since the last call.
+        Element** get_active_elems();
         void set_bc_left_dirichlet(int eqn, double val);
         void set_bc_right_dirichlet(int eqn, double val);
         void refine_single_elem(int id, int3 cand);
@@ -201,7 +226,9 @@ class HERMES_API Space {
         int n_base_elem;     // number of elements in the base space
         int n_dof;           // number of DOF (in each solution copy)
         Element *base_elems; // base space
-
+        std::vector<Element *> active_elems;  // active elements (see get_active_elems())
+        unsigned active_elems_version;        // Element::tree_version of active_elems
+        void update_active_elems();
 };
 
 // Returns updated coarse and reference spacees, with the last 
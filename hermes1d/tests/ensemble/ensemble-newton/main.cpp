@@ -0,0 +1,226 @@
+#define HERMES_REPORT_WARN
+#define HERMES_REPORT_INFO
+#define HERMES_REPORT_VERBOSE
+#define HERMES_REPORT_FILE "application.log"
+#include "hermes1d.h"
+
+// This test makes sure that the Ensemble gives the same
+// results as independent Newton's loops with DiscreteProblem.
+// The nonlinear problem -u'' + lambda*u^3 = 1 in (0, 1),
+// u(0) = 1, u'(1) + u(1) = 1 is solved for N_MEMBERS values
+// of lambda (the number of members is not a multiple of the
+// batch size), the coefficient vectors and the numbers of
+// Newton's iterations of all members must be the same.
+
+#define ERROR_SUCCESS                               0
+#define ERROR_FAILURE                               -1
+
+//  The following parameters can be changed:
+static int NEQ = 1;
+int NELEM = 10;                         // Number of elements.
+double A = 0, B = 1;                    // Domain end points.
+int P_INIT = 3;                         // Initial polynomial degree.
+int N_MEMBERS = 37;                     // Number of values of lambda.
+int BATCH_SIZE = 8;                     // Members assembled together.
+
+// Newton's method.
+double NEWTON_TOL = 1e-10;
+int NEWTON_MAX_ITER = 50;
+
+// Tolerance for the comparison of the coefficients.
+double TOL = 1e-12;
+
+MatrixSolverType matrix_solver = SOLVER_BANDED;
+
+// Boundary conditions.
+BCSpec DIR_BC_LEFT(0, 1);
+
+// Lambda used by the weak forms of DiscreteProblem
+// (the Ensemble passes it as user_data).
+double LAMBDA;
+
+// Weak forms for a given lambda.
+double jacobian(double lambda, int num, double *weights,
+                double *u, double *dudx, double *v, double *dvdx,
+                double u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM])
+{
+  double val = 0;
+  for(int i = 0; i<num; i++)
+  {
+    val += (dudx[i]*dvdx[i] + 3*lambda*u_prev[0][0][i]*u_prev[0][0][i]*u[i]*v[i])*weights[i];
+  }
+  return val;
+}
+
+double residual(double lambda, int num, double *weights,
+                double u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                double du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                double *v, double *dvdx)
+{
+  double val = 0;
+  for(int i = 0; i<num; i++)
+  {
+    double u = u_prev[0][0][i];
+    val += (du_prevdx[0][0][i]*dvdx[i] + (lambda*u*u*u - 1)*v[i])*weights[i];
+  }
+  return val;
+}
+
+// Weak forms of DiscreteProblem.
+double jacobian_dp(int num, double *x, double *weights,
+                   double *u, double *dudx, double *v, double *dvdx,
+                   double u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                   double du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                   void *user_data)
+{
+  return jacobian(LAMBDA, num, weights, u, dudx, v, dvdx, u_prev);
+}
+
+double residual_dp(int num, double *x, double *weights,
+                   double u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                   double du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                   double *v, double *dvdx, void *user_data)
+{
+  return residual(LAMBDA, num, weights, u_prev, du_prevdx, v, dvdx);
+}
+
+// Weak forms of the Ensemble.
+double jacobian_ens(int num, double *x, double *weights,
+                    double *u, double *dudx, double *v, double *dvdx,
+                    double u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                    double du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                    void *user_data)
+{
+  return jacobian(*(double *) user_data, num, weights, u, dudx, v, dvdx, u_prev);
+}
+
+double residual_ens(int num, double *x, double *weights,
+                    double u_prev[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                    double du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM][MAX_QUAD_PTS_NUM],
+                    double *v, double *dvdx, void *user_data)
+{
+  return residual(*(double *) user_data, num, weights, u_prev, du_prevdx, v, dvdx);
+}
+
+// Robin condition at the right end point (the same for all members).
+double jacobian_surf_right(double x, double u, double dudx,
+                           double v, double dvdx, double u_prev[MAX_SLN_NUM][MAX_EQN_NUM],
+                           double du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM], void *user_data)
+{
+  return u*v;
+}
+
+double residual_surf_right(double x, double u_prev[MAX_SLN_NUM][MAX_EQN_NUM],
+                           double du_prevdx[MAX_SLN_NUM][MAX_EQN_NUM], double v,
+                           double dvdx, void *user_data)
+{
+  return (u_prev[0][0] - 1)*v;
+}
+
+
+int main()
+{
+  // Create space with the Dirichlet condition at the left end point.
+  Space* space = new Space(A, B, NELEM, Hermes::vector<BCSpec *>(&DIR_BC_LEFT),
+                           Hermes::vector<BCSpec *>(), P_INIT, NEQ);
+  int ndof = Space::get_num_dofs(space);
+  info("ndof: %d", ndof);
+
+  // Values of lambda.
+  double *lambda = new double[N_MEMBERS];
+  void **member_data = new void*[N_MEMBERS];
+  for (int m = 0; m < N_MEMBERS; m++)
+  {
+    lambda[m] = 20.0 * m / (N_MEMBERS - 1);
+    member_data[m] = &lambda[m];
+  }
+
+  // Initial guess, the same for all members.
+  double *coeff_vec_init = new double[ndof];
+  get_coeff_vector(space, coeff_vec_init);
+
+  // Solve all members with the Ensemble.
+  WeakForm wf_ens;
+  wf_ens.add_matrix_form(jacobian_ens);
+  wf_ens.add_vector_form(residual_ens);
+  wf_ens.add_matrix_form_surf(jacobian_surf_right, BOUNDARY_RIGHT);
+  wf_ens.add_vector_form_surf(residual_surf_right, BOUNDARY_RIGHT);
+  Ensemble ensemble(&wf_ens, space, N_MEMBERS, member_data);
+  ensemble.set_batch_size(BATCH_SIZE);
+  int n_converged = ensemble.solve_newton(NEWTON_TOL, NEWTON_MAX_ITER, matrix_solver);
+  info("Ensemble: %d of %d members converged.", n_converged, N_MEMBERS);
+
+  // Solve the members one by one with DiscreteProblem.
+  WeakForm wf;
+  wf.add_matrix_form(jacobian_dp);
+  wf.add_vector_form(residual_dp);
+  wf.add_matrix_form_surf(jacobian_surf_right, BOUNDARY_RIGHT);
+  wf.add_vector_form_surf(residual_surf_right, BOUNDARY_RIGHT);
+  bool is_linear = false;
+  DiscreteProblem dp(&wf, space, is_linear);
+
+  SparseMatrix* matrix = create_matrix(matrix_solver);
+  Vector* rhs = create_vector(matrix_solver);
+  Solver* solver = create_linear_solver(matrix_solver, matrix, rhs);
+  double *coeff_vec = new double[ndof];
+
+  int success_test = (n_converged == N_MEMBERS);
+  double max_diff = 0;
+  for (int m = 0; m < N_MEMBERS; m++)
+  {
+    LAMBDA = lambda[m];
+    memcpy(coeff_vec, coeff_vec_init, ndof * sizeof(double));
+
+    // Newton's loop.
+    int it = 1;
+    while (1)
+    {
+      dp.assemble(coeff_vec, matrix, rhs);
+      double res_l2_norm = get_l2_norm(rhs);
+      if(res_l2_norm < NEWTON_TOL && it > 1) break;
+      for(int i=0; i<ndof; i++) rhs->set(i, -rhs->get(i));
+      if(!solver->solve())
+        error ("Matrix solver failed.\n");
+      for (int i = 0; i < ndof; i++) coeff_vec[i] += solver->get_solution()[i];
+      if (it >= NEWTON_MAX_ITER) error ("Newton method did not converge.");
+      it++;
+    }
+
+    // Compare with the member.
+    double *y = ensemble.get_coeff_vector(m);
+    for (int i = 0; i < ndof; i++)
+    {
+      double diff = fabs(y[i] - coeff_vec[i]) / (1 + fabs(coeff_vec[i]));
+      if (diff > max_diff) max_diff = diff;
+    }
+    if (ensemble.get_num_iters(m) != it)
+    {
+      info("lambda = %g: %d Newton's iterations with Ensemble, %d with DiscreteProblem.",
+           lambda[m], ensemble.get_num_iters(m), it);
+      success_test = 0;
+    }
+  }
+  info("Max. relative difference of the coefficients: %g", max_diff);
+  if (max_diff > TOL) success_test = 0;
+
+  // Cleanup.
+  delete matrix;
+  delete rhs;
+  delete solver;
+  delete [] coeff_vec;
+  delete [] coeff_vec_init;
+  delete [] member_data;
+  delete [] lambda;
+  delete space;
+
+  if (success_test)
+  {
+    info("Success!");
+    return ERROR_SUCCESS;
+  }
+  else
+  {
+    info("Failure!");
+    return ERROR_FAILURE;
+  }
+}
@@ -505,7 +505,8 @@ public:
   // Constructor.
   EulerEquationsWeakFormExplicitMultiComponent(NumericalFlux* num_flux, double kappa, double rho_ext, double v1_ext, double v2_ext, double pressure_ext, 
         std::string solid_wall_bottom_marker, std::string solid_wall_top_marker, std::string inlet_marker, std::string outlet_marker, 
-        Solution* prev_density, Solution* prev_density_vel_x, Solution* prev_density_vel_y, Solution* prev_energy, bool fvm_only = false, int num_of_equations = 4) :
+        Solution* prev_density, Solution* prev_density_vel_x, Solution* prev_density_vel_y, Solution* prev_energy, bool fvm_only = false, int num_of_equations = 4,
+        bool face_based = false) :
         WeakForm(num_of_equations), rho_ext(rho_ext), v1_ext(v1_ext), v2_ext(v2_ext), pressure_ext(pressure_ext), 
         energy_ext(QuantityCalculator::calc_energy(rho_ext, rho_ext * v1_ext, rho_ext * v2_ext, pressure_ext, kappa)), euler_fluxes(new EulerFluxes(kappa))
   {
@@ -528,20 +529,33 @@ public:
 
     add_multicomponent_vector_form(new EulerEquationsLinearFormTime(vector_coordinates));
     
-    add_multicomponent_vector_form_surf(new EulerEquationsLinearFormInterface(vector_coordinates, num_flux));
+    // Face-based assembling: the numerical flux is evaluated once on every face
+    // (inner and boundary), for all its quadrature points at once.
+    if(face_based) {
+      Hermes::vector<MeshFunction*> ext;
+      ext.push_back(prev_density);
+      ext.push_back(prev_density_vel_x);
+      ext.push_back(prev_density_vel_y);
+      ext.push_back(prev_energy);
+      add_flux_form_surf(new EulerEquationsFluxForm(vector_coordinates, ext, num_flux, 
+                         solid_wall_bottom_marker, solid_wall_top_marker, inlet_marker, outlet_marker));
+    }
+    else {
+      add_multicomponent_vector_form_surf(new EulerEquationsLinearFormInterface(vector_coordinates, num_flux));
 
-    add_multicomponent_vector_form_surf(new EulerEquationsLinearFormSolidWall(vector_coordinates, 
-                                        solid_wall_bottom_marker, num_flux));
-    
-    if(solid_wall_bottom_marker != solid_wall_top_marker)
       add_multicomponent_vector_form_surf(new EulerEquationsLinearFormSolidWall(vector_coordinates, 
-                                          solid_wall_top_marker, num_flux));
+                                          solid_wall_bottom_marker, num_flux));
+      
+      if(solid_wall_bottom_marker != solid_wall_top_marker)
+        add_multicomponent_vector_form_surf(new EulerEquationsLinearFormSolidWall(vector_coordinates, 
+                                            solid_wall_top_marker, num_flux));
 
-    add_multicomponent_vector_form_surf(new EulerEquationsLinearFormInlet(vector_coordinates, 
-                                        inlet_marker, num_flux));
+      add_multicomponent_vector_form_surf(new EulerEquationsLinearFormInlet(vector_coordinates, 
+                                          inlet_marker, num_flux));
 
-    add_multicomponent_vector_form_surf(new EulerEquationsLinearFormOutlet(vector_coordinates, 
-                                        outlet_marker, num_flux));
+      add_multicomponent_vector_form_surf(new EulerEquationsLinearFormOutlet(vector_coordinates, 
+                                          outlet_marker, num_flux));
+    }
 
     for(unsigned int vector_form_i = 0;vector_form_i < this->vfvol_mc.size();vector_form_i++) {
       vfvol_mc.at(vector_form_i)->ext.push_back(prev_density);
@@ -996,6 +1010,68 @@ protected:
     NumericalFlux* num_flux;
   };
 
+  class EulerEquationsFluxForm : public WeakForm::FluxFormSurf
+  {
+  public:
+    EulerEquationsFluxForm(Hermes::vector<unsigned int> coordinates, Hermes::vector<MeshFunction*> ext, 
+                           NumericalFlux* num_flux, std::string solid_wall_bottom_marker, 
+                           std::string solid_wall_top_marker, std::string inlet_marker, std::string outlet_marker) 
+         : WeakForm::FluxFormSurf(coordinates, ext), num_flux(num_flux), solid_wall_bottom_marker(solid_wall_bottom_marker), 
+           solid_wall_top_marker(solid_wall_top_marker), inlet_marker(inlet_marker), outlet_marker(outlet_marker) {}
+
+    void flux(int n, double **w_L, double **w_R, double *nx, double *ny, double **result) const {
+      num_flux->numerical_flux_batch(n, result, w_L, w_R, nx, ny);
+      scale(n, result);
+    }
+
+    bool boundary_flux(int n, std::string marker, double **w_L, double *nx, double *ny, 
+                       double *x, double *y, double **result) const {
+      EulerEquationsWeakFormExplicitMultiComponent* euler_wf = static_cast<EulerEquationsWeakFormExplicitMultiComponent*>(wf);
+      bool solid_wall = (marker == solid_wall_bottom_marker || marker == solid_wall_top_marker);
+      if(!solid_wall && marker != inlet_marker && marker != outlet_marker)
+        return false;
+
+      double w_B[4];
+      w_B[0] = euler_wf->rho_ext;
+      w_B[1] = euler_wf->rho_ext * euler_wf->v1_ext;
+      w_B[2] = euler_wf->rho_ext * euler_wf->v2_ext;
+      w_B[3] = euler_wf->energy_ext;
+      for (int i = 0;i < n;i++) {
+        double w_L_i[4], flux_i[4];
+        for(unsigned int j = 0; j < 4; j++)
+          w_L_i[j] = w_L[j][i];
+        if(solid_wall)
+          num_flux->numerical_flux_solid_wall(flux_i, w_L_i, nx[i], ny[i]);
+        else if(marker == inlet_marker)
+          num_flux->numerical_flux(flux_i, w_L_i, w_B, nx[i], ny[i]);
+        else
+          num_flux->numerical_flux_outlet(flux_i, w_L_i, euler_wf->pressure_ext, nx[i], ny[i]);
+        for(unsigned int j = 0; j < 4; j++)
+          result[j][i] = flux_i[j];
+      }
+      scale(n, result);
+      return true;
+    }
+
+    // The same integration order as the element-based surface forms (the order of the test
+    // functions), so that both assemblings give the same residual.
+    int ord(int ext_order, int test_order) const {
+      return test_order;
+    }
+
+    // The flux is subtracted from the residual of the element L and multiplied by the time step.
+    void scale(int n, double **result) const {
+      double tau = static_cast<EulerEquationsWeakFormExplicitMultiComponent*>(wf)->get_tau();
+      for(unsigned int j = 0; j < 4; j++)
+        for (int i = 0;i < n;i++)
+          result[j][i] *= -tau;
+    }
+
+    // Members.
+    NumericalFlux* num_flux;
+    std::string solid_wall_bottom_marker, solid_wall_top_marker, inlet_marker, outlet_marker;
+  };
+
   // Members.
   double rho_ext;
   double v1_ext;
@@ -25,6 +25,10 @@ bool SHOCK_CAPTURING = false;
 // Quantitative parameter of the discontinuity detector.
 double DISCONTINUITY_DETECTOR_PARAM = 1.0;
 
+// Explicit scheme with the numerical fluxes assembled face by face (every face of the mesh
+// is visited once) instead of the semi-implicit scheme.
+const bool FACE_BASED = true;
+
 const int P_INIT = 0;                                   // Initial polynomial degree.                      
 const int INIT_REF_NUM = 4;                             // Number of initial uniform mesh refinements.                       
 double CFL_NUMBER = 1.0;                                // CFL value.
@@ -80,11 +84,14 @@ int main(int argc, char* argv[])
   OsherSolomonNumericalFlux num_flux(KAPPA);
 
   // Initialize weak formulation.
-  EulerEquationsWeakFormSemiImplicitMultiComponent wf(&num_flux, KAPPA, RHO_EXT, V1_EXT, V2_EXT, P_EXT, BDY_SOLID_WALL_BOTTOM, BDY_SOLID_WALL_TOP, 
+  EulerEquationsWeakFormSemiImplicitMultiComponent wf_semi_implicit(&num_flux, KAPPA, RHO_EXT, V1_EXT, V2_EXT, P_EXT, BDY_SOLID_WALL_BOTTOM, BDY_SOLID_WALL_TOP, 
     BDY_INLET, BDY_OUTLET, &prev_rho, &prev_rho_v_x, &prev_rho_v_y, &prev_e, (P_INIT == 0));
+  EulerEquationsWeakFormExplicitMultiComponent wf_face_based(&num_flux, KAPPA, RHO_EXT, V1_EXT, V2_EXT, P_EXT, BDY_SOLID_WALL_BOTTOM, BDY_SOLID_WALL_TOP, 
+    BDY_INLET, BDY_OUTLET, &prev_rho, &prev_rho_v_x, &prev_rho_v_y, &prev_e, (P_INIT == 0), 4, true);
+  WeakForm* wf = FACE_BASED ? (WeakForm*) &wf_face_based : (WeakForm*) &wf_semi_implicit;
 
   // Initialize the FE problem.
-  DiscreteProblem dp(&wf, Hermes::vector<Space*>(&space_rho, &space_rho_v_x, &space_rho_v_y, &space_e));
+  DiscreteProblem dp(wf, Hermes::vector<Space*>(&space_rho, &space_rho_v_x, &space_rho_v_y, &space_e));
 
   // If the FE problem is in fact a FV problem.
   if(P_INIT == 0) 
@@ -117,7 +124,10 @@ int main(int argc, char* argv[])
     info("---- Time step %d, time %3.5f.", iteration++, t);
 
     // Set the current time step.
-    wf.set_time_step(time_step);
+    if(FACE_BASED)
+      wf_face_based.set_time_step(time_step);
+    else
+      wf_semi_implicit.set_time_step(time_step);
 
     // Assemble the stiffness matrix and rhs.
     info("Assembling the stiffness matrix and right-hand side vector.");
@@ -146,7 +156,10 @@ int main(int argc, char* argv[])
       flux_limiter.limit_according_to_detector(discontinuous_elements);
     }
 
-    CFL.calculate_semi_implicit(Hermes::vector<Solution *>(&prev_rho, &prev_rho_v_x, &prev_rho_v_y, &prev_e), &mesh, time_step);
+    if(FACE_BASED)
+      CFL.calculate(Hermes::vector<Solution *>(&prev_rho, &prev_rho_v_x, &prev_rho_v_y, &prev_e), &mesh, time_step);
+    else
+      CFL.calculate_semi_implicit(Hermes::vector<Solution *>(&prev_rho, &prev_rho_v_x, &prev_rho_v_y, &prev_e), &mesh, time_step);
 
     // Visualization.
     
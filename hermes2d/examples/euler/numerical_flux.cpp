@@ -33,21 +33,138 @@ void NumericalFlux::f_1(double result[4], double state[4])
 }
 
 
-VijayasundaramNumericalFlux::VijayasundaramNumericalFlux() : NumericalFlux(0)
+void NumericalFlux::numerical_flux_batch(int n, double* result[4], double* w_L[4], double* w_R[4],
+          double* nx, double* ny)
+{
+  for(int i = 0; i < n; i++) {
+    double w_L_i[4], w_R_i[4], result_i[4];
+    for(unsigned int j = 0; j < 4; j++) {
+      w_L_i[j] = w_L[j][i];
+      w_R_i[j] = w_R[j][i];
+    }
+    numerical_flux(result_i, w_L_i, w_R_i, nx[i], ny[i]);
+    for(unsigned int j = 0; j < 4; j++)
+      result[j][i] = result_i[j];
+  }
+}
+
+
+VijayasundaramNumericalFlux::VijayasundaramNumericalFlux(double kappa) : NumericalFlux(kappa)
 {
 }
 
 void VijayasundaramNumericalFlux::numerical_flux(double result[4], double w_L[4], double w_R[4],
           double nx, double ny)
 {
-  error("Not done yet.");
+  double* result_ptr[4] = { &result[0], &result[1], &result[2], &result[3] };
+  double* w_L_ptr[4] = { &w_L[0], &w_L[1], &w_L[2], &w_L[3] };
+  double* w_R_ptr[4] = { &w_R[0], &w_R[1], &w_R[2], &w_R[3] };
+  numerical_flux_batch(1, result_ptr, w_L_ptr, w_R_ptr, &nx, &ny);
 }
   
 double VijayasundaramNumericalFlux::numerical_flux_i(int component, double w_L[4], double w_R[4],
           double nx, double ny)
 {
-  error("Not done yet.");
-  return 0.0;
+  double result[4];
+  numerical_flux(result, w_L, w_R, nx, ny);
+  return result[component];
+}
+
+void VijayasundaramNumericalFlux::numerical_flux_batch(int n, double* result[4], double* w_L[4], double* w_R[4],
+          double* nx, double* ny)
+{
+  for(int i = 0; i < n; i++) {
+    // Rotate the states into the local coordinate system (Q()).
+    double l_0 = w_L[0][i], l_1 = nx[i] * w_L[1][i] + ny[i] * w_L[2][i], l_2 = -ny[i] * w_L[1][i] + nx[i] * w_L[2][i], l_3 = w_L[3][i];
+    double r_0 = w_R[0][i], r_1 = nx[i] * w_R[1][i] + ny[i] * w_R[2][i], r_2 = -ny[i] * w_R[1][i] + nx[i] * w_R[2][i], r_3 = w_R[3][i];
+
+    // Average state, its velocity, enthalpy and speed of sound.
+    double rho = 0.5 * (l_0 + r_0);
+    double u = 0.5 * (l_1 + r_1) / rho;
+    double v = 0.5 * (l_2 + r_2) / rho;
+    double p = (kappa - 1.0) * (0.5 * (l_3 + r_3) - 0.5 * rho * (u * u + v * v));
+    double H = (0.5 * (l_3 + r_3) + p) / rho;
+    double c = std::sqrt(kappa * p / rho);
+
+    // Positive eigenvalues for the left state, negative ones for the right state.
+    double lp_1 = std::max(u - c, 0.0), lp_2 = std::max(u, 0.0), lp_4 = std::max(u + c, 0.0);
+    double lm_1 = std::min(u - c, 0.0), lm_2 = std::min(u, 0.0), lm_4 = std::min(u + c, 0.0);
+
+    // Coordinates of the states in the basis of the eigenvectors
+    // K_1 = (1, u - c, v, H - u c), K_2 = (1, u, v, (u^2 + v^2) / 2), K_3 = (0, 0, 1, v), K_4 = (1, u + c, v, H + u c).
+    double k = (kappa - 1.0) / (c * c);
+    double l_a3 = l_2 - v * l_0;
+    double l_a2 = k * (l_0 * (H - u * u) + u * l_1 - l_3 + v * l_a3);
+    double l_a1 = (l_0 * (u + c) - l_1 - c * l_a2) / (2 * c);
+    double l_a4 = l_0 - l_a1 - l_a2;
+    double r_a3 = r_2 - v * r_0;
+    double r_a2 = k * (r_0 * (H - u * u) + u * r_1 - r_3 + v * r_a3);
+    double r_a1 = (r_0 * (u + c) - r_1 - c * r_a2) / (2 * c);
+    double r_a4 = r_0 - r_a1 - r_a2;
+
+    // P^+ w_L + P^- w_R.
+    double b_1 = lp_1 * l_a1 + lm_1 * r_a1;
+    double b_2 = lp_2 * l_a2 + lm_2 * r_a2;
+    double b_3 = lp_2 * l_a3 + lm_2 * r_a3;
+    double b_4 = lp_4 * l_a4 + lm_4 * r_a4;
+    double f_0 = b_1 + b_2 + b_4;
+    double f_1 = b_1 * (u - c) + b_2 * u + b_4 * (u + c);
+    double f_2 = (b_1 + b_2 + b_4) * v + b_3;
+    double f_3 = b_1 * (H - u * c) + b_2 * 0.5 * (u * u + v * v) + b_3 * v + b_4 * (H + u * c);
+
+    // Rotate back (Q_inv()).
+    result[0][i] = f_0;
+    result[1][i] = nx[i] * f_1 - ny[i] * f_2;
+    result[2][i] = ny[i] * f_1 + nx[i] * f_2;
+    result[3][i] = f_3;
+  }
+}
+
+void VijayasundaramNumericalFlux::numerical_flux_solid_wall(double result[4], double w_L[4], double nx, double ny)
+{
+  double p = QuantityCalculator::calc_pressure(w_L[0], w_L[1], w_L[2], w_L[3], kappa);
+  result[0] = 0;
+  result[1] = p * nx;
+  result[2] = p * ny;
+  result[3] = 0;
+}
+  
+double VijayasundaramNumericalFlux::numerical_flux_solid_wall_i(int component, double w_L[4], double nx, double ny)
+{
+  double result[4];
+  numerical_flux_solid_wall(result, w_L, nx, ny);
+  return result[component];
+}
+
+void VijayasundaramNumericalFlux::numerical_flux_inlet(double result[4], double w_L[4], double w_B[4],
+          double nx, double ny)
+{
+  numerical_flux(result, w_L, w_B, nx, ny);
+}
+  
+double VijayasundaramNumericalFlux::numerical_flux_inlet_i(int component, double w_L[4], double w_B[4],
+          double nx, double ny)
+{
+  double result[4];
+  numerical_flux_inlet(result, w_L, w_B, nx, ny);
+  return result[component];
+}
+
+void VijayasundaramNumericalFlux::numerical_flux_outlet(double result[4], double w_L[4], double pressure, double nx, double ny)
+{
+  double w_B[4];
+  w_B[0] = w_L[0];
+  w_B[1] = w_L[1];
+  w_B[2] = w_L[2];
+  w_B[3] = QuantityCalculator::calc_energy(w_L[0], w_L[1], w_L[2], pressure, kappa);
+  numerical_flux(result, w_L, w_B, nx, ny);
+}
+  
+double VijayasundaramNumericalFlux::numerical_flux_outlet_i(int component, double w_L[4], double pressure, double nx, double ny)
+{
+  double result[4];
+  numerical_flux_outlet(result, w_L, pressure, nx, ny);
+  return result[component];
 }
 
 StegerWarmingNumericalFlux::StegerWarmingNumericalFlux(double kappa) : NumericalFlux(kappa) {};
@@ -428,244 +545,129 @@ OsherSolomonNumericalFlux::OsherSolomonNumericalFlux(double kappa) : NumericalFl
 {
 }
 
-void OsherSolomonNumericalFlux::numerical_flux(double result[4], double w_L[4], double w_R[4],
-          double nx, double ny)
+// Flux in the direction of the x-axis (f_1 without the member kappa).
+static inline void osher_solomon_f_1(double result[4], const double state[4], double kappa)
 {
+  double p = QuantityCalculator::calc_pressure(state[0], state[1], state[2], state[3], kappa);
+  result[0] = state[1];
+  result[1] = state[1] * state[1] / state[0] + p;
+  result[2] = state[2] * state[1] / state[0];
+  result[3] = (state[1] / state[0]) * (state[3] + p);
+}
 
-  // At the beginning, rotate the states into the local coordinate system and store the left and right state
-  // so we do not have to pass it around.
-  Q(q_L, w_L, nx, ny);
-  Q(q_R, w_R, nx, ny);
-
-  // Decide what we have to calculate.
+// Coefficients of f_1(q_L), f_1(q_R), f_1(q_1), f_1(q_3), f_1(q_L_star), f_1(q_R_star) in the flux,
+// table 3.4.1 on the page 233 in Feist (2003); [column][row][state].
+static const double osher_solomon_table[4][4][6] =
+{
+  { { 0, 0, 0, 0, 1, 0 }, { 0, 0, 1, 0, 0, 0 }, { 0, 0, 0, 1, 0, 0 }, { 0, 0, 0, 0, 0, 1 } },
+  { { 1, 0, 0, 0, 0, 0 }, { 1, 0, 1, 0, -1, 0 }, { 1, 0, 0, 1, -1, 0 }, { 1, 0, 0, 0, -1, 1 } },
+  { { 0, 1, 0, 0, 1, -1 }, { 0, 1, 1, 0, 0, -1 }, { 0, 1, 0, 1, 0, -1 }, { 0, 1, 0, 0, 0, 0 } },
+  { { 1, 1, 0, 0, 0, -1 }, { 1, 1, 1, 0, -1, -1 }, { 1, 1, 0, 1, -1, -1 }, { 1, 1, 0, 0, -1, 0 } }
+};
+
+// Osher-Solomon flux of the states q_L, q_R already rotated into the local coordinate system of the edge.
+// All intermediate states are local, so that the kernel may be evaluated in many points at once.
+static void osher_solomon_flux_local(double result[4], double q_L[4], double q_R[4], double kappa)
+{
   // Speeds of sound.
-  a_L = QuantityCalculator::calc_sound_speed(q_L[0], q_L[1], q_L[2], q_L[3], kappa);
-  a_R = QuantityCalculator::calc_sound_speed(q_R[0], q_R[1], q_R[2], q_R[3], kappa);
-  
+  double a_L = QuantityCalculator::calc_sound_speed(q_L[0], q_L[1], q_L[2], q_L[3], kappa);
+  double a_R = QuantityCalculator::calc_sound_speed(q_R[0], q_R[1], q_R[2], q_R[3], kappa);
+  double u_L = q_L[1] / q_L[0];
+  double u_R = q_R[1] / q_R[0];
+
   // Check that we can use the following.
   double right_hand_side = 0;
   if((q_L[2] / q_L[0]) - (q_R[2] / q_R[0]) > 0)
     right_hand_side = (q_L[2] / q_L[0] - q_R[2] / q_R[0] > 0) / 2;
-  if(a_L + a_R + ((kappa - 1) * (q_L[1] / q_L[0] - q_R[1] / q_R[0]) / 2) <= right_hand_side)
+  if(a_L + a_R + ((kappa - 1) * (u_L - u_R) / 2) <= right_hand_side)
     error("Osher-Solomon numerical flux is not possible to construct according to the table.");
 
   // Utility numbers.
-  this->z_L = (0.5 * (kappa - 1) * q_L[1] / q_L[0]) + a_L;
-  this->z_R = (0.5 * (kappa - 1) * q_R[1] / q_R[0]) - a_R;
-  this->s_L = QuantityCalculator::calc_pressure(q_L[0], q_L[1], q_L[2], q_L[3], kappa) / std::pow(q_L[0], kappa);
-  this->s_R = QuantityCalculator::calc_pressure(q_R[0], q_R[1], q_R[2], q_R[3], kappa) / std::pow(q_R[0], kappa);
-  this->alpha = std::pow(s_R / s_L, 1 / (2 * kappa));
-
-  // We always need to calculate q_1, a_1, a_3, as we are going to decide what to return based on this.
-  calculate_q_1_a_1_a_3();
-
-  // First column in table 3.4.1 on the page 233 in Feist (2003).
-  if(q_R[1] / q_R[0] >= - a_R && q_L[1] / q_L[0] <= a_L) {
-    // First row.
-    if(a_1 <= q_1[1] / q_1[0]) {
-      calculate_q_L_star();
-      f_1(result, q_L_star);
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Second row.
-    if(0 < q_1[1] / q_1[0] && q_1[1] / q_1[0] < a_1) {
-      f_1(result, q_1);
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Third row.
-    if(-a_3 <= q_1[1] / q_1[0] && q_1[1] / q_1[0] <= 0) {
-      calculate_q_3();
-      f_1(result, q_3);
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Fourth row.
-    if(q_1[1] / q_1[0] < -a_3) {
-      calculate_q_R_star();
-      f_1(result, q_R_star);
-      Q_inv(result, result, nx, ny);
-      return;
-    }
+  double z_L = (0.5 * (kappa - 1) * u_L) + a_L;
+  double z_R = (0.5 * (kappa - 1) * u_R) - a_R;
+  double s_L = QuantityCalculator::calc_pressure(q_L[0], q_L[1], q_L[2], q_L[3], kappa) / std::pow(q_L[0], kappa);
+  double s_R = QuantityCalculator::calc_pressure(q_R[0], q_R[1], q_R[2], q_R[3], kappa) / std::pow(q_R[0], kappa);
+  double alpha = std::pow(s_R / s_L, 1 / (2 * kappa));
+
+  // The state q_1 decides the row of the table.
+  double q_1[4];
+  double a_1 = (z_L - z_R) / (1 + alpha);
+  q_1[0] = std::pow(a_1 / a_L, 2 / (kappa - 1)) * q_L[0];
+  q_1[1] = q_1[0] * 2 * (z_L - a_1) / (kappa - 1);
+  q_1[2] = q_1[0] * q_L[2] / q_L[0];
+  q_1[3] = QuantityCalculator::calc_energy(q_1[0], q_1[1], q_1[2], a_1 * a_1 * q_1[0] / kappa, kappa);
+  double a_3 = alpha * a_1;
+  double u_1 = q_1[1] / q_1[0];
+
+  int column = (u_R >= -a_R ? 0 : 2) + (u_L <= a_L ? 0 : 1);
+  int row = (a_1 <= u_1) ? 0 : ((0 < u_1) ? 1 : ((-a_3 <= u_1) ? 2 : 3));
+  const double* coef = osher_solomon_table[column][row];
+
+  double states[6][4];
+  for(unsigned int j = 0; j < 4; j++) {
+    states[0][j] = q_L[j];
+    states[1][j] = q_R[j];
+    states[2][j] = q_1[j];
   }
-
-  // Second column in table 3.4.1 on the page 233 in Feist (2003).
-  if(q_R[1] / q_R[0] >= - a_R && q_L[1] / q_L[0] > a_L) {
-    // First row.
-    if(a_1 <= q_1[1] / q_1[0]) {
-      f_1(result, q_L);
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Second row.
-    if(0 < q_1[1] / q_1[0] && q_1[1] / q_1[0] < a_1) {
-      calculate_q_L_star();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_L);
-      f_1(second_f_1, q_L_star);
-      f_1(third_f_1, q_1);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Third row.
-    if(-a_3 <= q_1[1] / q_1[0] && q_1[1] / q_1[0] <= 0) {
-      calculate_q_L_star();
-      calculate_q_3();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_L);
-      f_1(second_f_1, q_L_star);
-      f_1(third_f_1, q_3);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Fourth row.
-    if(q_1[1] / q_1[0] < -a_3) {
-      calculate_q_L_star();
-      calculate_q_R_star();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_L);
-      f_1(second_f_1, q_L_star);
-      f_1(third_f_1, q_R_star);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
+  if(coef[3] != 0) {
+    states[3][0] = q_1[0] / (alpha * alpha);
+    states[3][1] = states[3][0] * u_1;
+    states[3][2] = states[3][0] * q_R[2] / q_R[0];
+    states[3][3] = QuantityCalculator::calc_energy(states[3][0], states[3][1], states[3][2], a_3 * a_3 * states[3][0] / kappa, kappa);
+  }
+  if(coef[4] != 0) {
+    double a_L_star = 2 * z_L / (kappa + 1);
+    states[4][0] = std::pow(a_L_star / a_L, 2 / (kappa - 1)) * q_L[0];
+    states[4][1] = states[4][0] * a_L_star;
+    states[4][2] = q_1[0] * q_L[2] / q_L[0];
+    states[4][3] = QuantityCalculator::calc_energy(states[4][0], states[4][1], states[4][2], a_L_star * a_L_star * states[4][0] / kappa, kappa);
+  }
+  if(coef[5] != 0) {
+    double a_R_star = - 2 * z_R / (kappa + 1);
+    states[5][0] = std::pow(a_R_star / a_R, 2 / (kappa - 1)) * q_R[0];
+    states[5][1] = states[5][0] * -a_R_star;
+    states[5][2] = q_1[0] * q_R[2] / q_R[0];
+    states[5][3] = QuantityCalculator::calc_energy(states[5][0], states[5][1], states[5][2], a_R_star * a_R_star * states[5][0] / kappa, kappa);
   }
 
-  // Third column in table 3.4.1 on the page 233 in Feist (2003).
-  if(q_R[1] / q_R[0] < - a_R && q_L[1] / q_L[0] <= a_L) {
-    // First row.
-    if(a_1 <= q_1[1] / q_1[0]) {
-      calculate_q_R_star();
-      calculate_q_L_star();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_R);
-      f_1(second_f_1, q_R_star);
-      f_1(third_f_1, q_L_star);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Second row.
-    if(0 < q_1[1] / q_1[0] && q_1[1] / q_1[0] < a_1) {
-      calculate_q_R_star();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_R);
-      f_1(second_f_1, q_R_star);
-      f_1(third_f_1, q_1);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Third row.
-    if(-a_3 <= q_1[1] / q_1[0] && q_1[1] / q_1[0] <= 0) {
-      calculate_q_R_star();
-      calculate_q_3();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_R);
-      f_1(second_f_1, q_R_star);
-      f_1(third_f_1, q_3);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i];
-      return;
-    }
-    // Fourth row.
-    if(q_1[1] / q_1[0] < -a_3) {
-      f_1(result, q_R);
-      Q_inv(result, result, nx, ny);
-      return;
-    }
+  for(unsigned int j = 0; j < 4; j++)
+    result[j] = 0;
+  for(unsigned int k = 0; k < 6; k++) {
+    if(coef[k] == 0)
+      continue;
+    double f[4];
+    osher_solomon_f_1(f, states[k], kappa);
+    for(unsigned int j = 0; j < 4; j++)
+      result[j] += coef[k] * f[j];
   }
+}
 
-  // Fourth column in table 3.4.1 on the page 233 in Feist (2003).
-  if(q_R[1] / q_R[0] < - a_R && q_L[1] / q_L[0] > a_L) {
-    // First row.
-    if(a_1 <= q_1[1] / q_1[0]) {
-      calculate_q_R_star();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_L);
-      f_1(second_f_1, q_R_star);
-      f_1(third_f_1, q_R);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Second row.
-    if(0 < q_1[1] / q_1[0] && q_1[1] / q_1[0] < a_1) {
-      calculate_q_R_star();
-      calculate_q_L_star();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      double fourth_f_1[4];
-      double fifth_f_1[4];
-      f_1(first_f_1, q_L);
-      f_1(second_f_1, q_R_star);
-      f_1(third_f_1, q_R);
-      f_1(fourth_f_1, q_L_star);
-      f_1(fifth_f_1, q_1);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i] - fourth_f_1[i] + fifth_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Third row.
-    if(-a_3 <= q_1[1] / q_1[0] && q_1[1] / q_1[0] <= 0) {
-      calculate_q_R_star();
-      calculate_q_L_star();
-      calculate_q_3();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      double fourth_f_1[4];
-      double fifth_f_1[4];
-      f_1(first_f_1, q_L);
-      f_1(second_f_1, q_R_star);
-      f_1(third_f_1, q_R);
-      f_1(fourth_f_1, q_L_star);
-      f_1(fifth_f_1, q_3);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] - second_f_1[i] + third_f_1[i] - fourth_f_1[i] + fifth_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
-    }
-    // Fourth row.
-    if(q_1[1] / q_1[0] < -a_3) {
-      calculate_q_L_star();
-      double first_f_1[4];
-      double second_f_1[4];
-      double third_f_1[4];
-      f_1(first_f_1, q_L);
-      f_1(second_f_1, q_R);
-      f_1(third_f_1, q_L_star);
-      for(unsigned int i = 0; i < 4; i++)
-        result[i] = first_f_1[i] + second_f_1[i] - third_f_1[i];
-      Q_inv(result, result, nx, ny);
-      return;
+void OsherSolomonNumericalFlux::numerical_flux(double result[4], double w_L[4], double w_R[4],
+          double nx, double ny)
+{
+  // At the beginning, rotate the states into the local coordinate system.
+  double q_L_local[4], q_R_local[4];
+  Q(q_L_local, w_L, nx, ny);
+  Q(q_R_local, w_R, nx, ny);
+  osher_solomon_flux_local(result, q_L_local, q_R_local, kappa);
+  Q_inv(result, result, nx, ny);
+}
+
+void OsherSolomonNumericalFlux::numerical_flux_batch(int n, double* result[4], double* w_L[4], double* w_R[4],
+          double* nx, double* ny)
+{
+  for(int i = 0; i < n; i++) {
+    double w_L_i[4], w_R_i[4], q_L_i[4], q_R_i[4], result_i[4];
+    for(unsigned int j = 0; j < 4; j++) {
+      w_L_i[j] = w_L[j][i];
+      w_R_i[j] = w_R[j][i];
     }
+    Q(q_L_i, w_L_i, nx[i], ny[i]);
+    Q(q_R_i, w_R_i, nx[i], ny[i]);
+    osher_solomon_flux_local(result_i, q_L_i, q_R_i, kappa);
+    Q_inv(result_i, result_i, nx[i], ny[i]);
+    for(unsigned int j = 0; j < 4; j++)
+      result[j][i] = result_i[j];
   }
 }
 
@@ -805,43 +807,6 @@ double OsherSolomonNumericalFlux::numerical_flux_outlet_i(int component, double
   return result[component];
 }
 
-void OsherSolomonNumericalFlux::calculate_q_1_a_1_a_3()
-{
-  this->a_1 = (z_L - z_R) / (1 + alpha);
-  this->q_1[0] = std::pow(a_1 / a_L, 2 / (kappa - 1)) * q_L[0];
-  this->q_1[1] = this->q_1[0] * 2 * (z_L - a_1) / (kappa - 1);
-  this->q_1[2] = this->q_1[0] * this->q_L[2] / this->q_L[0] ;
-  this->q_1[3] = QuantityCalculator::calc_energy(this->q_1[0], this->q_1[1], this->q_1[2], a_1 * a_1 * q_1[0] / kappa, kappa);
-  this->a_3 = alpha * a_1;
-}
-
-void OsherSolomonNumericalFlux::calculate_q_L_star()
-{
-  this->a_L_star = 2 * z_L / (kappa + 1);
-  this->q_L_star[0] = std::pow(a_L_star / a_L, 2 / (kappa -1 )) * q_L[0];
-  this->q_L_star[1] = this->q_L_star[0] * a_L_star;
-  this->q_L_star[2] = this->q_1[0] * this->q_L[2] / this->q_L[0] ;
-  this->q_L_star[3] = QuantityCalculator::calc_energy(this->q_L_star[0], this->q_L_star[1], this->q_L_star[2], a_L_star * a_L_star * q_L_star[0] / kappa, kappa);
-}
-
-void OsherSolomonNumericalFlux::calculate_q_3()
-{
-  // a_3 already calculated.
-  this->q_3[0] = q_1[0] / (alpha * alpha);
-  this->q_3[1] = this->q_3[0] * this->q_1[1] / this->q_1[0] ;
-  this->q_3[2] = this->q_3[0] * this->q_R[2] / this->q_R[0] ;
-  this->q_3[3] = QuantityCalculator::calc_energy(this->q_3[0], this->q_3[1], this->q_3[2], a_3 * a_3 * q_3[0] / kappa, kappa);
-}
-
-void OsherSolomonNumericalFlux::calculate_q_R_star()
-{
-  this->a_R_star = - 2 * z_R / (kappa + 1);
-  this->q_R_star[0] = std::pow(a_R_star / a_R, 2 / (kappa -1 )) * q_R[0];
-  this->q_R_star[1] = this->q_R_star[0] * -a_R_star;
-  this->q_R_star[2] = this->q_1[0] * this->q_R[2] / this->q_R[0] ;
-  this->q_R_star[3] = QuantityCalculator::calc_energy(this->q_R_star[0], this->q_R_star[1], this->q_R_star[2], a_R_star * a_R_star * q_R_star[0] / kappa, kappa);
-}
-
 double OsherSolomonNumericalFlux::numerical_flux_i(int component, double w_L[4], double w_R[4],
           double nx, double ny)
 {
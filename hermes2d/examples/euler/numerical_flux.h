@@ -17,6 +17,13 @@ public:
   virtual double numerical_flux_i(int component, double w_L[4], double w_R[4],
           double nx, double ny) = 0;
 
+  /// Calculates all components of the flux in n points (all quadrature points of a face) at once.
+  /// The states and the result are stored by components, w_L[c][i] is the component c in the point i,
+  /// so that the loops over the points can be vectorized. The default implementation calls
+  /// numerical_flux() in every point.
+  virtual void numerical_flux_batch(int n, double* result[4], double* w_L[4], double* w_R[4],
+          double* nx, double* ny);
+
   virtual void numerical_flux_solid_wall(double result[4], double w_L[4], double nx, double ny) = 0;
   
   virtual double numerical_flux_solid_wall_i(int component, double w_L[4], double nx, double ny) = 0;
@@ -43,16 +50,40 @@ public:
   double kappa;
 };
 
+/// Vijayasundaram flux, F(w_L, w_R, n) = P^+(w, n) w_L + P^-(w, n) w_R, where w = (w_L + w_R) / 2 and
+/// P^+, P^- are the positive and negative parts of the Jacobian of the flux in the direction n.
+/// The products with P^+, P^- are evaluated directly from the eigenvectors of the Jacobian, without
+/// any branches, so that numerical_flux_batch() vectorizes.
 class VijayasundaramNumericalFlux : public NumericalFlux
 {
 public:
-  VijayasundaramNumericalFlux();
+  VijayasundaramNumericalFlux(double kappa);
 
   virtual void numerical_flux(double result[4], double w_L[4], double w_R[4],
           double nx, double ny);
   
   virtual double numerical_flux_i(int component, double w_L[4], double w_R[4],
           double nx, double ny);
+
+  virtual void numerical_flux_batch(int n, double* result[4], double* w_L[4], double* w_R[4],
+          double* nx, double* ny);
+
+  /// The solid wall flux contains only the pressure.
+  virtual void numerical_flux_solid_wall(double result[4], double w_L[4], double nx, double ny);
+  
+  virtual double numerical_flux_solid_wall_i(int component, double w_L[4], double nx, double ny);
+
+  /// The boundary state w_B is used as the state outside.
+  virtual void numerical_flux_inlet(double result[4], double w_L[4], double w_B[4],
+          double nx, double ny);
+  
+  virtual double numerical_flux_inlet_i(int component, double w_L[4], double w_B[4],
+          double nx, double ny);
+
+  /// The state outside is w_L with the pressure prescribed.
+  virtual void numerical_flux_outlet(double result[4], double w_L[4], double pressure, double nx, double ny);
+  
+  virtual double numerical_flux_outlet_i(int component, double w_L[4], double pressure, double nx, double ny);
 };
 
 class StegerWarmingNumericalFlux : public NumericalFlux
@@ -135,6 +166,10 @@ public:
   virtual double numerical_flux_i(int component, double w_L[4], double w_R[4],
           double nx, double ny);
 
+  /// Uses the same (stateless) kernel as numerical_flux(), the class members are not touched.
+  virtual void numerical_flux_batch(int n, double* result[4], double* w_L[4], double* w_R[4],
+          double* nx, double* ny);
+
   virtual void numerical_flux_solid_wall(double result[4], double w_L[4], double nx, double ny);
   
   virtual double numerical_flux_solid_wall_i(int component, double w_L[4], double nx, double ny);
@@ -150,15 +185,6 @@ public:
   virtual double numerical_flux_outlet_i(int component, double w_L[4], double pressure, double nx, double ny);
 
 protected:
-  void calculate_q_1_a_1_a_3();
-  
-  void calculate_q_L_star();
-
-  void calculate_q_3();
-
-  void calculate_q_R_star();
-
-
   // States.
   double q_L[4];
   double q_R[4];
@@ -176,10 +202,6 @@ protected:
   double a_1;
   double a_3;
   double a_B; // Boundary.
-
-  // Utility quantities.
-  double z_L, z_R, s_L, s_R, alpha;
-
 };
 
 #endif
\ No newline at end of file
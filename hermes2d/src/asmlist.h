@@ -65,6 +65,16 @@ public:
 
   void clear() { cnt = 0; }
 
+  /// Replaces the contents of the list by 'n' triplets given by the arrays i, d and c.
+  void copy(const int* i, const int* d, const scalar* c, unsigned int n)
+  {
+    while (cap < n) enlarge();
+    memcpy(idx, i, sizeof(int) * n);
+    memcpy(dof, d, sizeof(int) * n);
+    memcpy(coef, c, sizeof(scalar) * n);
+    cnt = n;
+  }
+
   inline void add_triplet(int i, int d, scalar c)
   {
     if (cnt >= cap) enlarge();
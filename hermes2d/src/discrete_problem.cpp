@@ -64,6 +64,8 @@ void DiscreteProblem::init()
   matrix_buffer = NULL;
   matrix_buffer_dim = 0;
   have_matrix = false;
+  current_stage_num = 0;
+  current_state_num = 0;
   values_changed = true;
   struct_changed = true;
 
@@ -96,6 +98,8 @@ void DiscreteProblem::init()
 
   vector_valued_forms = false;
 
+  condensation = NULL;
+
   Geom<Ord> *tmp = init_geom_ord();
   geom_ord = *tmp;
   delete tmp;
@@ -106,11 +110,22 @@ DiscreteProblem::~DiscreteProblem()
   _F_
   free();
   if (sp_seq != NULL) delete [] sp_seq;
+  if (condensation != NULL) delete condensation;
   if (pss != NULL) {
     for(int i = 0; i < num_user_pss; i++)
       delete pss[i];
     delete [] pss;
   }
+
+  // Deinitialize the DG caches and neighbor pss's, refmaps.
+  for(unsigned int i = 0; i < dg_face_cache.size(); i++)
+    dg_face_cache[i].free();
+  for(std::map<unsigned int, PrecalcShapeset *>::iterator it = dg_nspss.begin(); it != dg_nspss.end(); it++)
+    delete it->second;
+  for(std::map<unsigned int, PrecalcShapeset *>::iterator it = dg_npss.begin(); it != dg_npss.end(); it++)
+    delete it->second;
+  for(std::map<unsigned int, RefMap *>::iterator it = dg_nrefmap.begin(); it != dg_nrefmap.end(); it++)
+    delete it->second;
 }
 
 void DiscreteProblem::free()
@@ -131,6 +146,37 @@ int DiscreteProblem::get_num_dofs()
   return ndof;
 }
 
+void DiscreteProblem::set_static_condensation(bool enable)
+{
+  _F_
+  if (enable == (condensation != NULL)) return;
+  if (enable)
+    condensation = new StaticCondensation;
+  else
+  {
+    delete condensation;
+    condensation = NULL;
+  }
+  // the matrix has a different size now
+  have_matrix = false;
+}
+
+int DiscreteProblem::get_num_skeleton_dofs()
+{
+  _F_
+  if (condensation == NULL) return get_num_dofs();
+  if (!is_up_to_date()) condensation->init(spaces, get_num_dofs());
+  return condensation->get_num_dofs();
+}
+
+void DiscreteProblem::expand_condensed_solution(scalar* skeleton_sln, scalar* sln, 
+                                                double rhs_factor, int num_threads)
+{
+  _F_
+  if (condensation == NULL) error("Static condensation is not switched on.");
+  condensation->expand(skeleton_sln, sln, rhs_factor, num_threads);
+}
+
 scalar** DiscreteProblem::get_matrix_buffer(int n)
 {
   _F_
@@ -213,6 +259,14 @@ void DiscreteProblem::create_sparse_structure(SparseMatrix* mat, Vector* rhs,
 
   int ndof = get_num_dofs();
 
+  // With static condensation, only the skeleton DOFs are in the matrix.
+  if (condensation != NULL)
+  {
+    if (is_DG) error("Static condensation can not be used with DG forms.");
+    condensation->init(spaces, ndof);
+    ndof = condensation->get_num_dofs();
+  }
+
   if (mat != NULL)  
   {
     // Spaces have changed: create the matrix from scratch.
@@ -221,6 +275,7 @@ void DiscreteProblem::create_sparse_structure(SparseMatrix* mat, Vector* rhs,
     mat->prealloc(ndof);
 
     AsmList* al = new AsmList[wf->get_neq()];
+    AsmList an; // assembly list of a neighbor which is not cached in its space
     Mesh** meshes = new Mesh*[wf->get_neq()];
     bool **blocks = wf->get_blocks(force_diagonal_blocks);
 
@@ -237,6 +292,7 @@ void DiscreteProblem::create_sparse_structure(SparseMatrix* mat, Vector* rhs,
       for (unsigned int i = 0; i < wf->get_neq(); i++) {
         // TODO: do not get the assembly list again if the element was not changed.
         if (e[i] != NULL) spaces[i]->get_element_assembly_list(e[i], &(al[i]));
+        if (e[i] != NULL && condensation != NULL) condensation->map_dofs(&(al[i]));
       }
 
       if(is_DG) {
@@ -288,22 +344,23 @@ void DiscreteProblem::create_sparse_structure(SparseMatrix* mat, Vector* rhs,
               for(int neigh = 0; neigh < neighbor_elems_counts[el][ed]; neigh++) {
                 if ((blocks[m][el] || blocks[el][m]) && e[m] != NULL)  {
                   AsmList *am = &(al[m]);
-                  AsmList *an = new AsmList;
-                  spaces[el]->get_element_assembly_list(neighbor_elems_arrays[el][ed][neigh], an);
+                  const int *an_idx, *an_dof;
+                  const scalar* an_coef;
+                  int an_cnt = spaces[el]->get_element_assembly_list(neighbor_elems_arrays[el][ed][neigh],
+                                                                      an_idx, an_dof, an_coef, &an);
 
                   // pretend assembling of the element stiffness matrix
                   // register nonzero elements
                   for (unsigned int i = 0; i < am->cnt; i++) {
                     if (am->dof[i] >= 0) {
-                      for (unsigned int j = 0; j < an->cnt; j++) {
-                        if (an->dof[j] >= 0) {
-                          if(blocks[m][el]) mat->pre_add_ij(am->dof[i], an->dof[j]);
-                          if(blocks[el][m]) mat->pre_add_ij(an->dof[j], am->dof[i]);
+                      for (int j = 0; j < an_cnt; j++) {
+                        if (an_dof[j] >= 0) {
+                          if(blocks[m][el]) mat->pre_add_ij(am->dof[i], an_dof[j]);
+                          if(blocks[el][m]) mat->pre_add_ij(an_dof[j], am->dof[i]);
                         }
                       }
                     }
                   }
-                  delete an;
                 }
               }
             }
@@ -483,12 +540,27 @@ void DiscreteProblem::assemble(scalar* coeff_vec, SparseMatrix* mat,
   bool want_vector = (rhs != NULL);
   wf->get_stages(spaces, u_ext, stages, want_matrix, want_vector);
 
+  // Bubbles are condensed element by element, so all forms have to be assembled in the
+  // same states.
+  if (condensation != NULL)
+  {
+    if (stages.size() > 1 || !wf->ffsurf.empty())
+      error("Static condensation needs one assembling stage and no flux forms.");
+    condensation->begin_assembling(want_matrix);
+  }
+
+  // Flux forms only depend on the external functions, they have no Jacobian, so they cannot
+  // be used in Newton's method (the matrix would silently miss their linearization).
+  if (!wf->ffsurf.empty() && coeff_vec != NULL && mat != NULL)
+    error("Flux forms contribute to the right-hand side only, they cannot be used with the Jacobian.");
+
   // Loop through all assembling stages -- the purpose of this is increased performance
   // in multi-mesh calculations, where, e.g., only the right hand side uses two meshes.
   // In such a case, the matrix forms are assembled over one mesh, and only the rhs
   // traverses through the union mesh. On the other hand, if you don't use multi-mesh
   // at all, there will always be only one stage in which all forms are assembled as usual.
   for (unsigned ss = 0; ss < stages.size(); ss++) {
+    current_stage_num = ss;
     // Assemble one stage. One stage is a collection of functions, 
     // and meshes that can not be further minimized.
     // E.g. if a linear form uses two external solutions, each of 
@@ -500,6 +572,9 @@ void DiscreteProblem::assemble(scalar* coeff_vec, SparseMatrix* mat,
                        block_weights, spss, refmap, u_ext);
   }
 
+  // Face-based fluxes are assembled outside the stages.
+  assemble_flux_forms(rhs, spss, refmap);
+
   // Deinitialize matrix buffer.
   if(matrix_buffer != NULL)
     delete [] matrix_buffer;
@@ -571,7 +646,12 @@ void DiscreteProblem::assemble_one_stage(WeakForm::Stage& stage,
 
   // Loop through all assembling states.
   // Assemble each one.
+  // The neighborhoods of inner edges are reused if the meshes have not changed.
+  if(DG_matrix_forms_present || DG_vector_forms_present)
+    init_dg_face_cache(stage);
+
   Element** e;
+  current_state_num = 0;
   while ((e = trav.get_next_state(bnd, surf_pos)) != NULL) {
     // One state is a collection of (virtual) elements sharing 
     // the same physical location on (possibly) different meshes.
@@ -582,6 +662,7 @@ void DiscreteProblem::assemble_one_stage(WeakForm::Stage& stage,
     assemble_one_state(stage, matrix, rhs, force_diagonal_blocks, 
                        block_weights, spss, refmap, 
                        u_ext, e, bnd, surf_pos, trav.get_base());
+    current_state_num++;
   }
 
   if (matrix != NULL) matrix->finish();
@@ -668,6 +749,19 @@ void DiscreteProblem::assemble_one_state(WeakForm::Stage& stage,
   if(rep_element == NULL)
     return;
 
+  // With static condensation, the forms are assembled into the element system, which
+  // is condensed and added to the global one at the end of the state.
+  SparseMatrix* global_matrix = matrix;
+  Vector* global_rhs = rhs;
+  if (condensation != NULL) {
+    for (unsigned int i = 0; i < stage.idx.size(); i++)
+      if (e[i] != NULL && stage.fns[i]->get_transform() != 0)
+        error("Static condensation needs the same elements in all spaces.");
+    condensation->begin_element(current_state_num, stage.idx, al, matrix != NULL, rhs != NULL);
+    if (matrix != NULL) matrix = condensation->get_element_matrix();
+    if (rhs != NULL) rhs = condensation->get_element_vector();
+  }
+
   init_cache();
 
   /// Assemble volume matrix forms.
@@ -699,6 +793,9 @@ void DiscreteProblem::assemble_one_state(WeakForm::Stage& stage,
                               nat, isurf, e, trav_base, rep_element);
   }
 
+  if (condensation != NULL)
+    condensation->end_element(global_matrix, global_rhs);
+
   // Delete assembly lists.
   for(unsigned int i = 0; i < wf->get_neq(); i++) 
     delete al[i];
@@ -1058,51 +1155,61 @@ void DiscreteProblem::assemble_DG_forms(WeakForm::Stage& stage,
     if(stage.meshes[i]->get_seq() < min_dg_mesh_seq || i == 0)
       min_dg_mesh_seq = stage.meshes[i]->get_seq();
   
-  // Initialize the NeighborSearches.
+  // Take the neighborhoods of this edge from the cache if they have already 
+  // been calculated for these meshes.
   // 5 is for bits per page in the array.
-  LightArray<NeighborSearch*> neighbor_searches(5);
-  init_neighbors(neighbor_searches, stage, isurf);
-
-  // Create a multimesh tree;
-  DiscreteProblem::NeighborNode* root = new DiscreteProblem::NeighborNode(NULL, 0);
-  build_multimesh_tree(root, neighbor_searches);
-    
-  // Update all NeighborSearches according to the multimesh tree.
-  // After this, all NeighborSearches in neighbor_searches should have the same count 
-  // of neighbors and proper set of transformations
-  // for the central and the neighbor element(s) alike.
-  // Also check that every NeighborSearch has the same number of neighbor elements.
+  LightArray<NeighborSearch*> new_neighbor_searches(5);
   unsigned int num_neighbors = 0;
-  for(unsigned int i = 0; i < neighbor_searches.get_size(); i++)
-    if(neighbor_searches.present(i)) {
-      NeighborSearch* ns = neighbor_searches.get(i);
-      update_neighbor_search(ns, root);
-      if(num_neighbors == 0)
-        num_neighbors = ns->n_neighbors;
-      if(ns->n_neighbors != num_neighbors)
-        error("Num_neighbors of different NeighborSearches not matching in DiscreteProblem::assemble_surface_integrals().");
-    }
+  bool cached = load_dg_face(stage, isurf, num_neighbors);
+  LightArray<NeighborSearch*>& neighbor_searches = cached ? *dg_face_cache[current_stage_num].pool : new_neighbor_searches;
+
+  if(!cached) {
+    // Initialize the NeighborSearches.
+    init_neighbors(neighbor_searches, stage, isurf);
+
+    // Create a multimesh tree;
+    DiscreteProblem::NeighborNode* root = new DiscreteProblem::NeighborNode(NULL, 0);
+    build_multimesh_tree(root, neighbor_searches);
+      
+    // Update all NeighborSearches according to the multimesh tree.
+    // After this, all NeighborSearches in neighbor_searches should have the same count 
+    // of neighbors and proper set of transformations
+    // for the central and the neighbor element(s) alike.
+    // Also check that every NeighborSearch has the same number of neighbor elements.
+    for(unsigned int i = 0; i < neighbor_searches.get_size(); i++)
+      if(neighbor_searches.present(i)) {
+        NeighborSearch* ns = neighbor_searches.get(i);
+        update_neighbor_search(ns, root);
+        if(num_neighbors == 0)
+          num_neighbors = ns->n_neighbors;
+        if(ns->n_neighbors != num_neighbors)
+          error("Num_neighbors of different NeighborSearches not matching in DiscreteProblem::assemble_surface_integrals().");
+      }
 
-  // Create neighbor psss, refmaps.
-  std::map<unsigned int, PrecalcShapeset *> npss;
-  std::map<unsigned int, PrecalcShapeset *> nspss;
-  std::map<unsigned int, RefMap *> nrefmap;
+    // Delete the multimesh tree;
+    delete root;
+
+    store_dg_face(neighbor_searches, num_neighbors, isurf);
+  }
 
   // Initialize neighbor precalc shapesets and refmaps.      
   // This is only needed when there are matrix DG forms present.
+  // They are created only once and used for all edges.
   if(DG_matrix_forms_present)
     for (unsigned int i = 0; i < stage.idx.size(); i++) {
-      PrecalcShapeset* new_ps = new PrecalcShapeset(pss[i]->get_shapeset());
+      if(dg_npss.find(stage.idx[i]) != dg_npss.end())
+        continue;
+      PrecalcShapeset* new_ps = new PrecalcShapeset(pss[stage.idx[i]]->get_shapeset());
       new_ps->set_quad_2d(&g_quad_2d_std);
-      npss.insert(std::pair<unsigned int, PrecalcShapeset*>(stage.idx[i], new_ps));
+      dg_npss.insert(std::pair<unsigned int, PrecalcShapeset*>(stage.idx[i], new_ps));
 
       PrecalcShapeset* new_pss = new PrecalcShapeset(new_ps);
       new_pss->set_quad_2d(&g_quad_2d_std);
-      nspss.insert(std::pair<unsigned int, PrecalcShapeset*>(stage.idx[i], new_pss));
+      dg_nspss.insert(std::pair<unsigned int, PrecalcShapeset*>(stage.idx[i], new_pss));
 
       RefMap* new_rm = new RefMap();
       new_rm->set_quad_2d(&g_quad_2d_std);
-      nrefmap.insert(std::pair<unsigned int, RefMap*>(stage.idx[i], new_rm));
+      dg_nrefmap.insert(std::pair<unsigned int, RefMap*>(stage.idx[i], new_rm));
     }
 
   for(unsigned int neighbor_i = 0; neighbor_i < num_neighbors; neighbor_i++) {
@@ -1131,34 +1238,155 @@ void DiscreteProblem::assemble_DG_forms(WeakForm::Stage& stage,
 
     assemble_DG_one_neighbor(processed, neighbor_i, stage, mat, rhs, 
                              force_diagonal_blocks, block_weights, spss, refmap, 
-                             npss, nspss, nrefmap, neighbor_searches, u_ext, isempty, 
+                             dg_npss, dg_nspss, dg_nrefmap, neighbor_searches, u_ext, isempty, 
                              marker, al, bnd, surf_pos, nat, isurf, e, trav_base, rep_element);
   }
 
-  // Delete the multimesh tree;
-  delete root;
+  // Delete the new NeighborSearches, the pooled ones only 
+  // release the extended shapesets (they refer to the assembly 
+  // lists of this state).
+  for(unsigned int i = 0; i < neighbor_searches.get_size(); i++) 
+    if(neighbor_searches.present(i)) {
+      if(cached)
+        neighbor_searches.get(i)->clear_supported_shapes();
+      else
+        delete neighbor_searches.get(i);
+    }
+}
 
-  // Deinitialize neighbor pss's, refmaps.
-  if(DG_matrix_forms_present) {
-    for(std::map<unsigned int, PrecalcShapeset *>::iterator it = nspss.begin(); it != nspss.end(); it++)
-      delete it->second;
-    for(std::map<unsigned int, PrecalcShapeset *>::iterator it = npss.begin(); it != npss.end(); it++)
-      delete it->second;
-    for(std::map<unsigned int, RefMap *>::iterator it = nrefmap.begin(); it != nrefmap.end(); it++)
-      delete it->second;
+void DiscreteProblem::DGFaceCache::free()
+{
+  _F_
+  meshes.clear();
+  mesh_seqs.clear();
+  face_index.clear();
+  faces.clear();
+  neighborhoods.clear();
+  neighbors.clear();
+  if(pool != NULL) {
+    for(unsigned int i = 0; i < pool->get_size(); i++) 
+      if(pool->present(i))
+        delete pool->get(i);
+    delete pool;
+    pool = NULL;
   }
+}
 
-  // Delete the neighbor_searches array.
-  for(unsigned int i = 0; i < neighbor_searches.get_size(); i++) 
-    if(neighbor_searches.present(i))
-      delete neighbor_searches.get(i);
+void DiscreteProblem::init_dg_face_cache(WeakForm::Stage& stage)
+{
+  _F_
+  if(dg_face_cache.size() <= current_stage_num)
+    dg_face_cache.resize(current_stage_num + 1);
+  DGFaceCache& cache = dg_face_cache[current_stage_num];
+
+  bool up_to_date = (cache.meshes.size() == stage.meshes.size());
+  for(unsigned int i = 0; i < stage.meshes.size() && up_to_date; i++)
+    if(cache.meshes[i] != stage.meshes[i] || cache.mesh_seqs[i] != stage.meshes[i]->get_seq())
+      up_to_date = false;
+  if(up_to_date)
+    return;
+
+  cache.free();
+  for(unsigned int i = 0; i < stage.meshes.size(); i++) {
+    cache.meshes.push_back(stage.meshes[i]);
+    cache.mesh_seqs.push_back(stage.meshes[i]->get_seq());
+  }
+}
+
+void DiscreteProblem::store_dg_face(LightArray<NeighborSearch*>& neighbor_searches, 
+                                    unsigned int num_neighbors, int isurf)
+{
+  _F_
+  DGFaceCache& cache = dg_face_cache[current_stage_num];
+  unsigned int key = current_state_num * 4 + isurf;
+  if(cache.face_index.size() <= key)
+    cache.face_index.resize(key + 1, -1);
+
+  DGFaceCache::Face face;
+  face.first_neighborhood = cache.neighborhoods.size();
+  face.n_neighborhoods = 0;
+  face.num_neighbors = num_neighbors;
+  for(unsigned int i = 0; i < neighbor_searches.get_size(); i++)
+    if(neighbor_searches.present(i)) {
+      NeighborSearch* ns = neighbor_searches.get(i);
+      DGFaceCache::Neighborhood nh;
+      nh.ns_index = i;
+      nh.central_el_id = ns->central_el->id;
+      nh.original_central_el_transform = ns->original_central_el_transform;
+      nh.active_edge = ns->active_edge;
+      nh.neighborhood_type = ns->neighborhood_type;
+      nh.first_neighbor = cache.neighbors.size();
+      nh.n_neighbors = ns->n_neighbors;
+      for(unsigned int j = 0; j < ns->n_neighbors; j++) {
+        DGFaceCache::Neighbor nb;
+        nb.el_id = ns->neighbors[j]->id;
+        nb.local_num_of_edge = ns->neighbor_edges[j].local_num_of_edge;
+        nb.orientation = ns->neighbor_edges[j].orientation;
+        nb.central_n_trans = ns->central_n_trans[j];
+        nb.neighbor_n_trans = ns->neighbor_n_trans[j];
+        memcpy(nb.central_transformations, ns->central_transformations[j], nb.central_n_trans * sizeof(unsigned int));
+        memcpy(nb.neighbor_transformations, ns->neighbor_transformations[j], nb.neighbor_n_trans * sizeof(unsigned int));
+        cache.neighbors.push_back(nb);
+      }
+      cache.neighborhoods.push_back(nh);
+      face.n_neighborhoods++;
+    }
+  cache.face_index[key] = cache.faces.size();
+  cache.faces.push_back(face);
+}
+
+bool DiscreteProblem::load_dg_face(WeakForm::Stage& stage, int isurf, unsigned int& num_neighbors)
+{
+  _F_
+  DGFaceCache& cache = dg_face_cache[current_stage_num];
+  unsigned int key = current_state_num * 4 + isurf;
+  if(cache.face_index.size() <= key || cache.face_index[key] < 0)
+    return false;
+  DGFaceCache::Face& face = cache.faces[cache.face_index[key]];
+
+  // Create the pool, one NeighborSearch per mesh (as in init_neighbors()).
+  if(cache.pool == NULL) {
+    cache.pool = new LightArray<NeighborSearch*>(5);
+    for(unsigned int i = 0; i < stage.meshes.size(); i++)
+      if(!cache.pool->present(stage.meshes[i]->get_seq() - min_dg_mesh_seq))
+        cache.pool->add(new NeighborSearch(stage.fns[i]->get_active_element(), stage.meshes[i]), 
+                        stage.meshes[i]->get_seq() - min_dg_mesh_seq);
+  }
+
+  for(unsigned int k = 0; k < face.n_neighborhoods; k++) {
+    DGFaceCache::Neighborhood& nh = cache.neighborhoods[face.first_neighborhood + k];
+    NeighborSearch* ns = cache.pool->get(nh.ns_index);
+    ns->central_el = ns->mesh->get_element_fast(nh.central_el_id);
+    ns->original_central_el_transform = nh.original_central_el_transform;
+    ns->active_edge = nh.active_edge;
+    ns->neighborhood_type = (NeighborSearch::NeighborhoodType) nh.neighborhood_type;
+    ns->active_segment = 0;
+    ns->neighb_el = NULL;
+    ns->neighbors.clear();
+    ns->neighbor_edges.clear();
+    ns->n_neighbors = nh.n_neighbors;
+    for(unsigned int j = 0; j < nh.n_neighbors; j++) {
+      DGFaceCache::Neighbor& nb = cache.neighbors[nh.first_neighbor + j];
+      NeighborSearch::NeighborEdgeInfo edge_info;
+      edge_info.local_num_of_edge = nb.local_num_of_edge;
+      edge_info.orientation = nb.orientation;
+      ns->neighbors.push_back(ns->mesh->get_element_fast(nb.el_id));
+      ns->neighbor_edges.push_back(edge_info);
+      ns->central_n_trans[j] = nb.central_n_trans;
+      ns->neighbor_n_trans[j] = nb.neighbor_n_trans;
+      memcpy(ns->central_transformations[j], nb.central_transformations, nb.central_n_trans * sizeof(unsigned int));
+      memcpy(ns->neighbor_transformations[j], nb.neighbor_transformations, nb.neighbor_n_trans * sizeof(unsigned int));
+    }
+  }
+  num_neighbors = face.num_neighbors;
+  return true;
 }
 
 
 void DiscreteProblem::assemble_DG_one_neighbor(bool edge_processed, unsigned int neighbor_i, WeakForm::Stage& stage, 
       SparseMatrix* mat, Vector* rhs, bool force_diagonal_blocks, Table* block_weights,
-       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *> npss,
-       std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
+       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *>& npss,
+       std::map<unsigned int, PrecalcShapeset *>& nspss, std::map<unsigned int, RefMap *>& nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
        Hermes::vector<bool>& isempty, int marker, Hermes::vector<AsmList *>& al, bool bnd, SurfPos& surf_pos, Hermes::vector<bool>& nat, 
        int isurf, Element** e, Element* trav_base, Element* rep_element)
 {
@@ -1177,10 +1405,12 @@ void DiscreteProblem::assemble_DG_one_neighbor(bool edge_processed, unsigned int
     for(unsigned int trf_i = 0; trf_i < neighbor_searches.get(stage.meshes[fns_i]->get_seq() - min_dg_mesh_seq)->central_n_trans[neighbor_i]; trf_i++)
       stage.fns[fns_i]->push_transform(neighbor_searches.get(stage.meshes[fns_i]->get_seq() - min_dg_mesh_seq)->central_transformations[neighbor_i][trf_i]);
   
-  // For neighbor psss.
+  // For neighbor psss (they are used for all edges, so the transformations of the previous
+  // neighbor have to be dropped).
   if(DG_matrix_forms_present && !edge_processed)
     for(unsigned int idx_i = 0; idx_i < stage.idx.size(); idx_i++) {
       npss[stage.idx[idx_i]]->set_active_element((*neighbor_searches.get(stage.meshes[idx_i]->get_seq() - min_dg_mesh_seq)->get_neighbors())[neighbor_i]);
+      npss[stage.idx[idx_i]]->reset_transform();
       for(unsigned int trf_i = 0; trf_i < neighbor_searches.get(stage.meshes[idx_i]->get_seq() - min_dg_mesh_seq)->neighbor_n_trans[neighbor_i]; trf_i++)
         npss[stage.idx[idx_i]]->push_transform(neighbor_searches.get(stage.meshes[idx_i]->get_seq() - min_dg_mesh_seq)->neighbor_transformations[neighbor_i][trf_i]);
     }
@@ -1791,8 +2021,8 @@ void DiscreteProblem::assemble_multicomponent_surface_vector_forms(WeakForm::Sta
 void DiscreteProblem::assemble_DG_matrix_forms(WeakForm::Stage& stage, 
        SparseMatrix* mat, Vector* rhs, bool force_diagonal_blocks, 
        Table* block_weights, Hermes::vector<PrecalcShapeset *>& spss, 
-       Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *> npss,
-       std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap, 
+       Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *>& npss,
+       std::map<unsigned int, PrecalcShapeset *>& nspss, std::map<unsigned int, RefMap *>& nrefmap, 
        LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
        Hermes::vector<bool>& isempty, int marker, Hermes::vector<AsmList *>& al, bool bnd, 
        SurfPos& surf_pos, Hermes::vector<bool>& nat, int isurf, Element** e, 
@@ -1882,8 +2112,8 @@ void DiscreteProblem::assemble_DG_matrix_forms(WeakForm::Stage& stage,
 void DiscreteProblem::assemble_multicomponent_DG_matrix_forms(WeakForm::Stage& stage, 
        SparseMatrix* mat, Vector* rhs, bool force_diagonal_blocks, 
        Table* block_weights, Hermes::vector<PrecalcShapeset *>& spss, 
-       Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *> npss,
-       std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap, 
+       Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *>& npss,
+       std::map<unsigned int, PrecalcShapeset *>& nspss, std::map<unsigned int, RefMap *>& nrefmap, 
        LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
        Hermes::vector<bool>& isempty, int marker, Hermes::vector<AsmList *>& al, bool bnd, 
        SurfPos& surf_pos, Hermes::vector<bool>& nat, int isurf, Element** e, 
@@ -2050,6 +2280,190 @@ void DiscreteProblem::assemble_multicomponent_DG_vector_forms(WeakForm::Stage& s
   }
 }
 
+void DiscreteProblem::assemble_flux_forms(Vector* rhs, Hermes::vector<PrecalcShapeset *>& spss, 
+                                          Hermes::vector<RefMap *>& refmap)
+{
+  _F_
+
+  if (rhs == NULL) return;
+
+  Quad2D* quad = &g_quad_2d_std;
+  for (unsigned int ww = 0; ww < wf->ffsurf.size(); ww++) {
+    WeakForm::FluxFormSurf* ffs = wf->ffsurf[ww];
+    if (fabs(ffs->scaling_factor) < 1e-12) continue;
+
+    unsigned int nc = ffs->coordinates.size();
+    unsigned int nf = ffs->ext.size();
+    Mesh* mesh = spaces[ffs->coordinates[0]]->get_mesh();
+    for (unsigned int c = 0; c < nc; c++)
+      if (spaces[ffs->coordinates[c]]->get_mesh()->get_seq() != mesh->get_seq())
+        error("All spaces of a flux form have to be defined on the same mesh.");
+    for (unsigned int j = 0; j < nf; j++)
+      if (ffs->ext[j]->get_mesh()->get_seq() != mesh->get_seq())
+        error("External functions of a flux form have to be defined on the mesh of its spaces.");
+
+    // Traces and fluxes in the quadrature points of the current face, stored by components.
+    std::vector<scalar> buffer;
+    std::vector<scalar*> w_L(nf), w_R(nf), flux(nc);
+    std::vector<double> nx, ny, jwt;
+
+    RefMap* rm = refmap[ffs->coordinates[0]];
+    NeighborSearch* ns = NULL;
+    AsmList al;
+    Element* e;
+    for_all_active_elements(e, mesh) {
+      rm->set_active_element(e);
+      for (unsigned int j = 0; j < nf; j++)
+        ffs->ext[j]->set_active_element(e);
+
+      for (unsigned int isurf = 0; isurf < e->nvert; isurf++) {
+        bool bnd = (e->en[isurf]->bnd != 0);
+        int test_order = 0, ext_order = 0;
+        for (unsigned int c = 0; c < nc; c++)
+          test_order = std::max(test_order, spaces[ffs->coordinates[c]]->get_edge_order(e, isurf));
+        for (unsigned int j = 0; j < nf; j++)
+          ext_order = std::max(ext_order, ffs->ext[j]->get_edge_fn_order(isurf));
+
+        if (!bnd) {
+          if (ns == NULL)
+            ns = new NeighborSearch(e, mesh);
+          else
+            ns->central_el = e;
+          ns->set_active_edge(isurf);
+
+          // Every face is assembled once: from the smaller element, and from the one with
+          // the smaller id if the elements are of the same size.
+          if (ns->neighborhood_type == NeighborSearch::H2D_DG_GO_DOWN)
+            continue;
+          if (ns->neighborhood_type == NeighborSearch::H2D_DG_NO_TRANSF && ns->neighbors[0]->id < e->id)
+            continue;
+          ns->active_segment = 0;
+          ns->neighb_el = ns->neighbors[0];
+          ns->neighbor_edge = ns->neighbor_edges[0];
+
+          // The order on the other side.
+          Element* neighb = ns->neighb_el;
+          int neighb_edge = ns->neighbor_edge.local_num_of_edge;
+          for (unsigned int c = 0; c < nc; c++)
+            test_order = std::max(test_order, spaces[ffs->coordinates[c]]->get_edge_order(neighb, neighb_edge));
+          for (unsigned int j = 0; j < nf; j++) {
+            ffs->ext[j]->set_active_element(neighb);
+            ext_order = std::max(ext_order, ffs->ext[j]->get_edge_fn_order(neighb_edge));
+            ffs->ext[j]->set_active_element(e);
+          }
+        }
+
+        int order = ffs->ord(ext_order, test_order) + rm->get_inv_ref_order();
+        limit_order(order);
+
+        int eo;
+        if (bnd) {
+          quad->set_mode(e->get_mode());
+          eo = quad->get_edge_points(isurf, order);
+        }
+        else {
+          ns->set_quad_order(order);
+          eo = ns->get_quad_eo(false);
+        }
+        int np = quad->get_num_points(eo);
+        double3* pt = quad->get_points(eo);
+
+        if (buffer.size() < (2 * nf + nc) * np)
+          buffer.resize((2 * nf + nc) * np);
+        for (unsigned int j = 0; j < nf; j++) {
+          w_L[j] = &buffer[j * np];
+          w_R[j] = &buffer[(nf + j) * np];
+        }
+        for (unsigned int c = 0; c < nc; c++)
+          flux[c] = &buffer[(2 * nf + c) * np];
+
+        // Geometry (the central element is the smaller one, so its edge is the whole face).
+        double3* tan = rm->get_tangent(isurf, eo);
+        nx.resize(np); ny.resize(np); jwt.resize(np);
+        for (int i = 0; i < np; i++) {
+          nx[i] = tan[i][1];
+          ny[i] = -tan[i][0];
+          jwt[i] = pt[i][2] * tan[i][2];
+        }
+
+        // Traces of all external functions and the fluxes in all points at once.
+        if (bnd) {
+          for (unsigned int j = 0; j < nf; j++) {
+            Func<scalar>* fn = init_fn(ffs->ext[j], eo);
+            memcpy(w_L[j], fn->val, np * sizeof(scalar));
+            fn->free_fn();
+            delete fn;
+          }
+          std::string marker = mesh->get_boundary_markers_conversion().get_user_marker(e->en[isurf]->marker);
+          if (!ffs->boundary_flux(np, marker, &w_L[0], &nx[0], &ny[0], rm->get_phys_x(eo), rm->get_phys_y(eo), &flux[0]))
+            continue;
+        }
+        else {
+          for (unsigned int j = 0; j < nf; j++) {
+            DiscontinuousFunc<scalar>* fn = ns->init_ext_fn(ffs->ext[j]);
+            for (int i = 0; i < np; i++) {
+              w_L[j][i] = fn->get_val_central(i);
+              w_R[j][i] = fn->get_val_neighbor(i);
+            }
+            fn->free_fn();
+            delete fn;
+          }
+          ffs->flux(np, &w_L[0], &w_R[0], &nx[0], &ny[0], &flux[0]);
+        }
+
+        // Integration with the test functions of the central element
+        // (edges are parametrized from 0 to 1, hence the 0.5).
+        for (unsigned int c = 0; c < nc; c++) {
+          int m = ffs->coordinates[c];
+          PrecalcShapeset* fv = spss[m];
+          fv->set_active_element(e);
+          fv->reset_transform();
+          spaces[m]->get_boundary_assembly_list(e, isurf, &al);
+          for (unsigned int k = 0; k < al.cnt; k++) {
+            if (al.dof[k] < 0) continue;
+            fv->set_active_shape(al.idx[k]);
+            fv->set_quad_order(eo, H2D_FN_VAL);
+            double* v = fv->get_fn_values();
+            scalar res = 0;
+            for (int i = 0; i < np; i++)
+              res += jwt[i] * v[i] * flux[c][i];
+            rhs->add(al.dof[k], 0.5 * ffs->scaling_factor * res * al.coef[k]);
+          }
+        }
+        if (bnd)
+          continue;
+
+        // Integration with the test functions of the neighbor, in its (possibly reversed) points
+        // on the part of its edge matching the face.
+        int neighb_eo = ns->get_quad_eo(true);
+        bool reverse = (ns->neighbor_edge.orientation == 1);
+        for (unsigned int c = 0; c < nc; c++) {
+          int m = ffs->coordinates[c];
+          PrecalcShapeset* fv = spss[m];
+          fv->set_active_element(ns->neighb_el);
+          fv->reset_transform();
+          for (unsigned int k = 0; k < ns->neighbor_n_trans[0]; k++)
+            fv->push_transform(ns->neighbor_transformations[0][k]);
+          spaces[m]->get_boundary_assembly_list(ns->neighb_el, ns->neighbor_edge.local_num_of_edge, &al);
+          for (unsigned int k = 0; k < al.cnt; k++) {
+            if (al.dof[k] < 0) continue;
+            fv->set_active_shape(al.idx[k]);
+            fv->set_quad_order(neighb_eo, H2D_FN_VAL);
+            double* v = fv->get_fn_values();
+            scalar res = 0;
+            for (int i = 0; i < np; i++)
+              res += jwt[i] * v[reverse ? np - 1 - i : i] * flux[c][i];
+            rhs->add(al.dof[k], -0.5 * ffs->scaling_factor * res * al.coef[k]);
+          }
+        }
+      }
+    }
+
+    if (ns != NULL)
+      delete ns;
+  }
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Initialize integration order for external functions
@@ -2143,6 +2557,9 @@ ExtData<Ord>* DiscreteProblem::init_ext_fns_ord(Hermes::vector<MeshFunction *> &
 Func<double>* DiscreteProblem::get_fn(PrecalcShapeset *fu, RefMap *rm, const int order)
 {
   _F_
+  // Slave precalc shapesets do not switch the mode of the quadrature, so it may be
+  // the mode of another element (e.g. of the neighbor of a DG edge).
+  fu->get_quad_2d()->set_mode(rm->get_active_element()->get_mode());
   if(rm->is_jacobian_const()) {
     AssemblingCaches::KeyConst key(256 - fu->get_active_shape(), order, fu->get_transform(), fu->get_shapeset()->get_id(), rm->get_const_inv_ref_map());
     if(rm->get_active_element()->get_mode() == HERMES_MODE_TRIANGLE) {
@@ -2266,8 +2683,8 @@ scalar DiscreteProblem::eval_form(WeakForm::MatrixFormVol *mfv,
     Shapeset* fv_shapeset = fv->get_shapeset();
     int fu_index = fu->get_active_shape();
     int fv_index = fv->get_active_shape();
-    int fu_order = fu_shapeset->get_order(fu_index);
-    int fv_order = fv_shapeset->get_order(fv_index);
+    int fu_order = fu_shapeset->get_order(fu_index, fu->get_active_element()->get_mode());
+    int fv_order = fv_shapeset->get_order(fv_index, fv->get_active_element()->get_mode());
     int fu_order_h = H2D_GET_H_ORDER(fu_order);
     int fu_order_v = H2D_GET_V_ORDER(fu_order);
     int fv_order_h = H2D_GET_H_ORDER(fv_order);
@@ -2647,7 +3064,7 @@ scalar DiscreteProblem::eval_form(WeakForm::VectorFormVol *vfv,
     //       this needs more research.
     Shapeset* fv_shapeset = fv->get_shapeset();
     int fv_index = fv->get_active_shape();
-    int fv_order = fv_shapeset->get_order(fv_index);
+    int fv_order = fv_shapeset->get_order(fv_index, fv->get_active_element()->get_mode());
     int fv_order_h = H2D_GET_H_ORDER(fv_order);
     int fv_order_v = H2D_GET_V_ORDER(fv_order);
 
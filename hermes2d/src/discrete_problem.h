@@ -30,6 +30,7 @@
 #include "views/order_view.h"
 #include "function/function.h"
 #include "neighbor.h"
+#include "static_condensation.h"
 #include "ref_selectors/selector.h"
 #include <map>
 
@@ -57,7 +58,7 @@ public:
   DiscreteProblem(WeakForm* wf, Space* space);
 
   /// Non-parameterized constructor (currently used only in KellyTypeAdapt to gain access to NeighborSearch methods).
-  DiscreteProblem() : wf(NULL), pss(NULL) {num_user_pss = 0; sp_seq = NULL;}
+  DiscreteProblem() : wf(NULL), pss(NULL), condensation(NULL) {num_user_pss = 0; sp_seq = NULL;}
 
   /// Init function. Common code for the constructors.
   void init();
@@ -212,22 +213,22 @@ public:
   /// Assemble one DG neighbor.
   void assemble_DG_one_neighbor(bool edge_processed, unsigned int neighbor_i, WeakForm::Stage& stage, 
       SparseMatrix* mat, Vector* rhs, bool force_diagonal_blocks, Table* block_weights,
-       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *> npss,
-       std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
+       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *>& npss,
+       std::map<unsigned int, PrecalcShapeset *>& nspss, std::map<unsigned int, RefMap *>& nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
        Hermes::vector<bool>& isempty, int marker, Hermes::vector<AsmList *>& al, bool bnd, SurfPos& surf_pos, Hermes::vector<bool>& nat, 
        int isurf, Element** e, Element* trav_base, Element* rep_element);
 
   /// Assemble DG matrix forms.
   void assemble_DG_matrix_forms(WeakForm::Stage& stage, 
        SparseMatrix* mat, Vector* rhs, bool force_diagonal_blocks, Table* block_weights,
-       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *> npss,
-       std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
+       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *>& npss,
+       std::map<unsigned int, PrecalcShapeset *>& nspss, std::map<unsigned int, RefMap *>& nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
        Hermes::vector<bool>& isempty, int marker, Hermes::vector<AsmList *>& al, bool bnd, SurfPos& surf_pos, Hermes::vector<bool>& nat, 
        int isurf, Element** e, Element* trav_base, Element* rep_element);
   void assemble_multicomponent_DG_matrix_forms(WeakForm::Stage& stage, 
        SparseMatrix* mat, Vector* rhs, bool force_diagonal_blocks, Table* block_weights,
-       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *> npss,
-       std::map<unsigned int, PrecalcShapeset *> nspss, std::map<unsigned int, RefMap *> nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
+       Hermes::vector<PrecalcShapeset *>& spss, Hermes::vector<RefMap *>& refmap, std::map<unsigned int, PrecalcShapeset *>& npss,
+       std::map<unsigned int, PrecalcShapeset *>& nspss, std::map<unsigned int, RefMap *>& nrefmap, LightArray<NeighborSearch*>& neighbor_searches, Hermes::vector<Solution *>& u_ext, 
        Hermes::vector<bool>& isempty, int marker, Hermes::vector<AsmList *>& al, bool bnd, SurfPos& surf_pos, Hermes::vector<bool>& nat, 
        int isurf, Element** e, Element* trav_base, Element* rep_element);
 
@@ -243,6 +244,27 @@ public:
        Hermes::vector<bool>& isempty, int marker, Hermes::vector<AsmList *>& al, bool bnd, SurfPos& surf_pos, Hermes::vector<bool>& nat, 
        int isurf, Element** e, Element* trav_base, Element* rep_element);
 
+  /// Assemble the face-based fluxes (WeakForm::FluxFormSurf). Every face of the mesh is visited
+  /// once (elements in the order of their ids), the traces of the external functions from both
+  /// sides are evaluated at once for all quadrature points, and the flux is integrated with the
+  /// test functions of both elements.
+  void assemble_flux_forms(Vector* rhs, Hermes::vector<PrecalcShapeset *>& spss, 
+       Hermes::vector<RefMap *>& refmap);
+
+
+  /// Static condensation of the bubble DOFs (see StaticCondensation). When it is switched on,
+  /// assemble() produces the system for the skeleton (vertex and edge) DOFs only, which has
+  /// get_num_skeleton_dofs() unknowns, and the coefficients of all DOFs are computed from its
+  /// solution by expand_condensed_solution(). The weak form must have one assembling stage
+  /// in which the states are whole elements of all spaces, and no DG or flux forms.
+  void set_static_condensation(bool enable = true);
+  bool get_static_condensation() const { return condensation != NULL; }
+  int get_num_skeleton_dofs();
+
+  /// Computes the coefficient vector 'sln' (get_num_dofs() entries) from the solution of
+  /// the condensed system, see StaticCondensation::expand().
+  void expand_condensed_solution(scalar* skeleton_sln, scalar* sln, double rhs_factor = 1.0,
+                                 int num_threads = 1);
 
   /// SET functions.
   void invalidate_matrix() { have_matrix = false; }
@@ -483,6 +505,92 @@ protected:
   /// Minimum identifier of the meshes used in DG assembling in one stage.
   unsigned int min_dg_mesh_seq;
 
+  /// Cache of the neighborhoods of inner edges (DG) of one assembling stage.
+  /// The neighborhoods (NeighborSearches updated according to the multimesh tree)
+  /// depend only on the meshes, so they are computed in the first assembling, 
+  /// stored in flat arrays and loaded into a pool of NeighborSearches in the 
+  /// following ones, until any mesh of the stage or its seq changes. Elements are
+  /// stored by their ids, since a mesh may be replaced by a copy with the same seq
+  /// (Mesh::copy()), which has new elements.
+  /// The edges are still visited in the order of the element traversal; the cache
+  /// only saves the neighbor search and the multimesh tree of each edge.
+  class DGFaceCache
+  {
+  public:
+    DGFaceCache() : pool(NULL) {};
+
+    /// Neighborhood of the edge on one mesh (one NeighborSearch).
+    struct Neighborhood
+    {
+      unsigned int ns_index;
+      int central_el_id;
+      uint64_t original_central_el_transform;
+      int active_edge;
+      int neighborhood_type;
+      unsigned int first_neighbor;
+      unsigned int n_neighbors;
+    };
+
+    /// One neighbor of the edge.
+    struct Neighbor
+    {
+      int el_id;
+      int local_num_of_edge;
+      int orientation;
+      unsigned int central_n_trans;
+      unsigned int neighbor_n_trans;
+      unsigned int central_transformations[NeighborSearch::max_n_trans];
+      unsigned int neighbor_transformations[NeighborSearch::max_n_trans];
+    };
+
+    /// One inner edge of an assembling state.
+    struct Face
+    {
+      unsigned int first_neighborhood;
+      unsigned int n_neighborhoods;
+      unsigned int num_neighbors;
+    };
+
+    /// The meshes of the stage and their seq numbers.
+    Hermes::vector<Mesh*> meshes;
+    Hermes::vector<unsigned int> mesh_seqs;
+
+    /// Index to faces for the edge isurf of the state, [state * 4 + isurf], -1 if not cached.
+    std::vector<int> face_index;
+
+    std::vector<Face> faces;
+    std::vector<Neighborhood> neighborhoods;
+    std::vector<Neighbor> neighbors;
+
+    /// NeighborSearches the cached neighborhoods are loaded into.
+    LightArray<NeighborSearch*>* pool;
+
+    void free();
+  };
+
+  /// DG face caches for all assembling stages.
+  std::vector<DGFaceCache> dg_face_cache;
+
+  /// The current assembling stage and state (index of the state in the traversal).
+  unsigned int current_stage_num;
+  unsigned int current_state_num;
+
+  /// Drops the cache of the stage current_stage_num if the meshes have changed.
+  void init_dg_face_cache(WeakForm::Stage& stage);
+
+  /// Stores the neighborhoods of the edge isurf of the current state.
+  void store_dg_face(LightArray<NeighborSearch*>& neighbor_searches, unsigned int num_neighbors, int isurf);
+
+  /// Loads the neighborhoods of the edge isurf of the current state into the pool,
+  /// returns false if they are not cached.
+  bool load_dg_face(WeakForm::Stage& stage, int isurf, unsigned int& num_neighbors);
+
+  /// Neighbor precalc shapesets and refmaps for DG matrix forms, created once
+  /// and used for all edges.
+  std::map<unsigned int, PrecalcShapeset *> dg_npss;
+  std::map<unsigned int, PrecalcShapeset *> dg_nspss;
+  std::map<unsigned int, RefMap *> dg_nrefmap;
+
 
   /// Members.
   WeakForm* wf;
@@ -520,6 +628,9 @@ protected:
   PrecalcShapeset** pss;    // This is different from H3D.
   int num_user_pss;         // This is different from H3D.
 
+  /// Static condensation of the bubble DOFs, NULL if switched off.
+  StaticCondensation* condensation;
+
 
   /// Geometry and jacobian*weights caches.
   Geom<double>* cache_e[g_max_quad + 1 + 4 * g_max_quad + 4];
@@ -305,6 +305,155 @@ scalar SimpleFilter::get_pt_value(double x, double y, int it)
 	return result;
 }
 
+//// FusedFilter ///////////////////////////////////////////////////////////////////////////////////
+
+FusedFilter::FusedFilter(SimpleFilter* root)
+{
+  if (root == NULL) error("FusedFilter: the root filter is NULL.");
+
+  memset(source_item, 0, sizeof(source_item));
+  std::map<SimpleFilter*, int> visited;
+  Hermes::vector<MeshFunction*> sources;
+  add_stage(root, visited, sources);
+
+  Filter::init(sources);
+  num_components = root->get_num_components();
+}
+
+int FusedFilter::add_stage(SimpleFilter* flt, std::map<SimpleFilter*, int>& visited,
+                           Hermes::vector<MeshFunction*>& sources)
+{
+  // a filter used by several filters of the graph is evaluated only once
+  std::map<SimpleFilter*, int>::iterator it = visited.find(flt);
+  if (it != visited.end()) return it->second;
+
+  Stage st;
+  st.filter = flt;
+  st.num = flt->num;
+  st.num_components = flt->get_num_components();
+  for (int i = 0; i < st.num; i++)
+  {
+    st.item[i] = flt->item[i];
+    SimpleFilter* sf = dynamic_cast<SimpleFilter*>(flt->sln[i]);
+    if (sf != NULL)
+    {
+      if (st.item[i] & (H2D_FN_DX | H2D_FN_DY | H2D_FN_DXX | H2D_FN_DYY | H2D_FN_DXY))
+        error("FusedFilter: only values of a SimpleFilter can be used by another filter.");
+      st.input[i] = add_stage(sf, visited, sources);
+      continue;
+    }
+
+    unsigned int s = 0;
+    while (s < sources.size() && sources[s] != flt->sln[i]) s++;
+    if (s == sources.size())
+    {
+      if (s >= 10) error("FusedFilter: the filter graph has more than 10 sources.");
+      sources.push_back(flt->sln[i]);
+    }
+    source_item[s] |= st.item[i];
+    st.input[i] = -1 - (int) s;
+  }
+
+  stages.push_back(st);
+  return visited[flt] = (int) stages.size() - 1;
+}
+
+scalar* FusedFilter::get_input(Stage& st, int i, int j, int np)
+{
+  int a = 0, b = 0, mask = st.item[i];
+  if (mask >= 0x40) { a = 1; mask >>= 6; }
+  while (!(mask & 1)) { mask >>= 1; b++; }
+  int comp = (st.num_components == 1) ? a : j;
+
+  if (st.input[i] >= 0)
+  {
+    if (comp >= stages[st.input[i]].num_components) comp = 0;
+    return &buffer[(2 * st.input[i] + comp) * np];
+  }
+
+  scalar* tab = sln[-1 - st.input[i]]->get_values(comp, b);
+  if (tab == NULL) error("Value of 'item%d' is incorrect in filter definition.", i+1);
+  return tab;
+}
+
+void FusedFilter::precalculate(int order, int mask)
+{
+  if (mask & (H2D_FN_DX | H2D_FN_DY | H2D_FN_DXX | H2D_FN_DYY | H2D_FN_DXY))
+    error("Filter not defined for derivatives.");
+
+  Quad2D* quad = quads[cur_quad];
+  int np = quad->get_num_points(order);
+  Node* node = new_node(H2D_FN_VAL, np);
+
+  // precalculate every source once, with everything the graph needs from it
+  for (int i = 0; i < num; i++)
+    sln[i]->set_quad_order(order, source_item[i]);
+
+  int ns = stages.size();
+  if (buffer.size() < (size_t) (2 * ns * np))
+    buffer.resize(2 * ns * np);
+
+  // apply the filters in the topological order, the root writes directly to the node
+  for (int s = 0; s < ns; s++)
+  {
+    Stage& st = stages[s];
+    for (int j = 0; j < st.num_components; j++)
+    {
+      Hermes::vector<scalar*> values;
+      for (int i = 0; i < st.num; i++)
+        values.push_back(get_input(st, i, j, np));
+
+      scalar* result = (s == ns-1) ? node->values[j][0] : &buffer[(2*s + j) * np];
+      st.filter->filter_fn(np, values, result);
+    }
+  }
+
+  if(nodes->present(order)) {
+    assert(nodes->get(order) == cur_node);
+    ::free(nodes->get(order));
+  }
+  nodes->add(node, order);
+  cur_node = node;
+}
+
+scalar FusedFilter::get_pt_value(double x, double y, int it)
+{
+  if (it & (H2D_FN_DX | H2D_FN_DY | H2D_FN_DXX | H2D_FN_DYY | H2D_FN_DXY))
+    error("Filter not defined for derivatives.");
+
+  int ns = stages.size();
+  std::vector<scalar> val(2 * ns);
+  for (int s = 0; s < ns; s++)
+  {
+    Stage& st = stages[s];
+    for (int j = 0; j < st.num_components; j++)
+    {
+      scalar in[10];
+      Hermes::vector<scalar*> values;
+      for (int i = 0; i < st.num; i++)
+      {
+        int item = st.item[i];
+        int comp = (st.num_components == 1) ? (item >= 0x40 ? 1 : 0) : j;
+        if (st.input[i] >= 0)
+        {
+          if (comp >= stages[st.input[i]].num_components) comp = 0;
+          in[i] = val[2 * st.input[i] + comp];
+        }
+        else
+        {
+          if (st.num_components == 2 && (item & H2D_FN_COMPONENT_0) && (item & H2D_FN_COMPONENT_1))
+            item &= j ? H2D_FN_COMPONENT_1 : H2D_FN_COMPONENT_0;
+          in[i] = sln[-1 - st.input[i]]->get_pt_value(x, y, item);
+        }
+        values.push_back(&in[i]);
+      }
+      st.filter->filter_fn(1, values, &val[2*s + j]);
+    }
+  }
+
+  return val[2*(ns-1) + ((it >= 0x40 && num_components > 1) ? 1 : 0)];
+}
+
 //// DXDYFilter ////////////////////////////////////////////////////////////////////////////////////
 
 
@@ -68,6 +68,7 @@ protected:
 
   void copy_base(Filter* flt);
 
+  friend class FusedFilter;
 };
 
 
@@ -105,6 +106,64 @@ protected:
   void init_components();
   virtual void precalculate(int order, int mask);
 
+  friend class FusedFilter;
+};
+
+
+/// FusedFilter evaluates a whole graph of SimpleFilters at once. When filters are chained,
+/// e.g. MagFilter(DiffFilter(u1, v1), DiffFilter(u2, v2)), every filter precalculates its
+/// inputs and traverses them on its own, so the intermediate filters allocate their own
+/// tables and the Solutions shared by several filters are visited repeatedly.
+///
+/// FusedFilter takes the last filter of such a graph (the root). The graph is walked
+/// through the inputs which are SimpleFilters; any other MeshFunction (a Solution, but also
+/// e.g. a VonMisesFilter) becomes a source of the graph. Every distinct source is included
+/// only once, precalculated once per element, transformation and order with all the items
+/// the graph needs from it, and then the filter_fn's of the filters are applied in the
+/// topological order to whole arrays of values. The intermediate results live in a scratch
+/// buffer of the FusedFilter, the intermediate filters themselves are not touched at all
+/// (they only describe the graph and must exist as long as the FusedFilter).
+///
+/// The result is cached per element, transformation and order as with any other Function,
+/// and FusedFilter is an ordinary MeshFunction, so it can be passed to the Linearizer,
+/// to the norms and to the error estimators in place of the root filter.
+///
+/// Only the values of the intermediate filters can be used by the filters that follow
+/// (as with SimpleFilter itself).
+///
+class HERMES_API FusedFilter : public Filter
+{
+public:
+  FusedFilter(SimpleFilter* root);
+
+  virtual scalar get_pt_value(double x, double y, int item = H2D_FN_VAL_0);
+
+  /// Number of filters in the graph.
+  int get_num_stages() const { return (int) stages.size(); }
+
+  /// Number of distinct sources of the graph.
+  int get_num_sources() const { return num; }
+
+protected:
+  /// One filter of the graph. An input is either another stage (input >= 0),
+  /// or the source sln[-1 - input].
+  struct Stage
+  {
+    SimpleFilter* filter;
+    int num, num_components;
+    int input[10];
+    int item[10];
+  };
+
+  std::vector<Stage> stages;  ///< In the topological order, the root is the last one.
+  int source_item[10];        ///< Union of the items the graph needs from each source.
+  std::vector<scalar> buffer; ///< Intermediate results, two components per stage.
+
+  int add_stage(SimpleFilter* flt, std::map<SimpleFilter*, int>& visited,
+                Hermes::vector<MeshFunction*>& sources);
+  scalar* get_input(Stage& st, int i, int j, int np);
+
+  virtual void precalculate(int order, int mask);
 };
 
 
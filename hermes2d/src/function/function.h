@@ -113,7 +113,7 @@ public:
   /// \param mask [in] A combination of one or more of the constants H2D_FN_VAL, H2D_FN_DX, H2D_FN_DY,
   ///   H2D_FN_DXX, H2D_FN_DYY, H2D_FN_DXY specifying the values which should be precalculated. The default is
   ///   H2D_FN_VAL | H2D_FN_DX | H2D_FN_DY. You can also use H2D_FN_ALL to precalculate everything.
-  void set_quad_order(unsigned int order, int mask = H2D_FN_DEFAULT)
+  virtual void set_quad_order(unsigned int order, int mask = H2D_FN_DEFAULT)
   {
     if(nodes->present(order)) {
       cur_node = nodes->get(order);
@@ -533,6 +533,7 @@ void Solution::set_coeff_vector(Space* space, PrecalcShapeset* pss, scalar* coef
   Quad2D* quad = &g_quad_2d_cheb;
   pss->set_quad_2d(quad);
   scalar* mono = mono_coefs;
+  AsmList al;
   for_all_active_elements(e, mesh)
   {
     mode = e->get_mode();
@@ -540,8 +541,9 @@ void Solution::set_coeff_vector(Space* space, PrecalcShapeset* pss, scalar* coef
     o = elem_orders[e->id];
     int np = quad->get_num_points(o);
 
-    AsmList al;
-    space->get_element_assembly_list(e, &al);
+    const int *al_idx, *al_dof;
+    const scalar* al_coef;
+    int al_cnt = space->get_element_assembly_list(e, al_idx, al_dof, al_coef, &al);
     pss->set_active_element(e);
 
     for (int l = 0; l < num_components; l++)
@@ -550,13 +552,13 @@ void Solution::set_coeff_vector(Space* space, PrecalcShapeset* pss, scalar* coef
       scalar* val = mono;
       elem_coefs[l][e->id] = (int) (mono - mono_coefs);
       memset(val, 0, sizeof(scalar)*np);
-      for (unsigned int k = 0; k < al.cnt; k++)
+      for (int k = 0; k < al_cnt; k++)
       {
-        pss->set_active_shape(al.idx[k]);
+        pss->set_active_shape(al_idx[k]);
         pss->set_quad_order(o, H2D_FN_VAL);
-        int dof = al.dof[k];
+        int dof = al_dof[k];
         double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
-        scalar coef = al.coef[k] * (dof >= 0 ? coeffs[dof] : dir_lift_coeff);
+        scalar coef = al_coef[k] * (dof >= 0 ? coeffs[dof] : dir_lift_coeff);
         double* shape = pss->get_fn_values(l);
         for (int i = 0; i < np; i++)
           val[i] += shape[i] * coef;
@@ -38,6 +38,8 @@
 #include "../hermes_common/solver/petsc.h"
 #include "../hermes_common/solver/umfpack_solver.h"
 #include "../hermes_common/solver/superlu.h"
+#include "../hermes_common/solver/banded.h"
+#include "../hermes_common/solver/mixed_precision.h"
 
 // preconditioners
 #include "../hermes_common/solver/precond.h"
@@ -76,6 +78,7 @@
 #include "mesh/trans.h"
 
 #include "weakform/weakform.h"
+#include "weakform/weakform_compiler.h"
 #include "discrete_problem.h"
 #include "function/forms.h"
 
@@ -38,6 +38,19 @@ Quad2DStd CurvMap::quad2d;
 
 Trf CurvMap::ctm;
 
+unsigned int Nurbs::next_id = 0;
+
+std::map<CurvMap::CoeffKey, CurvMap::CoeffEntry> CurvMap::coeff_cache;
+std::list<CurvMap::CoeffKey> CurvMap::coeff_lru;
+int CurvMap::coeff_cache_size = H2D_CURV_CACHE_SIZE;
+pthread_mutex_t CurvMap::coeff_cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// releases the cached projections at exit (defined after the cache, so it is destroyed first)
+static struct CurvCoeffCacheCleanup
+{
+  ~CurvCoeffCacheCleanup() { CurvMap::free_coeff_cache(); }
+} curv_coeff_cache_cleanup;
+
 //// NURBS //////////////////////////////////////////////////////////////////////////////////////////
 // recursive calculation of the basis function N_i,k
 bool CurvMap::warning_issued = false;
@@ -553,15 +566,15 @@ void CurvMap::precalculate_cholesky_projection_matrices_bubble()
 //// edge part of projection based interpolation ///////////////////////////////////////////////////
 
 // compute point (x,y) in reference element, edge vector (v1, v2)
-void CurvMap::edge_coord(Element* e, int edge, double t, double2& x, double2& v)
+void CurvMap::edge_coord(Element* e, int edge, double t, double2& x, double2& v, CurvMapWorkspace* ws)
 {
   _F_
   int mode = e->get_mode();
   double2 a, b;
-  a[0] = ctm.m[0] * ref_vert[mode][edge][0] + ctm.t[0];
-  a[1] = ctm.m[1] * ref_vert[mode][edge][1] + ctm.t[1];
-  b[0] = ctm.m[0] * ref_vert[mode][e->next_vert(edge)][0] + ctm.t[0];
-  b[1] = ctm.m[1] * ref_vert[mode][e->next_vert(edge)][1] + ctm.t[1];
+  a[0] = ws->ctm->m[0] * ref_vert[mode][edge][0] + ws->ctm->t[0];
+  a[1] = ws->ctm->m[1] * ref_vert[mode][edge][1] + ws->ctm->t[1];
+  b[0] = ws->ctm->m[0] * ref_vert[mode][e->next_vert(edge)][0] + ws->ctm->t[0];
+  b[1] = ws->ctm->m[1] * ref_vert[mode][e->next_vert(edge)][1] + ws->ctm->t[1];
 
   for (int i = 0; i < 2; i++)
   {
@@ -572,10 +585,11 @@ void CurvMap::edge_coord(Element* e, int edge, double t, double2& x, double2& v)
   v[0] /= lenght; v[1] /= lenght;
 }
 
-void CurvMap::calc_edge_projection(Element* e, int edge, Nurbs** nurbs, int order, double2* proj)
+void CurvMap::calc_edge_projection(Element* e, int edge, Nurbs** nurbs, int order, double2* proj,
+                                   CurvMapWorkspace* ws)
 {
   _F_
-  ref_map_pss.set_active_element(e);
+  ws->pss->set_active_element(e);
 
   int i, j, k;
   int mo1 = quad1d.get_max_order();
@@ -591,10 +605,10 @@ void CurvMap::calc_edge_projection(Element* e, int edge, Nurbs** nurbs, int orde
   memset(rhside[1], 0, sizeof(double) * ne);
 
   double a_1, a_2, b_1, b_2;
-  a_1 = ctm.m[0] * ref_vert[mode][edge][0] + ctm.t[0];
-  a_2 = ctm.m[1] * ref_vert[mode][edge][1] + ctm.t[1];
-  b_1 = ctm.m[0] * ref_vert[mode][e->next_vert(edge)][0] + ctm.t[0];
-  b_2 = ctm.m[1] * ref_vert[mode][e->next_vert(edge)][1] + ctm.t[1];
+  a_1 = ws->ctm->m[0] * ref_vert[mode][edge][0] + ws->ctm->t[0];
+  a_2 = ws->ctm->m[1] * ref_vert[mode][edge][1] + ws->ctm->t[1];
+  b_1 = ws->ctm->m[0] * ref_vert[mode][e->next_vert(edge)][0] + ws->ctm->t[0];
+  b_2 = ws->ctm->m[1] * ref_vert[mode][e->next_vert(edge)][1] + ws->ctm->t[1];
 
   // values of nonpolynomial function in two vertices
   double2 fa, fb;
@@ -606,7 +620,7 @@ void CurvMap::calc_edge_projection(Element* e, int edge, Nurbs** nurbs, int orde
   {
     double2 x, v;
     double t = pt[j][0];
-    edge_coord(e, edge, t, x, v);
+    edge_coord(e, edge, t, x, v, ws);
     calc_ref_map(e, nurbs, x[0], x[1], fn[j]);
 
     for (k = 0; k < 2; k++)
@@ -672,20 +686,20 @@ void CurvMap::calc_edge_projection(Element* e, int edge, Nurbs** nurbs, int orde
 
 //// bubble part of projection based interpolation /////////////////////////////////////////////////
 
-void CurvMap::old_projection(Element* e, int order, double2* proj, double* old[2])
+void CurvMap::old_projection(Element* e, int order, double2* proj, double* old[2], CurvMapWorkspace* ws)
 {
   _F_
-  int mo2 = quad2d.get_max_order();
-  int np = quad2d.get_num_points(mo2);
+  int mo2 = ws->quad2d->get_max_order();
+  int np = ws->quad2d->get_num_points(mo2);
 
   for (unsigned int k = 0; k < e->nvert; k++) // loop over vertices
   {
     // vertex basis functions in all integration points
     double* vd;
-    int index_v = ref_map_shapeset.get_vertex_index(k);
-    ref_map_pss.set_active_shape(index_v);
-    ref_map_pss.set_quad_order(mo2);
-    vd = ref_map_pss.get_fn_values();
+    int index_v = ws->shapeset->get_vertex_index(k);
+    ws->pss->set_active_shape(index_v);
+    ws->pss->set_quad_order(mo2);
+    vd = ws->pss->get_fn_values();
 
     for (int m = 0; m < 2; m++)   // part 0 or 1
       for (int j = 0; j < np; j++)
@@ -695,10 +709,10 @@ void CurvMap::old_projection(Element* e, int order, double2* proj, double* old[2
     {
       // edge basis functions in all integration points
       double* ed;
-      int index_e = ref_map_shapeset.get_edge_index(k,0,ii+2);
-      ref_map_pss.set_active_shape(index_e);
-      ref_map_pss.set_quad_order(mo2);
-      ed = ref_map_pss.get_fn_values();
+      int index_e = ws->shapeset->get_edge_index(k,0,ii+2);
+      ws->pss->set_active_shape(index_e);
+      ws->pss->set_quad_order(mo2);
+      ed = ws->pss->get_fn_values();
 
       for (int m = 0; m < 2; m++)  //part 0 or 1
         for (int j = 0; j < np; j++)
@@ -707,16 +721,17 @@ void CurvMap::old_projection(Element* e, int order, double2* proj, double* old[2
   }
 }
 
-void CurvMap::calc_bubble_projection(Element* e, Nurbs** nurbs, int order, double2* proj)
+void CurvMap::calc_bubble_projection(Element* e, Nurbs** nurbs, int order, double2* proj,
+                                     CurvMapWorkspace* ws)
 {
   _F_
-  ref_map_pss.set_active_element(e);
+  ws->pss->set_active_element(e);
 
   int i, j, k;
-  int mo2 = quad2d.get_max_order();
-  int np = quad2d.get_num_points(mo2);
+  int mo2 = ws->quad2d->get_max_order();
+  int np = ws->quad2d->get_num_points(mo2);
   int qo = e->is_quad() ? H2D_MAKE_QUAD_ORDER(order, order) : order;
-  int nb = ref_map_shapeset.get_num_bubbles(qo);
+  int nb = ws->shapeset->get_num_bubbles(qo);
 
   double2* fn = new double2[np];
   memset(fn, 0, np * sizeof(double2));
@@ -731,15 +746,15 @@ void CurvMap::calc_bubble_projection(Element* e, Nurbs** nurbs, int order, doubl
   }
 
   // compute known part of projection (vertex and edge part)
-  old_projection(e, order, proj, old);
+  old_projection(e, order, proj, old, ws);
 
   // fn values of both components of nonpolynomial function
-  double3* pt = quad2d.get_points(mo2);
+  double3* pt = ws->quad2d->get_points(mo2);
   for (j = 0; j < np; j++)  // over all integration points
   {
     double2 a;
-    a[0] = ctm.m[0] * pt[j][0] + ctm.t[0];
-    a[1] = ctm.m[1] * pt[j][1] + ctm.t[1];
+    a[0] = ws->ctm->m[0] * pt[j][0] + ws->ctm->t[0];
+    a[1] = ws->ctm->m[1] * pt[j][1] + ws->ctm->t[1];
     calc_ref_map(e, nurbs, a[0], a[1], fn[j]);
   }
 
@@ -750,10 +765,10 @@ void CurvMap::calc_bubble_projection(Element* e, Nurbs** nurbs, int order, doubl
     {
       // bubble basis functions in all integration points
       double *bfn;
-      int index_i = ref_map_shapeset.get_bubble_indices(qo)[i];
-      ref_map_pss.set_active_shape(index_i);
-      ref_map_pss.set_quad_order(mo2);
-      bfn = ref_map_pss.get_fn_values();
+      int index_i = ws->shapeset->get_bubble_indices(qo)[i];
+      ws->pss->set_active_shape(index_i);
+      ws->pss->set_quad_order(mo2);
+      bfn = ws->pss->get_fn_values();
 
       for (j = 0; j < np; j++) // over all integration points
         rhside[k][i] += pt[j][2] * (bfn[j] * (fn[j][k] - old[k][j]));
@@ -779,7 +794,7 @@ void CurvMap::calc_bubble_projection(Element* e, Nurbs** nurbs, int order, doubl
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-void CurvMap::ref_map_projection(Element* e, Nurbs** nurbs, int order, double2* proj)
+void CurvMap::ref_map_projection(Element* e, Nurbs** nurbs, int order, double2* proj, CurvMapWorkspace* ws)
 {
   _F_
   // vertex part
@@ -794,31 +809,36 @@ void CurvMap::ref_map_projection(Element* e, Nurbs** nurbs, int order, double2*
 
   // edge part
   for (int edge = 0; edge < (int)e->nvert; edge++)
-    calc_edge_projection(e, edge, nurbs, order, proj);
+    calc_edge_projection(e, edge, nurbs, order, proj, ws);
 
   //bubble part
-  calc_bubble_projection(e, nurbs, order, proj);
+  calc_bubble_projection(e, nurbs, order, proj, ws);
 }
 
 
-void CurvMap::update_refmap_coeffs(Element* e)
+void CurvMap::update_refmap_coeffs(Element* e, CurvMapWorkspace* ws)
 {
   _F_
-  ref_map_pss.set_quad_2d(&quad2d);
-  //ref_map_pss.set_active_element(e);
+  CurvMapWorkspace def_ws = { &ref_map_shapeset, &ref_map_pss, &ctm, &quad2d };
+  if (ws == NULL) ws = &def_ws;
+
+  ws->pss->set_quad_2d(ws->quad2d);
+  //ws->pss->set_active_element(e);
 
   // calculation of projection matrices
+  pthread_mutex_lock(&coeff_cache_mutex);
   if (edge_proj_matrix == NULL) precalculate_cholesky_projection_matrix_edge();
   if (bubble_proj_matrix_tri == NULL) precalculate_cholesky_projection_matrices_bubble();
+  pthread_mutex_unlock(&coeff_cache_mutex);
 
-  ref_map_pss.set_mode(e->get_mode());
-  ref_map_shapeset.set_mode(e->get_mode());
+  ws->pss->set_mode(e->get_mode());
+  ws->shapeset->set_mode(e->get_mode());
 
   // allocate projection coefficients
   int nv = e->nvert;
   int ne = order - 1;
   int qo = e->is_quad() ? H2D_MAKE_QUAD_ORDER(order, order) : order;
-  int nb = ref_map_shapeset.get_num_bubbles(qo);
+  int nb = ws->shapeset->get_num_bubbles(qo);
   nc = nv + nv*ne + nb;
   if (coeffs != NULL) {
     delete [] coeffs;
@@ -829,23 +849,165 @@ void CurvMap::update_refmap_coeffs(Element* e)
   // WARNING: do not change the format of the array 'coeffs'. If it changes,
   // RefMap::set_active_element() has to be changed too.
 
+  // reuse the projection of an element with the same geometry, if there is one
+  CoeffKey key;
+  make_coeff_key(e, key);
+  pthread_mutex_lock(&coeff_cache_mutex);
+  std::map<CoeffKey, CoeffEntry>::iterator it = coeff_cache.find(key);
+  if (it != coeff_cache.end() && it->second.nc == nc)
+  {
+    memcpy(coeffs, it->second.coeffs, sizeof(double2) * nc);
+    coeff_lru.splice(coeff_lru.begin(), coeff_lru, it->second.lru);
+    pthread_mutex_unlock(&coeff_cache_mutex);
+    for (int i = 0; i < nv; i++)
+    {
+      coeffs[i][0] = e->vn[i]->x;
+      coeffs[i][1] = e->vn[i]->y;
+    }
+    return;
+  }
+  pthread_mutex_unlock(&coeff_cache_mutex);
+
   Nurbs** nurbs;
   if (toplevel == false)
   {
-    ref_map_pss.set_active_element(e);
-    ref_map_pss.set_transform(part);
+    ws->pss->set_active_element(e);
+    ws->pss->set_transform(part);
     nurbs = parent->cm->nurbs;
   }
   else
   {
-    ref_map_pss.reset_transform();
+    ws->pss->reset_transform();
     nurbs = e->cm->nurbs;
   }
-  ctm = *(ref_map_pss.get_ctm());
-  ref_map_pss.reset_transform(); // fixme - do we need this?
+  *ws->ctm = *(ws->pss->get_ctm());
+  ws->pss->reset_transform(); // fixme - do we need this?
 
   // calculation of new projection coefficients
-  ref_map_projection(e, nurbs, order, coeffs);
+  ref_map_projection(e, nurbs, order, coeffs, ws);
+
+  // store them in the cache, drop the least recently used ones
+  pthread_mutex_lock(&coeff_cache_mutex);
+  if (coeff_cache_size <= 0) {
+    pthread_mutex_unlock(&coeff_cache_mutex);
+    return;
+  }
+  it = coeff_cache.find(key);
+  if (it != coeff_cache.end())
+  {
+    delete [] it->second.coeffs;
+    coeff_lru.erase(it->second.lru);
+    coeff_cache.erase(it);
+  }
+  while ((int) coeff_cache.size() >= coeff_cache_size && !coeff_lru.empty())
+    drop_lru_coeffs();
+  CoeffEntry entry;
+  entry.nc = nc;
+  entry.coeffs = new double2[nc];
+  memcpy(entry.coeffs, coeffs, sizeof(double2) * nc);
+  coeff_lru.push_front(key);
+  entry.lru = coeff_lru.begin();
+  coeff_cache.insert(std::pair<CoeffKey, CoeffEntry>(key, entry));
+  pthread_mutex_unlock(&coeff_cache_mutex);
+}
+
+// A workspace owning its objects, so that they are destroyed through their own types.
+struct OwnedCurvMapWorkspace : public CurvMapWorkspace
+{
+  OwnedCurvMapWorkspace() : own_pss(&own_shapeset)
+  {
+    shapeset = &own_shapeset;
+    pss = &own_pss;
+    ctm = &own_ctm;
+    quad2d = &own_quad2d;
+  }
+
+  H1ShapesetJacobi own_shapeset;
+  PrecalcShapeset own_pss;
+  Trf own_ctm;
+  Quad2DStd own_quad2d;
+};
+
+CurvMapWorkspace* CurvMap::create_workspace()
+{
+  _F_
+  return new OwnedCurvMapWorkspace;
+}
+
+void CurvMap::free_workspace(CurvMapWorkspace* ws)
+{
+  _F_
+  delete static_cast<OwnedCurvMapWorkspace*>(ws);
+}
+
+bool CurvMap::CoeffKey::operator<(const CoeffKey& other) const
+{
+  // lexicographic, member by member (not bytewise, the padding is not compared)
+  if (order != other.order) return order < other.order;
+  if (part != other.part) return part < other.part;
+  if (nvert != other.nvert) return nvert < other.nvert;
+  if (base_nvert != other.base_nvert) return base_nvert < other.base_nvert;
+  for (int i = 0; i < 4; i++)
+  {
+    if (nurbs[i] != other.nurbs[i]) return nurbs[i] < other.nurbs[i];
+    if (vert[i][0] != other.vert[i][0]) return vert[i][0] < other.vert[i][0];
+    if (vert[i][1] != other.vert[i][1]) return vert[i][1] < other.vert[i][1];
+  }
+  return false;
+}
+
+void CurvMap::make_coeff_key(Element* e, CoeffKey& key)
+{
+  _F_
+  // the unused vertices and edges of triangles are zero
+  memset(&key, 0, sizeof(CoeffKey));
+
+  Element* base = toplevel ? e : parent;
+  Nurbs** nurbs = base->cm->nurbs;
+  for (unsigned int i = 0; i < base->nvert; i++)
+  {
+    key.nurbs[i] = (nurbs[i] != NULL) ? nurbs[i]->id : 0;
+    key.vert[i][0] = base->vn[i]->x;
+    key.vert[i][1] = base->vn[i]->y;
+  }
+  key.part = toplevel ? 0 : part;
+  key.order = order;
+  key.nvert = e->nvert;
+  key.base_nvert = base->nvert;
+}
+
+void CurvMap::drop_lru_coeffs()
+{
+  // the least recently used key always has an entry, but an end() iterator must not be
+  // dereferenced if it had none
+  std::map<CoeffKey, CoeffEntry>::iterator last = coeff_cache.find(coeff_lru.back());
+  if (last != coeff_cache.end())
+  {
+    delete [] last->second.coeffs;
+    coeff_cache.erase(last);
+  }
+  coeff_lru.pop_back();
+}
+
+void CurvMap::set_coeff_cache_size(int size)
+{
+  _F_
+  pthread_mutex_lock(&coeff_cache_mutex);
+  coeff_cache_size = size;
+  while ((int) coeff_cache.size() > std::max(size, 0) && !coeff_lru.empty())
+    drop_lru_coeffs();
+  pthread_mutex_unlock(&coeff_cache_mutex);
+}
+
+void CurvMap::free_coeff_cache()
+{
+  _F_
+  pthread_mutex_lock(&coeff_cache_mutex);
+  for (std::map<CoeffKey, CoeffEntry>::iterator it = coeff_cache.begin(); it != coeff_cache.end(); it++)
+    delete [] it->second.coeffs;
+  coeff_cache.clear();
+  coeff_lru.clear();
+  pthread_mutex_unlock(&coeff_cache_mutex);
 }
 
 void CurvMap::get_mid_edge_points(Element* e, double2* pt, int n)
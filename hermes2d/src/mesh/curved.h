@@ -18,6 +18,7 @@
 
 #include "../h2d_common.h"
 #include "../shapeset/shapeset_common.h"
+#include <list>
 
 class Element;
 class H1ShapesetJacobi;
@@ -26,6 +27,18 @@ class Quad1DStd;
 class Quad2DStd;
 struct Trf;
 
+/// The objects used when the reference mapping of a curved element is projected. CurvMap
+/// uses its static members by default; Mesh::refine_elements() gives each of its threads
+/// a workspace of its own (see CurvMap::create_workspace()), so that the sons of curved
+/// elements can be projected in parallel.
+struct CurvMapWorkspace
+{
+  H1ShapesetJacobi* shapeset;
+  PrecalcShapeset* pss;
+  Trf* ctm;
+  Quad2DStd* quad2d; ///< the mode of the quadrature is changed by the projection
+};
+
 /// \brief Represents one NURBS curve.
 ///
 /// The structure Nurbs defines one curved edge, or, more precisely,
@@ -40,7 +53,7 @@ struct Trf;
 
 struct HERMES_API Nurbs
 {
-  Nurbs() { ref = 0; twin = false; };
+  Nurbs() { ref = 0; twin = false; id = ++next_id; };
   void unref();
 
   int degree;  ///< curve degree (2=quadratic, etc.)
@@ -52,8 +65,14 @@ struct HERMES_API Nurbs
   bool twin;   ///< true on internal curved edges for the second (artificial) Nurbs
   bool arc;     ///< true if this is in fact a circular arc
   double angle; ///< arc angle
+  unsigned int id; ///< unique number of the curve (identifies it in the cache of CurvMap)
+
+  static unsigned int next_id;
 };
 
+/// Maximum number of projections kept in the cache of CurvMap.
+#define H2D_CURV_CACHE_SIZE 16384
+
 
 /// CurvMap is a structure storing complete information on the curved edges of
 /// an element. There are two variants of this structure. The first is for
@@ -95,11 +114,26 @@ public:
   // or when it is necessary to re-calculate coefficients for another
   // order: 'e' is a pointer to the element to which this CurvMap
   // belongs to. First, old "coeffs" are removed if they are not NULL,
-  // then new coefficients are projected.
-  void update_refmap_coeffs(Element* e);
+  // then new coefficients are projected. Several elements can be updated in parallel,
+  // each thread with its own workspace (NULL means the static members of CurvMap).
+  void update_refmap_coeffs(Element* e, CurvMapWorkspace* ws = NULL);
+
+  static CurvMapWorkspace* create_workspace();
+  static void free_workspace(CurvMapWorkspace* ws);
 
   void get_mid_edge_points(Element* e, double2* pt, int n);
 
+  /// Projected coefficients are cached and reused when an element with the same geometry
+  /// is curved again, which happens when the reference mesh is refined (or unrefined and
+  /// refined again) in every adaptivity step, or when a copy of a mesh is refined. The key
+  /// is the geometry of the base element (the coordinates of its vertices and the NURBS
+  /// curves of its edges, see Nurbs::id), the sub-element path ('part') and the order.
+  /// An element with moved vertices or changed curves thus never gets stale coefficients.
+  /// The cache is shared by all meshes; the least recently used projections are dropped
+  /// when it holds more than set_coeff_cache_size() entries.
+  static void set_coeff_cache_size(int size);
+  static void free_coeff_cache();
+
   static H1ShapesetJacobi ref_map_shapeset;
   static PrecalcShapeset ref_map_pss;
 
@@ -153,15 +187,43 @@ public:
   static double** calculate_bubble_projection_matrix(int nb, int* indices);
   static void precalculate_cholesky_projection_matrices_bubble();
 
-  static void edge_coord(Element* e, int edge, double t, double2& x, double2& v);
-  static void calc_edge_projection(Element* e, int edge, Nurbs** nurbs, int order, double2* proj);
+  static void edge_coord(Element* e, int edge, double t, double2& x, double2& v, CurvMapWorkspace* ws);
+  static void calc_edge_projection(Element* e, int edge, Nurbs** nurbs, int order, double2* proj,
+                                   CurvMapWorkspace* ws);
 
-  static void old_projection(Element* e, int order, double2* proj, double* old[2]);
-  static void calc_bubble_projection(Element* e, Nurbs** nurbs, int order, double2* proj);
+  static void old_projection(Element* e, int order, double2* proj, double* old[2], CurvMapWorkspace* ws);
+  static void calc_bubble_projection(Element* e, Nurbs** nurbs, int order, double2* proj,
+                                     CurvMapWorkspace* ws);
   
-  static void ref_map_projection(Element* e, Nurbs** nurbs, int order, double2* proj);
+  static void ref_map_projection(Element* e, Nurbs** nurbs, int order, double2* proj, CurvMapWorkspace* ws);
 
   static bool warning_issued;
+
+protected:
+  struct CoeffKey
+  {
+    unsigned int nurbs[4]; ///< Nurbs::id of the base element edges, 0 for straight edges
+    double vert[4][2];     ///< vertices of the base element
+    uint64_t part;
+    int order, nvert, base_nvert;
+
+    bool operator<(const CoeffKey& other) const;
+  };
+
+  struct CoeffEntry
+  {
+    int nc;
+    double2* coeffs;
+    std::list<CoeffKey>::iterator lru;
+  };
+
+  static std::map<CoeffKey, CoeffEntry> coeff_cache;
+  static std::list<CoeffKey> coeff_lru; ///< most recently used first
+  static int coeff_cache_size;
+  static pthread_mutex_t coeff_cache_mutex; ///< guards the cache and the projection matrices
+
+  void make_coeff_key(Element* e, CoeffKey& key);
+  static void drop_lru_coeffs(); ///< called with coeff_cache_mutex locked
 };
 
 
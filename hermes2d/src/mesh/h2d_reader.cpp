@@ -201,7 +201,6 @@ bool H2DReader::load_stream(std::istream &is, Mesh *mesh,
     node->type = HERMES_TYPE_VERTEX;
     node->bnd = 0;
     node->p1 = node->p2 = -1;
-    node->next_hash = NULL;
     p.push_int("i", i);
     p.exec("x, y = vertices[i]");
     node->x = p.pull_double("x");
@@ -20,39 +20,45 @@
 
 HashTable::HashTable()
 {
-  v_table = NULL; e_table = NULL;
+  v_table.slots = e_table.slots = NULL;
+  v_table.mask = e_table.mask = -1;
+  v_table.count = e_table.count = 0;
   nqueries = ncollisions = 0;
 }
 
 
 void HashTable::init(int size)
 {
-  v_table = e_table = NULL;
-  nqueries = ncollisions = 0;
+  if (size & (size-1)) error("Parameter 'size' must be a power of two.");
 
-  mask = size-1;
-  if (size & mask) error("Parameter 'size' must be a power of two.");
+  free_table(v_table);
+  free_table(e_table);
+  alloc_table(v_table, size);
+  alloc_table(e_table, size);
 
-  // allocate and initialize the hash tables
-  v_table = new Node*[size];
-  e_table = new Node*[size];
+  nqueries = ncollisions = 0;
+}
 
-  memset(v_table, 0, size * sizeof(Node*));
-  memset(e_table, 0, size * sizeof(Node*));
 
-  nqueries = ncollisions = 0;
+void HashTable::alloc_table(Table& t, int size)
+{
+  t.slots = new Slot[size];
+  t.mask = size-1;
+  t.count = 0;
+  for (int i = 0; i < size; i++)
+    t.slots[i].id = -1;
 }
 
 
-void HashTable::copy_list(Node** ptr, Node* node)
+void HashTable::free_table(Table& t)
 {
-  while (node != NULL)
+  if (t.slots != NULL)
   {
-    *ptr = &nodes[node->id];
-    ptr = &((*ptr)->next_hash);
-    node = node->next_hash;
+    delete [] t.slots;
+    t.slots = NULL;
   }
-  *ptr = NULL;
+  t.mask = -1;
+  t.count = 0;
 }
 
 
@@ -60,57 +66,55 @@ void HashTable::copy(const HashTable* ht)
 {
   free();
   nodes.copy(ht->nodes);
-  mask = ht->mask;
 
-  v_table = new Node*[mask+1];
-  e_table = new Node*[mask+1];
-  for (int i = 0; i <= mask; i++)
+  // the slots refer to the nodes by their id's, so they can be copied as they are
+  const Table* src[2] = { &ht->v_table, &ht->e_table };
+  Table* dst[2] = { &v_table, &e_table };
+  for (int k = 0; k < 2; k++)
   {
-    copy_list(v_table + i, ht->v_table[i]);
-    copy_list(e_table + i, ht->e_table[i]);
+    if (src[k]->slots == NULL) continue;
+    alloc_table(*dst[k], src[k]->mask+1);
+    memcpy(dst[k]->slots, src[k]->slots, (src[k]->mask+1) * sizeof(Slot));
+    dst[k]->count = src[k]->count;
   }
 }
 
 
 void HashTable::rebuild()
 {
-  memset(v_table, 0, (mask+1) * sizeof(Node*));
-  memset(e_table, 0, (mask+1) * sizeof(Node*));
+  if (v_table.slots == NULL) init();
+  for (int i = 0; i <= v_table.mask; i++) v_table.slots[i].id = -1;
+  for (int i = 0; i <= e_table.mask; i++) e_table.slots[i].id = -1;
+  v_table.count = e_table.count = 0;
 
   Node* node;
   for_all_nodes(node, this)
   {
+    // top-level vertex nodes have no parents and are never searched for
+    if (node->type == HERMES_TYPE_VERTEX && node->p1 < 0) continue;
+
     int p1 = node->p1, p2 = node->p2;
     if (p1 > p2) std::swap(p1, p2);
-    int idx = hash(p1, p2);
-
-    if (node->type == HERMES_TYPE_VERTEX)
-    {
-      node->next_hash = v_table[idx];
-      v_table[idx] = node;
-    }
-    else
-    {
-      node->next_hash = e_table[idx];
-      e_table[idx] = node;
-    }
+    insert_into(node->type == HERMES_TYPE_VERTEX ? v_table : e_table, p1, p2, node->id);
   }
 }
 
 
+void HashTable::reserve(int nnodes)
+{
+  nodes.reserve(nnodes);
+
+  // a table is at most half full and holds either vertex or edge nodes
+  while (v_table.mask+1 < nnodes) grow(v_table);
+  while (e_table.mask+1 < nnodes) grow(e_table);
+}
+
+
 void HashTable::free()
 {
   nodes.free();
-  if (v_table != NULL)
-  {
-    delete [] v_table;
-    v_table = NULL;
-  }
-  if (e_table != NULL)
-  {
-    delete [] e_table;
-    e_table = NULL;
-  }
+  free_table(v_table);
+  free_table(e_table);
   dump_hash_stat();
 }
 
@@ -123,16 +127,84 @@ void HashTable::dump_hash_stat()
 }
 
 
-inline Node* HashTable::search_list(Node* node, int p1, int p2)
+inline int HashTable::find_slot(const Table& t, int p1, int p2)
 {
   nqueries++;
-  while (node != NULL)
+  int i = hash(p1, p2) & t.mask;
+  while (t.slots[i].id >= 0)
   {
-    if (node->p1 == p1 && node->p2 == p2) return node;
-    node = node->next_hash;
+    if (t.slots[i].p1 == p1 && t.slots[i].p2 == p2) return i;
+    i = (i+1) & t.mask;
     ncollisions++;
   }
-  return NULL;
+  return i;
+}
+
+
+inline Node* HashTable::search(Table& t, int p1, int p2)
+{
+  if (t.slots == NULL) return NULL;
+  int i = find_slot(t, p1, p2);
+  return (t.slots[i].id >= 0) ? &nodes[t.slots[i].id] : NULL;
+}
+
+
+void HashTable::insert_into(Table& t, int p1, int p2, int id)
+{
+  if (2*(t.count+1) > t.mask+1) grow(t);
+
+  int i = hash(p1, p2) & t.mask;
+  while (t.slots[i].id >= 0) i = (i+1) & t.mask;
+
+  t.slots[i].p1 = p1;
+  t.slots[i].p2 = p2;
+  t.slots[i].id = id;
+  t.count++;
+}
+
+
+void HashTable::grow(Table& t)
+{
+  Table old = t;
+  alloc_table(t, (old.mask+1 > 0) ? 2*(old.mask+1) : H2D_DEFAULT_HASH_SIZE);
+
+  // the keys are stored in the slots, the nodes are not accessed
+  for (int i = 0; i <= old.mask; i++)
+  {
+    Slot& s = old.slots[i];
+    if (s.id < 0) continue;
+    int j = hash(s.p1, s.p2) & t.mask;
+    while (t.slots[j].id >= 0) j = (j+1) & t.mask;
+    t.slots[j] = s;
+  }
+  t.count = old.count;
+  free_table(old);
+}
+
+
+void HashTable::remove_from(Table& t, int id)
+{
+  int p1 = nodes[id].p1, p2 = nodes[id].p2;
+  if (p1 > p2) std::swap(p1, p2);
+  if (t.slots == NULL) return;
+  int i = find_slot(t, p1, p2);
+  if (t.slots[i].id != id) return;
+
+  // shift back the following slots which would not be found after emptying slot i
+  int j = i;
+  while (true)
+  {
+    j = (j+1) & t.mask;
+    if (t.slots[j].id < 0) break;
+    int k = hash(t.slots[j].p1, t.slots[j].p2) & t.mask;
+    if ((j > i) ? (k <= i || k > j) : (k <= i && k > j))
+    {
+      t.slots[i] = t.slots[j];
+      i = j;
+    }
+  }
+  t.slots[i].id = -1;
+  t.count--;
 }
 
 
@@ -140,8 +212,7 @@ Node* HashTable::get_vertex_node(int p1, int p2)
 {
   // search for the node in the vertex hashtable
   if (p1 > p2) std::swap(p1, p2);
-  int i = hash(p1, p2);
-  Node* node = search_list(v_table[i], p1, p2);
+  Node* node = search(v_table, p1, p2);
   if (node != NULL) return node;
 
   // not found - create a new one
@@ -158,8 +229,7 @@ Node* HashTable::get_vertex_node(int p1, int p2)
   newnode->y = (nodes[p1].y + nodes[p2].y) * 0.5;
 
   // insert into hashtable
-  newnode->next_hash = v_table[i];
-  v_table[i] = newnode;
+  insert_into(v_table, p1, p2, newnode->id);
 
   return newnode;
 }
@@ -168,8 +238,7 @@ Node* HashTable::get_edge_node(int p1, int p2)
 {
   // search for the node in the edge hashtable
   if (p1 > p2) std::swap(p1, p2);
-  int i = hash(p1, p2);
-  Node* node = search_list(e_table[i], p1, p2);
+  Node* node = search(e_table, p1, p2);
   if (node != NULL) return node;
 
   // not found - create a new one
@@ -185,8 +254,7 @@ Node* HashTable::get_edge_node(int p1, int p2)
   newnode->elem[0] = newnode->elem[1] = NULL;
 
   // insert into hashtable
-  newnode->next_hash = e_table[i];
-  e_table[i] = newnode;
+  insert_into(e_table, p1, p2, newnode->id);
 
   return newnode;
 }
@@ -195,33 +263,21 @@ Node* HashTable::get_edge_node(int p1, int p2)
 Node* HashTable::peek_vertex_node(int p1, int p2)
 {
   if (p1 > p2) std::swap(p1, p2);
-  return search_list(v_table[hash(p1, p2)], p1, p2);
+  return search(v_table, p1, p2);
 }
 
 
 Node* HashTable::peek_edge_node(int p1, int p2)
 {
   if (p1 > p2) std::swap(p1, p2);
-  return search_list(e_table[hash(p1, p2)], p1, p2);
+  return search(e_table, p1, p2);
 }
 
 
 void HashTable::remove_vertex_node(int id)
 {
   // remove the node from the hash table
-  int i = hash(nodes[id].p1, nodes[id].p2);
-  Node** ptr = v_table + i;
-  Node* node = *ptr;
-  while (node != NULL)
-  {
-    if (node->id == id)
-    {
-      *ptr = node->next_hash;
-      break;
-    }
-    ptr = &node->next_hash;
-    node = *ptr;
-  }
+  remove_from(v_table, id);
 
   // remove node from the array
   nodes.remove(id);
@@ -231,19 +287,7 @@ void HashTable::remove_vertex_node(int id)
 void HashTable::remove_edge_node(int id)
 {
   // remove the node from the hash table
-  int i = hash(nodes[id].p1, nodes[id].p2);
-  Node** ptr = e_table + i;
-  Node* node = *ptr;
-  while (node != NULL)
-  {
-    if (node->id == id)
-    {
-      *ptr = node->next_hash;
-      break;
-    }
-    ptr = &node->next_hash;
-    node = *ptr;
-  }
+  remove_from(e_table, id);
 
   // remove node from the array
   nodes.remove(id);
@@ -27,6 +27,13 @@ struct Node;
 /// HashTable is a base class for Mesh. It serves as a container for all nodes
 /// of a mesh. Moreover, it has node searching functions based on hash tables.
 ///
+/// Vertex and edge nodes are searched for by the id's of their parents in two
+/// open-addressing tables with linear probing. A slot stores the (sorted) parent
+/// id's together with the id of the node, so that a search reads only consecutive
+/// slots and touches the node array just once, when the node is found. A table
+/// doubles its size when it gets half full, removed nodes are deleted by shifting
+/// the following slots back (no tombstones are left in the table).
+///
 class HERMES_API HashTable
 {
 public:
@@ -63,10 +70,10 @@ public:
 protected:
   Array<Node> nodes; ///< Array storing all nodes
 
-  static const int H2D_DEFAULT_HASH_SIZE = 0x20000; // 128K entries
+  static const int H2D_DEFAULT_HASH_SIZE = 0x1000; // 4K entries, the tables grow as needed
 
   /// Initializes the hash table.
-  /// \param size [in] Hash table size; must be a power of two.
+  /// \param size [in] Initial hash table size; must be a power of two.
   void init(int size = H2D_DEFAULT_HASH_SIZE);
 
   /// Copies another hash table contents
@@ -75,6 +82,10 @@ protected:
   /// Reconstructs the hashtable, after, e.g., the nodes have been loaded from a file.
   void rebuild();
 
+  /// Prepares for adding nodes up to the id 'nnodes': reserves the node array and enlarges
+  /// the hash tables, so that they do not have to grow while the nodes are added.
+  void reserve(int nnodes);
+
   /// Frees all memory used by the instance.
   void free();
 
@@ -91,20 +102,53 @@ protected:
 // Internal members
 private:
 
-  Node** v_table; ///< Vertex node hash table
-  Node** e_table; ///< Edge node hash table
+  /// Slot of a hash table.
+  struct Slot
+  {
+    int p1, p2; ///< parent id numbers, p1 < p2
+    int id;     ///< node id number, -1 if the slot is empty
+  };
+
+  /// Open-addressing hash table of vertex or edge nodes.
+  struct Table
+  {
+    Slot* slots;
+    int mask;   ///< number of slots - 1
+    int count;  ///< number of used slots
+  };
+
+  Table v_table; ///< Vertex node hash table
+  Table e_table; ///< Edge node hash table
 
-  int mask;
   int nqueries, ncollisions;
 
-  int hash(int p1, int p2) { return (984120265*p1 + 125965121*p2) & mask; }
+  static int hash(int p1, int p2)
+  {
+    unsigned int h = 984120265u*p1 + 125965121u*p2;
+    return (int) (h ^ (h >> 16));
+  }
+
+  /// Allocates an empty table with 'size' slots.
+  void alloc_table(Table& t, int size);
+
+  /// Frees the slots of a table.
+  void free_table(Table& t);
+
+  /// Returns the index of the slot with the parent ids p1 and p2 (p1 < p2),
+  /// or of the empty slot where such node would be inserted.
+  int find_slot(const Table& t, int p1, int p2);
+
+  /// Searches a table for the node with the parent ids p1 and p2.
+  Node* search(Table& t, int p1, int p2);
+
+  /// Stores a node in a table (the node must not be there yet).
+  void insert_into(Table& t, int p1, int p2, int id);
 
-  /// Searches a list of hash synonyms given the first list item.
-  /// Returns the node matching the parent ids p1 and p2.
-  Node* search_list(Node* node, int p1, int p2);
+  /// Doubles the size of a table.
+  void grow(Table& t);
 
-  /// Creates a copy of a hash synonym list.
-  void copy_list(Node** ptr, Node* node);
+  /// Removes the node from a table.
+  void remove_from(Table& t, int id);
 
   friend struct Node;
   friend class H2DReader;
@@ -125,6 +125,7 @@ Mesh::Mesh() : HashTable()
 {
   nbase = nactive = ntopvert = ninitial = 0;
   seq = g_mesh_seq++;
+  curved_sons = NULL;
 }
 
 Element* Mesh::get_element(int id) const
@@ -335,6 +336,16 @@ Element* create_quad(Mesh* mesh, int marker, Node* v0, Node* v1, Node* v2, Node*
   return e;
 }
 
+// projects the reference mapping of a new curved son, unless Mesh::refine_elements()
+// collects the sons to project them later (in parallel)
+static void update_son_refmap(Mesh* mesh, Element* son)
+{
+  if (mesh != NULL && mesh->curved_sons != NULL)
+    mesh->curved_sons->push_back(son);
+  else
+    son->cm->update_refmap_coeffs(son);
+}
+
 static CurvMap* create_son_curv_map(Element* e, int son)
 {
   // if the top three bits of part are nonzero, we would overflow
@@ -408,7 +419,7 @@ void refine_triangle_to_triangles(Mesh* mesh, Element* e, Element** sons_out)
   // update coefficients of curved reference mapping
   for (int i = 0; i < 4; i++)
     if (sons[i]->is_curved())
-      sons[i]->cm->update_refmap_coeffs(sons[i]);
+      update_son_refmap(mesh, sons[i]);
 
   // deactivate this element and unregister from its nodes
   e->active = 0;
@@ -641,7 +652,7 @@ void refine_quad(Mesh* mesh, Element* e, int refinement, Element** sons_out)
   // update coefficients of curved reference mapping
   for (i = 0; i < 4; i++)
     if (sons[i] != NULL && sons[i]->cm != NULL)
-      sons[i]->cm->update_refmap_coeffs(sons[i]);
+      update_son_refmap(mesh, sons[i]);
 
   // optimization: iro never gets worse
   if (e->iro_cache == 0)
@@ -733,13 +744,99 @@ void Mesh::refine_element_id(int id, int refinement)
   refine_element(this, e, refinement);
 }
 
+// one of the threads projecting the reference mappings of curved sons in refine_elements()
+struct CurvedSonsJob
+{
+  std::vector<Element*>* sons;
+  int first, step;
+  CurvMapWorkspace* ws;
+};
+
+static void* project_curved_sons(void* data)
+{
+  CurvedSonsJob* job = (CurvedSonsJob*) data;
+  std::vector<Element*>& sons = *job->sons;
+  for (int i = job->first; i < (int) sons.size(); i += job->step)
+    sons[i]->cm->update_refmap_coeffs(sons[i], job->ws);
+  return NULL;
+}
+
+void Mesh::refine_elements(const Hermes::vector<int>& ids, const Hermes::vector<int>& refinements,
+                           int num_threads)
+{
+  if (refinements.size() > 0 && refinements.size() != ids.size())
+    error("The number of refinements does not match the number of elements.");
+
+  // check the elements and estimate the number of new elements and nodes
+  int new_elems = 0, new_nodes = 0;
+  for (unsigned int i = 0; i < ids.size(); i++)
+  {
+    Element* e = get_element(ids[i]);
+    if (!e->used) error("Invalid element id number.");
+    if (!e->active) error("Attempt to refine element #%d which has been refined already.", e->id);
+    int r = refinements.size() > 0 ? refinements[i] : 0;
+    if (e->is_triangle()) { new_elems += (r == 3) ? 3 : 4; new_nodes += (r == 3) ? 10 : 9; }
+    else if (r == 0)      { new_elems += 4; new_nodes += 12; }
+    else                  { new_elems += 2; new_nodes += 5; }
+  }
+  elements.reserve(get_max_element_id() + new_elems);
+  HashTable::reserve(get_max_node_id() + new_nodes);
+
+  // create the mid-edge vertex nodes of all elements in one pass (quads refined
+  // with refinement 1 split edges 1 and 3, with refinement 2 edges 0 and 2)
+  for (unsigned int i = 0; i < ids.size(); i++)
+  {
+    Element* e = get_element_fast(ids[i]);
+    int r = refinements.size() > 0 ? refinements[i] : 0;
+    for (unsigned int j = 0; j < e->nvert; j++)
+      if (e->is_triangle() || r == 0 || (r == 1) == (j & 1))
+        get_vertex_node(e->vn[j]->id, e->vn[e->next_vert(j)]->id);
+  }
+
+  // refine the elements in the given order, so that the node and element ids do not
+  // depend on the number of threads; with more threads, the reference mappings
+  // of curved sons are projected afterwards
+  std::vector<Element*> sons;
+  if (num_threads > 1) curved_sons = &sons;
+  elements.set_append_only(true);
+  for (unsigned int i = 0; i < ids.size(); i++)
+    refine_element_id(ids[i], refinements.size() > 0 ? refinements[i] : 0);
+  elements.set_append_only(false);
+  curved_sons = NULL;
+
+  if (sons.empty()) return;
+  int n = std::min(num_threads, (int) sons.size());
+  pthread_t* threads = new pthread_t[n];
+  CurvedSonsJob* jobs = new CurvedSonsJob[n];
+  for (int t = 0; t < n; t++)
+  {
+    jobs[t].sons = &sons;
+    jobs[t].first = t;
+    jobs[t].step = n;
+    jobs[t].ws = CurvMap::create_workspace();
+  }
+  for (int t = 0; t < n; t++)
+    if (pthread_create(&threads[t], NULL, project_curved_sons, jobs + t) != 0)
+      error("Failed to create a thread for projecting curved elements.");
+  for (int t = 0; t < n; t++)
+  {
+    pthread_join(threads[t], NULL);
+    CurvMap::free_workspace(jobs[t].ws);
+  }
+  delete [] jobs;
+  delete [] threads;
+}
+
 void Mesh::refine_all_elements(int refinement, bool mark_as_initial)
 {
   Element* e;
-  elements.set_append_only(true);
+  Hermes::vector<int> ids, refinements;
   for_all_active_elements(e, this)
-    refine_element_id(e->id, refinement);
-  elements.set_append_only(false);
+  {
+    ids.push_back(e->id);
+    refinements.push_back(refinement);
+  }
+  refine_elements(ids, refinements);
   if(mark_as_initial)
     ninitial = this->get_max_element_id();
 }
@@ -751,14 +848,16 @@ static char* rtb_vert;
 void Mesh::refine_by_criterion(int (*criterion)(Element*), int depth)
 {
   Element* e;
-  elements.set_append_only(true);
   for (int r, i = 0; i < depth; i++) {
+    Hermes::vector<int> ids, refinements;
     for_all_active_elements(e, this) {
-      if ((r = criterion(e)) >= 0)
-        refine_element_id(e->id, r);
+      if ((r = criterion(e)) >= 0) {
+        ids.push_back(e->id);
+        refinements.push_back(r);
+      }
     }
+    refine_elements(ids, refinements);
   }
-  elements.set_append_only(false);
 }
 
 static int rtv_id;
@@ -917,6 +1016,7 @@ Nurbs* Mesh::reverse_nurbs(Nurbs* nurbs)
   Nurbs* rev = new Nurbs;
   *rev = *nurbs;
   rev->twin = true;
+  rev->id = ++Nurbs::next_id;
 
   rev->pt = new double3[nurbs->np];
   for (int i = 0; i < nurbs->np; i++)
@@ -1050,7 +1150,6 @@ void Mesh::create(int nv, double2* verts, int nt, int4* tris,
     node->type = HERMES_TYPE_VERTEX;
     node->bnd = 0;
     node->p1 = node->p2 = -1;
-    node->next_hash = NULL;
     node->x = verts[i][0];
     node->y = verts[i][1];
   }
@@ -1718,7 +1817,7 @@ void Mesh::refine_triangle_to_quads(Mesh* mesh, Element* e, Element** sons_out)
   // update coefficients of curved reference mapping
   for (int i = 0; i < 3; i++)
     if (sons[i]->is_curved())
-      sons[i]->cm->update_refmap_coeffs(sons[i]);
+      update_son_refmap(mesh, sons[i]);
 
   // deactivate this element and unregister from its nodes
   e->active = 0;
@@ -55,7 +55,6 @@ struct HERMES_API Node
   };
 
   int p1, p2; ///< parent id numbers
-  Node* next_hash; ///< next node in hash synonym list
 
   bool is_constrained_vertex() const { assert(type == HERMES_TYPE_VERTEX); return ref <= 3 && !bnd; }
 
@@ -227,6 +226,17 @@ public:
   /// refine vertically.
   void refine_element_id(int id, int refinement = 0);
 
+  /// Refines a batch of elements: the element ids[i] with refinements[i], which has the same
+  /// meaning as in refine_element_id(), or 3 to split a triangle into three quads (if
+  /// 'refinements' is empty, all elements are refined uniformly). The node and element
+  /// arrays and the node hash table are enlarged once for the whole batch, and the
+  /// mid-edge vertex nodes are created in one pass before the elements are refined in the
+  /// given order. The reference mappings of the sons of curved elements are projected by
+  /// 'num_threads' threads; the ids of the new nodes and elements do not depend on it.
+  void refine_elements(const Hermes::vector<int>& ids,
+                       const Hermes::vector<int>& refinements = Hermes::vector<int>(),
+                       int num_threads = 1);
+
   /// Refines all elements.
   /// \param refinement [in] Same meaning as in refine_element_id().
   void refine_all_elements(int refinement = 0, bool mark_as_initial = false);
@@ -319,6 +329,9 @@ public:
   int nactive;
   unsigned seq;
 
+  /// For internal use: the sons of curved elements waiting for projection (see refine_elements()).
+  std::vector<Element*>* curved_sons;
+
 protected:
 
   int nbase, ntopvert;
@@ -87,17 +87,19 @@ void NeighborSearch::reset_neighb_info()
   neighb_el = NULL;
   neighbor_edge.local_num_of_edge = 0;
 
+  // Reset transformations. Only the rows of the current neighbors are ever written
+  // (the rest is kept zero), clearing the whole tables (4 MB) would dominate the
+  // assembling of every inner edge.
+  memset(central_transformations, 0, n_neighbors*max_n_trans*sizeof(unsigned int));
+  memset(neighbor_transformations, 0, n_neighbors*max_n_trans*sizeof(unsigned int));
+  memset(central_n_trans, 0, n_neighbors*sizeof(unsigned int));
+  memset(neighbor_n_trans, 0, n_neighbors*sizeof(unsigned int));
+  neighborhood_type = H2D_DG_NOT_INITIALIZED;
+
   // Clear vectors with neighbor elements and their edge info for the active edge.
   neighbor_edges.clear();
   neighbors.clear();
   n_neighbors = 0;
-
-  // Reset transformations.
-  memset(central_transformations, 0, max_neighbors*max_n_trans*sizeof(unsigned int));
-  memset(neighbor_transformations, 0, max_neighbors*max_n_trans*sizeof(unsigned int));
-  memset(central_n_trans, 0, max_neighbors*sizeof(unsigned int));
-  memset(neighbor_n_trans, 0, max_neighbors*sizeof(unsigned int));
-  neighborhood_type = H2D_DG_NOT_INITIALIZED;
 }
 
 void NeighborSearch::set_active_edge(int edge)
@@ -81,6 +81,11 @@ public:
   int get_safe_max_order() const { return safe_max_order[mode]; }
   int get_num_tables() const { return num_tables[mode]; }
 
+  // The same in the given mode, regardless of the current one.
+  int get_num_points(int order, int mode) const { return np[mode][order]; };
+  double3* get_points(int order, int mode) const { assert(order < num_tables[mode]); return tables[mode][order]; }
+  int get_num_tables(int mode) const { return num_tables[mode]; }
+
   double2* get_ref_vertex(int n) { return &ref_vert[mode][n]; }
 
 protected:
@@ -18,7 +18,8 @@
 
 RungeKutta::RungeKutta(DiscreteProblem* dp, ButcherTable* bt, MatrixSolverType matrix_solver, bool start_from_zero_K_vector, bool residual_as_vector) 
     : dp(dp), is_linear(dp->get_is_linear()), bt(bt), num_stages(bt->get_size()), stage_wf_right(bt->get_size() * dp->get_spaces().size()), 
-    stage_wf_left(dp->get_spaces().size()), start_from_zero_K_vector(start_from_zero_K_vector), residual_as_vector(residual_as_vector), iteration(0) 
+    stage_wf_left(dp->get_spaces().size()), stage_wf_dirk(dp->get_spaces().size()), mass_ndof(-1), 
+    start_from_zero_K_vector(start_from_zero_K_vector), residual_as_vector(residual_as_vector), iteration(0) 
 {
   // Check for not implemented features.
   if (matrix_solver != SOLVER_UMFPACK)
@@ -36,11 +37,47 @@ RungeKutta::RungeKutta(DiscreteProblem* dp, ButcherTable* bt, MatrixSolverType m
 
   // Vector for the left part of the residual.
   vector_left = new scalar[num_stages*  dp->get_num_dofs()];
+
+  // Solver for the mass matrix (explicit stages).
+  mass_solver = create_linear_solver(matrix_solver, &matrix_left, &vector_mass);
+
+  // Stages of diagonally implicit methods with the same diagonal 
+  // coefficient share the matrix and the solver.
+  stage_slot = new unsigned int[num_stages];
+  stage_matrix = new UMFPackMatrix*[num_stages];
+  stage_vector = new UMFPackVector*[num_stages];
+  stage_solver = new Solver*[num_stages];
+  for (unsigned int i = 0; i < num_stages; i++) {
+    stage_slot[i] = i;
+    for (unsigned int j = 0; j < i; j++)
+      if (bt->get_A(j, j) == bt->get_A(i, i)) {
+        stage_slot[i] = j;
+        break;
+      }
+    stage_matrix[i] = NULL;
+    stage_vector[i] = NULL;
+    stage_solver[i] = NULL;
+    if (bt->is_diagonally_implicit() && stage_slot[i] == i && bt->get_A(i, i) != 0.0) {
+      stage_matrix[i] = new UMFPackMatrix;
+      stage_vector[i] = new UMFPackVector;
+      stage_solver[i] = create_linear_solver(matrix_solver, stage_matrix[i], stage_vector[i]);
+    }
+  }
 }
 
 RungeKutta::~RungeKutta()
 {
   delete solver;
+  delete mass_solver;
+  for (unsigned int i = 0; i < num_stages; i++) {
+    if (stage_solver[i] != NULL) delete stage_solver[i];
+    if (stage_matrix[i] != NULL) delete stage_matrix[i];
+    if (stage_vector[i] != NULL) delete stage_vector[i];
+  }
+  delete [] stage_slot;
+  delete [] stage_matrix;
+  delete [] stage_vector;
+  delete [] stage_solver;
   delete [] K_vector;
   delete [] u_ext_vec;
   delete [] vector_left;
@@ -79,6 +116,12 @@ bool RungeKutta::rk_time_step(double current_time, double time_step, Hermes::vec
   if(error_fns != Hermes::vector<Solution*>() && bt->is_embedded() == false)
     error("rk_time_step(): R-K method must be embedded if temporal error estimate is requested.");
 
+  // Explicit and diagonally implicit methods are solved stage by stage.
+  if (bt->is_diagonally_implicit())
+    return rk_time_step_dirk(current_time, time_step, slns_time_prev, slns_time_new, 
+                             error_fns, jacobian_changed, verbose, newton_tol, newton_max_iter,
+                             newton_damping_coeff, newton_max_allowed_residual_norm);
+
   // All Spaces of the problem.
   Hermes::vector<Space*> stage_spaces_vector;
   
@@ -105,7 +148,6 @@ bool RungeKutta::rk_time_step(double current_time, double time_step, Hermes::vec
   // matrix and residula vector coming from the function f(...). Of course the RK equation is assumed
   // in a form suitable for the Newton's method: k_i - f(...) = 0. At the end, matrix_left and vector_left
   // are added to matrix_right and vector_right, respectively.
-  DiscreteProblem stage_dp_left(&stage_wf_left, dp->get_spaces());
   DiscreteProblem stage_dp_right(&stage_wf_right, stage_spaces_vector);
 
   // Prepare residuals of stage solutions.
@@ -127,9 +169,9 @@ bool RungeKutta::rk_time_step(double current_time, double time_step, Hermes::vec
 
   // Assemble the block-diagonal mass matrix M of size ndof times ndof.
   // The corresponding part of the global residual vector is obtained 
-  // just by multiplication with the stage vector K.
-  // FIXME: This should not be repeated if spaces have not changed.
-  stage_dp_left.assemble(&matrix_left, NULL);
+  // just by multiplication with the stage vector K. This is not 
+  // repeated if spaces have not changed.
+  update_mass_matrix();
 
   // The Newton's loop.
   double residual_norm;
@@ -261,6 +303,195 @@ bool RungeKutta::rk_time_step(double current_time, double time_step, Hermes::vec
   return true;
 }
 
+bool RungeKutta::rk_time_step_dirk(double current_time, double time_step, Hermes::vector<Solution*> slns_time_prev, 
+                                   Hermes::vector<Solution*> slns_time_new, Hermes::vector<Solution*> error_fns, 
+                                   bool jacobian_changed, bool verbose, double newton_tol, int newton_max_iter,
+                                   double newton_damping_coeff, double newton_max_allowed_residual_norm)
+{
+  int ndof = dp->get_num_dofs();
+
+  // Project the previous time level solutions onto the actual spaces.
+  scalar* slns_prev_time_projection = new scalar[ndof];
+  OGProjection::project_global(dp->get_spaces(), slns_time_prev, slns_prev_time_projection, SOLVER_UMFPACK);
+
+  // Mass matrix M. Its factorization is kept until M is assembled again.
+  update_mass_matrix();
+
+  // Creates the weak formulation of one stage.
+  create_dirk_stage_wf();
+
+  // Every stage matrix has its own DiscreteProblem, so that 
+  // the sparse structure is created only once per time step.
+  DiscreteProblem** stage_dps = new DiscreteProblem*[num_stages];
+  bool* jacobian_assembled = new bool[num_stages];
+  for (unsigned int i = 0; i < num_stages; i++) {
+    stage_dps[i] = NULL;
+    if (stage_slot[i] == i)
+      stage_dps[i] = new DiscreteProblem(&stage_wf_dirk, dp->get_spaces());
+    jacobian_assembled[i] = false;
+  }
+
+  // Prepare residuals of stage solutions.
+  Hermes::vector<Solution*> residuals_vector;
+  Hermes::vector<bool> add_dir_lift;
+  for(unsigned int sln_i = 0; sln_i < dp->get_spaces().size(); sln_i++) {
+    residuals_vector.push_back(new Solution(dp->get_space(sln_i)->get_mesh()));
+    add_dir_lift.push_back(false);
+  }
+
+  // Zero utility vectors.
+  if(start_from_zero_K_vector || !iteration)
+     memset(K_vector, 0, num_stages * ndof * sizeof(scalar));
+
+  // Part of the stage solution Y_i known from the previous stages.
+  scalar* stage_base = new scalar[ndof];
+
+  bool success = true;
+  for (unsigned int i = 0; i < num_stages && success; i++) {
+    bool explicit_stage = (bt->get_A(i, i) == 0.0);
+    unsigned int slot = stage_slot[i];
+    DiscreteProblem* stage_dp = stage_dps[slot];
+    UMFPackVector* stage_rhs = explicit_stage ? &vector_mass : stage_vector[slot];
+    Solver* stage_lin_solver = explicit_stage ? mass_solver : stage_solver[slot];
+    scalar* K_i = K_vector + i * ndof;
+    scalar* Y_i = u_ext_vec + i * ndof;
+
+    set_dirk_stage(i, current_time, time_step);
+
+    // Y_n + h \sum_{j<i} a_{ij} K_j.
+    for (int idx = 0; idx < ndof; idx++) {
+      scalar increment = 0;
+      for (unsigned int j = 0; j < i; j++)
+        increment += bt->get_A(i, j) * K_vector[j * ndof + idx];
+      stage_base[idx] = time_step * increment + slns_prev_time_projection[idx];
+    }
+
+    // The Newton's loop (a single linear solve for explicit stages).
+    stage_rhs->alloc(ndof);
+    double residual_norm;
+    int it = 1;
+    while (true) {
+      // Stage solution Y_i.
+      for (int idx = 0; idx < ndof; idx++)
+        Y_i[idx] = stage_base[idx] + time_step * bt->get_A(i, i) * K_i[idx];
+
+      // Residual M K_i - F(Y_i).
+      matrix_left.multiply_with_vector(K_i, vector_left + i * ndof);
+      stage_dp->assemble(Y_i, NULL, stage_rhs, true, true);
+      stage_rhs->add_vector(vector_left + i * ndof);
+      stage_rhs->change_sign();
+
+      // Measure the residual norm.
+      if (residual_as_vector)
+        residual_norm = hermes2d.get_l2_norm(stage_rhs);
+      else {
+        Solution::vector_to_solutions(stage_rhs, dp->get_spaces(), residuals_vector, add_dir_lift);
+        residual_norm = hermes2d.calc_norms(residuals_vector);
+      }
+
+      // Info for the user.
+      if (verbose) {
+        if (it == 1) {
+          info("---- Stage %d, Newton initial residual norm: %g", i + 1, residual_norm);
+        }
+        else {
+          info("---- Stage %d, Newton iter %d, residual norm: %g", i + 1, it-1, residual_norm);
+        }
+      }
+
+      // If maximum allowed residual norm is exceeded, fail.
+      if (residual_norm > newton_max_allowed_residual_norm) {
+        if (verbose) {
+          info("Current residual norm: %g", residual_norm);
+          info("Maximum allowed residual norm: %g", newton_max_allowed_residual_norm);
+          info("Newton solve not successful, returning false.");
+        }
+        success = false;
+        break;
+      }
+
+      // If residual norm is within tolerance, or the maximum number
+      // of iteration has been reached, then quit.
+      if ((residual_norm < newton_tol || it > newton_max_iter) && it > 1)
+        break;
+
+      // Jacobian M - h a_{ii} dF/dY, shared by stages with the same a_{ii}.
+      if (!explicit_stage && (jacobian_changed || !jacobian_assembled[slot])) {
+        stage_dp->assemble(Y_i, stage_matrix[slot], NULL, true, true);
+        stage_matrix[slot]->add_matrix(&matrix_left);
+        stage_lin_solver->set_factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH);
+        jacobian_assembled[slot] = true;
+      }
+
+      // Solve the linear system. The factorization is reused 
+      // until the matrix is assembled again.
+      if(!stage_lin_solver->solve()) 
+        error ("Matrix solver failed.\n");
+      stage_lin_solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+
+      // The equation M K_i = F(Y_i) of an explicit stage 
+      // does not depend on K_i, so we are done.
+      if (explicit_stage) {
+        for (int idx = 0; idx < ndof; idx++)
+          K_i[idx] += stage_lin_solver->get_solution()[idx];
+        break;
+      }
+
+      // Add \deltaK_i^{n+1} to K_i^n.
+      for (int idx = 0; idx < ndof; idx++)
+        K_i[idx] += newton_damping_coeff * stage_lin_solver->get_solution()[idx];
+
+      // Increase iteration counter.
+      it++;
+    }
+
+    // If max number of iterations was exceeded, fail.
+    if (success && !explicit_stage && it >= newton_max_iter) {
+      if (verbose) {
+        info("Maximum allowed number of Newton iterations exceeded, returning false.");
+      }
+      success = false;
+    }
+  }
+
+  if (success) {
+    // Calculate new time level solution in the stage space (u_{n+1} = u_n + h \sum_{j=1}^s b_j k_j).
+    scalar* coeff_vec = new scalar[ndof];
+    for (int i = 0; i < ndof; i++) {
+      coeff_vec[i] = slns_prev_time_projection[i];
+      for (unsigned int j = 0; j < num_stages; j++)
+        coeff_vec[i] += time_step * bt->get_B(j) * K_vector[j * ndof + i];
+    }
+    Solution::vector_to_solutions(coeff_vec, dp->get_spaces(), slns_time_new);
+
+    // If error_fn is not NULL, use the B2-row in the Butcher's
+    // table to calculate the temporal error estimate.
+    if (error_fns != Hermes::vector<Solution *>()) {
+      for (int i = 0; i < ndof; i++) {
+        coeff_vec[i] = 0;
+        for (unsigned int j = 0; j < num_stages; j++)
+          coeff_vec[i] += (bt->get_B(j) - bt->get_B2(j)) * K_vector[j * ndof + i];
+        coeff_vec[i] *= time_step;
+      }
+      Solution::vector_to_solutions(coeff_vec, dp->get_spaces(), error_fns, add_dir_lift);
+    }
+    delete [] coeff_vec;
+    iteration++;
+  }
+
+  // Clean up.
+  for (unsigned int i = 0; i < num_stages; i++)
+    if (stage_dps[i] != NULL) delete stage_dps[i];
+  delete [] stage_dps;
+  delete [] jacobian_assembled;
+  for (unsigned int i = 0; i < residuals_vector.size(); i++) 
+    delete residuals_vector[i];
+  delete [] stage_base;
+  delete [] slns_prev_time_projection;
+
+  return success;
+}
+
 bool RungeKutta::rk_time_step(double current_time, double time_step, Hermes::vector<Solution*> slns_time_prev, 
                               Hermes::vector<Solution*> slns_time_new, bool jacobian_changed,
                               bool verbose, double newton_tol, int newton_max_iter,double newton_damping_coeff, 
@@ -286,14 +517,13 @@ bool RungeKutta::rk_time_step(double current_time, double time_step, Solution* s
                newton_damping_coeff, newton_max_allowed_residual_norm);
 }
 
-void RungeKutta::create_stage_wf(unsigned int size, double current_time, double time_step) 
+void RungeKutta::create_mass_wf() 
 {
-  // Clear the WeakForms.
+  // Clear the WeakForm.
   stage_wf_left.delete_all();
-  stage_wf_right.delete_all();
 
-  // First let's do the mass matrix (only one block ndof times ndof).
-  for(unsigned int component_i = 0; component_i < size; component_i++) {
+  // The mass matrix (only one block ndof times ndof).
+  for(unsigned int component_i = 0; component_i < dp->get_spaces().size(); component_i++) {
     if(dp->get_spaces()[component_i]->get_type() == HERMES_H1_SPACE || dp->get_spaces()[component_i]->get_type() == HERMES_L2_SPACE) {
       MatrixFormVolL2* proj_form = new MatrixFormVolL2(component_i, component_i);
       proj_form->areas.push_back(HERMES_ANY);
@@ -315,6 +545,39 @@ void RungeKutta::create_stage_wf(unsigned int size, double current_time, double
       stage_wf_left.add_matrix_form(proj_form);
     }
   }
+}
+
+bool RungeKutta::update_mass_matrix()
+{
+  Hermes::vector<Space *> spaces = dp->get_spaces();
+
+  // Check whether the spaces have changed since the last assembling.
+  bool up_to_date = (mass_ndof == dp->get_num_dofs() && mass_space_seq.size() == spaces.size());
+  for (unsigned int i = 0; i < spaces.size() && up_to_date; i++)
+    if (spaces[i]->get_seq() != mass_space_seq[i] || (int) spaces[i]->get_mesh()->get_seq() != mass_mesh_seq[i])
+      up_to_date = false;
+  if (up_to_date) 
+    return false;
+
+  create_mass_wf();
+  DiscreteProblem mass_dp(&stage_wf_left, spaces);
+  mass_dp.assemble(&matrix_left, NULL);
+  mass_solver->set_factorization_scheme(HERMES_FACTORIZE_FROM_SCRATCH);
+
+  mass_ndof = dp->get_num_dofs();
+  mass_space_seq.clear();
+  mass_mesh_seq.clear();
+  for (unsigned int i = 0; i < spaces.size(); i++) {
+    mass_space_seq.push_back(spaces[i]->get_seq());
+    mass_mesh_seq.push_back(spaces[i]->get_mesh()->get_seq());
+  }
+  return true;
+}
+
+void RungeKutta::create_stage_wf(unsigned int size, double current_time, double time_step) 
+{
+  // Clear the WeakForm.
+  stage_wf_right.delete_all();
 
   // In the rest we will take the stationary jacobian and residual forms 
   // (right-hand side) and use them to create a block Jacobian matrix of
@@ -441,6 +704,82 @@ void RungeKutta::create_stage_wf(unsigned int size, double current_time, double
   }
 }
 
+void RungeKutta::create_dirk_stage_wf() 
+{
+  // Clear the WeakForm.
+  stage_wf_dirk.delete_all();
+
+  // Original weak formulation.
+  WeakForm* wf = dp->get_weak_formulation();
+
+  // The forms of one stage are the stationary jacobian and residual 
+  // forms, the Jacobian is scaled by -h a_{ii} in set_dirk_stage(). 
+  // There are no additional external solutions, the stage solution 
+  // Y_i is passed as the coefficient vector.
+  Hermes::vector<WeakForm::MatrixFormVol *> mfvol_base = wf->get_mfvol();
+  Hermes::vector<WeakForm::MatrixFormSurf *> mfsurf_base = wf->get_mfsurf();
+  Hermes::vector<WeakForm::VectorFormVol *> vfvol_base = wf->get_vfvol();
+  Hermes::vector<WeakForm::VectorFormSurf *> vfsurf_base = wf->get_vfsurf();
+
+  for (unsigned int m = 0; m < mfvol_base.size(); m++) {
+    WeakForm::MatrixFormVol* mfv = mfvol_base[m]->clone();
+    mfv->u_ext_offset = 0;
+    mfv->adapt_eval = false;
+    mfv->adapt_order_increase = -1;
+    mfv->adapt_rel_error_tol = -1;
+    stage_wf_dirk.add_matrix_form(mfv);
+  }
+  for (unsigned int m = 0; m < mfsurf_base.size(); m++) {
+    WeakForm::MatrixFormSurf* mfs = mfsurf_base[m]->clone();
+    mfs->u_ext_offset = 0;
+    mfs->adapt_eval = false;
+    mfs->adapt_order_increase = -1;
+    mfs->adapt_rel_error_tol = -1;
+    stage_wf_dirk.add_matrix_form_surf(mfs);
+  }
+  for (unsigned int m = 0; m < vfvol_base.size(); m++) {
+    WeakForm::VectorFormVol* vfv = vfvol_base[m]->clone();
+    vfv->scaling_factor = -1.0;
+    vfv->u_ext_offset = 0;
+    vfv->adapt_eval = false;
+    vfv->adapt_order_increase = -1;
+    vfv->adapt_rel_error_tol = -1;
+    stage_wf_dirk.add_vector_form(vfv);
+  }
+  for (unsigned int m = 0; m < vfsurf_base.size(); m++) {
+    WeakForm::VectorFormSurf* vfs = vfsurf_base[m]->clone();
+    vfs->scaling_factor = -1.0;
+    vfs->u_ext_offset = 0;
+    vfs->adapt_eval = false;
+    vfs->adapt_order_increase = -1;
+    vfs->adapt_rel_error_tol = -1;
+    stage_wf_dirk.add_vector_form_surf(vfs);
+  }
+}
+
+void RungeKutta::set_dirk_stage(unsigned int stage, double current_time, double time_step)
+{
+  // The forms are changed in place, so that the WeakForm seq number 
+  // (and thus the sparse structure of the stage matrices) stays the same.
+  double stage_time = current_time + bt->get_C(stage)*time_step;
+  Hermes::vector<WeakForm::MatrixFormVol *> mfvol = stage_wf_dirk.get_mfvol();
+  Hermes::vector<WeakForm::MatrixFormSurf *> mfsurf = stage_wf_dirk.get_mfsurf();
+  Hermes::vector<WeakForm::VectorFormVol *> vfvol = stage_wf_dirk.get_vfvol();
+  Hermes::vector<WeakForm::VectorFormSurf *> vfsurf = stage_wf_dirk.get_vfsurf();
+  for (unsigned int m = 0; m < mfvol.size(); m++) {
+    mfvol[m]->scaling_factor = -time_step * bt->get_A(stage, stage);
+    mfvol[m]->set_current_stage_time(stage_time);
+  }
+  for (unsigned int m = 0; m < mfsurf.size(); m++) {
+    mfsurf[m]->scaling_factor = -time_step * bt->get_A(stage, stage);
+    mfsurf[m]->set_current_stage_time(stage_time);
+  }
+  for (unsigned int m = 0; m < vfvol.size(); m++)
+    vfvol[m]->set_current_stage_time(stage_time);
+  for (unsigned int m = 0; m < vfsurf.size(); m++)
+    vfsurf[m]->set_current_stage_time(stage_time);
+}
+
 void RungeKutta::prepare_u_ext_vec(double time_step, scalar* slns_prev_time_projection)
 {
   unsigned int ndof = dp->get_num_dofs();
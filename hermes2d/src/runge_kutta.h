@@ -23,13 +23,10 @@
 //      Dirichlet lift is not updated for different stage times as it should 
 //      be. 
 //
-// (1) With explicit and diagonally implicit methods, the matrix is treated
-//     in the same way as with fully implicit ones. To make this more 
-//     efficient, with explicit and diagonally implicit methods one should 
-//     first only solve for the upper left block, then eliminate all blocks 
-//     under it, then solve for block at position 22, eliminate all blocks 
-//     under it, etc. Currently this is not done and everything is left to 
-//     the matrix solver.   
+// (1) Explicit and diagonally implicit methods are solved stage by stage 
+//     (ndof times ndof systems, see rk_time_step_dirk()). The fully 
+//     implicit ones still assemble and solve the whole (num_stages*ndof 
+//     times num_stages*ndof) system at once. 
 //
 // (2) In example 03-timedep-adapt-space-and-time with implicit Euler 
 //     method, Newton's method takes much longer than in 01-timedep-adapt-space-only
@@ -121,6 +118,32 @@ public:
 
 
 protected:
+  /// Stage-by-stage version of rk_time_step() for explicit and diagonally implicit
+  /// Butcher's tables (A(i, j) = 0 for j > i). The stage equations are then solved
+  /// one after another, the stage i only needs K_1, ..., K_{i-1}:
+  ///   M K_i - F(t + c_i h, Y_i) = 0,  Y_i = Y_n + h \sum_{j<i} a_{ij} K_j + h a_{ii} K_i,
+  /// with the Jacobian M - h a_{ii} dF/dY of size ndof times ndof. Stages with
+  /// the same a_{ii} share the matrix; if jacobian_changed == false, it is assembled
+  /// and factorized only once per time step. For a_{ii} = 0 the stage is explicit,
+  /// K_i = M^{-1} F(t + c_i h, Y_i), and the factorization of M is kept across time
+  /// steps as long as the spaces do not change.
+  bool rk_time_step_dirk(double current_time, double time_step, Hermes::vector<Solution*> slns_time_prev, 
+                         Hermes::vector<Solution*> slns_time_new, Hermes::vector<Solution*> error_fns, 
+                         bool jacobian_changed, bool verbose, double newton_tol, int newton_max_iter, 
+                         double newton_damping_coeff, double newton_max_allowed_residual_norm);
+
+  /// Creates the weak formulation for the mass matrix M (stage_wf_left).
+  void create_mass_wf();
+
+  /// Assembles the mass matrix M into matrix_left unless the spaces are 
+  /// the same as at the last assembling. Returns true if M was assembled.
+  bool update_mass_matrix();
+
+  /// Creates the weak formulation of one stage (stage_wf_dirk) for rk_time_step_dirk(),
+  /// set_dirk_stage() then sets the scaling factors and the time of the stage.
+  void create_dirk_stage_wf();
+  void set_dirk_stage(unsigned int stage, double current_time, double time_step);
+
   /// Creates an augmented weak formulation for the multi-stage Runge-Kutta problem.
   /// The original discretized equation is M\dot{Y} = F(t, Y) where M is the mass
   /// matrix, Y the coefficient vector, and F the (nonlinear) stationary residual.
@@ -160,6 +183,26 @@ protected:
   WeakForm stage_wf_right;    // For the main part equation (written on the right),
                               // size num_stages*ndof times num_stages*ndof.
   WeakForm stage_wf_left;     // For the matrix M (size ndof times ndof).
+  WeakForm stage_wf_dirk;     // One stage of a diagonally implicit method
+                              // (size ndof times ndof).
+
+  /// Space and mesh seq numbers and ndof at the last assembling of matrix_left.
+  Hermes::vector<int> mass_space_seq;
+  Hermes::vector<int> mass_mesh_seq;
+  int mass_ndof;
+
+  /// Solver for explicit stages, M K_i = F(Y_i).
+  UMFPackVector vector_mass;
+  Solver* mass_solver;
+
+  /// Matrices, vectors and solvers for the stages of diagonally implicit methods.
+  /// Stage i uses the ones of the stage stage_slot[i], which is the first stage with
+  /// the same diagonal coefficient A(i, i) (NULL if A(i, i) = 0 or if the Butcher's
+  /// table is fully implicit).
+  unsigned int* stage_slot;
+  UMFPackMatrix** stage_matrix;
+  UMFPackVector** stage_vector;
+  Solver** stage_solver;
   
   bool start_from_zero_K_vector;
 
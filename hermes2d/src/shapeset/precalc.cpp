@@ -17,7 +17,18 @@
 #include "../quadrature/quad.h"
 #include "precalc.h"
 
+// Atomic read and increment of RefStore::generation, so that slaves can check it without
+// locking the mutex of the store.
+#ifdef _MSC_VER
+  #include <intrin.h>
+  #define H2D_PSS_READ_GENERATION(g)  _InterlockedOr((volatile long*) &(g), 0)
+  #define H2D_PSS_INC_GENERATION(g)   _InterlockedIncrement((volatile long*) &(g))
+#else
+  #define H2D_PSS_READ_GENERATION(g)  __sync_fetch_and_add(&(g), 0)
+  #define H2D_PSS_INC_GENERATION(g)   __sync_add_and_fetch(&(g), 1)
+#endif
 
+pthread_mutex_t PrecalcShapeset::constrained_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 PrecalcShapeset::PrecalcShapeset(Shapeset* shapeset)
                : RealFunction()
@@ -27,6 +38,12 @@ PrecalcShapeset::PrecalcShapeset(Shapeset* shapeset)
   master_pss = NULL;
   num_components = shapeset->get_num_components();
   assert(num_components == 1 || num_components == 2);
+
+  store = new RefStore;
+  pthread_mutex_init(&store->mutex, NULL);
+  store->generation = 0;
+
+  init();
   update_max_index();
   set_quad_2d(&g_quad_2d_std);
 }
@@ -40,16 +57,29 @@ PrecalcShapeset::PrecalcShapeset(PrecalcShapeset* pss)
   master_pss = pss;
   shapeset = pss->shapeset;
   num_components = pss->num_components;
+  store = pss->store;
+
+  init();
   update_max_index();
   set_quad_2d(&g_quad_2d_std);
 }
 
+void PrecalcShapeset::init()
+{
+  memset(ref, 0, sizeof(ref));
+  pthread_mutex_lock(&store->mutex);
+  ref_generation = store->generation;
+  pthread_mutex_unlock(&store->mutex);
+  cache_size = H2D_PSS_CACHE_SIZE;
+  overflow_node = NULL;
+  mode = HERMES_MODE_TRIANGLE;
+  index = 0;
+}
+
 void PrecalcShapeset::update_max_index()
 {
-  shapeset->set_mode(HERMES_MODE_TRIANGLE);
-  max_index[0] = shapeset->get_max_index();
-  shapeset->set_mode(HERMES_MODE_QUAD);
-  max_index[1] = shapeset->get_max_index();
+  max_index[0] = shapeset->get_max_index(HERMES_MODE_TRIANGLE);
+  max_index[1] = shapeset->get_max_index(HERMES_MODE_QUAD);
 }
 
 
@@ -58,47 +88,29 @@ void PrecalcShapeset::set_quad_2d(Quad2D* quad_2d)
   RealFunction::set_quad_2d(quad_2d);
 }
 
-void PrecalcShapeset::handle_overflow_idx()
+void PrecalcShapeset::set_cache_size(int size)
 {
-  if(overflow_nodes != NULL) {
-    for(unsigned int i = 0; i < overflow_nodes->get_size(); i++)
-      if(overflow_nodes->present(i))
-        ::free(overflow_nodes->get(i));
-    delete overflow_nodes;
+  cache_size = std::max(size, 1);
+  while ((int) cache_map.size() > cache_size)
+  {
+    cache_map.erase(cache_list.back().first);
+    total_mem -= cache_list.back().second->size;
+    ::free(cache_list.back().second);
+    cache_list.pop_back();
   }
-  nodes = new LightArray<Node *>;
-  overflow_nodes = nodes;
 }
 
 void PrecalcShapeset::set_active_shape(int index)
 {
-  // Key creation.
-  unsigned key = cur_quad | (mode << 3) | ((unsigned) (max_index[mode] - index) << 4);
-
-  if(master_pss == NULL) {
-    if(!tables.present(key))
-      tables.add(new std::map<uint64_t, LightArray<Node*>*>, key);
-    sub_tables = tables.get(key);
-  }
-  else {
-    if(!master_pss->tables.present(key))
-      master_pss->tables.add(new std::map<uint64_t, LightArray<Node*>*>, key);
-    sub_tables = master_pss->tables.get(key);
-  }
-
-  // Update the Node table.
-  update_nodes_ptr();
-
   this->index = index;
-  order = std::max(H2D_GET_H_ORDER(shapeset->get_order(index)), H2D_GET_V_ORDER(shapeset->get_order(index)));
+  int o = shapeset->get_order(index, mode);
+  order = std::max(H2D_GET_H_ORDER(o), H2D_GET_V_ORDER(o));
 }
 
 
 void PrecalcShapeset::set_active_element(Element* e)
 {
-  mode = e->get_mode();
-  shapeset->set_mode(mode);
-  get_quad_2d()->set_mode(mode);
+  set_mode(e->get_mode());
   element = e;
 }
 
@@ -106,72 +118,298 @@ void PrecalcShapeset::set_active_element(Element* e)
 void PrecalcShapeset::set_mode(int mode)  // used in curved.cpp
 {
   this->mode = mode;
-  shapeset->set_mode(mode);
-  get_quad_2d()->set_mode(mode);
   element = NULL;
+
+  // The shapeset and the quadrature are shared, only the master switches their mode
+  // (RefMap and CurvMap rely on it).
+  if (!is_slave())
+  {
+    shapeset->set_mode(mode);
+    get_quad_2d()->set_mode(mode);
+  }
+  else
+    check_generation();
+}
+
+
+void PrecalcShapeset::check_generation()
+{
+  // The mutex is taken only after free() of the master, not on every element.
+  if (ref_generation == H2D_PSS_READ_GENERATION(store->generation))
+    return;
+  pthread_mutex_lock(&store->mutex);
+  if (ref_generation != store->generation)
+    clear_ref();
+  pthread_mutex_unlock(&store->mutex);
+}
+
+
+void PrecalcShapeset::clear_ref()
+{
+  for (int i = 0; i < 4; i++)
+    if (ref[i] != NULL)
+      memset(ref[i], 0, 2 * H2D_MAX_TABLES * sizeof(RefTable*));
+  ref_generation = store->generation;
+}
+
+
+void PrecalcShapeset::set_quad_order(unsigned int order, int mask)
+{
+  if ((int) order >= H2D_MAX_TABLES || (int) order >= get_quad_2d()->get_num_tables(mode))
+    error("Order out of range (%d, %d).", order, get_quad_2d()->get_num_tables(mode));
+
+  // Shape functions on the reference element are in the shared tables.
+  if (sub_idx == 0 && index >= 0)
+  {
+    cur_node = get_ref_table(order, mask)->nodes + index;
+    return;
+  }
+
+  // Too deep transforms are not cached.
+  if (sub_idx > H2D_MAX_IDX)
+  {
+    Node* node = calculate_node(order, mask, NULL);
+    if (overflow_node != NULL)
+    {
+      total_mem -= overflow_node->size;
+      ::free(overflow_node);
+    }
+    cur_node = overflow_node = node;
+    return;
+  }
+
+  CacheKey key;
+  key.sub_idx = sub_idx;
+  key.index = index;
+  key.order = ((cur_quad << 1) + mode) * H2D_MAX_TABLES + order;
+
+  std::map<CacheKey, CacheList::iterator>::iterator it = cache_map.find(key);
+  if (it != cache_map.end())
+  {
+    CacheList::iterator li = it->second;
+    if (li != cache_list.begin())
+      cache_list.splice(cache_list.begin(), cache_list, li);
+    if ((li->second->mask & mask) != mask)
+    {
+      Node* node = calculate_node(order, mask, li->second);
+      total_mem -= li->second->size;
+      ::free(li->second);
+      li->second = node;
+    }
+    cur_node = li->second;
+    return;
+  }
+
+  cur_node = calculate_node(order, mask, NULL);
+  cache_list.push_front(std::pair<CacheKey, Node*>(key, cur_node));
+  cache_map[key] = cache_list.begin();
+  if ((int) cache_map.size() > cache_size)
+  {
+    cache_map.erase(cache_list.back().first);
+    total_mem -= cache_list.back().second->size;
+    ::free(cache_list.back().second);
+    cache_list.pop_back();
+  }
 }
 
 
 void PrecalcShapeset::precalculate(int order, int mask)
+{
+  set_quad_order(order, mask);
+}
+
+
+PrecalcShapeset::RefTable* PrecalcShapeset::get_ref_table(int order, int mask)
+{
+  if (ref[cur_quad] == NULL)
+  {
+    ref[cur_quad] = new RefTable*[2 * H2D_MAX_TABLES];
+    memset(ref[cur_quad], 0, 2 * H2D_MAX_TABLES * sizeof(RefTable*));
+  }
+
+  RefTable*& table = ref[cur_quad][mode * H2D_MAX_TABLES + order];
+  if (table != NULL && (table->mask & mask) == mask)
+    return table;
+
+  // Get the table from the store, create it if it is not there or if it is missing
+  // some expansions (the previous one then stays valid for other instances).
+  Quad2D* quad = get_quad_2d();
+  pthread_mutex_lock(&store->mutex);
+  if (ref_generation != store->generation)
+    clear_ref();
+  RefTable**& tables = store->tables[quad];
+  if (tables == NULL)
+  {
+    tables = new RefTable*[2 * H2D_MAX_TABLES];
+    memset(tables, 0, 2 * H2D_MAX_TABLES * sizeof(RefTable*));
+  }
+  RefTable*& published = tables[mode * H2D_MAX_TABLES + order];
+  if (published == NULL || (published->mask & mask) != mask)
+  {
+    RefTable* prev = published;
+    published = create_ref_table(quad, mode, order, mask | (prev != NULL ? prev->mask : H2D_FN_DEFAULT));
+    published->prev = prev;
+  }
+  table = published;
+  pthread_mutex_unlock(&store->mutex);
+
+  return table;
+}
+
+
+PrecalcShapeset::RefTable* PrecalcShapeset::create_ref_table(Quad2D* quad, int mode, int order, int mask)
+{
+  int np = quad->get_num_points(order, mode);
+  double3* pt = quad->get_points(order, mode);
+  int ns = max_index[mode] + 1;
+
+  int nt = 0;
+  for (int j = 0; j < num_components; j++)
+    for (int k = 0; k < 6; k++)
+      if (mask & idx2mask[k][j]) nt++;
+
+  RefTable* table = new RefTable;
+  table->mask = mask;
+  table->np = np;
+  table->num_shapes = ns;
+  table->data = new double[nt * ns * np];
+  table->nodes = (Node*) malloc(ns * sizeof(Node));
+  table->prev = NULL;
+  for (int s = 0; s < ns; s++)
+  {
+    table->nodes[s].mask = mask;
+    table->nodes[s].size = 0;
+    memset(table->nodes[s].values, 0, sizeof(table->nodes[s].values));
+  }
+
+  double* data = table->data;
+  for (int j = 0; j < num_components; j++)
+  {
+    for (int k = 0; k < 6; k++)
+    {
+      if (!(mask & idx2mask[k][j])) continue;
+      for (int s = 0; s < ns; s++)
+      {
+        double* val = data + s * np;
+        if (shapeset->has_shape(s, mode))
+          for (int i = 0; i < np; i++)
+            val[i] = shapeset->get_value(k, s, pt[i][0], pt[i][1], j, mode);
+        else
+          memset(val, 0, np * sizeof(double));
+        table->nodes[s].values[j][k] = val;
+      }
+      data += ns * np;
+    }
+  }
+
+  return table;
+}
+
+
+PrecalcShapeset::Node* PrecalcShapeset::calculate_node(int order, int mask, Node* old_node)
 {
   int i, j, k;
 
-  // initialization
   Quad2D* quad = get_quad_2d();
-  quad->set_mode(mode);
-  H2D_CHECK_ORDER(quad, order);
-  int np = quad->get_num_points(order);
-  double3* pt = quad->get_points(order);
+  int np = quad->get_num_points(order, mode);
+  double3* pt = quad->get_points(order, mode);
 
-  int oldmask = (cur_node != NULL) ? cur_node->mask : 0;
+  int oldmask = (old_node != NULL) ? old_node->mask : 0;
   int newmask = mask | oldmask;
   Node* node = new_node(newmask, np);
 
-  // precalculate all required tables
+  // Values of constrained shape functions depend on the mode of the shapeset and on
+  // the combinations it calculates on demand, so these are evaluated one at a time
+  // (the shapeset may be used by several masters) and the mode is restored afterwards.
+  bool constrained = (index < 0);
+  int shapeset_mode = 0;
+  if (constrained)
+  {
+    pthread_mutex_lock(&constrained_mutex);
+    shapeset_mode = shapeset->get_mode();
+    shapeset->set_mode(mode);
+  }
+
   for (j = 0; j < num_components; j++)
   {
     for (k = 0; k < 6; k++)
     {
       if (newmask & idx2mask[k][j]) {
         if (oldmask & idx2mask[k][j])
-          memcpy(node->values[j][k], cur_node->values[j][k], np * sizeof(double));
-        else
+          memcpy(node->values[j][k], old_node->values[j][k], np * sizeof(double));
+        else if (constrained)
           for (i = 0; i < np; i++)
             node->values[j][k][i] = shapeset->get_value(k, index, ctm->m[0] * pt[i][0] + ctm->t[0],
                                                                   ctm->m[1] * pt[i][1] + ctm->t[1], j);
+        else
+          for (i = 0; i < np; i++)
+            node->values[j][k][i] = shapeset->get_value(k, index, ctm->m[0] * pt[i][0] + ctm->t[0],
+                                                                  ctm->m[1] * pt[i][1] + ctm->t[1], j, mode);
       }
     }
   }
-  if(nodes->present(order)) {
-    assert(nodes->get(order) == cur_node);
-    ::free(nodes->get(order));
+
+  if (constrained)
+  {
+    shapeset->set_mode(shapeset_mode);
+    pthread_mutex_unlock(&constrained_mutex);
+  }
+
+  return node;
+}
+
+
+void PrecalcShapeset::free_cache()
+{
+  for (CacheList::iterator it = cache_list.begin(); it != cache_list.end(); it++)
+  {
+    total_mem -= it->second->size;
+    ::free(it->second);
+  }
+  cache_list.clear();
+  cache_map.clear();
+
+  if (overflow_node != NULL)
+  {
+    total_mem -= overflow_node->size;
+    ::free(overflow_node);
+    overflow_node = NULL;
   }
-  nodes->add(node, order);
-  cur_node = node;
+  cur_node = NULL;
 }
 
 
 void PrecalcShapeset::free()
 {
+  free_cache();
+  for (int i = 0; i < 4; i++)
+  {
+    delete [] ref[i];
+    ref[i] = NULL;
+  }
+
   if (master_pss != NULL) return;
 
-  for(unsigned int i = 0; i < tables.get_size(); i++)
-    if(tables.present(i)) {
-      for(std::map<uint64_t, LightArray<Node*>*>::iterator it = tables.get(i)->begin(); it != tables.get(i)->end(); it++) {
-        for(unsigned int k = 0; k < it->second->get_size(); k++)
-          if(it->second->present(k))
-            ::free(it->second->get(k));
-        delete it->second;
+  pthread_mutex_lock(&store->mutex);
+  for (std::map<Quad2D*, RefTable**>::iterator it = store->tables.begin(); it != store->tables.end(); it++)
+  {
+    for (int i = 0; i < 2 * H2D_MAX_TABLES; i++)
+    {
+      RefTable* table = it->second[i];
+      while (table != NULL)
+      {
+        RefTable* prev = table->prev;
+        delete [] table->data;
+        ::free(table->nodes);
+        delete table;
+        table = prev;
       }
-      delete tables.get(i);
     }
-
-  if(overflow_nodes != NULL) {
-    for(unsigned int i = 0; i < overflow_nodes->get_size(); i++)
-      if(overflow_nodes->present(i))
-        ::free(overflow_nodes->get(i));
-    delete overflow_nodes;
+    delete [] it->second;
   }
+  store->tables.clear();
+  H2D_PSS_INC_GENERATION(store->generation);
+  pthread_mutex_unlock(&store->mutex);
 }
 
 extern PrecalcShapeset ref_map_pss;
@@ -179,18 +417,9 @@ extern PrecalcShapeset ref_map_pss;
 PrecalcShapeset::~PrecalcShapeset()
 {
   free();
+  if (master_pss == NULL)
+  {
+    pthread_mutex_destroy(&store->mutex);
+    delete store;
+  }
 }
-
-void PrecalcShapeset::push_transform(int son)
-{
-  Transformable::push_transform(son);
-  if(sub_tables != NULL)
-    update_nodes_ptr();
-}
-
-void PrecalcShapeset::pop_transform()
-{
-  Transformable::pop_transform();
-  if(sub_tables != NULL)
-    update_nodes_ptr();
-}
\ No newline at end of file
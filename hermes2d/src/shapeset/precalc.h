@@ -18,12 +18,31 @@
 
 #include "../function/function.h"
 #include "../shapeset/shapeset.h"
+#include <list>
+
+/// Default number of tables in the cache of transformed shape functions of a PrecalcShapeset.
+#define H2D_PSS_CACHE_SIZE  1024
 
 
 /// \brief Caches precalculated shape function values.
 ///
 /// PrecalcShapeset is a cache of precalculated shape function values.
 ///
+/// Values of shape functions on the reference element (no sub-element transform) are kept in
+/// reference tables, one for each quadrature, mode and order, holding all shape functions of
+/// the shapeset in the layout [component][expansion][shape][point]. A published table is never
+/// changed (a request for more expansions replaces it by a new one), so the tables are shared
+/// read-only by the master instance and all its slaves; they are created under a mutex, and
+/// each instance keeps its own pointers to them.
+///
+/// Slaves of one master can be used in parallel threads: they do not change the mode of the
+/// shapeset and of the quadrature (the master does, RefMap and CurvMap rely on it), and the
+/// shared state is only read under the mutex. The master itself must not be used, and must
+/// not be freed, while its slaves are used in other threads.
+///
+/// Values on sub-elements (after push_transform()) and values of constrained shape functions
+/// are kept by each instance in a small LRU cache (see set_cache_size()). The values returned
+/// by get_fn_values() etc. are valid until the next call to set_quad_order().
 ///
 class HERMES_API PrecalcShapeset : public RealFunction
 {
@@ -39,6 +58,7 @@ public:
   /// the slave can have different shape function active, different transform
   /// selected, etc. Slave pss's are used for test functions when calling
   /// bilinear forms, inside Solution so as not to disrupt user's pss, etc.
+  /// A slave must not outlive its master.
   /// \param master_pss [in] Master precalculated shapeset pointer.
   PrecalcShapeset(PrecalcShapeset* master_pss);
 
@@ -54,9 +74,8 @@ public:
   /// Switches the class to the appropriate mode (triangle, quad).
   virtual void set_active_element(Element* e);
 
-  /// Virtual function handling overflows. Has to be virtual, because
-  /// the necessary iterators in the templated class do not work with GCC.
-  virtual void handle_overflow_idx();
+  /// Not used, transformed values are cached in the LRU cache.
+  virtual void handle_overflow_idx() {}
 
   /// Activates a shape function given by its index. The values of the shape function
   /// can then be obtained by setting the required integration rule order by calling
@@ -67,13 +86,18 @@ public:
   /// Returns the index of the active shape (can be negative if the shape is constrained).
   int get_active_shape() const { return index; };
 
+  /// Selects the values of the active shape function for the given integration rule,
+  /// see Function::set_quad_order().
+  virtual void set_quad_order(unsigned int order, int mask = H2D_FN_DEFAULT);
+
   /// Returns a pointer to the shapeset which is being precalculated.
   Shapeset* get_shapeset() const { return shapeset; }
 
   /// Returns type of space
   ESpaceType get_space_type() const { return shapeset->get_space_type(); }
 
-  /// Internal. Use set_active_element() instead.
+  /// Internal. Use set_active_element() instead. Unlike slaves, the master also switches
+  /// the mode of the shapeset and of the quadrature.
   void set_mode(int mode);
 
   /// For internal use only.
@@ -87,27 +111,71 @@ public:
   }
 
   /// Returns the polynomial order of the active shape function on given edge.
-  virtual int get_edge_fn_order(int edge) { return Hermes2D::make_edge_order(mode, edge, shapeset->get_order(index)); }
+  virtual int get_edge_fn_order(int edge) { return Hermes2D::make_edge_order(mode, edge, shapeset->get_order(index, mode)); }
 
-  /// See Transformable::push_transform.
-  virtual void push_transform(int son);
+  /// Sets the maximum number of tables in the cache of transformed and constrained
+  /// shape functions of this instance.
+  void set_cache_size(int size);
 
-  virtual void pop_transform();
+  /// Maximum number of orders (quadrature tables, including the edge ones) of a quadrature.
+  static const int H2D_MAX_TABLES = g_max_quad + 1 + 4 * g_max_quad + 4;
 
 protected:
 
   Shapeset* shapeset;
 
-  /// Main structure.
-  /// There is a 3-layer structure of the precalculated tables.
-  /// The first (the lowest) one is the layer where mapping of integral orders to
-  /// Function::Node takes place. See function.h for details.
-  /// The second one is the layer with mapping of sub-element transformation to
-  /// a table from the lowest layer.
-  /// The highest and most complicated one maps a key formed by
-  /// quadrature table selector (0-7), mode of the shape function (triangle/quad),
-  /// and shape function index to a table from the middle layer.
-  LightArray<std::map<uint64_t, LightArray<Node*>*>*> tables;
+  /// Values of all (unconstrained) shape functions on the reference element for one
+  /// quadrature, mode and order.
+  struct RefTable
+  {
+    int mask;          ///< Expansions present (H2D_FN_XXX).
+    int np;            ///< Number of points.
+    int num_shapes;    ///< max_index + 1.
+    double* data;      ///< Values, [component][expansion][shape][point], only the expansions in 'mask'.
+    Node* nodes;       ///< Headers for the individual shapes, their values point to 'data'.
+    RefTable* prev;    ///< The table replaced by this one (it is freed with this one).
+  };
+
+  /// Reference tables shared by the master and its slaves.
+  struct RefStore
+  {
+    pthread_mutex_t mutex;
+    int generation;    ///< Incremented by free() of the master, invalidates the pointers of slaves (written under the mutex, read atomically).
+    /// Tables for each quadrature, [mode * H2D_MAX_TABLES + order].
+    std::map<Quad2D*, RefTable**> tables;
+  };
+
+  /// Key of a table in the LRU cache.
+  struct CacheKey
+  {
+    uint64_t sub_idx;
+    int index;
+    int order;         ///< Also the quadrature (cur_quad) and the mode.
+    bool operator<(const CacheKey& other) const
+    {
+      if (sub_idx != other.sub_idx) return sub_idx < other.sub_idx;
+      if (index != other.index) return index < other.index;
+      return order < other.order;
+    }
+  };
+
+  typedef std::list<std::pair<CacheKey, Node*> > CacheList;
+
+  RefStore* store;     ///< Owned by the master.
+
+  /// Pointers to the reference tables used by this instance, for each quadrature slot
+  /// (cur_quad), [mode * H2D_MAX_TABLES + order].
+  RefTable** ref[4];
+  int ref_generation;
+
+  /// LRU cache of transformed and constrained shape functions of this instance,
+  /// the most recently used table first.
+  CacheList cache_list;
+  std::map<CacheKey, CacheList::iterator> cache_map;
+  int cache_size;
+
+  /// Values for transforms deeper than H2D_MAX_IDX (these are not cached).
+  Node* overflow_node;
 
   int mode;
   int index;
@@ -117,8 +185,30 @@ protected:
 
   bool is_slave() const { return master_pss != NULL; }
 
+  void init();
+
   virtual void precalculate(int order, int mask);
 
+  /// Returns the reference table of the current quadrature and mode containing at least 'mask'.
+  RefTable* get_ref_table(int order, int mask);
+
+  /// Creates a reference table (called with the mutex of the store locked).
+  RefTable* create_ref_table(Quad2D* quad, int mode, int order, int mask);
+
+  /// Drops the pointers to the reference tables if free() of the master has freed them.
+  void check_generation();
+
+  /// Drops the pointers to the reference tables (called with the mutex of the store locked).
+  void clear_ref();
+
+  /// Guards the evaluation of constrained shape functions, see calculate_node().
+  static pthread_mutex_t constrained_mutex;
+
+  /// Calculates the values of the active shape function (with the current transform) into a new node.
+  Node* calculate_node(int order, int mask, Node* old_node);
+
+  void free_cache();
+
   void update_max_index();
 
   /// Forces a transform without using push_transform() etc.
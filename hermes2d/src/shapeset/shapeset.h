@@ -92,6 +92,9 @@ public:
   /// Returns the highest shape function index.
   int get_max_index() const { return max_index[mode]; }
 
+  /// Returns the highest shape function index in the given mode.
+  int get_max_index(int mode) const { return max_index[mode]; }
+
   /// Returns 2 if this is a vector shapeset, 1 otherwise.
   int get_num_components() const { return num_components; }
 
@@ -152,28 +155,43 @@ public:
     else return ((-1 - index) >> 3) & 15;
   }
 
+  /// Returns the polynomial degree of the specified shape function in the given mode.
+  int get_order(int index, int mode) const
+  {
+    if (index >= 0) {
+      H2D_CHECK_INDEX;
+      return index_to_order[mode][index];
+    }
+    else return ((-1 - index) >> 3) & 15;
+  }
+
 
   /// Obtains the value of the given shape function. (x,y) is a coordinate in the reference
   /// domain, component is 0 for scalar shapesets and 0 or 1 for vector shapesets.
   inline double get_value(int n, int index, double x, double y, int component)
   {
     if (index >= 0)
-    {
-      H2D_CHECK_INDEX; H2D_CHECK_COMPONENT;
-      Shapeset::shape_fn_t** shape_expansion = shape_table[n][mode];
-      if (shape_expansion == NULL) { // requested exansion (f, df/dx, df/dy, ddf/dxdx, ...) is not defined
-        static int warned_mode = -1, warned_index = -1, warned_n = 1; //just to keep the number of warnings low: warn just once about a given combinations of n, mode, and index.
-        warn_if(warned_mode != mode || warned_index != index || warned_n != n, "Requested undefined expansion %d (mode: %d) of a shape %d, returning 0", n, mode, index);
-        warned_mode = mode; warned_index = index; warned_n = n;
-        return 0;
-      }
-      else
-        return shape_expansion[component][index](x, y);
-    }
+      return get_value(n, index, x, y, component, mode);
     else
       return get_constrained_value(n, index, x, y, component);
   }
 
+  /// Obtains the value of the given (unconstrained) shape function in the given mode,
+  /// regardless of the current mode (see set_mode()).
+  inline double get_value(int n, int index, double x, double y, int component, int mode)
+  {
+    H2D_CHECK_INDEX; H2D_CHECK_COMPONENT;
+    Shapeset::shape_fn_t** shape_expansion = shape_table[n][mode];
+    if (shape_expansion == NULL) { // requested exansion (f, df/dx, df/dy, ddf/dxdx, ...) is not defined
+      static int warned_mode = -1, warned_index = -1, warned_n = 1; //just to keep the number of warnings low: warn just once about a given combinations of n, mode, and index.
+      warn_if(warned_mode != mode || warned_index != index || warned_n != n, "Requested undefined expansion %d (mode: %d) of a shape %d, returning 0", n, mode, index);
+      warned_mode = mode; warned_index = index; warned_n = n;
+      return 0;
+    }
+    else
+      return shape_expansion[component][index](x, y);
+  }
+
   inline double get_fn_value (int index, double x, double y, int component) { return get_value(0, index, x, y, component); }
   inline double get_dx_value (int index, double x, double y, int component) { return get_value(1, index, x, y, component); }
   inline double get_dy_value (int index, double x, double y, int component) { return get_value(2, index, x, y, component); }
@@ -182,6 +200,14 @@ public:
   inline double get_dxy_value(int index, double x, double y, int component) { return get_value(5, index, x, y, component); }
 
 
+  /// Returns false if there is no shape function with the given (unconstrained) index in the
+  /// given mode, the index tables of some shapesets have gaps on quads.
+  bool has_shape(int index, int mode) const
+  {
+    H2D_CHECK_INDEX;
+    return shape_table[0][mode][0][index] != NULL;
+  }
+
   /// Returns the coordinates of the reference domain vertices.
   double2* get_ref_vertex(int vertex)
   {
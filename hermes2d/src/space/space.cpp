@@ -17,6 +17,7 @@
 #include "space.h"
 #include "../../../hermes_common/matrix.h"
 #include "../boundaryconditions/essential_bcs.h"
+#include "../../../hermes_common/dof_ordering.h"
 
 Space::Space(Mesh* mesh, Shapeset* shapeset, EssentialBCs* essential_bcs, Ord2 p_init)
   : shapeset(shapeset), essential_bcs(essential_bcs), mesh(mesh) {
@@ -30,8 +31,10 @@ Space::Space(Mesh* mesh, Shapeset* shapeset, EssentialBCs* essential_bcs, Ord2 p
   this->ndata_allocated = 0;
   this->mesh_seq = -1;
   this->seq = 0;
+  this->al_seq = -1;
   this->was_assigned = false;
   this->ndof = 0;
+  this->dof_ordering = HERMES_NATURAL_DOF_ORDERING;
 
   if(essential_bcs != NULL)
     for(std::vector<EssentialBoundaryCondition*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
@@ -52,6 +55,7 @@ void Space::free()
 {
   _F_
   free_extra_data();
+  free_assembly_lists();
   if (nsize) { ::free(ndata); ndata=NULL; }
   if (esize) { ::free(edata); edata=NULL; }
 }
@@ -477,6 +481,9 @@ int Space::assign_dofs(int first_dof, int stride)
 
   resize_tables();
 
+  // the DOF numbers change, the cache is built again below
+  free_assembly_lists();
+
   Element* e;
   /** \todo Find out whether the following code this is crucial.
    *  If uncommented, this enforces 0 order for all sons if the base element has 0 order.
@@ -502,6 +509,8 @@ int Space::assign_dofs(int first_dof, int stride)
   assign_vertex_dofs();
   assign_edge_dofs();
   assign_bubble_dofs();
+  if (dof_ordering != HERMES_NATURAL_DOF_ORDERING)
+    reorder_dofs();
 
   free_extra_data();
   update_essential_bc_values();
@@ -512,6 +521,8 @@ int Space::assign_dofs(int first_dof, int stride)
   was_assigned = true;
   this->ndof = (next_dof - first_dof) / stride;
 
+  build_assembly_lists();
+
   return this->ndof;
 }
 
@@ -546,6 +557,80 @@ void Space::reset_dof_assignment()
   }
 }
 
+void Space::set_dof_ordering(EDofOrdering ordering)
+{
+  _F_
+  this->dof_ordering = ordering;
+  seq++;
+
+  // since space changed, enumerate basis functions
+  this->assign_dofs();
+}
+
+void Space::reorder_dofs()
+{
+  _F_
+  // The blocks are the DOFs of the unconstrained nodes (constrained ones have no DOFs
+  // of their own yet, see update_constraints()) and the bubble DOFs of the elements.
+  // 'block_dof' points to the first DOF of the block in ndata or edata.
+  std::vector<int*> block_dof;
+  std::vector<int> block_size;
+  std::vector<int> node_block(mesh->get_max_node_id(), -1);
+  Node* n;
+  for_all_nodes(n, mesh)
+  {
+    NodeData* nd = ndata + n->id;
+    if (nd->dof >= 0 && nd->n > 0)
+    {
+      node_block[n->id] = block_dof.size();
+      block_dof.push_back(&nd->dof);
+      block_size.push_back(nd->n);
+    }
+  }
+
+  // the blocks of the active elements and their centers
+  std::vector<int> elem_ptr(1, 0), elem_blocks;
+  std::vector<double> centers;
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    double cx = 0.0, cy = 0.0;
+    for (unsigned int i = 0; i < e->nvert; i++)
+    {
+      if (node_block[e->vn[i]->id] >= 0) elem_blocks.push_back(node_block[e->vn[i]->id]);
+      cx += e->vn[i]->x;
+      cy += e->vn[i]->y;
+    }
+    for (unsigned int i = 0; i < e->nvert; i++)
+      if (node_block[e->en[i]->id] >= 0) elem_blocks.push_back(node_block[e->en[i]->id]);
+    ElementData* ed = edata + e->id;
+    if (ed->n > 0)
+    {
+      elem_blocks.push_back(block_dof.size());
+      block_dof.push_back(&ed->bdof);
+      block_size.push_back(ed->n);
+    }
+    elem_ptr.push_back(elem_blocks.size());
+    centers.push_back(cx / e->nvert);
+    centers.push_back(cy / e->nvert);
+  }
+  if (block_dof.empty()) return;
+
+  std::vector<int> order(block_dof.size());
+  dof_block_ordering(dof_ordering, block_dof.size(), elem_ptr.size() - 1, &elem_ptr[0],
+                     elem_blocks.empty() ? NULL : &elem_blocks[0],
+                     centers.empty() ? NULL : &centers[0], 2, &order[0]);
+
+  // number the blocks from 'first_dof' again, in the new order
+  int dof = first_dof;
+  for (unsigned int i = 0; i < order.size(); i++)
+  {
+    *block_dof[order[i]] = dof;
+    dof += block_size[order[i]] * stride;
+  }
+  if (dof != next_dof) error("Inconsistent DOF blocks in Space::reorder_dofs().");
+}
+
 //// assembly lists ///////////////////////////////////////////////////////////////////////////////
 
 void AsmList::enlarge()
@@ -558,6 +643,18 @@ void AsmList::enlarge()
 
 
 void Space::get_element_assembly_list(Element* e, AsmList* al)
+{
+  _F_
+  const int *idx, *dof;
+  const scalar* coef;
+  int cnt = get_element_assembly_list(e, idx, dof, coef, al);
+  if (idx != al->idx) al->copy(idx, dof, coef, cnt);
+  shapeset->set_mode(e->get_mode());
+}
+
+
+int Space::get_element_assembly_list(Element* e, const int*& idx, const int*& dof, const scalar*& coef,
+                                     AsmList* al)
 {
   _F_
   // some checks
@@ -567,6 +664,27 @@ void Space::get_element_assembly_list(Element* e, AsmList* al)
     error("The space is out of date. You need to update it with assign_dofs()"
           " any time the mesh changes.");
 
+  if (al_seq != seq || e->id >= (int) al_offset.size() || al_offset[e->id] < 0)
+  {
+    // not in the cache
+    calc_element_assembly_list(e, al);
+    idx = al->idx;
+    dof = al->dof;
+    coef = al->coef;
+    return al->cnt;
+  }
+
+  int offset = al_offset[e->id];
+  idx = &al_idx[offset];
+  dof = &al_dof[offset];
+  coef = &al_coef[offset];
+  return al_cnt[e->id];
+}
+
+
+void Space::calc_element_assembly_list(Element* e, AsmList* al)
+{
+  _F_
   // add vertex, edge and bubble functions to the assembly list
   al->clear();
   shapeset->set_mode(e->get_mode());
@@ -578,6 +696,46 @@ void Space::get_element_assembly_list(Element* e, AsmList* al)
 }
 
 
+void Space::build_assembly_lists()
+{
+  _F_
+  free_assembly_lists();
+  al_offset.assign(mesh->get_max_element_id(), -1);
+  al_cnt.assign(mesh->get_max_element_id(), 0);
+
+  // the triplets of all active elements are stored one after another in one buffer
+  Element* e;
+  AsmList al;
+  for_all_active_elements(e, mesh)
+  {
+    calc_element_assembly_list(e, &al);
+    al_offset[e->id] = (int) al_idx.size();
+    al_cnt[e->id] = al.cnt;
+    al_idx.insert(al_idx.end(), al.idx, al.idx + al.cnt);
+    al_dof.insert(al_dof.end(), al.dof, al.dof + al.cnt);
+    al_coef.insert(al_coef.end(), al.coef, al.coef + al.cnt);
+  }
+
+  // an element without any shape functions still needs a valid pointer
+  al_idx.push_back(0);
+  al_dof.push_back(0);
+  al_coef.push_back(0.0);
+  al_seq = seq;
+}
+
+
+void Space::free_assembly_lists()
+{
+  _F_
+  al_offset.clear();
+  al_cnt.clear();
+  std::vector<int>().swap(al_idx);
+  std::vector<int>().swap(al_dof);
+  std::vector<scalar>().swap(al_coef);
+  al_seq = -1;
+}
+
+
 void Space::get_boundary_assembly_list(Element* e, int surf_num, AsmList* al)
 {
   _F_
@@ -686,6 +844,11 @@ void Space::update_edge_bc(Element* e, SurfPos* surf_pos)
 void Space::update_essential_bc_values()
 {
   _F_
+  // the coefficients of the Dirichlet lift are part of the assembly lists (assign_dofs()
+  // builds the cache itself when the DOFs are complete)
+  bool cached = (al_seq == seq);
+  free_assembly_lists();
+
   Element* e;
   for_all_base_elements(e, mesh)
   {
@@ -699,6 +862,8 @@ void Space::update_essential_bc_values()
       }
     }
   }
+
+  if (cached) build_assembly_lists();
 }
 
 
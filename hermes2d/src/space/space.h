@@ -136,6 +136,14 @@ public:
   /// \return The number of basis functions contained in the space.
   virtual int assign_dofs(int first_dof = 0, int stride = 1);
 
+  /// Selects the ordering of the DOFs (see EDofOrdering and dof_ordering.h in hermes_common)
+  /// and assigns the DOFs again. The default, HERMES_NATURAL_DOF_ORDERING, numbers them as
+  /// the nodes and elements are walked by assign_vertex_dofs() etc. The other orderings
+  /// renumber them afterwards to reduce the fill-in of direct solvers (reverse Cuthill-McKee)
+  /// or to improve the locality of the matrix (element-wise, space-filling curve).
+  void set_dof_ordering(EDofOrdering ordering);
+  EDofOrdering get_dof_ordering() const { return dof_ordering; }
+
   /// \brief Returns the number of basis functions contained in the space.
   int get_num_dofs() { return ndof; }
   /// \brief Returns the DOF number of the last basis function.
@@ -165,12 +173,35 @@ public:
   /// Obtains an boundary conditions
   inline EssentialBCs* get_essential_bcs() { return essential_bcs; }
 
-  /// Obtains an assembly list for the given element.
+  /// Obtains an assembly list for the given element. The lists of all active elements are
+  /// calculated by calc_element_assembly_list() and cached by assign_dofs() and
+  /// update_essential_bc_values(). Spaces with their own assembly lists should override
+  /// calc_element_assembly_list(), which fills the cache; the cached lists are also returned
+  /// by the overload below. Like before the cache, the shapeset is switched to the mode of 'e'.
   virtual void get_element_assembly_list(Element* e, AsmList* al);
 
+  /// Like get_element_assembly_list(), but returns read-only pointers to the cached triplets
+  /// of an active element instead of copying them; the space is not modified, so several
+  /// threads may call this at once. The pointers stay valid until the next assign_dofs() or
+  /// update_essential_bc_values() of the space (or until it is destroyed). The lists of
+  /// elements which are not cached (inactive elements, or all of them if the space has
+  /// changed since its DOFs were assigned) are calculated into 'al', which is owned by the
+  /// caller, and the pointers point into it. Returns the number of the triplets.
+  int get_element_assembly_list(Element* e, const int*& idx, const int*& dof, const scalar*& coef,
+                                AsmList* al);
+
   /// Obtains an edge assembly list (contains shape functions that are nonzero on the specified edge).
   void get_boundary_assembly_list(Element* e, int surf_num, AsmList* al);
 
+  /// Returns the number of bubble DOFs of the active element 'e'. They are numbered
+  /// 'first_dof', 'first_dof' + 'dof_stride', ...
+  int get_element_bubble_dofs(Element* e, int& first_dof, int& dof_stride) const
+  {
+    first_dof = edata[e->id].bdof;
+    dof_stride = stride;
+    return edata[e->id].n;
+  }
+
   /// Updates essential BC values. Typically used for time-dependent
   /// essnetial boundary conditions.
   void update_essential_bc_values();
@@ -200,6 +231,7 @@ protected:
   int stride;
   int seq, mesh_seq;
   bool was_assigned;
+  EDofOrdering dof_ordering;
 
   struct BaseComponent
   {
@@ -263,6 +295,11 @@ protected: //debugging support
   virtual void assign_vertex_dofs() = 0;
   virtual void assign_edge_dofs() = 0;
   virtual void assign_bubble_dofs() = 0;
+  /// Renumbers the assigned DOFs according to 'dof_ordering'.
+  void reorder_dofs();
+
+  /// Calculates the assembly list of the element (not cached).
+  virtual void calc_element_assembly_list(Element* e, AsmList* al);
 
   virtual void get_vertex_assembly_list(Element* e, int iv, AsmList* al) = 0;
   virtual void get_boundary_assembly_list_internal(Element* e, int surf_num, AsmList* al) = 0;
@@ -288,6 +325,18 @@ protected: //debugging support
   std::vector<void*> extra_data;
   void free_extra_data();
 
+  /// Cached assembly lists of the active elements, valid if al_seq == seq. The triplets of the
+  /// element 'e' are al_idx, al_dof and al_coef[al_offset[e->id] .. + al_cnt[e->id]], elements
+  /// which are not in the cache have al_offset -1.
+  std::vector<int> al_offset, al_cnt;
+  std::vector<int> al_idx, al_dof;
+  std::vector<scalar> al_coef;
+  int al_seq;
+
+  /// Calculates the assembly lists of all active elements into the cache.
+  void build_assembly_lists();
+  void free_assembly_lists();
+
   void propagate_zero_orders(Element* e);
 
 public:
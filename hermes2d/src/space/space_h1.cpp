@@ -87,6 +87,7 @@ Space* H1Space::dup(Mesh* mesh, int order_increase) const
 {
   _F_
   H1Space* space = new H1Space(mesh, essential_bcs, 1, shapeset);
+  space->dof_ordering = dof_ordering;
   space->copy_orders(this, order_increase);
   return space;
 }
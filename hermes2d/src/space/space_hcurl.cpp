@@ -78,6 +78,7 @@ HcurlSpace::~HcurlSpace()
 Space* HcurlSpace::dup(Mesh* mesh, int order_increase) const
 {
   HcurlSpace* space = new HcurlSpace(mesh, essential_bcs, 0, this->shapeset);
+  space->dof_ordering = dof_ordering;
   space->copy_orders(this, order_increase);
   return space;
 }
@@ -77,12 +77,10 @@ HdivSpace::~HdivSpace()
 
 Space* HdivSpace::dup(Mesh* mesh, int order_increase) const
 {
-  // FIXME
-  // HdivSpace* space = new HdivSpace(mesh, essential_bcs, 0, this->shapeset);
-  // space->copy_callbacks(this);
-  // space->copy_orders(this, order_increase);
-  // return space;
-  return NULL;
+  HdivSpace* space = new HdivSpace(mesh, essential_bcs, 0, this->shapeset);
+  space->dof_ordering = dof_ordering;
+  space->copy_orders(this, order_increase);
+  return space;
 }
 
 void HdivSpace::set_shapeset(Shapeset *shapeset)
@@ -64,6 +64,7 @@ Space* L2Space::dup(Mesh* mesh, int order_increase) const
 {
   // FIXME - not tested
   L2Space* space = new L2Space(mesh, essential_bcs, 0, shapeset);
+  space->dof_ordering = dof_ordering;
   space->copy_orders(this, order_increase);
   return space;
 }
@@ -109,15 +110,8 @@ void L2Space::assign_bubble_dofs()
 
 //// assembly lists ////////////////////////////////////////////////////////////////////////////////
 
-void L2Space::get_element_assembly_list(Element* e, AsmList* al)
+void L2Space::calc_element_assembly_list(Element* e, AsmList* al)
 {
-  // some checks
-  if (e->id >= esize || edata[e->id].order < 0)
-    error("Uninitialized element order (id = #%d).", e->id);
-  if (!is_up_to_date())
-    error("The space is out of date. You need to update it with assign_dofs()"
-          " any time the mesh changes.");
-
   // add bubble functions to the assembly list
   al->clear();
   shapeset->set_mode(e->get_mode());
@@ -48,7 +48,6 @@ public:
 
   virtual ESpaceType get_type() const { return HERMES_L2_SPACE; }
 
-  virtual void get_element_assembly_list(Element* e, AsmList* al);
 
 protected:
 
@@ -67,6 +66,7 @@ protected:
   virtual void assign_edge_dofs() {}
   virtual void assign_bubble_dofs();
 
+  virtual void calc_element_assembly_list(Element* e, AsmList* al);
   virtual void get_vertex_assembly_list(Element* e, int iv, AsmList* al) {}
   virtual void get_boundary_assembly_list_internal(Element* e, int surf_num, AsmList* al);
   virtual void get_bubble_assembly_list(Element* e, AsmList* al);
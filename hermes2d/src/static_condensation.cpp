@@ -0,0 +1,433 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "h2d_common.h"
+#include "static_condensation.h"
+#include "space/space.h"
+#include <pthread.h>
+
+StaticCondensation::StaticCondensation()
+  : ndof(0), nskel(0), have_matrix(false), cur_num(-1), cur_ns(0), cur_nb(0),
+    cur_matrix(false), cur_vector(false), elem_matrix(this), elem_vector(this)
+{
+}
+
+StaticCondensation::~StaticCondensation()
+{
+  free();
+}
+
+void StaticCondensation::free()
+{
+  elems.clear();
+  dofs.clear();
+  piv.clear();
+  data.clear();
+  have_matrix = false;
+}
+
+void StaticCondensation::init(Hermes::vector<Space *>& spaces, int ndof)
+{
+  _F_
+  free();
+  this->ndof = ndof;
+
+  // mark the bubble DOFs, L2 spaces have only bubbles and are not condensed
+  skel.assign(ndof, 0);
+  for (unsigned int i = 0; i < spaces.size(); i++)
+  {
+    if (spaces[i]->get_type() == HERMES_L2_SPACE) continue;
+    Element* e;
+    for_all_active_elements(e, spaces[i]->get_mesh())
+    {
+      int first, stride;
+      int n = spaces[i]->get_element_bubble_dofs(e, first, stride);
+      for (int k = 0, dof = first; k < n; k++, dof += stride)
+        skel[dof] = -1;
+    }
+  }
+
+  nskel = 0;
+  for (int i = 0; i < ndof; i++)
+    if (skel[i] >= 0) skel[i] = nskel++;
+
+  local.assign(ndof, -1);
+  verbose("Static condensation: %d of %d DOFs in the skeleton.", nskel, ndof);
+}
+
+void StaticCondensation::map_dofs(AsmList* al)
+{
+  for (unsigned int i = 0; i < al->cnt; i++)
+    if (al->dof[i] >= 0)
+      al->dof[i] = skel[al->dof[i]];
+}
+
+void StaticCondensation::begin_assembling(bool want_matrix)
+{
+  _F_
+  // the element data are stored again with the matrix
+  if (want_matrix)
+  {
+    free();
+    have_matrix = true;
+  }
+  else if (!have_matrix)
+    error("The right-hand side can only be condensed with the matrix assembled before.");
+}
+
+void StaticCondensation::begin_element(int num, Hermes::vector<int>& idx, Hermes::vector<AsmList *>& al,
+                                       bool want_matrix, bool want_vector)
+{
+  _F_
+  cur_num = num;
+  cur_matrix = want_matrix;
+  cur_vector = want_vector;
+
+  // local numbering of the DOFs of the element, the skeleton ones first
+  cur_dofs.clear();
+  for (int pass = 0; pass < 2; pass++)
+  {
+    for (unsigned int i = 0; i < idx.size(); i++)
+    {
+      AsmList* a = al[idx[i]];
+      for (unsigned int k = 0; k < a->cnt; k++)
+      {
+        int dof = a->dof[k];
+        if (dof < 0 || local[dof] >= 0 || (skel[dof] < 0) != (pass == 1)) continue;
+        local[dof] = cur_dofs.size();
+        cur_dofs.push_back(dof);
+      }
+    }
+    if (pass == 0) cur_ns = cur_dofs.size();
+  }
+  cur_nb = cur_dofs.size() - cur_ns;
+
+  if (!want_matrix && (num >= (int) elems.size() || elems[num].ns != cur_ns || elems[num].nb != cur_nb))
+    error("The element does not match the condensed matrix assembled before.");
+
+  int n = cur_ns + cur_nb;
+  if (want_matrix) cur_K.assign(n * n, 0.0);
+  if (want_vector) cur_f.assign(n, 0.0);
+}
+
+int StaticCondensation::get_local(int dof) const
+{
+  int l = (dof >= 0 && dof < ndof) ? local[dof] : -1;
+  if (l < 0) error("DOF %d does not belong to the condensed element.", dof);
+  return l;
+}
+
+void StaticCondensation::end_element(SparseMatrix* mat, Vector* rhs)
+{
+  _F_
+  int ns = cur_ns, nb = cur_nb, n = ns + nb;
+
+  if (cur_matrix)
+  {
+    if ((int) elems.size() <= cur_num)
+    {
+      CondensedElement empty = { 0, 0, (int) dofs.size(), data.size() };
+      elems.resize(cur_num + 1, empty);
+    }
+    CondensedElement* ce = &elems[cur_num];
+    ce->ns = ns;
+    ce->nb = nb;
+    ce->dof_offset = dofs.size();
+    ce->data_offset = data.size();
+    for (int k = 0; k < ns; k++)
+      dofs.push_back(skel[cur_dofs[k]]);
+    for (int k = 0; k < nb; k++)
+      dofs.push_back(cur_dofs[ns + k]);
+    piv.resize(dofs.size());
+    data.resize(data.size() + nb * nb + 2 * ns * nb + nb, 0.0);
+
+    scalar* lu = &data[ce->data_offset];
+    scalar* ksb = lu + nb * nb;
+    scalar* kbs = ksb + ns * nb;
+    for (int i = 0; i < nb; i++)
+      for (int j = 0; j < nb; j++)
+        lu[i * nb + j] = cur_K[(ns + i) * n + ns + j];
+    for (int i = 0; i < ns; i++)
+      for (int j = 0; j < nb; j++)
+      {
+        ksb[i * nb + j] = cur_K[i * n + ns + j];
+        kbs[j * ns + i] = cur_K[(ns + j) * n + i];
+      }
+    if (nb > 0 && !lu_factor(lu, nb, &piv[ce->dof_offset]))
+      error("Singular bubble block of the element matrix in static condensation.");
+
+    // Schur complement K_ss - K_sb K_bb^-1 K_bs, column by column
+    std::vector<scalar> w(nb);
+    for (int c = 0; c < ns && nb > 0; c++)
+    {
+      for (int k = 0; k < nb; k++)
+        w[k] = kbs[k * ns + c];
+      lu_solve(lu, nb, &piv[ce->dof_offset], &w[0]);
+      for (int r = 0; r < ns; r++)
+      {
+        scalar sum = 0.0;
+        for (int k = 0; k < nb; k++)
+          sum += ksb[r * nb + k] * w[k];
+        cur_K[r * n + c] -= sum;
+      }
+    }
+
+    if (ns > 0)
+    {
+      std::vector<scalar*> rows(ns);
+      std::vector<int> sdofs(ns);
+      for (int r = 0; r < ns; r++)
+      {
+        rows[r] = &cur_K[r * n];
+        sdofs[r] = skel[cur_dofs[r]];
+      }
+      mat->add(ns, ns, &rows[0], &sdofs[0], &sdofs[0]);
+    }
+  }
+
+  if (cur_vector)
+  {
+    CondensedElement* ce = &elems[cur_num];
+    scalar* lu = &data[ce->data_offset];
+    scalar* ksb = lu + nb * nb;
+    scalar* y = ksb + 2 * ns * nb;
+    for (int k = 0; k < nb; k++)
+      y[k] = cur_f[ns + k];
+    if (nb > 0) lu_solve(lu, nb, &piv[ce->dof_offset], y);
+
+    for (int r = 0; r < ns; r++)
+    {
+      scalar sum = 0.0;
+      for (int k = 0; k < nb; k++)
+        sum += ksb[r * nb + k] * y[k];
+      rhs->add(skel[cur_dofs[r]], cur_f[r] - sum);
+    }
+  }
+
+  for (unsigned int i = 0; i < cur_dofs.size(); i++)
+    local[cur_dofs[i]] = -1;
+  cur_num = -1;
+}
+
+void* StaticCondensation::expand_elements(void* job)
+{
+  ExpandJob* j = (ExpandJob*) job;
+  StaticCondensation* sc = j->sc;
+  std::vector<scalar> z;
+  for (unsigned int i = j->first; i < sc->elems.size(); i += j->step)
+  {
+    CondensedElement* ce = &sc->elems[i];
+    int ns = ce->ns, nb = ce->nb;
+    if (nb == 0) continue;
+
+    const int* edofs = &sc->dofs[ce->dof_offset];
+    const scalar* lu = &sc->data[ce->data_offset];
+    const scalar* kbs = lu + nb * nb + ns * nb;
+    const scalar* y = kbs + nb * ns;
+
+    // u_b = K_bb^-1 (f_b - K_bs u_s)
+    z.assign(nb, 0.0);
+    for (int k = 0; k < nb; k++)
+      for (int c = 0; c < ns; c++)
+        z[k] += kbs[k * ns + c] * j->skeleton_sln[edofs[c]];
+    lu_solve(lu, nb, &sc->piv[ce->dof_offset], &z[0]);
+    for (int k = 0; k < nb; k++)
+      j->sln[edofs[ns + k]] = j->rhs_factor * y[k] - z[k];
+  }
+  return NULL;
+}
+
+void StaticCondensation::expand(scalar* skeleton_sln, scalar* sln, double rhs_factor, int num_threads)
+{
+  _F_
+  if (!have_matrix) error("No condensed system has been assembled.");
+
+  for (int i = 0; i < ndof; i++)
+    if (skel[i] >= 0)
+      sln[i] = skeleton_sln[skel[i]];
+
+  // the elements have disjoint bubble DOFs, so they can be processed in parallel
+  int n = std::max(1, std::min(num_threads, (int) elems.size()));
+  ExpandJob* jobs = new ExpandJob[n];
+  for (int t = 0; t < n; t++)
+  {
+    jobs[t].sc = this;
+    jobs[t].first = t;
+    jobs[t].step = n;
+    jobs[t].skeleton_sln = skeleton_sln;
+    jobs[t].sln = sln;
+    jobs[t].rhs_factor = rhs_factor;
+  }
+  if (n == 1)
+    expand_elements(jobs);
+  else
+  {
+    pthread_t* threads = new pthread_t[n];
+    for (int t = 0; t < n; t++)
+      if (pthread_create(&threads[t], NULL, expand_elements, jobs + t) != 0)
+        error("Failed to create a thread for recovering the bubble DOFs.");
+    for (int t = 0; t < n; t++)
+      pthread_join(threads[t], NULL);
+    delete [] threads;
+  }
+  delete [] jobs;
+}
+
+//// dense LU factorization with partial pivoting (row-major) ////////////////////////////////////
+
+bool StaticCondensation::lu_factor(scalar* a, int n, int* piv)
+{
+  double amax = 0.0;
+  for (int i = 0; i < n * n; i++)
+    amax = std::max(amax, (double) std::abs(a[i]));
+
+  for (int k = 0; k < n; k++)
+  {
+    int p = k;
+    double max = std::abs(a[k * n + k]);
+    for (int i = k + 1; i < n; i++)
+      if (std::abs(a[i * n + k]) > max) { max = std::abs(a[i * n + k]); p = i; }
+    if (max <= 1e-13 * amax) return false;
+
+    piv[k] = p;
+    if (p != k)
+      for (int j = 0; j < n; j++)
+        std::swap(a[k * n + j], a[p * n + j]);
+
+    for (int i = k + 1; i < n; i++)
+    {
+      scalar l = (a[i * n + k] /= a[k * n + k]);
+      for (int j = k + 1; j < n; j++)
+        a[i * n + j] -= l * a[k * n + j];
+    }
+  }
+  return true;
+}
+
+void StaticCondensation::lu_solve(const scalar* a, int n, const int* piv, scalar* b)
+{
+  for (int k = 0; k < n; k++)
+    if (piv[k] != k) std::swap(b[k], b[piv[k]]);
+  for (int i = 1; i < n; i++)
+    for (int j = 0; j < i; j++)
+      b[i] -= a[i * n + j] * b[j];
+  for (int i = n - 1; i >= 0; i--)
+  {
+    for (int j = i + 1; j < n; j++)
+      b[i] -= a[i * n + j] * b[j];
+    b[i] /= a[i * n + i];
+  }
+}
+
+//// element matrix and vector ///////////////////////////////////////////////////////////////////
+
+scalar StaticCondensation::ElementMatrix::get(unsigned int m, unsigned int n)
+{
+  return sc->cur_K[sc->get_local(m) * sc->cur_dofs.size() + sc->get_local(n)];
+}
+
+void StaticCondensation::ElementMatrix::zero()
+{
+  std::fill(sc->cur_K.begin(), sc->cur_K.end(), 0.0);
+}
+
+void StaticCondensation::ElementMatrix::add_to_diagonal(scalar v)
+{
+  int n = sc->cur_dofs.size();
+  for (int i = 0; i < n; i++)
+    sc->cur_K[i * n + i] += v;
+}
+
+void StaticCondensation::ElementMatrix::add(unsigned int m, unsigned int n, scalar v)
+{
+  if ((int) m < 0 || (int) n < 0) return;
+  sc->cur_K[sc->get_local(m) * sc->cur_dofs.size() + sc->get_local(n)] += v;
+}
+
+void StaticCondensation::ElementMatrix::add(unsigned int m, unsigned int n, scalar **mat, int *rows, int *cols)
+{
+  int size = sc->cur_dofs.size();
+  for (unsigned int i = 0; i < m; i++)
+  {
+    if (rows[i] < 0) continue;
+    scalar* row = &sc->cur_K[sc->get_local(rows[i]) * size];
+    for (unsigned int j = 0; j < n; j++)
+      if (cols[j] >= 0)
+        row[sc->get_local(cols[j])] += mat[i][j];
+  }
+}
+
+bool StaticCondensation::ElementMatrix::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt)
+{
+  return false;
+}
+
+unsigned int StaticCondensation::ElementMatrix::get_matrix_size() const
+{
+  return sc->cur_K.size();
+}
+
+scalar StaticCondensation::ElementVector::get(unsigned int idx)
+{
+  return sc->cur_f[sc->get_local(idx)];
+}
+
+void StaticCondensation::ElementVector::extract(scalar *v) const
+{
+  error("The element vector of static condensation can not be extracted.");
+}
+
+void StaticCondensation::ElementVector::zero()
+{
+  std::fill(sc->cur_f.begin(), sc->cur_f.end(), 0.0);
+}
+
+void StaticCondensation::ElementVector::change_sign()
+{
+  for (unsigned int i = 0; i < sc->cur_f.size(); i++)
+    sc->cur_f[i] = -sc->cur_f[i];
+}
+
+void StaticCondensation::ElementVector::set(unsigned int idx, scalar y)
+{
+  sc->cur_f[sc->get_local(idx)] = y;
+}
+
+void StaticCondensation::ElementVector::add(unsigned int idx, scalar y)
+{
+  if ((int) idx < 0) return;
+  sc->cur_f[sc->get_local(idx)] += y;
+}
+
+void StaticCondensation::ElementVector::add_vector(Vector* vec)
+{
+  error("A global vector can not be added to the element vector of static condensation.");
+}
+
+void StaticCondensation::ElementVector::add_vector(scalar* vec)
+{
+  error("A global vector can not be added to the element vector of static condensation.");
+}
+
+void StaticCondensation::ElementVector::add(unsigned int n, unsigned int *idx, scalar *y)
+{
+  for (unsigned int i = 0; i < n; i++)
+    add(idx[i], y[i]);
+}
+
+bool StaticCondensation::ElementVector::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt)
+{
+  return false;
+}
@@ -0,0 +1,172 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_STATIC_CONDENSATION_H
+#define __H2D_STATIC_CONDENSATION_H
+
+#include "../../hermes_common/matrix.h"
+#include "asmlist.h"
+
+class Space;
+
+/// \brief Static condensation of the bubble DOFs.
+///
+/// Bubble functions of an element are coupled only with the functions of the same element,
+/// so their DOFs can be eliminated element by element before the global solve. With the
+/// element system split into the skeleton (vertex and edge) DOFs s and the bubble DOFs b,
+///
+///   | K_ss  K_sb | | u_s |   | f_s |
+///   | K_bs  K_bb | | u_b | = | f_b |,
+///
+/// the Schur complement K_ss - K_sb K_bb^-1 K_bs and the vector f_s - K_sb K_bb^-1 f_b of every
+/// element are assembled into the global system, which thus has only the skeleton DOFs as
+/// unknowns. After it is solved, the bubble DOFs are recovered element by element from
+/// u_b = K_bb^-1 (f_b - K_bs u_s). The LU factorization of K_bb, K_sb and K_bs of every element
+/// are kept for the recovery and for assembling the right-hand side alone.
+///
+/// All DOFs of L2 spaces stay in the skeleton. The element systems are collected through the
+/// matrix and vector returned by get_element_matrix() and get_element_vector(), which take
+/// the global DOF numbers, so DiscreteProblem assembles the forms into them unchanged.
+class HERMES_API StaticCondensation
+{
+public:
+  StaticCondensation();
+  ~StaticCondensation();
+
+  /// Numbers the skeleton DOFs of the spaces, 'ndof' is the number of all DOFs. The stored
+  /// element data are dropped.
+  void init(Hermes::vector<Space *>& spaces, int ndof);
+  void free();
+
+  /// Returns the number of the skeleton DOFs (the size of the condensed system).
+  int get_num_dofs() const { return nskel; }
+
+  /// Replaces the DOFs in the assembly list by their skeleton numbers (-1 for bubble DOFs).
+  void map_dofs(AsmList* al);
+
+  /// Called before assembling. If the matrix is assembled, the stored element data are replaced.
+  void begin_assembling(bool want_matrix);
+
+  /// Starts the element (assembling state) 'num' whose DOFs are in the assembly lists al[idx[i]].
+  /// The states have to be visited in the same order in all assemblings; a right-hand side
+  /// alone can only be assembled after the matrix.
+  void begin_element(int num, Hermes::vector<int>& idx, Hermes::vector<AsmList *>& al,
+                     bool want_matrix, bool want_vector);
+
+  /// The element matrix and vector the forms of the current element are assembled into.
+  SparseMatrix* get_element_matrix() { return &elem_matrix; }
+  Vector* get_element_vector() { return &elem_vector; }
+
+  /// Condenses the system of the current element and adds it to 'mat' and 'rhs' (any of them
+  /// can be NULL if it is not assembled).
+  void end_element(SparseMatrix* mat, Vector* rhs);
+
+  /// Computes the coefficients of all DOFs ('sln', get_num_dofs() of DiscreteProblem entries)
+  /// from the solution of the condensed system. If the right-hand side has been scaled after
+  /// assembling (e.g., its sign changed in the Newton's method), 'rhs_factor' has to be the
+  /// same factor. The elements are processed by 'num_threads' threads.
+  void expand(scalar* skeleton_sln, scalar* sln, double rhs_factor = 1.0, int num_threads = 1);
+
+protected:
+  /// Element matrix and vector, indexed by global DOFs which are translated to the local ones.
+  class ElementMatrix : public SparseMatrix
+  {
+  public:
+    ElementMatrix(StaticCondensation* sc) : sc(sc) {}
+
+    virtual void alloc() {}
+    virtual void free() {}
+    virtual scalar get(unsigned int m, unsigned int n);
+    virtual void zero();
+    virtual void add_to_diagonal(scalar v);
+    virtual void add(unsigned int m, unsigned int n, scalar v);
+    virtual void add(unsigned int m, unsigned int n, scalar **mat, int *rows, int *cols);
+    virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE);
+    virtual unsigned int get_matrix_size() const;
+    virtual double get_fill_in() const { return 1.0; }
+
+  protected:
+    StaticCondensation* sc;
+  };
+
+  class ElementVector : public Vector
+  {
+  public:
+    ElementVector(StaticCondensation* sc) : sc(sc) {}
+
+    virtual void alloc(unsigned int ndofs) {}
+    virtual void free() {}
+    virtual scalar get(unsigned int idx);
+    virtual void extract(scalar *v) const;
+    virtual void zero();
+    virtual void change_sign();
+    virtual void set(unsigned int idx, scalar y);
+    virtual void add(unsigned int idx, scalar y);
+    virtual void add_vector(Vector* vec);
+    virtual void add_vector(scalar* vec);
+    virtual void add(unsigned int n, unsigned int *idx, scalar *y);
+    virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE);
+
+  protected:
+    StaticCondensation* sc;
+  };
+
+  /// Data of a condensed element: 'ns' skeleton and 'nb' bubble DOFs, their numbers (skeleton
+  /// numbers of the skeleton DOFs, global numbers of the bubble ones) at dofs[dof_offset], and
+  /// the LU factorization of K_bb (nb x nb, with the pivots at piv[dof_offset]), K_sb (ns x nb),
+  /// K_bs (nb x ns) and y = K_bb^-1 f_b at data[data_offset], in this order.
+  struct CondensedElement
+  {
+    int ns, nb;
+    int dof_offset;
+    size_t data_offset;
+  };
+
+  int ndof, nskel;
+  std::vector<int> skel;           ///< skeleton number of each DOF, -1 for bubble DOFs
+
+  std::vector<CondensedElement> elems;  ///< indexed by the state number
+  std::vector<int> dofs, piv;
+  std::vector<scalar> data;
+  bool have_matrix;
+
+  /// The current element: its DOFs (skeleton ones first), their local numbers
+  /// (-1 for other DOFs) and the dense system.
+  int cur_num, cur_ns, cur_nb;
+  bool cur_matrix, cur_vector;
+  std::vector<int> cur_dofs, local;
+  std::vector<scalar> cur_K, cur_f;
+
+  ElementMatrix elem_matrix;
+  ElementVector elem_vector;
+
+  int get_local(int dof) const;
+
+  static bool lu_factor(scalar* a, int n, int* piv);
+  static void lu_solve(const scalar* a, int n, const int* piv, scalar* b);
+
+  /// Recovers the bubble DOFs of the elements first, first + step, ...
+  struct ExpandJob
+  {
+    StaticCondensation* sc;
+    int first, step;
+    scalar* skeleton_sln;
+    scalar* sln;
+    double rhs_factor;
+  };
+  static void* expand_elements(void* job);
+};
+
+#endif
@@ -254,6 +254,10 @@ WeakForm::MultiComponentVectorFormSurf* WeakForm::MultiComponentVectorFormSurf::
   return NULL;
 }
 
+WeakForm::FluxFormSurf::FluxFormSurf(Hermes::vector<unsigned int> coordinates, 
+                                     Hermes::vector<MeshFunction *> ext, double scaling_factor) : 
+  Form(H2D_DG_INNER_EDGE, ext, Hermes::vector<scalar>(), scaling_factor), coordinates(coordinates) { }
+
 WeakForm::WeakForm(unsigned int neq, bool mat_free)
 {
   _F_
@@ -375,6 +379,20 @@ void WeakForm::add_multicomponent_vector_form_surf(MultiComponentVectorFormSurf*
   seq++;
 }
 
+void WeakForm::add_flux_form_surf(FluxFormSurf* form)
+{
+  _F_
+  for(unsigned int form_i = 0; form_i < form->coordinates.size(); form_i++)
+    if(form->coordinates.at(form_i) >= neq)
+      error("Invalid equation number.");
+  if(form->ext.size() == 0)
+    error("A flux form needs the external functions to take the traces of.");
+
+  form->set_weakform(this);
+  ffsurf.push_back(form);
+  seq++;
+}
+
 void WeakForm::set_ext_fns(void* fn, Hermes::vector<MeshFunction*> ext)
 {
   _F_
@@ -316,6 +316,46 @@ public:
                       Geom<Ord> *e, ExtData<Ord> *ext) const = 0;
   };
 
+  /// Numerical flux for the face-based assembling of the right-hand side of DG and FVM problems.
+  ///
+  /// Unlike the DG forms (area H2D_DG_INNER_EDGE), which are evaluated for every test function
+  /// from both sides of an inner edge, the flux is evaluated once on every face (every segment
+  /// of an inner edge and every boundary edge), for all its quadrature points at once, and it is
+  /// integrated with the test functions of the elements on both sides of the face:
+  ///   scaling_factor * \int_face F(w_L, w_R, n) v_L   is added to the residual of the element L,
+  ///   scaling_factor * \int_face F(w_L, w_R, n) v_R   is subtracted from that of the element R,
+  /// where n is the unit normal pointing from L to R and w_L, w_R are the traces of the external
+  /// functions 'ext' from L and R. The result F[c] belongs to the equation coordinates[c].
+  /// The flux has to be conservative, F(w_R, w_L, -n) = -F(w_L, w_R, n).
+  ///
+  /// The spaces of all coordinates and all external functions have to be defined on the same mesh.
+  /// The flux only contributes to the right-hand side: it is meant for explicit schemes, where the
+  /// matrix (e.g. the mass matrix) does not depend on it. DiscreteProblem::assemble() reports an
+  /// error when flux forms are assembled together with the Jacobian of Newton's method.
+  class HERMES_API FluxFormSurf : public Form
+  {
+  public:
+    FluxFormSurf(Hermes::vector<unsigned int> coordinates, 
+                 Hermes::vector<MeshFunction *> ext = Hermes::vector<MeshFunction*>(),
+                 double scaling_factor = 1.0);
+
+    Hermes::vector<unsigned int> coordinates;
+
+    /// Flux in n points of an inner face. w_L[j][i] and w_R[j][i] are the values of ext[j] in the
+    /// point i, result[c][i] is the flux for coordinates[c].
+    virtual void flux(int n, scalar **w_L, scalar **w_R, double *nx, double *ny, scalar **result) const = 0;
+
+    /// Flux in n points of a boundary face with the (user) marker 'marker', (x[i], y[i]) are the
+    /// physical coordinates of the points. Returns false if the boundary is not handled by the
+    /// flux (it is then left to the surface forms).
+    virtual bool boundary_flux(int n, std::string marker, scalar **w_L, double *nx, double *ny, 
+                               double *x, double *y, scalar **result) const { return false; }
+
+    /// Quadrature order on a face. The default is exact for polynomial traces and test functions
+    /// (as in FVM, where the traces are constant).
+    virtual int ord(int ext_order, int test_order) const { return ext_order + test_order; }
+  };
+
   // General case.
   void add_matrix_form(MatrixFormVol* mfv);
   void add_matrix_form_surf(MatrixFormSurf* mfs);
@@ -327,6 +367,9 @@ public:
   void add_multicomponent_vector_form(MultiComponentVectorFormVol* vfv);
   void add_multicomponent_vector_form_surf(MultiComponentVectorFormSurf* vfs);
 
+  /// Face-based fluxes (see FluxFormSurf).
+  void add_flux_form_surf(FluxFormSurf* ffs);
+
   void set_ext_fns(void* fn, Hermes::vector<MeshFunction*> ext = Hermes::vector<MeshFunction*>());
 
   /// Returns the number of equations.
@@ -384,6 +427,9 @@ public:
   Hermes::vector<MultiComponentVectorFormVol *> vfvol_mc;
   Hermes::vector<MultiComponentVectorFormSurf *> vfsurf_mc;
 
+  // Face-based fluxes, assembled outside the stages.
+  Hermes::vector<FluxFormSurf *> ffsurf;
+
   // Storage of forms according to user-supplied strings.
   std::map<std::string, MatrixFormVol>  mfvol_string_temp;
   std::map<std::string, MatrixFormSurf> mfsurf_string_temp;
@@ -0,0 +1,847 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "../h2d_common.h"
+#include "weakform_compiler.h"
+
+/*
+
+  The grammar of the forms (as in weakform_parser.cpp, with functions and unary minus):
+
+  form    := type ident ["," ident] ":" expr
+  type    := "vol" | "surf"
+  expr    := term | term "+" expr | term "-" expr
+  term    := unary | unary "*" term | unary "/" term
+  unary   := power | "-" unary
+  power   := factor | power "^" expnt
+  expnt   := factor | "-" expnt
+  factor  := number | ident | ident "_x" | ident "_y" | spvar | "i"
+           | func "(" expr ")" | ("dx" | "dy") "(" ident ")" | "(" expr ")"
+  spvar   := "x" | "y" | "nx" | "ny"
+  func    := "sqrt" | "exp" | "log" | "sin" | "cos" | "abs"
+  ident   := letter { letter | digit | "_" }
+
+  The binary operators are left-associative. The unary minus binds less tightly than "^",
+  so -x^2 is -(x^2), while x^-2 is allowed.
+
+  The names of the functions (u, v and the external ones) and of the parameters must differ
+  from each other, from the predefined names (spvar, "i", "dx", "dy", func) and from the
+  derivatives f_x, f_y of the functions.
+
+*/
+
+static inline double wfc_abs(double a) { return fabs(a); }
+#ifdef H2D_COMPLEX
+static inline scalar wfc_abs(scalar a) { return std::abs(a); }
+#endif
+
+
+//// parser ////////////////////////////////////////////////////////////////////////////////////////
+
+enum WFCTokenType
+{
+  WFC_EOF, WFC_IDENT, WFC_NUMBER,
+  WFC_PLUS, WFC_MINUS, WFC_STAR, WFC_SLASH, WFC_POWER,
+  WFC_BRA, WFC_KET, WFC_COMMA, WFC_COLON
+};
+
+/// Recursive descent parser of the textual forms building the tree of a WeakFormExpression.
+class WeakFormParser
+{
+public:
+  WeakFormParser(WeakFormExpression* wfe, const std::string& text,
+                 Hermes::vector<std::string>& ext_names,
+                 Hermes::vector<std::string>& param_names, Hermes::vector<scalar>& param)
+    : wfe(wfe), text(text), pos(0), ext_names(ext_names), param_names(param_names), param(param)
+  {
+    if (param_names.size() > param.size())
+      error("More parameter names than parameters in the form \"%s\".", text.c_str());
+    next_token();
+  }
+
+  void form()
+  {
+    if (type != WFC_IDENT || (lexeme != "vol" && lexeme != "surf"))
+      fail("'vol' or 'surf' expected");
+    wfe->surface = (lexeme == "surf");
+    next_token();
+
+    if (type != WFC_IDENT) fail("name of a function expected");
+    std::string first = lexeme;
+    next_token();
+    if (type == WFC_COMMA)
+    {
+      next_token();
+      if (type != WFC_IDENT) fail("name of the test function expected");
+      u_name = first;
+      v_name = lexeme;
+      wfe->bilinear = true;
+      next_token();
+    }
+    else
+    {
+      v_name = first;
+      wfe->bilinear = false;
+    }
+    check_for(WFC_COLON, "':' expected");
+
+    // The names must not shadow each other or the predefined ones.
+    std::vector<std::string> names;
+    if (wfe->bilinear) names.push_back(u_name);
+    names.push_back(v_name);
+    for (unsigned int k = 0; k < ext_names.size(); k++) names.push_back(ext_names[k]);
+    for (unsigned int k = 0; k < param_names.size(); k++) names.push_back(param_names[k]);
+    for (unsigned int k = 0; k < names.size(); k++)
+      check_name(names, k);
+
+    wfe->root = expr();
+    if (type != WFC_EOF) fail("end of the form expected");
+  }
+
+protected:
+  WeakFormExpression* wfe;
+  const std::string& text;
+  size_t pos, token_pos;
+
+  WFCTokenType type;
+  std::string lexeme;
+  double number;
+
+  std::string u_name, v_name;
+  Hermes::vector<std::string>& ext_names;
+  Hermes::vector<std::string>& param_names;
+  Hermes::vector<scalar>& param;
+
+  void fail(const char* message)
+  {
+    error("Error in the form \"%s\" at position %d: %s.", text.c_str(), (int) token_pos, message);
+  }
+
+  static bool is_predefined(const std::string& name)
+  {
+    static const char* predefined[] = { "x", "y", "nx", "ny", "i", "dx", "dy",
+                                        "sqrt", "exp", "log", "sin", "cos", "abs" };
+    for (unsigned int k = 0; k < sizeof(predefined) / sizeof(char*); k++)
+      if (name == predefined[k]) return true;
+    return false;
+  }
+
+  void check_name(const std::vector<std::string>& names, unsigned int k)
+  {
+    const std::string& name = names[k];
+    if (name.empty() || !isalpha(name[0]))
+      error("Invalid name \"%s\" in the form \"%s\".", name.c_str(), text.c_str());
+    for (size_t l = 1; l < name.size(); l++)
+      if (!isalnum(name[l]) && name[l] != '_')
+        error("Invalid name \"%s\" in the form \"%s\".", name.c_str(), text.c_str());
+    if (is_predefined(name))
+      error("The name \"%s\" is predefined in the form \"%s\".", name.c_str(), text.c_str());
+    for (unsigned int l = 0; l < k; l++)
+      if (names[l] == name)
+        error("The name \"%s\" is used twice in the form \"%s\".", name.c_str(), text.c_str());
+    // the functions come first in 'names'
+    unsigned int n_fns = (wfe->bilinear ? 2 : 1) + ext_names.size();
+    for (unsigned int l = 0; l < n_fns; l++)
+      if (name == names[l] + "_x" || name == names[l] + "_y")
+        error("The name \"%s\" is the derivative of \"%s\" in the form \"%s\".",
+              name.c_str(), names[l].c_str(), text.c_str());
+  }
+
+  void next_token()
+  {
+    while (pos < text.size() && isspace(text[pos])) pos++;
+    token_pos = pos;
+    if (pos >= text.size()) { type = WFC_EOF; return; }
+
+    char c = text[pos];
+    if (isalpha(c))
+    {
+      size_t start = pos;
+      while (pos < text.size() && (isalnum(text[pos]) || text[pos] == '_')) pos++;
+      type = WFC_IDENT;
+      lexeme = text.substr(start, pos - start);
+      return;
+    }
+    if (isdigit(c) || (c == '.' && pos + 1 < text.size() && isdigit(text[pos + 1])))
+    {
+      char* end;
+      number = strtod(text.c_str() + pos, &end);
+      pos = end - text.c_str();
+      type = WFC_NUMBER;
+      return;
+    }
+
+    pos++;
+    switch (c)
+    {
+      case '+': type = WFC_PLUS; break;
+      case '-': type = WFC_MINUS; break;
+      case '*': type = WFC_STAR; break;
+      case '/': type = WFC_SLASH; break;
+      case '^': type = WFC_POWER; break;
+      case '(': type = WFC_BRA; break;
+      case ')': type = WFC_KET; break;
+      case ',': type = WFC_COMMA; break;
+      case ':': type = WFC_COLON; break;
+      default: fail("unexpected character");
+    }
+  }
+
+  void check_for(WFCTokenType t, const char* message)
+  {
+    if (type != t) fail(message);
+    next_token();
+  }
+
+  int expr()
+  {
+    int l = term();
+    while (type == WFC_PLUS || type == WFC_MINUS)
+    {
+      WeakFormExpression::NodeType op = (type == WFC_PLUS) ? WeakFormExpression::N_ADD : WeakFormExpression::N_SUB;
+      next_token();
+      l = wfe->fold(wfe->make_node(op, l, term()));
+    }
+    return l;
+  }
+
+  int term()
+  {
+    int l = unary();
+    while (type == WFC_STAR || type == WFC_SLASH)
+    {
+      WeakFormExpression::NodeType op = (type == WFC_STAR) ? WeakFormExpression::N_MUL : WeakFormExpression::N_DIV;
+      next_token();
+      l = wfe->fold(wfe->make_node(op, l, unary()));
+    }
+    return l;
+  }
+
+  int unary()
+  {
+    if (type != WFC_MINUS) return power();
+    next_token();
+    return wfe->fold(wfe->make_node(WeakFormExpression::N_NEG, unary()));
+  }
+
+  int power()
+  {
+    int l = factor();
+    while (type == WFC_POWER)
+    {
+      next_token();
+      int r = exponent();
+      if (wfe->nodes[r].type != WeakFormExpression::N_CONST) fail("the exponent must be a constant");
+      int n = wfe->make_node(WeakFormExpression::N_POW, l);
+#ifdef H2D_COMPLEX
+      if (std::imag(wfe->nodes[r].c) != 0.0) fail("the exponent must be real");
+      wfe->nodes[n].e = std::real(wfe->nodes[r].c);
+#else
+      wfe->nodes[n].e = wfe->nodes[r].c;
+#endif
+      l = wfe->fold(n);
+    }
+    return l;
+  }
+
+  int exponent()
+  {
+    if (type != WFC_MINUS) return factor();
+    next_token();
+    return wfe->fold(wfe->make_node(WeakFormExpression::N_NEG, exponent()));
+  }
+
+  // Returns the index of u, v or the external function of the given name, -1 if there is none.
+  int find_function(const std::string& name)
+  {
+    if (wfe->bilinear && name == u_name) return WeakFormExpression::FN_U;
+    if (name == v_name) return WeakFormExpression::FN_V;
+    for (unsigned int k = 0; k < ext_names.size(); k++)
+      if (name == ext_names[k]) return WeakFormExpression::FN_EXT + k;
+    return -1;
+  }
+
+  int make_input(int fn, int comp)
+  {
+    if (fn >= WeakFormExpression::FN_EXT)
+      wfe->n_ext_used = std::max(wfe->n_ext_used, fn - WeakFormExpression::FN_EXT + 1);
+    int n = wfe->make_node(WeakFormExpression::N_INPUT);
+    wfe->nodes[n].input = WeakFormExpression::IN_FN + 3*fn + comp;
+    return n;
+  }
+
+  int factor()
+  {
+    if (type == WFC_NUMBER)
+    {
+      double d = number;
+      next_token();
+      return wfe->make_const(d);
+    }
+    if (type == WFC_BRA)
+    {
+      next_token();
+      int n = expr();
+      check_for(WFC_KET, "')' expected");
+      return n;
+    }
+    if (type != WFC_IDENT) fail("number, name or '(' expected");
+
+    std::string name = lexeme;
+    next_token();
+
+    // Functions and derivatives dx(f), dy(f).
+    if (type == WFC_BRA)
+    {
+      next_token();
+      if (name == "dx" || name == "dy")
+      {
+        if (type != WFC_IDENT) fail("name of a function expected");
+        int fn = find_function(lexeme);
+        if (fn < 0) fail("unknown function");
+        next_token();
+        check_for(WFC_KET, "')' expected");
+        return make_input(fn, (name == "dx") ? 1 : 2);
+      }
+
+      static const char* names[] = { "sqrt", "exp", "log", "sin", "cos", "abs" };
+      int f = -1;
+      for (int k = 0; k < 6; k++)
+        if (name == names[k]) f = k;
+      if (f < 0) fail("unknown function");
+      int n = wfe->make_node(WeakFormExpression::N_FUNC, expr());
+      wfe->nodes[n].input = f;
+      check_for(WFC_KET, "')' expected");
+      return wfe->fold(n);
+    }
+
+    int fn = find_function(name);
+    if (fn >= 0) return make_input(fn, 0);
+
+    // Coordinates and normals.
+    static const char* spvars[] = { "x", "y", "nx", "ny" };
+    for (int k = 0; k < 4; k++)
+    {
+      if (name != spvars[k]) continue;
+      if (k >= 2 && !wfe->surface) fail("normals are defined only in surface forms");
+      int n = wfe->make_node(WeakFormExpression::N_INPUT);
+      wfe->nodes[n].input = k;
+      return n;
+    }
+
+    // Parameters.
+    for (unsigned int k = 0; k < param_names.size(); k++)
+      if (name == param_names[k]) return wfe->make_const(param[k]);
+
+    if (name == "i")
+    {
+#ifdef H2D_COMPLEX
+      return wfe->make_const(scalar(0.0, 1.0));
+#else
+      fail("the imaginary unit is available only in the complex version");
+#endif
+    }
+
+    // Partial derivatives u_x, u_y.
+    size_t under = name.rfind('_');
+    if (under != std::string::npos && (fn = find_function(name.substr(0, under))) >= 0)
+    {
+      std::string partial = name.substr(under + 1);
+      if (partial != "x" && partial != "y")
+        fail("'x' or 'y' expected after '_' (second derivatives are not supported)");
+      return make_input(fn, (partial == "x") ? 1 : 2);
+    }
+
+    fail("unknown name");
+    return -1;
+  }
+};
+
+
+//// WeakFormExpression ////////////////////////////////////////////////////////////////////////////
+
+WeakFormExpression::WeakFormExpression(std::string text, Hermes::vector<std::string> ext_names,
+                                       Hermes::vector<std::string> param_names, Hermes::vector<scalar> param)
+{
+  _F_
+  n_ext = ext_names.size();
+  n_ext_used = 0;
+  n_inputs = IN_FN + 3 * (FN_EXT + n_ext);
+  parse(text, ext_names, param_names, param);
+
+  // Compile the tree. The slots of inputs used by the program are collected so that
+  // only these have to be set up for each block of points.
+  std::vector<bool> busy;
+  n_regs = 0;
+  result = compile_node(root, busy);
+  if (result < n_inputs && nodes[root].type == N_CONST)
+  {
+    result = n_inputs + alloc_reg(busy);
+    emit(OP_CONST, result - n_inputs, -1, -1, nodes[root].c);
+  }
+
+  // Renumber the slots so that the used inputs come first (in the order of their numbers,
+  // so the inputs of type double precede the external functions) and the registers follow.
+  std::vector<int> map(n_inputs, -1);
+  for (unsigned int k = 0; k < code.size(); k++)
+  {
+    if (code[k].a >= 0 && code[k].a < n_inputs) map[code[k].a] = 0;
+    if (code[k].b >= 0 && code[k].b < n_inputs) map[code[k].b] = 0;
+  }
+  if (result < n_inputs) map[result] = 0;
+  for (int k = 0; k < n_inputs; k++)
+    if (map[k] == 0) { map[k] = used_inputs.size(); used_inputs.push_back(k); }
+  if (used_inputs.size() > H2D_WFC_MAX_INPUTS)
+    error("The weak form expression uses more than %d inputs.", H2D_WFC_MAX_INPUTS);
+
+  int nu = used_inputs.size();
+  for (unsigned int k = 0; k < code.size(); k++)
+  {
+    int* ops[2] = { &code[k].a, &code[k].b };
+    for (int l = 0; l < 2; l++)
+      if (*ops[l] >= n_inputs) *ops[l] += nu - n_inputs;
+      else if (*ops[l] >= 0) *ops[l] = map[*ops[l]];
+  }
+  result = (result >= n_inputs) ? result + nu - n_inputs : map[result];
+}
+
+void WeakFormExpression::parse(const std::string& text, Hermes::vector<std::string>& ext_names,
+                               Hermes::vector<std::string>& param_names, Hermes::vector<scalar>& param)
+{
+  WeakFormParser parser(this, text, ext_names, param_names, param);
+  parser.form();
+}
+
+int WeakFormExpression::make_node(NodeType type, int left, int right)
+{
+  Node n;
+  n.type = type;
+  n.left = left;
+  n.right = right;
+  n.input = -1;
+  n.c = 0.0;
+  n.e = 0.0;
+  nodes.push_back(n);
+  return nodes.size() - 1;
+}
+
+int WeakFormExpression::make_const(scalar c)
+{
+  int n = make_node(N_CONST);
+  nodes[n].c = c;
+  return n;
+}
+
+int WeakFormExpression::fold(int n)
+{
+  Node& nd = nodes[n];
+  bool lc = (nd.left >= 0 && nodes[nd.left].type == N_CONST);
+  bool rc = (nd.right >= 0 && nodes[nd.right].type == N_CONST);
+  scalar a = lc ? nodes[nd.left].c : 0.0;
+  scalar b = rc ? nodes[nd.right].c : 0.0;
+
+  switch (nd.type)
+  {
+    case N_ADD: if (lc && rc) return make_const(a + b); break;
+    case N_SUB: if (lc && rc) return make_const(a - b); break;
+    case N_MUL: if (lc && rc) return make_const(a * b); break;
+    case N_DIV: if (lc && rc) return make_const(a / b); break;
+    case N_NEG: if (lc) return make_const(-a); break;
+    case N_POW: if (lc) return make_const(pow(a, nd.e)); break;
+    case N_FUNC:
+      if (!lc) break;
+      switch (nd.input)
+      {
+        case F_SQRT: return make_const(sqrt(a));
+        case F_EXP:  return make_const(exp(a));
+        case F_LOG:  return make_const(log(a));
+        case F_SIN:  return make_const(sin(a));
+        case F_COS:  return make_const(cos(a));
+        case F_ABS:  return make_const(wfc_abs(a));
+      }
+      break;
+    default: break;
+  }
+  return n;
+}
+
+int WeakFormExpression::alloc_reg(std::vector<bool>& busy)
+{
+  for (unsigned int r = 0; r < busy.size(); r++)
+    if (!busy[r]) { busy[r] = true; return r; }
+  if ((int) busy.size() >= H2D_WFC_MAX_REGS)
+    error("The weak form expression needs more than %d registers.", H2D_WFC_MAX_REGS);
+  busy.push_back(true);
+  n_regs = busy.size();
+  return busy.size() - 1;
+}
+
+void WeakFormExpression::emit(Opcode op, int dst, int a, int b, scalar c, double e)
+{
+  Instr in;
+  in.op = op;
+  in.dst = dst;
+  in.a = a;
+  in.b = b;
+  in.c = c;
+  in.e = e;
+  code.push_back(in);
+}
+
+// Emits the code of the subtree and returns the slot with its values. The registers of the
+// operands are released before the register of the result is allocated, so that the number
+// of registers is the depth of the tree rather than its size. Constant operands (the tree is
+// folded, so at most one operand is a constant) become immediate operands.
+int WeakFormExpression::compile_node(int n, std::vector<bool>& busy)
+{
+  const Node& nd = nodes[n];
+  if (nd.type == N_INPUT) return nd.input;
+  if (nd.type == N_CONST) return -1;
+
+  int a = -1, b = -1;
+  bool lc = (nodes[nd.left].type == N_CONST);
+  bool rc = (nd.right >= 0 && nodes[nd.right].type == N_CONST);
+  if (!lc) a = compile_node(nd.left, busy);
+  if (nd.right >= 0 && !rc) b = compile_node(nd.right, busy);
+  if (a >= n_inputs) busy[a - n_inputs] = false;
+  if (b >= n_inputs) busy[b - n_inputs] = false;
+  int dst = alloc_reg(busy);
+
+  switch (nd.type)
+  {
+    case N_ADD:
+      if (lc) emit(OP_ADDC, dst, b, -1, nodes[nd.left].c);
+      else if (rc) emit(OP_ADDC, dst, a, -1, nodes[nd.right].c);
+      else emit(OP_ADD, dst, a, b);
+      break;
+    case N_SUB:
+      if (lc) emit(OP_SUBC, dst, b, -1, nodes[nd.left].c);
+      else if (rc) emit(OP_ADDC, dst, a, -1, -nodes[nd.right].c);
+      else emit(OP_SUB, dst, a, b);
+      break;
+    case N_MUL:
+      if (lc) emit(OP_MULC, dst, b, -1, nodes[nd.left].c);
+      else if (rc) emit(OP_MULC, dst, a, -1, nodes[nd.right].c);
+      else if (a == b) emit(OP_SQR, dst, a);
+      else emit(OP_MUL, dst, a, b);
+      break;
+    case N_DIV:
+      if (lc) emit(OP_DIVC, dst, b, -1, nodes[nd.left].c);
+      else if (rc) emit(OP_MULC, dst, a, -1, 1.0 / nodes[nd.right].c);
+      else emit(OP_DIV, dst, a, b);
+      break;
+    case N_NEG:
+      emit(OP_NEG, dst, a);
+      break;
+    case N_POW:
+      if (nd.e == 1.0) emit(OP_MULC, dst, a, -1, 1.0);
+      else if (nd.e == 2.0) emit(OP_SQR, dst, a);
+      else emit(OP_POWC, dst, a, -1, 0.0, nd.e);
+      break;
+    case N_FUNC:
+      emit((Opcode) (OP_SQRT + nd.input), dst, a);
+      break;
+    default:
+      error("Internal error in the weak form compiler.");
+  }
+  return n_inputs + dst;
+}
+
+scalar WeakFormExpression::value(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e,
+                                 ExtData<scalar> *ext) const
+{
+  assert(n_ext_used == 0 || (ext != NULL && ext->nf >= n_ext_used));
+
+  scalar regs[H2D_WFC_MAX_REGS][H2D_WFC_BLOCK];
+#ifdef H2D_COMPLEX
+  scalar conv[IN_FN + 6][H2D_WFC_BLOCK];
+#endif
+
+  int nu = used_inputs.size();
+  const scalar* slot[H2D_WFC_MAX_INPUTS + H2D_WFC_MAX_REGS];
+  for (int r = 0; r < n_regs; r++) slot[nu + r] = regs[r];
+
+  // Base pointers of the used inputs. The inputs of type double (coordinates,
+  // normals, u and v) come first, 'nd' is their number.
+  const double* dbase[IN_FN + 6];
+  const scalar* sbase[H2D_WFC_MAX_INPUTS];
+  int nd = 0;
+  for (int k = 0; k < nu; k++)
+  {
+    int in = used_inputs[k];
+    switch (in)
+    {
+      case IN_X:  dbase[nd++] = e->x;  break;
+      case IN_Y:  dbase[nd++] = e->y;  break;
+      case IN_NX: dbase[nd++] = e->nx; break;
+      case IN_NY: dbase[nd++] = e->ny; break;
+      default:
+      {
+        int fn = (in - IN_FN) / 3, comp = (in - IN_FN) % 3;
+        if (fn < FN_EXT)
+        {
+          Func<double>* f = (fn == FN_U) ? u : v;
+          dbase[nd++] = (comp == 0) ? f->val : (comp == 1) ? f->dx : f->dy;
+        }
+        else
+        {
+          Func<scalar>* f = ext->fn[fn - FN_EXT];
+          sbase[k] = (comp == 0) ? f->val : (comp == 1) ? f->dx : f->dy;
+        }
+      }
+    }
+  }
+
+  scalar result_value = 0.0;
+  for (int off = 0; off < n; off += H2D_WFC_BLOCK)
+  {
+    int m = std::min(n - off, H2D_WFC_BLOCK);
+
+    // Point the input slots to this block.
+    for (int k = 0; k < nd; k++)
+    {
+#ifdef H2D_COMPLEX
+      for (int i = 0; i < m; i++) conv[k][i] = dbase[k][off + i];
+      slot[k] = conv[k];
+#else
+      slot[k] = dbase[k] + off;
+#endif
+    }
+    for (int k = nd; k < nu; k++)
+      slot[k] = sbase[k] + off;
+
+    for (unsigned int k = 0; k < code.size(); k++)
+    {
+      const Instr& ins = code[k];
+      scalar* d = regs[ins.dst];
+      const scalar* a = (ins.a >= 0) ? slot[ins.a] : NULL;
+      const scalar* b = (ins.b >= 0) ? slot[ins.b] : NULL;
+      const scalar c = ins.c;
+      int i;
+      switch (ins.op)
+      {
+        case OP_CONST: for (i = 0; i < m; i++) d[i] = c; break;
+        case OP_ADD:   for (i = 0; i < m; i++) d[i] = a[i] + b[i]; break;
+        case OP_SUB:   for (i = 0; i < m; i++) d[i] = a[i] - b[i]; break;
+        case OP_MUL:   for (i = 0; i < m; i++) d[i] = a[i] * b[i]; break;
+        case OP_DIV:   for (i = 0; i < m; i++) d[i] = a[i] / b[i]; break;
+        case OP_NEG:   for (i = 0; i < m; i++) d[i] = -a[i]; break;
+        case OP_SQR:   for (i = 0; i < m; i++) d[i] = a[i] * a[i]; break;
+        case OP_ADDC:  for (i = 0; i < m; i++) d[i] = a[i] + c; break;
+        case OP_MULC:  for (i = 0; i < m; i++) d[i] = a[i] * c; break;
+        case OP_SUBC:  for (i = 0; i < m; i++) d[i] = c - a[i]; break;
+        case OP_DIVC:  for (i = 0; i < m; i++) d[i] = c / a[i]; break;
+        case OP_POWC:  for (i = 0; i < m; i++) d[i] = pow(a[i], ins.e); break;
+        case OP_SQRT:  for (i = 0; i < m; i++) d[i] = sqrt(a[i]); break;
+        case OP_EXP:   for (i = 0; i < m; i++) d[i] = exp(a[i]); break;
+        case OP_LOG:   for (i = 0; i < m; i++) d[i] = log(a[i]); break;
+        case OP_SIN:   for (i = 0; i < m; i++) d[i] = sin(a[i]); break;
+        case OP_COS:   for (i = 0; i < m; i++) d[i] = cos(a[i]); break;
+        case OP_ABS:   for (i = 0; i < m; i++) d[i] = wfc_abs(a[i]); break;
+      }
+    }
+
+    const scalar* r = slot[result];
+    const double* w = wt + off;
+    for (int i = 0; i < m; i++)
+      result_value += w[i] * r[i];
+  }
+  return result_value;
+}
+
+Ord WeakFormExpression::ord_node(int n, Ord* in) const
+{
+  const Node& nd = nodes[n];
+  switch (nd.type)
+  {
+    case N_CONST: return Ord(0);
+    case N_INPUT: return in[nd.input];
+    case N_NEG:   return ord_node(nd.left, in);
+    case N_POW:   return pow(ord_node(nd.left, in), nd.e);
+    case N_FUNC:
+    {
+      Ord a = ord_node(nd.left, in);
+      switch (nd.input)
+      {
+        case F_SQRT: return sqrt(a);
+        case F_EXP:  return exp(a);
+        case F_LOG:  return log(a);
+        case F_SIN:  return sin(a);
+        case F_COS:  return cos(a);
+        default:     return abs(a);
+      }
+    }
+    default: break;
+  }
+
+  // Constants are folded into the operations, they do not increase the order
+  // (except for a constant divided by a function).
+  bool rc = (nodes[nd.right].type == N_CONST);
+  Ord a = ord_node(nd.left, in), b = ord_node(nd.right, in);
+  switch (nd.type)
+  {
+    case N_ADD:
+    case N_SUB: return a + b;
+    case N_MUL: return a * b;
+    default:    return rc ? a : a / b;
+  }
+}
+
+Ord WeakFormExpression::ord(Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, ExtData<Ord> *ext) const
+{
+  assert(n_ext_used == 0 || (ext != NULL && ext->nf >= n_ext_used));
+
+  // Orders of all inputs (the tree refers to the original numbers of the inputs).
+  std::vector<Ord> in(n_inputs);
+  in[IN_X] = e->x[0];
+  in[IN_Y] = e->y[0];
+  if (surface)
+  {
+    in[IN_NX] = e->nx[0];
+    in[IN_NY] = e->ny[0];
+  }
+  for (int fn = 0; fn < FN_EXT + n_ext_used; fn++)
+  {
+    Func<Ord>* f = (fn == FN_U) ? u : (fn == FN_V) ? v : ext->fn[fn - FN_EXT];
+    if (f == NULL) continue;
+    in[IN_FN + 3*fn]     = f->val[0];
+    in[IN_FN + 3*fn + 1] = f->dx[0];
+    in[IN_FN + 3*fn + 2] = f->dy[0];
+  }
+  return ord_node(root, &in[0]);
+}
+
+
+//// forms /////////////////////////////////////////////////////////////////////////////////////////
+
+CompiledMatrixFormVol::CompiledMatrixFormVol(unsigned int i, unsigned int j, std::string text,
+                                             std::string area, SymFlag sym, Hermes::vector<MeshFunction *> ext,
+                                             Hermes::vector<std::string> ext_names, Hermes::vector<scalar> param,
+                                             Hermes::vector<std::string> param_names)
+  : WeakForm::MatrixFormVol(i, j, area, sym, ext, param),
+    expr(text, ext_names, param_names, param)
+{
+  if (expr.is_surface() || !expr.is_bilinear())
+    error("The form \"%s\" is not a bilinear volumetric form (\"vol u, v: ...\").", text.c_str());
+  if (ext_names.size() > ext.size())
+    error("More names of external functions than external functions in the form \"%s\".", text.c_str());
+}
+
+scalar CompiledMatrixFormVol::value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *u, Func<double> *v,
+                                    Geom<double> *e, ExtData<scalar> *ext) const
+{
+  return expr.value(n, wt, u, v, e, ext);
+}
+
+Ord CompiledMatrixFormVol::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                               Geom<Ord> *e, ExtData<Ord> *ext) const
+{
+  return expr.ord(u, v, e, ext);
+}
+
+WeakForm::MatrixFormVol* CompiledMatrixFormVol::clone()
+{
+  return new CompiledMatrixFormVol(*this);
+}
+
+CompiledMatrixFormSurf::CompiledMatrixFormSurf(unsigned int i, unsigned int j, std::string text,
+                                               std::string area, Hermes::vector<MeshFunction *> ext,
+                                               Hermes::vector<std::string> ext_names, Hermes::vector<scalar> param,
+                                               Hermes::vector<std::string> param_names)
+  : WeakForm::MatrixFormSurf(i, j, area, ext, param),
+    expr(text, ext_names, param_names, param)
+{
+  if (!expr.is_surface() || !expr.is_bilinear())
+    error("The form \"%s\" is not a bilinear surface form (\"surf u, v: ...\").", text.c_str());
+  if (ext_names.size() > ext.size())
+    error("More names of external functions than external functions in the form \"%s\".", text.c_str());
+}
+
+scalar CompiledMatrixFormSurf::value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *u, Func<double> *v,
+                                     Geom<double> *e, ExtData<scalar> *ext) const
+{
+  return expr.value(n, wt, u, v, e, ext);
+}
+
+Ord CompiledMatrixFormSurf::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                                Geom<Ord> *e, ExtData<Ord> *ext) const
+{
+  return expr.ord(u, v, e, ext);
+}
+
+WeakForm::MatrixFormSurf* CompiledMatrixFormSurf::clone()
+{
+  return new CompiledMatrixFormSurf(*this);
+}
+
+CompiledVectorFormVol::CompiledVectorFormVol(unsigned int i, std::string text,
+                                             std::string area, Hermes::vector<MeshFunction *> ext,
+                                             Hermes::vector<std::string> ext_names, Hermes::vector<scalar> param,
+                                             Hermes::vector<std::string> param_names)
+  : WeakForm::VectorFormVol(i, area, ext, param),
+    expr(text, ext_names, param_names, param)
+{
+  if (expr.is_surface() || expr.is_bilinear())
+    error("The form \"%s\" is not a linear volumetric form (\"vol v: ...\").", text.c_str());
+  if (ext_names.size() > ext.size())
+    error("More names of external functions than external functions in the form \"%s\".", text.c_str());
+}
+
+scalar CompiledVectorFormVol::value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *v,
+                                    Geom<double> *e, ExtData<scalar> *ext) const
+{
+  return expr.value(n, wt, NULL, v, e, ext);
+}
+
+Ord CompiledVectorFormVol::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+                               Geom<Ord> *e, ExtData<Ord> *ext) const
+{
+  return expr.ord(NULL, v, e, ext);
+}
+
+WeakForm::VectorFormVol* CompiledVectorFormVol::clone()
+{
+  return new CompiledVectorFormVol(*this);
+}
+
+CompiledVectorFormSurf::CompiledVectorFormSurf(unsigned int i, std::string text,
+                                               std::string area, Hermes::vector<MeshFunction *> ext,
+                                               Hermes::vector<std::string> ext_names, Hermes::vector<scalar> param,
+                                               Hermes::vector<std::string> param_names)
+  : WeakForm::VectorFormSurf(i, area, ext, param),
+    expr(text, ext_names, param_names, param)
+{
+  if (!expr.is_surface() || expr.is_bilinear())
+    error("The form \"%s\" is not a linear surface form (\"surf v: ...\").", text.c_str());
+  if (ext_names.size() > ext.size())
+    error("More names of external functions than external functions in the form \"%s\".", text.c_str());
+}
+
+scalar CompiledVectorFormSurf::value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *v,
+                                     Geom<double> *e, ExtData<scalar> *ext) const
+{
+  return expr.value(n, wt, NULL, v, e, ext);
+}
+
+Ord CompiledVectorFormSurf::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+                                Geom<Ord> *e, ExtData<Ord> *ext) const
+{
+  return expr.ord(NULL, v, e, ext);
+}
+
+WeakForm::VectorFormSurf* CompiledVectorFormSurf::clone()
+{
+  return new CompiledVectorFormSurf(*this);
+}
@@ -0,0 +1,227 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_WEAKFORM_COMPILER_H
+#define __H2D_WEAKFORM_COMPILER_H
+
+#include "weakform.h"
+#include "../function/forms.h"
+
+/// Number of integration points processed by one pass of the bytecode.
+#define H2D_WFC_BLOCK     64
+/// Maximum number of registers of a compiled expression.
+#define H2D_WFC_MAX_REGS  16
+/// Maximum number of distinct inputs (functions, derivatives, coordinates) of an expression.
+#define H2D_WFC_MAX_INPUTS 32
+
+/// \brief Weak form given as text, compiled into a register-based bytecode.
+///
+/// The text has the form (see also weakform_lexer.l)
+///
+///   "vol u, v: (u_x*v_x + u_y*v_y)/Re + u*v/tau"   (bilinear form, basis u, test function v)
+///   "surf v: alpha * (x^2 + y^2) * v"              (linear form, test function v)
+///
+/// Operands are the basis and the test function and their derivatives (u, u_x, u_y, or
+/// dx(u), dy(u)), external functions named by 'ext_names' (bound to Form::ext in this order,
+/// with the same derivatives), coordinates x, y, the outer normal nx, ny (surface forms only),
+/// numbers and parameters named by 'param_names' (with values from Form::param), and in the
+/// complex version the imaginary unit i. Operators are +, -, *, / and ^ with a constant
+/// exponent, functions are sqrt, exp, log, sin, cos and abs. Names consist of letters, digits
+/// and underscores; a name that would shadow another one (e.g. a parameter named x, or an
+/// external function named u_x) is rejected.
+///
+/// The text is parsed once into a tree, in which constants (including the parameters) are
+/// folded. The tree is then compiled into a flat sequence of instructions operating on
+/// registers, each holding the values in a block of H2D_WFC_BLOCK integration points, so that
+/// every instruction is a plain loop over the points. The integration order is obtained from
+/// the same tree by evaluating it on Ord, so no ord() has to be written for the form.
+class HERMES_API WeakFormExpression
+{
+public:
+  WeakFormExpression(std::string text,
+                     Hermes::vector<std::string> ext_names = Hermes::vector<std::string>(),
+                     Hermes::vector<std::string> param_names = Hermes::vector<std::string>(),
+                     Hermes::vector<scalar> param = Hermes::vector<scalar>());
+
+  bool is_surface() const { return surface; }
+  bool is_bilinear() const { return bilinear; }
+  int get_num_instructions() const { return (int) code.size(); }
+  int get_num_registers() const { return n_regs; }
+
+  /// Number of the external functions the expression uses (the first ones of 'ext_names').
+  /// 'ext' in value() and ord() has to hold at least these, the compiled forms below check
+  /// that they are given enough external functions when they are constructed.
+  int get_num_ext() const { return n_ext_used; }
+
+  /// Integral of the expression (u is NULL for linear forms).
+  scalar value(int n, double *wt, Func<double> *u, Func<double> *v, Geom<double> *e,
+               ExtData<scalar> *ext) const;
+
+  /// Integration order of the expression.
+  Ord ord(Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, ExtData<Ord> *ext) const;
+
+protected:
+  enum NodeType { N_CONST, N_INPUT, N_ADD, N_SUB, N_MUL, N_DIV, N_NEG, N_POW, N_FUNC };
+  enum FuncType { F_SQRT, F_EXP, F_LOG, F_SIN, F_COS, F_ABS };
+
+  /// Inputs: coordinates and normals, then (val, dx, dy) of u, v and the external functions.
+  enum { IN_X, IN_Y, IN_NX, IN_NY, IN_FN };
+  enum { FN_U, FN_V, FN_EXT };
+
+  struct Node
+  {
+    NodeType type;
+    int left, right;   ///< Operands (indices to 'nodes').
+    int input;         ///< N_INPUT: the input, N_FUNC: the function.
+    scalar c;          ///< N_CONST: the value.
+    double e;          ///< N_POW: the exponent.
+  };
+
+  enum Opcode
+  {
+    OP_CONST, OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_NEG, OP_SQR,
+    OP_ADDC, OP_MULC, OP_SUBC, OP_DIVC, OP_POWC,
+    OP_SQRT, OP_EXP, OP_LOG, OP_SIN, OP_COS, OP_ABS
+  };
+
+  /// Operands are slots: the used inputs (see used_inputs) come first, registers follow.
+  struct Instr
+  {
+    Opcode op;
+    int dst;           ///< Register.
+    int a, b;          ///< Slots.
+    scalar c;          ///< Immediate operand.
+    double e;          ///< Exponent of OP_POWC.
+  };
+
+  bool surface, bilinear;
+  int n_ext, n_ext_used, n_inputs;
+
+  std::vector<Node> nodes;
+  int root;
+
+  std::vector<Instr> code;
+  std::vector<int> used_inputs;
+  int n_regs;
+  int result;          ///< Slot with the values of the expression.
+
+  // Parsing.
+  void parse(const std::string& text, Hermes::vector<std::string>& ext_names,
+             Hermes::vector<std::string>& param_names, Hermes::vector<scalar>& param);
+
+  int make_node(NodeType type, int left = -1, int right = -1);
+  int make_const(scalar c);
+  int fold(int n);
+
+  // Compilation.
+  int compile_node(int n, std::vector<bool>& busy);
+  int alloc_reg(std::vector<bool>& busy);
+  void emit(Opcode op, int dst, int a, int b = -1, scalar c = 0.0, double e = 0.0);
+
+  Ord ord_node(int n, Ord* in) const;
+
+  friend class WeakFormParser;
+};
+
+
+/// Bilinear volumetric form given as text, e.g. "vol u, v: u_x*v_x + u_y*v_y".
+class HERMES_API CompiledMatrixFormVol : public WeakForm::MatrixFormVol
+{
+public:
+  CompiledMatrixFormVol(unsigned int i, unsigned int j, std::string text,
+                        std::string area = HERMES_ANY, SymFlag sym = HERMES_NONSYM,
+                        Hermes::vector<MeshFunction *> ext = Hermes::vector<MeshFunction*>(),
+                        Hermes::vector<std::string> ext_names = Hermes::vector<std::string>(),
+                        Hermes::vector<scalar> param = Hermes::vector<scalar>(),
+                        Hermes::vector<std::string> param_names = Hermes::vector<std::string>());
+
+  virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *u, Func<double> *v,
+                       Geom<double> *e, ExtData<scalar> *ext) const;
+  virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                  Geom<Ord> *e, ExtData<Ord> *ext) const;
+
+  virtual WeakForm::MatrixFormVol* clone();
+
+protected:
+  WeakFormExpression expr;
+};
+
+/// Bilinear surface form given as text, e.g. "surf u, v: alpha*u*v".
+class HERMES_API CompiledMatrixFormSurf : public WeakForm::MatrixFormSurf
+{
+public:
+  CompiledMatrixFormSurf(unsigned int i, unsigned int j, std::string text,
+                         std::string area = HERMES_ANY,
+                         Hermes::vector<MeshFunction *> ext = Hermes::vector<MeshFunction*>(),
+                         Hermes::vector<std::string> ext_names = Hermes::vector<std::string>(),
+                         Hermes::vector<scalar> param = Hermes::vector<scalar>(),
+                         Hermes::vector<std::string> param_names = Hermes::vector<std::string>());
+
+  virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *u, Func<double> *v,
+                       Geom<double> *e, ExtData<scalar> *ext) const;
+  virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                  Geom<Ord> *e, ExtData<Ord> *ext) const;
+
+  virtual WeakForm::MatrixFormSurf* clone();
+
+protected:
+  WeakFormExpression expr;
+};
+
+/// Linear volumetric form given as text, e.g. "vol v: f*v".
+class HERMES_API CompiledVectorFormVol : public WeakForm::VectorFormVol
+{
+public:
+  CompiledVectorFormVol(unsigned int i, std::string text,
+                        std::string area = HERMES_ANY,
+                        Hermes::vector<MeshFunction *> ext = Hermes::vector<MeshFunction*>(),
+                        Hermes::vector<std::string> ext_names = Hermes::vector<std::string>(),
+                        Hermes::vector<scalar> param = Hermes::vector<scalar>(),
+                        Hermes::vector<std::string> param_names = Hermes::vector<std::string>());
+
+  virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *v,
+                       Geom<double> *e, ExtData<scalar> *ext) const;
+  virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+                  Geom<Ord> *e, ExtData<Ord> *ext) const;
+
+  virtual WeakForm::VectorFormVol* clone();
+
+protected:
+  WeakFormExpression expr;
+};
+
+/// Linear surface form given as text, e.g. "surf v: g*v".
+class HERMES_API CompiledVectorFormSurf : public WeakForm::VectorFormSurf
+{
+public:
+  CompiledVectorFormSurf(unsigned int i, std::string text,
+                         std::string area = HERMES_ANY,
+                         Hermes::vector<MeshFunction *> ext = Hermes::vector<MeshFunction*>(),
+                         Hermes::vector<std::string> ext_names = Hermes::vector<std::string>(),
+                         Hermes::vector<scalar> param = Hermes::vector<scalar>(),
+                         Hermes::vector<std::string> param_names = Hermes::vector<std::string>());
+
+  virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *v,
+                       Geom<double> *e, ExtData<scalar> *ext) const;
+  virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+                  Geom<Ord> *e, ExtData<Ord> *ext) const;
+
+  virtual WeakForm::VectorFormSurf* clone();
+
+protected:
+  WeakFormExpression expr;
+};
+
+#endif
@@ -0,0 +1,196 @@
+#include "hermes2d.h"
+
+using namespace WeakFormsH1;
+
+// This test makes sure that the cache of the DG edge neighborhoods (DiscreteProblem::DGFaceCache)
+// does not change the assembled system. A system of two advection equations with upwind fluxes
+// on inner edges, coupled by an inner edge form, is discretized by L2 spaces of order p on two
+// meshes of triangles and quads refined differently (with hanging nodes), and an inner edge
+// vector form takes the values of a Solution on the second mesh from both sides of the edge.
+// The second assembling by one DiscreteProblem (which uses the cached neighborhoods) has to give
+// the same matrix and vector as the first one and as a new DiscreteProblem. Then the first mesh
+// is refined, so that the cache is out of date, and the next assembling has to agree with a new
+// DiscreteProblem again.
+
+// Upwind flux of the velocity (1, 0.5) through the edge.
+template<typename Real>
+Real upwind_flux(Real u_central, Real u_neighbor, Real nx, Real ny)
+{
+  Real a_dot_n = nx + 0.5 * ny;
+  return a_dot_n * (a_dot_n >= 0 ? u_central : u_neighbor);
+}
+
+template<>
+Ord upwind_flux(Ord u_central, Ord u_neighbor, Ord nx, Ord ny)
+{
+  return u_central + u_neighbor;
+}
+
+class CustomWeakForm : public WeakForm
+{
+public:
+  CustomWeakForm(MeshFunction* ext_fn) : WeakForm(2)
+  {
+    add_matrix_form(new DefaultMatrixFormVol(0, 0));
+    add_matrix_form(new DefaultMatrixFormVol(1, 1));
+    add_matrix_form_surf(new MatrixFormInterface(0, 0));
+    add_matrix_form_surf(new MatrixFormInterface(1, 1));
+    add_matrix_form_surf(new MatrixFormInterface(0, 1));
+    add_vector_form(new DefaultVectorFormVol(1, HERMES_ANY, new HermesFunction(1.0)));
+    VectorFormInterface* form = new VectorFormInterface(0);
+    form->ext.push_back(ext_fn);
+    add_vector_form_surf(form);
+  }
+
+private:
+  class MatrixFormInterface : public WeakForm::MatrixFormSurf
+  {
+  public:
+    MatrixFormInterface(int i, int j) : WeakForm::MatrixFormSurf(i, j, H2D_DG_INNER_EDGE) { }
+
+    template<typename Real, typename Scalar>
+    Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v,
+                       Geom<Real> *e, ExtData<Scalar> *ext) const {
+      Scalar result = 0;
+      for (int i = 0; i < n; i++)
+        result += wt[i] * upwind_flux<Real>(u->get_val_central(i), u->get_val_neighbor(i), e->nx[i], e->ny[i])
+                  * (v->get_val_central(i) - v->get_val_neighbor(i));
+      return result;
+    }
+
+    virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *u, Func<double> *v,
+                         Geom<double> *e, ExtData<scalar> *ext) const {
+      return matrix_form<double, scalar>(n, wt, u_ext, u, v, e, ext);
+    }
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                    Geom<Ord> *e, ExtData<Ord> *ext) const {
+      return matrix_form<Ord, Ord>(n, wt, u_ext, u, v, e, ext);
+    }
+  };
+
+  class VectorFormInterface : public WeakForm::VectorFormSurf
+  {
+  public:
+    VectorFormInterface(int i) : WeakForm::VectorFormSurf(i, H2D_DG_INNER_EDGE) { }
+
+    template<typename Real, typename Scalar>
+    Scalar vector_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *v,
+                       Geom<Real> *e, ExtData<Scalar> *ext) const {
+      Func<Scalar>* w = ext->fn[0];
+      Scalar result = 0;
+      for (int i = 0; i < n; i++)
+        result += wt[i] * upwind_flux<Scalar>(w->get_val_central(i), w->get_val_neighbor(i), e->nx[i], e->ny[i])
+                  * v->val[i];
+      return result;
+    }
+
+    virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *v,
+                         Geom<double> *e, ExtData<scalar> *ext) const {
+      return vector_form<double, scalar>(n, wt, u_ext, v, e, ext);
+    }
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+                    Geom<Ord> *e, ExtData<Ord> *ext) const {
+      return vector_form<Ord, Ord>(n, wt, u_ext, v, e, ext);
+    }
+  };
+};
+
+// Assembles the system by 'dp' into 'values': the matrix entries (row by row) and the vector.
+// The matrix and the vector are reused by the following assemblings by the same DiscreteProblem.
+void assemble(DiscreteProblem* dp, UMFPackMatrix* mat, UMFPackVector* rhs, int ndof,
+              std::vector<double>& values)
+{
+  dp->assemble(mat, rhs);
+
+  values.clear();
+  for (int i = 0; i < ndof; i++)
+    for (int j = 0; j < ndof; j++)
+      values.push_back(mat->get(i, j));
+  for (int i = 0; i < ndof; i++)
+    values.push_back(rhs->get(i));
+}
+
+// Returns true if the systems 'a' and 'b' are the same.
+bool compare(std::vector<double>& a, std::vector<double>& b, const char* msg)
+{
+  double max_value = 0.0, max_diff = 0.0;
+  for (unsigned int i = 0; i < a.size(); i++)
+  {
+    max_value = std::max(max_value, fabs(a[i]));
+    max_diff = std::max(max_diff, fabs(a[i] - b[i]));
+  }
+  printf("%s: max. value %g, max. difference %g\n", msg, max_value, max_diff);
+  return a.size() == b.size() && max_value > 0.0 && max_diff <= 1e-14 * max_value;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("please input as this format: dg_face_cache  p \n");
+    return ERR_FAILURE;
+  }
+  int p = atoi(argv[1]);
+  if (p < 0) return ERR_FAILURE;
+
+  Mesh mesh1, mesh2;
+  H2DReader mloader;
+  mloader.load("square_mixed.mesh", &mesh1);
+  mloader.load("square_mixed.mesh", &mesh2);
+  mesh1.refine_element_id(0);
+  mesh2.refine_element_id(5);
+  mesh1.refine_all_elements();
+  mesh2.refine_all_elements();
+
+  L2Space space1(&mesh1, p), space2(&mesh2, p);
+  Hermes::vector<Space*> spaces(&space1, &space2);
+  int ndof = Space::get_num_dofs(spaces);
+
+  // a Solution on the second mesh for the vector form
+  int ndof2 = space2.get_num_dofs();
+  scalar* coeff_vec = new scalar[ndof2];
+  for (int i = 0; i < ndof2; i++)
+    coeff_vec[i] = sin((double) i);
+  Solution w;
+  Solution::vector_to_solution(coeff_vec, &space2, &w);
+  delete [] coeff_vec;
+
+  CustomWeakForm wf(&w);
+  std::vector<double> first, cached, uncached;
+  DiscreteProblem dp(&wf, spaces);
+  UMFPackMatrix mat;
+  UMFPackVector rhs;
+  assemble(&dp, &mat, &rhs, ndof, first);
+  assemble(&dp, &mat, &rhs, ndof, cached);
+  {
+    DiscreteProblem dp_new(&wf, spaces);
+    UMFPackMatrix mat_new;
+    UMFPackVector rhs_new;
+    assemble(&dp_new, &mat_new, &rhs_new, ndof, uncached);
+  }
+  bool success = compare(first, cached, "cached and first assembling");
+  success = compare(uncached, cached, "cached and uncached assembling") && success;
+
+  // the cache is out of date after a refinement
+  mesh1.refine_element_id(mesh1.get_max_element_id() - 1);
+  space1.set_uniform_order(p);
+  ndof = Space::assign_dofs(spaces);
+  assemble(&dp, &mat, &rhs, ndof, cached);
+  {
+    DiscreteProblem dp_new(&wf, spaces);
+    UMFPackMatrix mat_new;
+    UMFPackVector rhs_new;
+    assemble(&dp_new, &mat_new, &rhs_new, ndof, uncached);
+  }
+  success = compare(uncached, cached, "after a refinement, reused and new DiscreteProblem") && success;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return ERR_SUCCESS;
+  }
+  printf("Failure!\n");
+  return ERR_FAILURE;
+}
@@ -0,0 +1,229 @@
+#include "hermes2d.h"
+
+using namespace WeakFormsH1;
+
+// This test checks the DOF orderings of Space. A Poisson problem with a nonzero Dirichlet
+// condition is solved on the unit square (square_mixed.mesh: 2 x 2 cells, two of them split
+// into triangles; one cell is refined to get hanging nodes, then the mesh is refined
+// 'levels' times) with elements of order p, once for each ordering. For each ordering the
+// DOFs of the element assembly lists have to be exactly 0, ..., ndof - 1, dup() of the H1
+// space and of an Hdiv space (on the same grid without triangles, square_quad.mesh) has to
+// keep the numbering, and the solutions have to be the same at a set of points. The
+// bandwidth and the profile of the RCM ordering must not be larger than those of the
+// natural ordering.
+//
+// The bandwidth, the profile, the number of nonzeros of the factor (the fill-in of a direct
+// solver which does not reorder the matrix) and the throughput of the matrix-vector product
+// are printed for each ordering as a benchmark; the timings do not decide the result.
+
+class CustomWeakForm : public WeakForm
+{
+public:
+  CustomWeakForm() : WeakForm(1)
+  {
+    add_matrix_form(new DefaultJacobianDiffusion(0, 0));
+    add_vector_form(new DefaultVectorFormVol(0, HERMES_ANY, new HermesFunction(1.0)));
+  }
+};
+
+// Number of nonzeros of the Cholesky factor of a matrix with the (symmetrized) pattern of
+// 'mat', computed row by row with the elimination tree.
+long factor_nnz(CSCMatrix* mat)
+{
+  int n = mat->get_size();
+  int* Ap = mat->get_Ap();
+  int* Ai = mat->get_Ai();
+  std::vector<std::vector<int> > lower(n);
+  for (int j = 0; j < n; j++)
+    for (int k = Ap[j]; k < Ap[j+1]; k++)
+    {
+      if (Ai[k] > j) lower[Ai[k]].push_back(j);
+      else if (Ai[k] < j) lower[j].push_back(Ai[k]);
+    }
+
+  std::vector<int> parent(n, -1), mark(n, -1);
+  long nnz = n;
+  for (int i = 0; i < n; i++)
+  {
+    mark[i] = i;
+    for (unsigned int k = 0; k < lower[i].size(); k++)
+      for (int j = lower[i][k]; mark[j] != i; j = parent[j])
+      {
+        if (parent[j] < 0) parent[j] = i;
+        mark[j] = i;
+        nnz++;
+      }
+  }
+  return nnz;
+}
+
+// Loads the mesh, refines one cell to get hanging nodes, then refines it 'levels' times.
+void load_mesh(const char* filename, Mesh* mesh, int levels)
+{
+  H2DReader mloader;
+  mloader.load(filename, mesh);
+  mesh->refine_element_id(0);
+  for (int i = 0; i < levels; i++)
+    mesh->refine_all_elements();
+}
+
+// Checks that the DOFs of the element assembly lists are exactly 0, ..., ndof - 1.
+bool is_permutation(Mesh* mesh, Space* space)
+{
+  int ndof = space->get_num_dofs();
+  std::vector<bool> used(ndof, false);
+  Element* e;
+  AsmList al;
+  for_all_active_elements(e, mesh)
+  {
+    space->get_element_assembly_list(e, &al);
+    for (unsigned int i = 0; i < al.cnt; i++)
+    {
+      if (al.dof[i] >= ndof) return false;
+      if (al.dof[i] >= 0) used[al.dof[i]] = true;
+    }
+  }
+  return std::count(used.begin(), used.end(), true) == ndof;
+}
+
+// Checks that dup() keeps the ordering: the duplicate numbers the DOFs as the original.
+bool dup_keeps_ordering(Mesh* mesh, Space* space)
+{
+  Space* dup = space->dup(mesh);
+  bool same = (dup->get_dof_ordering() == space->get_dof_ordering()
+               && dup->get_num_dofs() == space->get_num_dofs());
+  Element* e;
+  AsmList al, dup_al;
+  for_all_active_elements(e, mesh)
+  {
+    space->get_element_assembly_list(e, &al);
+    dup->get_element_assembly_list(e, &dup_al);
+    if (al.cnt != dup_al.cnt) same = false;
+    for (unsigned int i = 0; same && i < al.cnt; i++)
+      if (al.dof[i] != dup_al.dof[i]) same = false;
+  }
+  delete dup;
+  return same;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    printf("please input as this format: dof_ordering  levels  p \n");
+    return ERR_FAILURE;
+  }
+  int levels = atoi(argv[1]), p = atoi(argv[2]);
+  if (levels < 0 || p < 1) return ERR_FAILURE;
+
+  Mesh mesh, quad_mesh;
+  load_mesh("square_mixed.mesh", &mesh, levels);
+  load_mesh("square_quad.mesh", &quad_mesh, levels);
+
+  DefaultEssentialBCConst bc("1", 1.0);
+  EssentialBCs bcs(&bc);
+  CustomWeakForm wf;
+
+  const int num_orderings = 4;
+  EDofOrdering orderings[num_orderings] = { HERMES_NATURAL_DOF_ORDERING, HERMES_RCM_DOF_ORDERING,
+                                            HERMES_ELEMENT_DOF_ORDERING, HERMES_SFC_DOF_ORDERING };
+  const char* names[num_orderings] = { "natural", "RCM", "element", "SFC" };
+
+  // the solutions are compared at the points of a grid
+  const int np = 7;
+  std::vector<double> values;
+  int ndof = -1, natural_bandwidth = 0;
+  long natural_profile = 0;
+  printf("%-8s %7s %9s %9s %10s %11s %8s %9s\n", "ordering", "DOFs", "nnz", "bandwidth", "profile",
+         "factor nnz", "SpMV s", "MFlop/s");
+  for (int o = 0; o < num_orderings; o++)
+  {
+    H1Space space(&mesh, &bcs, p);
+    space.set_dof_ordering(orderings[o]);
+    if (ndof < 0) ndof = space.get_num_dofs();
+    if (space.get_num_dofs() != ndof || !is_permutation(&mesh, &space))
+    {
+      printf("%s ordering: the DOFs are not a permutation of 0, ..., %d.\n", names[o], ndof - 1);
+      printf("Failure!\n");
+      return ERR_FAILURE;
+    }
+    HdivSpace hdiv_space(&quad_mesh, p);
+    hdiv_space.set_dof_ordering(orderings[o]);
+    if (!dup_keeps_ordering(&mesh, &space) || !dup_keeps_ordering(&quad_mesh, &hdiv_space))
+    {
+      printf("%s ordering: dup() does not keep the numbering of the DOFs.\n", names[o]);
+      printf("Failure!\n");
+      return ERR_FAILURE;
+    }
+
+    DiscreteProblem dp(&wf, &space);
+    UMFPackMatrix mat;
+    UMFPackVector rhs;
+    dp.assemble(&mat, &rhs);
+
+    // bandwidth and profile (the number of entries between the first nonzero of a row
+    // and the diagonal) of the symmetric matrix
+    int size = mat.get_size(), bandwidth = 0;
+    std::vector<int> first(size);
+    for (int i = 0; i < size; i++) first[i] = i;
+    for (int j = 0; j < size; j++)
+      for (int l = mat.get_Ap()[j]; l < mat.get_Ap()[j+1]; l++)
+      {
+        int i = mat.get_Ai()[l];
+        bandwidth = std::max(bandwidth, abs(i - j));
+        first[std::max(i, j)] = std::min(first[std::max(i, j)], std::min(i, j));
+      }
+    long profile = 0;
+    for (int i = 0; i < size; i++) profile += i - first[i];
+
+    // matrix-vector products (benchmark only)
+    std::vector<scalar> x(size, 1.0), y(size);
+    int reps = std::max(1, (int) (2e7 / mat.get_nnz()));
+    TimePeriod timer;
+    for (int r = 0; r < reps; r++)
+      mat.multiply_with_vector(&x[0], &y[0]);
+    timer.tick();
+    double spmv = timer.last() / reps;
+
+    printf("%-8s %7d %9d %9d %10ld %11ld %8.2e %9.0f\n", names[o], size, mat.get_nnz(), bandwidth,
+           profile, factor_nnz(&mat), spmv, spmv > 0.0 ? 2e-6 * mat.get_nnz() / spmv : 0.0);
+    if (orderings[o] == HERMES_NATURAL_DOF_ORDERING)
+    {
+      natural_bandwidth = bandwidth;
+      natural_profile = profile;
+    }
+    else if (orderings[o] == HERMES_RCM_DOF_ORDERING
+             && (bandwidth > natural_bandwidth || profile > natural_profile))
+    {
+      printf("RCM ordering: the bandwidth or the profile is larger than with the natural ordering.\n");
+      printf("Failure!\n");
+      return ERR_FAILURE;
+    }
+
+    MixedPrecisionLinearSolver solver(&mat, &rhs);
+    if (!solver.solve())
+    {
+      printf("Failure!\n");
+      return ERR_FAILURE;
+    }
+    Solution sln;
+    Solution::vector_to_solution(solver.get_solution(), &space, &sln);
+    for (int i = 0, m = 0; i < np; i++)
+      for (int j = 0; j < np; j++, m++)
+      {
+        double v = sln.get_pt_value((i + 0.5) / np, (j + 0.5) / np);
+        if (o == 0)
+          values.push_back(v);
+        else if (fabs(v - values[m]) > 1e-10 * (1.0 + fabs(values[m])))
+        {
+          printf("%s ordering: the solution differs at (%g, %g): %g %g\n", names[o],
+                 (i + 0.5) / np, (j + 0.5) / np, v, values[m]);
+          printf("Failure!\n");
+          return ERR_FAILURE;
+        }
+      }
+  }
+
+  printf("Success!\n");
+  return ERR_SUCCESS;
+}
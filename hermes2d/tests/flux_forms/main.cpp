@@ -0,0 +1,224 @@
+#include "hermes2d.h"
+
+// This test makes sure that the face-based assembling of the numerical fluxes of the Euler
+// equations (WeakForm::FluxFormSurf, EulerEquationsWeakFormExplicitMultiComponent with
+// face_based = true) gives the same residual as the element-based assembling by the DG
+// surface forms. The state is a smooth nonconstant flow projected to L2 spaces of order p
+// on a mesh of triangles and quads with hanging nodes, all four boundary conditions (inlet,
+// outlet, two solid walls) are present. Only p = 0, 1 are tested: for higher orders the
+// element-based forms integrate every test function with its own quadrature order, while
+// the flux is integrated with one quadrature on the whole face. The mode 'vijayasundaram'
+// checks the Vijayasundaram flux, which the residuals do not use.
+
+const double KAPPA = 1.4;
+const double P_EXT = 2.5;
+const double RHO_EXT = 1.0;
+const double V1_EXT = 1.25;
+const double V2_EXT = 0.0;
+
+const std::string BDY_INLET = "1";
+const std::string BDY_OUTLET = "2";
+const std::string BDY_SOLID_WALL_BOTTOM = "3";
+const std::string BDY_SOLID_WALL_TOP = "4";
+
+#include "../forms_explicit.cpp"
+
+// Conservative variables of a perturbation of the inlet state.
+class State : public ExactSolutionScalar
+{
+public:
+  State(Mesh* mesh, int component) : ExactSolutionScalar(mesh), component(component) {}
+
+  virtual scalar value(double x, double y) const {
+    double rho = RHO_EXT * (1.0 + 0.1 * sin(2*x + y));
+    double v1 = V1_EXT * (1.0 + 0.1 * cos(x - 3*y));
+    double v2 = 0.2 * sin(x * y);
+    double p = P_EXT * (1.0 + 0.1 * cos(x + y));
+    switch (component) {
+      case 0: return rho;
+      case 1: return rho * v1;
+      case 2: return rho * v2;
+      default: return QuantityCalculator::calc_energy(rho, rho * v1, rho * v2, p, KAPPA);
+    }
+  }
+
+  virtual void derivatives(double x, double y, scalar& dx, scalar& dy) const {
+    dx = dy = 0.0;
+  }
+
+  virtual Ord ord(Ord x, Ord y) const {
+    return Ord(10);
+  }
+
+  int component;
+};
+
+// Residual of the explicit scheme (the right-hand side of the mass matrix system).
+static void residual(Hermes::vector<Space*> spaces, Hermes::vector<Solution*> state,
+                     int p, bool face_based, UMFPackVector* rhs)
+{
+  OsherSolomonNumericalFlux num_flux(KAPPA);
+  EulerEquationsWeakFormExplicitMultiComponent wf(&num_flux, KAPPA, RHO_EXT, V1_EXT, V2_EXT, P_EXT, 
+    BDY_SOLID_WALL_BOTTOM, BDY_SOLID_WALL_TOP, BDY_INLET, BDY_OUTLET, state[0], state[1], state[2], state[3],
+    (p == 0), 4, face_based);
+  wf.set_time_step(1.0);
+
+  DiscreteProblem dp(&wf, spaces);
+  if (p == 0)
+    dp.set_fvm();
+  UMFPackMatrix mat;
+  dp.assemble(&mat, rhs);
+}
+
+// Physical flux f(w) . n of the Euler equations.
+static void physical_flux(double result[4], double w[4], double nx, double ny)
+{
+  double u = w[1] / w[0], v = w[2] / w[0], vn = u * nx + v * ny;
+  double p = QuantityCalculator::calc_pressure(w[0], w[1], w[2], w[3], KAPPA);
+  result[0] = w[0] * vn;
+  result[1] = w[1] * vn + p * nx;
+  result[2] = w[2] * vn + p * ny;
+  result[3] = (w[3] + p) * vn;
+}
+
+// Checks the Vijayasundaram flux (which the residual test below does not use): the flux is
+// consistent, F(w, w, n) = f(w) . n, it is the upwind flux f(w_L) . n when both states move
+// with the same supersonic velocity in the direction n (all eigenvalues are positive), and
+// numerical_flux_batch() gives the same result as numerical_flux() in every point.
+static bool check_vijayasundaram()
+{
+  VijayasundaramNumericalFlux num_flux(KAPPA);
+
+  const int n = 16;
+  double w_L[4][n], w_R[4][n], nx[n], ny[n], result[4][n];
+  for (int i = 0; i < n; i++)
+  {
+    double angle = 2.0 * M_PI * i / n;
+    nx[i] = cos(angle);
+    ny[i] = sin(angle);
+    double rho = RHO_EXT * (1.0 + 0.1 * sin(3.0 * i)), p = P_EXT * (1.0 + 0.1 * cos(5.0 * i));
+    double v1 = V1_EXT * cos(2.0 * i), v2 = V1_EXT * sin(7.0 * i);
+    w_L[0][i] = rho;
+    w_L[1][i] = rho * v1;
+    w_L[2][i] = rho * v2;
+    w_L[3][i] = QuantityCalculator::calc_energy(rho, rho * v1, rho * v2, p, KAPPA);
+    rho *= 1.1; v1 -= 0.2; v2 += 0.1; p *= 0.9;
+    w_R[0][i] = rho;
+    w_R[1][i] = rho * v1;
+    w_R[2][i] = rho * v2;
+    w_R[3][i] = QuantityCalculator::calc_energy(rho, rho * v1, rho * v2, p, KAPPA);
+  }
+
+  double* result_ptr[4] = { result[0], result[1], result[2], result[3] };
+  double* w_L_ptr[4] = { w_L[0], w_L[1], w_L[2], w_L[3] };
+  double* w_R_ptr[4] = { w_R[0], w_R[1], w_R[2], w_R[3] };
+  num_flux.numerical_flux_batch(n, result_ptr, w_L_ptr, w_R_ptr, nx, ny);
+
+  double max_consistency = 0.0, max_upwind = 0.0, max_batch = 0.0;
+  for (int i = 0; i < n; i++)
+  {
+    double wl[4], wr[4], f[4], flux[4];
+    for (int j = 0; j < 4; j++)
+    {
+      wl[j] = w_L[j][i];
+      wr[j] = w_R[j][i];
+    }
+
+    physical_flux(f, wl, nx[i], ny[i]);
+    num_flux.numerical_flux(flux, wl, wl, nx[i], ny[i]);
+    for (int j = 0; j < 4; j++)
+      max_consistency = std::max(max_consistency, fabs(flux[j] - f[j]) / (1.0 + fabs(f[j])));
+
+    num_flux.numerical_flux(flux, wl, wr, nx[i], ny[i]);
+    for (int j = 0; j < 4; j++)
+      max_batch = std::max(max_batch, fabs(flux[j] - result[j][i]) / (1.0 + fabs(flux[j])));
+
+    // the same densities and pressures moving with one supersonic velocity (Mach 3 of the
+    // left state) in the direction n
+    double speed = 3.0 * sqrt(KAPPA * QuantityCalculator::calc_pressure(wl[0], wl[1], wl[2], wl[3], KAPPA) / wl[0]);
+    double* w[2] = { wl, wr };
+    for (int k = 0; k < 2; k++)
+    {
+      double rho = w[k][0], p = QuantityCalculator::calc_pressure(w[k][0], w[k][1], w[k][2], w[k][3], KAPPA);
+      w[k][1] = rho * speed * nx[i];
+      w[k][2] = rho * speed * ny[i];
+      w[k][3] = QuantityCalculator::calc_energy(rho, w[k][1], w[k][2], p, KAPPA);
+    }
+    physical_flux(f, wl, nx[i], ny[i]);
+    num_flux.numerical_flux(flux, wl, wr, nx[i], ny[i]);
+    for (int j = 0; j < 4; j++)
+      max_upwind = std::max(max_upwind, fabs(flux[j] - f[j]) / (1.0 + fabs(f[j])));
+  }
+  printf("Vijayasundaram flux: consistency %g, upwind %g, batch %g\n", max_consistency, max_upwind,
+         max_batch);
+
+  return max_consistency < 1e-12 && max_upwind < 1e-12 && max_batch < 1e-14;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("please input as this format: flux_forms p|vijayasundaram \n");
+    return ERR_FAILURE;
+  }
+  if (strcmp(argv[1], "vijayasundaram") == 0)
+  {
+    if (!check_vijayasundaram())
+    {
+      printf("Failure!\n");
+      return ERR_FAILURE;
+    }
+    printf("Success!\n");
+    return ERR_SUCCESS;
+  }
+  int p = atoi(argv[1]);
+  if (p < 0 || p > 1) return ERR_FAILURE;
+
+  Mesh mesh;
+  H2DReader mloader;
+  mloader.load("channel.mesh", &mesh);
+
+  // hanging nodes
+  mesh.refine_all_elements();
+  int max_id = mesh.get_max_element_id();
+  mesh.refine_element_id(max_id - 1);
+  mesh.refine_element_id(max_id / 2);
+
+  L2Space space_rho(&mesh, p);
+  L2Space space_rho_v_x(&mesh, p);
+  L2Space space_rho_v_y(&mesh, p);
+  L2Space space_e(&mesh, p);
+  Hermes::vector<Space*> spaces(&space_rho, &space_rho_v_x, &space_rho_v_y, &space_e);
+  int ndof = Space::get_num_dofs(spaces);
+
+  State exact_rho(&mesh, 0), exact_rho_v_x(&mesh, 1), exact_rho_v_y(&mesh, 2), exact_e(&mesh, 3);
+  scalar* coeff_vec = new scalar[ndof];
+  OGProjection::project_global(spaces, Hermes::vector<MeshFunction*>(&exact_rho, &exact_rho_v_x, &exact_rho_v_y, &exact_e),
+                               coeff_vec, SOLVER_BANDED, Hermes::vector<ProjNormType>(HERMES_L2_NORM, HERMES_L2_NORM, 
+                               HERMES_L2_NORM, HERMES_L2_NORM));
+  Solution rho, rho_v_x, rho_v_y, e;
+  Hermes::vector<Solution*> state(&rho, &rho_v_x, &rho_v_y, &e);
+  Solution::vector_to_solutions(coeff_vec, spaces, state);
+  delete [] coeff_vec;
+
+  UMFPackVector element_based, face_based;
+  residual(spaces, state, p, false, &element_based);
+  residual(spaces, state, p, true, &face_based);
+
+  double max_value = 0.0, max_diff = 0.0;
+  for (int i = 0; i < ndof; i++)
+  {
+    max_value = std::max(max_value, fabs(element_based.get(i)));
+    max_diff = std::max(max_diff, fabs(element_based.get(i) - face_based.get(i)));
+  }
+  printf("%d DOFs, max |residual| %g, max difference %g\n", ndof, max_value, max_diff);
+
+  if (max_value == 0.0 || max_diff > 1e-12 * max_value)
+  {
+    printf("Failure!\n");
+    return ERR_FAILURE;
+  }
+  printf("Success!\n");
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "hermes2d.h"
+
+// This test makes sure that FusedFilter gives the same results as the chain of the
+// SimpleFilters it is made of. Four Solutions with given coefficient vectors are combined
+// by two graphs of filters: MagFilter(DiffFilter(u1, v1), DiffFilter(u2, v2)), and the
+// graph SumFilter(SquareFilter(d), d, u1) with d = DiffFilter(u1, v1), where the filter d
+// and the Solution u1 are used twice. The values of the FusedFilter and of the root filter
+// have to be the same at the integration points of all elements (for several orders) and
+// at a set of points, and the FusedFilter has to have the right numbers of stages and
+// sources.
+
+const int P_INIT = 3;
+const double TOL = 1e-12;
+
+// Compares the values of 'fused' and 'root' at the integration points of all elements
+// and at the points of a grid, returns the maximum difference.
+double compare(Mesh* mesh, MeshFunction* fused, MeshFunction* root)
+{
+  double max_diff = 0;
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    for (int order = 1; order <= 2 * P_INIT; order++)
+    {
+      fused->set_active_element(e);
+      fused->set_quad_order(order, H2D_FN_VAL);
+      int np = fused->get_quad_2d()->get_num_points(order);
+      std::vector<scalar> values(fused->get_fn_values(), fused->get_fn_values() + np);
+
+      root->set_active_element(e);
+      root->set_quad_order(order, H2D_FN_VAL);
+      scalar* root_values = root->get_fn_values();
+      for (int i = 0; i < np; i++)
+        max_diff = std::max(max_diff, std::abs(values[i] - root_values[i]));
+    }
+  }
+
+  const int np = 7;
+  for (int i = 0; i < np; i++)
+    for (int j = 0; j < np; j++)
+    {
+      double x = (i + 0.5) / np, y = (j + 0.5) / np;
+      max_diff = std::max(max_diff, std::abs(fused->get_pt_value(x, y) - root->get_pt_value(x, y)));
+    }
+  return max_diff;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("please input as this format: fused_filter  graph \n");
+    return ERR_FAILURE;
+  }
+  int graph = atoi(argv[1]);
+  if (graph < 0 || graph > 1) return ERR_FAILURE;
+
+  Mesh mesh;
+  H2DReader mloader;
+  mloader.load("square_mixed.mesh", &mesh);
+  mesh.refine_all_elements();
+  mesh.refine_all_elements();
+
+  H1Space space(&mesh, P_INIT);
+  int ndof = space.get_num_dofs();
+  scalar* coeffs = new scalar[ndof];
+  Solution u1, v1, u2, v2;
+  Solution* slns[4] = { &u1, &v1, &u2, &v2 };
+  for (int s = 0; s < 4; s++)
+  {
+    for (int i = 0; i < ndof; i++)
+      coeffs[i] = sin(0.7 * (s + 1) * i + s);
+    Solution::vector_to_solution(coeffs, &space, slns[s]);
+  }
+  delete [] coeffs;
+
+  DiffFilter d1(Hermes::vector<MeshFunction*>(&u1, &v1));
+  DiffFilter d2(Hermes::vector<MeshFunction*>(&u2, &v2));
+  SquareFilter sq((Hermes::vector<MeshFunction*>(&d1)));
+  SimpleFilter* root;
+  int num_stages, num_sources;
+  if (graph == 0)
+  {
+    root = new MagFilter(Hermes::vector<MeshFunction*>(&d1, &d2));
+    num_stages = 3;
+    num_sources = 4;
+  }
+  else
+  {
+    root = new SumFilter(Hermes::vector<MeshFunction*>(&sq, &d1, &u1));
+    num_stages = 3;
+    num_sources = 2;
+  }
+
+  FusedFilter fused(root);
+  printf("stages = %d, sources = %d\n", fused.get_num_stages(), fused.get_num_sources());
+  bool success = (fused.get_num_stages() == num_stages && fused.get_num_sources() == num_sources);
+
+  double diff = compare(&mesh, &fused, root);
+  printf("max. difference = %g\n", diff);
+  if (diff > TOL) success = false;
+  delete root;
+
+  if (success)
+  {
+    printf("Success!\n");
+    return ERR_SUCCESS;
+  }
+  printf("Failure!\n");
+  return ERR_FAILURE;
+}
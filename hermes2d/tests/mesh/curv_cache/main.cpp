@@ -0,0 +1,105 @@
+#include "hermes2d.h"
+
+// This test makes sure that the cache of the projected reference mappings of curved
+// elements does not change them. The keys of the cache contain the ids of the curves, so
+// copies of one mesh share the entries. A copy of the mesh is refined with the cache
+// switched off, and other copies with the cache on: the first one fills the cache, the
+// second one takes the coefficients from it, and with a cache too small for the mesh the
+// entries are dropped all the time. The coefficients of all active curved elements have
+// to be the same as without the cache.
+
+const int LEVELS = 3;
+
+// copies the mesh and refines the copy LEVELS times, the quads in all three ways
+static void copy_and_refine(Mesh* base, Mesh* mesh)
+{
+  mesh->copy(base);
+  for (int level = 0; level < LEVELS; level++)
+  {
+    Element* e;
+    Hermes::vector<int> ids, refinements;
+    for_all_active_elements(e, mesh)
+    {
+      ids.push_back(e->id);
+      refinements.push_back(e->is_triangle() ? 0 : (level + e->id) % 3);
+    }
+    mesh->refine_elements(ids, refinements);
+  }
+}
+
+static bool compare(Mesh* ref, Mesh* mesh)
+{
+  if (ref->get_max_element_id() != mesh->get_max_element_id())
+  {
+    printf("The numbers of elements differ.\n");
+    return false;
+  }
+
+  int curved = 0;
+  for (int i = 0; i < ref->get_max_element_id(); i++)
+  {
+    Element* a = ref->get_element(i);
+    Element* b = mesh->get_element(i);
+    if (a->used != b->used || a->active != b->active || a->is_curved() != b->is_curved())
+    {
+      printf("Element #%d differs.\n", i);
+      return false;
+    }
+    if (!a->used || !a->active || !a->is_curved()) continue;
+    if (a->cm->nc != b->cm->nc)
+    {
+      printf("The reference mapping of element #%d differs.\n", i);
+      return false;
+    }
+    for (int j = 0; j < a->cm->nc; j++)
+      if (a->cm->coeffs[j][0] != b->cm->coeffs[j][0] || a->cm->coeffs[j][1] != b->cm->coeffs[j][1])
+      {
+        printf("The reference mapping of element #%d differs.\n", i);
+        return false;
+      }
+    curved++;
+  }
+  printf("%d active curved elements compared\n", curved);
+  return curved > 0;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("please input as this format: curv_cache meshfile.mesh \n");
+    return ERR_FAILURE;
+  }
+
+  Mesh base;
+  H2DReader mloader;
+  mloader.load(argv[1], &base);
+
+  // without the cache
+  CurvMap::set_coeff_cache_size(0);
+  Mesh ref;
+  copy_and_refine(&base, &ref);
+
+  // the cache filled by the first copy, then used by the second one
+  CurvMap::set_coeff_cache_size(H2D_CURV_CACHE_SIZE);
+  Mesh first, second;
+  copy_and_refine(&base, &first);
+  copy_and_refine(&base, &second);
+  bool success = compare(&ref, &first) && compare(&ref, &second);
+
+  // a cache too small for the mesh
+  CurvMap::free_coeff_cache();
+  CurvMap::set_coeff_cache_size(5);
+  Mesh small;
+  copy_and_refine(&base, &small);
+  if (!compare(&ref, &small)) success = false;
+  CurvMap::set_coeff_cache_size(H2D_CURV_CACHE_SIZE);
+
+  if (success)
+  {
+    printf("Success!\n");
+    return ERR_SUCCESS;
+  }
+  printf("Failure!\n");
+  return ERR_FAILURE;
+}
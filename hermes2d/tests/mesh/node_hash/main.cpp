@@ -0,0 +1,98 @@
+#include "hermes2d.h"
+
+// This test checks the vertex and edge node hash tables of the mesh and
+// measures the time of mesh loading, uniform refinement and unrefinement.
+// The initial mesh is the mesh of triangles and quads in square_mixed.mesh
+// refined 'initial' times. After every step, all vertex and edge nodes of
+// the active elements have to be found by their parents, and after
+// unrefining the mesh has to have the same number of nodes as the initial one.
+
+// Checks that the nodes of all active elements can be found in the hash tables.
+bool check_nodes(Mesh* mesh)
+{
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    for (unsigned int i = 0; i < e->nvert; i++)
+    {
+      int j = e->next_vert(i);
+      if (mesh->peek_edge_node(e->vn[i]->id, e->vn[j]->id) != e->en[i] ||
+          mesh->peek_edge_node(e->vn[j]->id, e->vn[i]->id) != e->en[i])
+      {
+        printf("edge node #%d of element #%d not found\n", e->en[i]->id, e->id);
+        return false;
+      }
+
+      Node* v = e->vn[i];
+      if (v->p1 >= 0 && mesh->peek_vertex_node(v->p1, v->p2) != v)
+      {
+        printf("vertex node #%d of element #%d not found\n", v->id, e->id);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    printf("please input as this format: node_hash  initial  levels \n");
+    return ERR_FAILURE;
+  }
+  int initial = atoi(argv[1]), levels = atoi(argv[2]);
+  if (initial < 0 || levels < 0) return ERR_FAILURE;
+
+  Mesh mesh;
+  H2DReader mloader;
+  TimePeriod timer;
+  mloader.load("square_mixed.mesh", &mesh);
+  for (int l = 0; l < initial; l++)
+    mesh.refine_all_elements();
+  timer.tick();
+  printf("initial mesh: %d elements, %d nodes, %g s\n",
+         mesh.get_num_active_elements(), mesh.get_num_nodes(), timer.last());
+
+  int num_nodes = mesh.get_num_nodes();
+  int num_elements = mesh.get_num_active_elements();
+  if (!check_nodes(&mesh)) return ERR_FAILURE;
+
+  for (int l = 0; l < levels; l++)
+  {
+    timer.tick(HERMES_SKIP);
+    mesh.refine_all_elements();
+    timer.tick();
+    printf("refinement:   %d elements, %d nodes, %g s\n",
+           mesh.get_num_active_elements(), mesh.get_num_nodes(), timer.last());
+    if (!check_nodes(&mesh)) return ERR_FAILURE;
+  }
+
+  for (int l = 0; l < levels; l++)
+  {
+    timer.tick(HERMES_SKIP);
+    mesh.unrefine_all_elements();
+    timer.tick();
+    printf("unrefinement: %d elements, %d nodes, %g s\n",
+           mesh.get_num_active_elements(), mesh.get_num_nodes(), timer.last());
+    if (!check_nodes(&mesh)) return ERR_FAILURE;
+  }
+
+  if (mesh.get_num_nodes() != num_nodes || mesh.get_num_active_elements() != num_elements)
+  {
+    printf("Failure!\n");
+    return ERR_FAILURE;
+  }
+
+  // the nodes of the refined mesh are created again in the emptied slots
+  timer.tick(HERMES_SKIP);
+  for (int l = 0; l < levels; l++)
+    mesh.refine_all_elements();
+  timer.tick();
+  printf("re-refinement: %d elements, %d nodes, %g s\n",
+         mesh.get_num_active_elements(), mesh.get_num_nodes(), timer.last());
+  if (!check_nodes(&mesh)) return ERR_FAILURE;
+
+  printf("Success!\n");
+  return ERR_SUCCESS;
+}
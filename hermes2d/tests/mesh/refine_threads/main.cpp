@@ -0,0 +1,102 @@
+#include "hermes2d.h"
+
+// This test makes sure that refining a curved mesh with several threads gives the same
+// mesh as the serial refinement: the same nodes and elements, and the same coefficients
+// of the projected reference mappings of the curved elements.
+
+// refines all active elements of the mesh, the quads in all three ways
+static void refine(Mesh* mesh, int level, int num_threads)
+{
+  Element* e;
+  Hermes::vector<int> ids, refinements;
+  for_all_active_elements(e, mesh)
+  {
+    ids.push_back(e->id);
+    refinements.push_back(e->is_triangle() ? 0 : (level + e->id) % 3);
+  }
+  mesh->refine_elements(ids, refinements, num_threads);
+}
+
+static bool compare(Mesh* serial, Mesh* threaded)
+{
+  if (serial->get_max_node_id() != threaded->get_max_node_id()
+      || serial->get_max_element_id() != threaded->get_max_element_id())
+  {
+    printf("The numbers of nodes or elements differ.\n");
+    return false;
+  }
+
+  for (int i = 0; i < serial->get_max_node_id(); i++)
+  {
+    Node* a = serial->get_node(i);
+    Node* b = threaded->get_node(i);
+    if (a->used != b->used || a->type != b->type)
+    {
+      printf("Node #%d differs.\n", i);
+      return false;
+    }
+    if (a->used && a->type == HERMES_TYPE_VERTEX && (a->x != b->x || a->y != b->y))
+    {
+      printf("Vertex #%d differs.\n", i);
+      return false;
+    }
+  }
+
+  int curved = 0;
+  for (int i = 0; i < serial->get_max_element_id(); i++)
+  {
+    Element* a = serial->get_element(i);
+    Element* b = threaded->get_element(i);
+    if (a->used != b->used || a->active != b->active || a->is_curved() != b->is_curved())
+    {
+      printf("Element #%d differs.\n", i);
+      return false;
+    }
+    if (!a->used || !a->active || !a->is_curved()) continue;
+    if (a->cm->nc != b->cm->nc)
+    {
+      printf("The reference mapping of element #%d differs.\n", i);
+      return false;
+    }
+    for (int j = 0; j < a->cm->nc; j++)
+      if (fabs(a->cm->coeffs[j][0] - b->cm->coeffs[j][0]) > 1e-14
+          || fabs(a->cm->coeffs[j][1] - b->cm->coeffs[j][1]) > 1e-14)
+      {
+        printf("The reference mapping of element #%d differs.\n", i);
+        return false;
+      }
+    curved++;
+  }
+  printf("%d nodes, %d elements, %d active curved elements compared\n",
+         serial->get_max_node_id(), serial->get_max_element_id(), curved);
+  return curved > 0;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    printf("please input as this format: refine_threads meshfile.mesh num_threads \n");
+    return ERR_FAILURE;
+  }
+  int num_threads = atoi(argv[2]);
+
+  Mesh serial, threaded;
+  H2DReader mloader;
+  mloader.load(argv[1], &serial);
+  mloader.load(argv[1], &threaded);
+
+  for (int level = 0; level < 3; level++)
+  {
+    refine(&serial, level, 1);
+    refine(&threaded, level, num_threads);
+    if (!compare(&serial, &threaded))
+    {
+      printf("Failure!\n");
+      return ERR_FAILURE;
+    }
+  }
+
+  printf("Success!\n");
+  return ERR_SUCCESS;
+}
@@ -0,0 +1,133 @@
+#include "hermes2d.h"
+
+using namespace WeakFormsH1;
+
+// This test makes sure that the stage-by-stage solution of diagonally implicit
+// Runge-Kutta methods gives the same results as the solution of the whole
+// system of all stages. The heat equation du/dt = div(grad u) + 1 with zero Dirichlet
+// conditions is solved on a grid of the unit square with a Butcher's table and with the
+// same table with the stages in the reverse order. The reversed table describes the same
+// method, but it is not lower triangular, so rk_time_step() solves it as a fully implicit
+// one. The solutions (and the temporal error functions of embedded methods) after
+// NUM_STEPS time steps have to be the same. The first stage of the ESDIRK method is
+// explicit.
+
+const int P_INIT = 3;
+const int NUM_STEPS = 5;
+const double TIME_STEP = 0.01;
+const double NEWTON_TOL = 1e-10;
+const double TOL = 1e-10;
+
+class CustomWeakFormHeatRK : public WeakForm
+{
+public:
+  CustomWeakFormHeatRK() : WeakForm(1)
+  {
+    add_matrix_form(new DefaultJacobianDiffusion(0, 0, HERMES_ANY, new HermesFunction(-1.0)));
+    add_vector_form(new DefaultResidualDiffusion(0, HERMES_ANY, new HermesFunction(-1.0)));
+    add_vector_form(new DefaultVectorFormVol(0, HERMES_ANY, new HermesFunction(1.0)));
+  }
+};
+
+// Fills 'rev' (of the same size) with the Butcher's table 'bt' with the stages in the
+// reverse order.
+void reverse_stages(ButcherTable* bt, ButcherTable* rev)
+{
+  int s = bt->get_size();
+  for (int i = 0; i < s; i++)
+  {
+    for (int j = 0; j < s; j++)
+      rev->set_A(i, j, bt->get_A(s-1 - i, s-1 - j));
+    rev->set_B(i, bt->get_B(s-1 - i));
+    rev->set_B2(i, bt->get_B2(s-1 - i));
+    rev->set_C(i, bt->get_C(s-1 - i));
+  }
+}
+
+// Performs NUM_STEPS time steps with the Butcher's table 'bt'.
+void solve(DiscreteProblem* dp, ButcherTable* bt, Mesh* mesh, Solution* sln, Solution* error_fn)
+{
+  RungeKutta runge_kutta(dp, bt, SOLVER_UMFPACK);
+  Solution sln_time_prev(mesh, 0.0);
+  double current_time = 0;
+  for (int ts = 0; ts < NUM_STEPS; ts++)
+  {
+    bool jacobian_changed = false;
+    bool verbose = false;
+    bool ok = bt->is_embedded()
+            ? runge_kutta.rk_time_step(current_time, TIME_STEP, &sln_time_prev, sln, error_fn,
+                                       jacobian_changed, verbose, NEWTON_TOL)
+            : runge_kutta.rk_time_step(current_time, TIME_STEP, &sln_time_prev, sln,
+                                       jacobian_changed, verbose, NEWTON_TOL);
+    if (!ok) error("Runge-Kutta time step failed.");
+    current_time += TIME_STEP;
+    sln_time_prev.copy(sln);
+  }
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2)
+  {
+    printf("please input as this format: runge_kutta  table \n");
+    return ERR_FAILURE;
+  }
+  const int num_tables = 3;
+  ButcherTableType tables[num_tables] = { Implicit_SDIRK_2_2, Implicit_ESDIRK_TRBDF2_3_23_embedded,
+                                          Implicit_SDIRK_CASH_3_23_embedded };
+  int table = atoi(argv[1]);
+  if (table < 0 || table >= num_tables) return ERR_FAILURE;
+
+  Hermes2D hermes2d;
+
+  // the unit square with the boundary marker 1 split into 8 x 8 cells
+  Mesh mesh;
+  H2DReader mloader;
+  mloader.load("square_quad.mesh", &mesh);
+  mesh.refine_all_elements();
+  mesh.refine_all_elements();
+
+  DefaultEssentialBCConst bc("1", 0.0);
+  EssentialBCs bcs(&bc);
+  H1Space space(&mesh, &bcs, P_INIT);
+  CustomWeakFormHeatRK wf;
+
+  ButcherTable bt(tables[table]);
+  ButcherTable bt_rev(bt.get_size());
+  reverse_stages(&bt, &bt_rev);
+  if (!bt.is_diagonally_implicit() || bt_rev.is_diagonally_implicit())
+  {
+    printf("Failure!\n");
+    return ERR_FAILURE;
+  }
+
+  // stage by stage
+  DiscreteProblem dp(&wf, &space);
+  Solution sln(&mesh), error_fn(&mesh, 0.0);
+  solve(&dp, &bt, &mesh, &sln, &error_fn);
+
+  // all stages at once
+  DiscreteProblem dp_rev(&wf, &space);
+  Solution sln_rev(&mesh), error_fn_rev(&mesh, 0.0);
+  solve(&dp_rev, &bt_rev, &mesh, &sln_rev, &error_fn_rev);
+
+  double norm = hermes2d.calc_norm(&sln, HERMES_H1_NORM);
+  double diff = hermes2d.calc_abs_error(&sln, &sln_rev, HERMES_H1_NORM);
+  printf("ndof = %d, solution norm = %g, difference = %g\n", space.get_num_dofs(), norm, diff);
+  bool success = (norm > 0 && diff <= TOL * norm);
+  if (bt.is_embedded())
+  {
+    double error_norm = hermes2d.calc_norm(&error_fn, HERMES_H1_NORM);
+    double error_diff = hermes2d.calc_abs_error(&error_fn, &error_fn_rev, HERMES_H1_NORM);
+    printf("temporal error norm = %g, difference = %g\n", error_norm, error_diff);
+    if (error_norm == 0 || error_diff > TOL * norm) success = false;
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return ERR_SUCCESS;
+  }
+  printf("Failure!\n");
+  return ERR_FAILURE;
+}
@@ -0,0 +1,154 @@
+#include "hermes2d.h"
+#include <pthread.h>
+
+// This test makes sure that slaves of one PrecalcShapeset can be used in parallel threads.
+// NUM_THREADS slaves of a fresh master go over the elements of a mesh of triangles and
+// quads (each thread starting at a different element, so that they create the shared
+// reference tables at the same time), and take the values and derivatives of all shape
+// functions and of some constrained ones, on the element and on sub-elements, first with
+// H2D_FN_VAL and then with H2D_FN_DEFAULT (which replaces the shared tables). The values
+// have to be the same as those of a slave of another master used alone, and the slaves
+// must not change the mode of the shapeset and of the quadrature.
+
+const int NUM_THREADS = 4;
+const int ROUNDS = 3;
+const int MAX_ORDER = 6;
+
+// The indices of all shape functions in the given mode and of some constrained ones.
+std::vector<int> get_indices(Shapeset* shapeset, int mode)
+{
+  std::vector<int> indices;
+  for (int i = 0; i <= shapeset->get_max_index(mode); i++)
+    if (shapeset->has_shape(i, mode))
+      indices.push_back(i);
+  for (int edge = 0; edge < 3; edge++)
+    for (int part = 0; part < 2; part++)
+      indices.push_back(shapeset->get_constrained_edge_index(edge, 2 + edge, 0, part));
+  return indices;
+}
+
+// Appends the values of the shape functions 'indices' on the element 'e' (and on some of
+// its sub-elements) taken from 'pss' to 'values'.
+void get_values(PrecalcShapeset* pss, Element* e, std::vector<int>& indices, std::vector<double>& values)
+{
+  int mode = e->get_mode();
+  pss->set_active_element(e);
+  for (int t = 0; t < 3; t++)
+  {
+    pss->reset_transform();
+    if (t > 0) pss->push_transform(t);
+    if (t > 1) pss->push_transform(3);
+    for (unsigned int i = 0; i < indices.size(); i++)
+    {
+      pss->set_active_shape(indices[i]);
+      for (int order = 1; order <= MAX_ORDER; order++)
+      {
+        int np = pss->get_quad_2d()->get_num_points(order, mode);
+        pss->set_quad_order(order, H2D_FN_VAL);
+        values.insert(values.end(), pss->get_fn_values(), pss->get_fn_values() + np);
+        pss->set_quad_order(order, H2D_FN_DEFAULT);
+        values.insert(values.end(), pss->get_fn_values(), pss->get_fn_values() + np);
+        values.insert(values.end(), pss->get_dx_values(), pss->get_dx_values() + np);
+        values.insert(values.end(), pss->get_dy_values(), pss->get_dy_values() + np);
+      }
+    }
+  }
+}
+
+struct Job
+{
+  PrecalcShapeset* pss;
+  std::vector<Element*>* elems;
+  std::vector<int>* indices;   // for each mode
+  int first;
+  std::vector<std::vector<double> > values;   // for each element
+};
+
+void* run_job(void* arg)
+{
+  Job* job = (Job*) arg;
+  int n = job->elems->size();
+  job->values.resize(n);
+  for (int r = 0; r < ROUNDS; r++)
+    for (int k = 0; k < n; k++)
+    {
+      int m = (job->first + k) % n;
+      Element* e = (*job->elems)[m];
+      std::vector<double> values;
+      get_values(job->pss, e, job->indices[e->get_mode()], values);
+      if (r == 0)
+        job->values[m] = values;
+      else if (values != job->values[m])
+        job->values[m].clear();    // marks a difference between the rounds
+    }
+  return NULL;
+}
+
+int main(int argc, char* argv[])
+{
+  Mesh mesh;
+  H2DReader mloader;
+  mloader.load("square_mixed.mesh", &mesh);
+  std::vector<Element*> elems;
+  Element* e;
+  for_all_active_elements(e, &mesh)
+    elems.push_back(e);
+
+  H1Shapeset shapeset;
+  std::vector<int> indices[2] = { get_indices(&shapeset, HERMES_MODE_TRIANGLE),
+                                  get_indices(&shapeset, HERMES_MODE_QUAD) };
+  int other_mode = 1 - elems.back()->get_mode();
+  shapeset.set_mode(other_mode);
+  g_quad_2d_std.set_mode(other_mode);
+
+  // the reference values
+  PrecalcShapeset ref_master(&shapeset);
+  PrecalcShapeset ref_pss(&ref_master);
+  std::vector<std::vector<double> > ref(elems.size());
+  for (unsigned int m = 0; m < elems.size(); m++)
+    get_values(&ref_pss, elems[m], indices[elems[m]->get_mode()], ref[m]);
+  bool success = (shapeset.get_mode() == other_mode && g_quad_2d_std.get_mode() == other_mode);
+  if (!success)
+    printf("A slave has changed the mode of the shapeset or of the quadrature.\n");
+
+  // the slaves in parallel threads
+  PrecalcShapeset master(&shapeset);
+  Job jobs[NUM_THREADS];
+  pthread_t threads[NUM_THREADS];
+  for (int t = 0; t < NUM_THREADS; t++)
+  {
+    jobs[t].pss = new PrecalcShapeset(&master);
+    jobs[t].elems = &elems;
+    jobs[t].indices = indices;
+    jobs[t].first = t * elems.size() / NUM_THREADS;
+  }
+  for (int t = 0; t < NUM_THREADS; t++)
+    if (pthread_create(&threads[t], NULL, run_job, jobs + t) != 0)
+      error("Failed to create a thread.");
+  for (int t = 0; t < NUM_THREADS; t++)
+    pthread_join(threads[t], NULL);
+
+  for (int t = 0; t < NUM_THREADS; t++)
+  {
+    for (unsigned int m = 0; m < elems.size(); m++)
+      if (jobs[t].values[m] != ref[m])
+      {
+        printf("Thread %d: the values on element #%d differ.\n", t, elems[m]->id);
+        success = false;
+      }
+    delete jobs[t].pss;
+  }
+  if (shapeset.get_mode() != other_mode || g_quad_2d_std.get_mode() != other_mode)
+  {
+    printf("A slave has changed the mode of the shapeset or of the quadrature.\n");
+    success = false;
+  }
+
+  if (success)
+  {
+    printf("Success!\n");
+    return ERR_SUCCESS;
+  }
+  printf("Failure!\n");
+  return ERR_FAILURE;
+}
@@ -0,0 +1,125 @@
+#include "hermes2d.h"
+
+using namespace WeakFormsH1;
+
+// This test checks the static condensation of bubble DOFs. An advection-diffusion-reaction
+// problem with a nonzero Dirichlet condition is solved on the mesh of triangles and quads
+// in square_mixed.mesh (with one element refined to get hanging nodes) refined 'levels' times
+// with elements of order p, once with the full system and once with the condensed one,
+// whose solution is expanded to all DOFs. Both systems are solved by a dense LU
+// factorization, and the two coefficient vectors have to be the same.
+
+class CustomWeakForm : public WeakForm
+{
+public:
+  CustomWeakForm() : WeakForm(1)
+  {
+    add_matrix_form(new DefaultJacobianDiffusion(0, 0));
+    add_matrix_form(new DefaultJacobianAdvection(0, 0, HERMES_ANY, new HermesFunction(1.0),
+                                                 new HermesFunction(0.5)));
+    add_matrix_form(new DefaultMatrixFormVol(0, 0, HERMES_ANY, new HermesFunction(2.0)));
+    add_vector_form(new DefaultVectorFormVol(0, HERMES_ANY, new HermesFunction(1.0)));
+  }
+};
+
+// Assembles the system and solves it by a dense LU factorization into 'sln'.
+int solve(DiscreteProblem* dp, std::vector<double>& sln, std::vector<double>& rhs_values)
+{
+  UMFPackMatrix mat;
+  UMFPackVector rhs;
+  dp->assemble(&mat, &rhs);
+
+  int n = mat.get_size();
+  double** a = new_matrix<double>(n, n);
+  for (int i = 0; i < n; i++)
+    for (int j = 0; j < n; j++)
+      a[i][j] = mat.get(i, j);
+
+  sln.resize(n);
+  rhs_values.resize(n);
+  rhs.extract(&rhs_values[0]);
+  sln = rhs_values;
+
+  int* idx = new int[n];
+  double d;
+  ludcmp(a, n, idx, &d);
+  lubksb(a, n, idx, &sln[0]);
+  delete [] idx;
+  delete [] a;
+  return n;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    printf("please input as this format: static_condensation  levels  p \n");
+    return ERR_FAILURE;
+  }
+  int levels = atoi(argv[1]), p = atoi(argv[2]);
+  if (levels < 0 || p < 1) return ERR_FAILURE;
+
+  Mesh mesh;
+  H2DReader mloader;
+  mloader.load("square_mixed.mesh", &mesh);
+  mesh.refine_element_id(0);
+  for (int l = 0; l < levels; l++)
+    mesh.refine_all_elements();
+
+  DefaultEssentialBCConst bc("1", 1.0);
+  EssentialBCs bcs(&bc);
+  H1Space space(&mesh, &bcs, p);
+  CustomWeakForm wf;
+
+  // full system
+  DiscreteProblem dp_full(&wf, &space);
+  std::vector<double> sln_full, rhs_full;
+  TimePeriod timer;
+  int ndof = solve(&dp_full, sln_full, rhs_full);
+  timer.tick();
+  printf("full system:      %d DOFs, %g s\n", ndof, timer.last());
+
+  // condensed system
+  DiscreteProblem dp(&wf, &space);
+  dp.set_static_condensation();
+  std::vector<double> sln_skel, rhs_skel;
+  timer.tick(HERMES_SKIP);
+  int nskel = solve(&dp, sln_skel, rhs_skel);
+  std::vector<double> sln(ndof);
+  dp.expand_condensed_solution(&sln_skel[0], &sln[0], 1.0, 4);
+  timer.tick();
+  printf("condensed system: %d DOFs, %g s\n", nskel, timer.last());
+  if (nskel != dp.get_num_skeleton_dofs() || (p > 2 && nskel >= ndof))
+  {
+    printf("Failure!\n");
+    return ERR_FAILURE;
+  }
+
+  // the right-hand side alone is condensed with the stored element matrices
+  // (the matrix structure is reused, so the vector has to be allocated)
+  UMFPackVector rhs;
+  rhs.alloc(nskel);
+  dp.assemble(NULL, &rhs);
+  for (int i = 0; i < nskel; i++)
+    if (fabs(rhs.get(i) - rhs_skel[i]) > 1e-12 * (1.0 + fabs(rhs_skel[i])))
+    {
+      printf("right-hand side #%d differs: %g %g\n", i, rhs.get(i), rhs_skel[i]);
+      return ERR_FAILURE;
+    }
+
+  double max = 0.0, diff = 0.0;
+  for (int i = 0; i < ndof; i++)
+  {
+    max = std::max(max, fabs(sln_full[i]));
+    diff = std::max(diff, fabs(sln[i] - sln_full[i]));
+  }
+  printf("max. difference of the solutions: %g\n", diff);
+  if (diff > 1e-10 * max)
+  {
+    printf("Failure!\n");
+    return ERR_FAILURE;
+  }
+
+  printf("Success!\n");
+  return ERR_SUCCESS;
+}
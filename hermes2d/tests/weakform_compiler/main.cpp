@@ -0,0 +1,373 @@
+#include "hermes2d.h"
+
+// This test checks the textual weak forms compiled by WeakFormExpression. The modes are
+//   parse    - the precedence of the unary minus and the associativity of the binary
+//              operators: each linear form is evaluated at a number of points (more than one
+//              block of the bytecode) with a nonconstant test function v, once with the
+//              operands a, b, c given as external functions (evaluated by the bytecode) and
+//              once as parameters (folded when parsing), and the result is compared with the
+//              same expression evaluated in C++; bilinear forms with derivatives and names
+//              with underscores are checked in the same way,
+//   ord      - the integration orders returned by ord() are compared with the orders of the
+//              same expressions evaluated in C++ on Ord,
+//   assemble - a system assembled by DiscreteProblem from CompiledMatrixFormVol and
+//              CompiledVectorFormVol (with an external function and parameters) is compared
+//              with the one assembled from the same forms written in C++.
+
+const int n = 100;
+
+struct TestCase
+{
+  const char* text;
+  double (*fn)(double x, double y, double a, double b, double c);
+};
+
+static double f1(double x, double y, double a, double b, double c) { return -x*x; }
+static double f2(double x, double y, double a, double b, double c) { return a - b - c; }
+static double f3(double x, double y, double a, double b, double c) { return a / b / c; }
+static double f4(double x, double y, double a, double b, double c) { return -(a*a) * -(b*b*b); }
+static double f5(double x, double y, double a, double b, double c) { return a * pow(b, -2.0) - -c; }
+static double f6(double x, double y, double a, double b, double c) { return pow(a*a, 3.0) - (a - b)/c/x + y; }
+static double f7(double x, double y, double a, double b, double c) { return - - x - y*y; }
+
+static TestCase cases[] = {
+  { "-x^2", f1 },
+  { "a-b-c", f2 },
+  { "a/b/c", f3 },
+  { "-a^2 * -b^3", f4 },
+  { "a*b^-2 - -c", f5 },
+  { "a^2^3 - (a-b)/c/x + y", f6 },
+  { "--x - y^2", f7 }
+};
+
+// Bilinear forms, 'f_1' is an external function and 'Re_num' a parameter (the value RE).
+const double RE = 2.5;
+
+struct BilinearTestCase
+{
+  const char* text;
+  double (*fn)(double x, double y, double nx, double ny, double u, double u_x, double u_y,
+               double v, double v_x, double v_y, double f, double f_x, double f_y);
+};
+
+static double g1(double x, double y, double nx, double ny, double u, double u_x, double u_y,
+                 double v, double v_x, double v_y, double f, double f_x, double f_y)
+{ return (u_x*v_x + u_y*v_y)/RE + f*u*v; }
+static double g2(double x, double y, double nx, double ny, double u, double u_x, double u_y,
+                 double v, double v_x, double v_y, double f, double f_x, double f_y)
+{ return u_x*v - u*v_y + f_x*u*v - f_y*u_y*v_x; }
+static double g3(double x, double y, double nx, double ny, double u, double u_x, double u_y,
+                 double v, double v_x, double v_y, double f, double f_x, double f_y)
+{ return nx*u*v_x - ny*u_y*v + exp(x)*u*v; }
+
+static BilinearTestCase bilinear_cases[] = {
+  { "vol u, v: (u_x*v_x + u_y*v_y)/Re_num + f_1*u*v", g1 },
+  { "vol u, v: dx(u)*v - u*dy(v) + f_1_x*u*v - dy(f_1)*u_y*v_x", g2 },
+  { "surf u_0, v_0: nx*u_0*v_0_x - ny*u_0_y*v_0 + exp(x)*u_0*v_0", g3 }
+};
+
+static int parse()
+{
+  // points, weights, the basis and the test function
+  double x[n], y[n], nx[n], ny[n], wt[n], fn[6][n];
+  scalar val[3][n], dx[n], dy[n];
+  for (int i = 0; i < n; i++)
+  {
+    x[i] = 0.5 + 0.01 * i;
+    y[i] = 1.0 - 0.007 * i;
+    nx[i] = cos(0.03 * i);
+    ny[i] = sin(0.03 * i);
+    wt[i] = 0.2 + 0.005 * i;
+    fn[0][i] = 1.0 - 0.004 * i;
+    fn[1][i] = 0.3 + 0.002 * i;
+    fn[2][i] = -0.7 + 0.01 * i;
+    fn[3][i] = 0.5 + 0.006 * i;
+    fn[4][i] = 1.2 - 0.003 * i;
+    fn[5][i] = -0.1 - 0.002 * i;
+    val[0][i] = 1.5 + 0.02 * i;
+    val[1][i] = 0.8 - 0.003 * i;
+    val[2][i] = 2.0 + 0.01 * i;
+    dx[i] = 0.4 - 0.005 * i;
+    dy[i] = -0.9 + 0.012 * i;
+  }
+  Geom<double> e;
+  e.x = x;
+  e.y = y;
+  e.nx = nx;
+  e.ny = ny;
+  Func<double> u(n, 1), v(n, 1);
+  u.val = fn[0];
+  u.dx = fn[1];
+  u.dy = fn[2];
+  v.val = fn[3];
+  v.dx = fn[4];
+  v.dy = fn[5];
+
+  Func<scalar> a(n, 1), b(n, 1), c(n, 1);
+  a.val = val[0];
+  a.dx = dx;
+  a.dy = dy;
+  b.val = val[1];
+  c.val = val[2];
+  Func<scalar>* fns[3] = { &a, &b, &c };
+  ExtData<scalar> ext;
+  ext.nf = 3;
+  ext.fn = fns;
+
+  Hermes::vector<std::string> names("a", "b", "c");
+  for (unsigned int k = 0; k < sizeof(cases) / sizeof(TestCase); k++)
+  {
+    std::string text = std::string("vol v: (") + cases[k].text + ") * v";
+
+    // a, b, c as external functions
+    WeakFormExpression by_ext(text, names);
+    double expected = 0.0;
+    for (int i = 0; i < n; i++)
+      expected += wt[i] * cases[k].fn(x[i], y[i], std::real(val[0][i]), std::real(val[1][i]), std::real(val[2][i])) * v.val[i];
+    double result = std::real(by_ext.value(n, wt, NULL, &v, &e, &ext));
+    printf("%-24s %.15g %.15g\n", cases[k].text, result, expected);
+    if (fabs(result - expected) > 1e-12 * (1.0 + fabs(expected)))
+      return ERR_FAILURE;
+
+    // a, b, c as parameters
+    Hermes::vector<scalar> param(val[0][0], val[1][0], val[2][0]);
+    WeakFormExpression by_param(text, Hermes::vector<std::string>(), names, param);
+    expected = 0.0;
+    for (int i = 0; i < n; i++)
+      expected += wt[i] * cases[k].fn(x[i], y[i], std::real(val[0][0]), std::real(val[1][0]), std::real(val[2][0])) * v.val[i];
+    result = std::real(by_param.value(n, wt, NULL, &v, &e, NULL));
+    if (fabs(result - expected) > 1e-12 * (1.0 + fabs(expected)))
+    {
+      printf("%s with parameters: %.15g %.15g\n", cases[k].text, result, expected);
+      return ERR_FAILURE;
+    }
+  }
+
+  // bilinear forms, a is the external function f_1
+  ext.nf = 1;
+  for (unsigned int k = 0; k < sizeof(bilinear_cases) / sizeof(BilinearTestCase); k++)
+  {
+    WeakFormExpression expr(bilinear_cases[k].text, Hermes::vector<std::string>("f_1"),
+                            Hermes::vector<std::string>("Re_num"), Hermes::vector<scalar>(RE));
+    double expected = 0.0;
+    for (int i = 0; i < n; i++)
+      expected += wt[i] * bilinear_cases[k].fn(x[i], y[i], nx[i], ny[i], u.val[i], u.dx[i], u.dy[i],
+                                               v.val[i], v.dx[i], v.dy[i], std::real(val[0][i]),
+                                               std::real(dx[i]), std::real(dy[i]));
+    double result = std::real(expr.value(n, wt, &u, &v, &e, &ext));
+    printf("%-60s %.15g %.15g\n", bilinear_cases[k].text, result, expected);
+    if (fabs(result - expected) > 1e-12 * (1.0 + fabs(expected)))
+      return ERR_FAILURE;
+  }
+
+  return ERR_SUCCESS;
+}
+
+// Orders of the forms, 'w' is an external function.
+struct OrdTestCase
+{
+  const char* text;
+  Ord (*fn)(Func<Ord>* u, Func<Ord>* v, Func<Ord>* w, Geom<Ord>* e);
+};
+
+static Ord o1(Func<Ord>* u, Func<Ord>* v, Func<Ord>* w, Geom<Ord>* e)
+{ return u->dx[0]*v->dx[0] + u->dy[0]*v->dy[0]; }
+static Ord o2(Func<Ord>* u, Func<Ord>* v, Func<Ord>* w, Geom<Ord>* e)
+{ return e->x[0]*e->x[0]*u->val[0]*v->val[0] + w->val[0]*u->val[0]*v->val[0]; }
+static Ord o3(Func<Ord>* u, Func<Ord>* v, Func<Ord>* w, Geom<Ord>* e)
+{ return sqrt(w->val[0])*v->val[0] / (e->x[0]*e->y[0] + 1.0); }
+static Ord o4(Func<Ord>* u, Func<Ord>* v, Func<Ord>* w, Geom<Ord>* e)
+{ return exp(e->x[0])*v->dx[0] + pow(w->dy[0], 3.0)*v->val[0]; }
+static Ord o5(Func<Ord>* u, Func<Ord>* v, Func<Ord>* w, Geom<Ord>* e)
+{ return (e->nx[0]*u->dx[0] + e->ny[0]*u->dy[0])*v->val[0] + sin(e->x[0])*u->val[0]*v->val[0]; }
+static Ord o6(Func<Ord>* u, Func<Ord>* v, Func<Ord>* w, Geom<Ord>* e)
+{ return v->val[0] * 5.0; }
+
+static OrdTestCase ord_cases[] = {
+  { "vol u, v: u_x*v_x + u_y*v_y", o1 },
+  { "vol u, v: x^2*u*v + w*u*v", o2 },
+  { "vol v: sqrt(w)*v/(1 + x*y)", o3 },
+  { "vol v: exp(x)*v_x + w_y^3*v", o4 },
+  { "surf u, v: (nx*u_x + ny*u_y)*v + sin(x)*u*v", o5 },
+  { "surf v: 5*v", o6 }
+};
+
+static int ord()
+{
+  // the derivatives have lower orders than the values
+  Ord u_val(3), u_der(2), v_val(2), v_der(1), w_val(4), w_der(3);
+  Func<Ord> u(1, 1), v(1, 1), w(1, 1);
+  u.val = &u_val;
+  u.dx = u.dy = &u_der;
+  v.val = &v_val;
+  v.dx = v.dy = &v_der;
+  w.val = &w_val;
+  w.dx = w.dy = &w_der;
+  Func<Ord>* fns[1] = { &w };
+  ExtData<Ord> ext;
+  ext.nf = 1;
+  ext.fn = fns;
+  Geom<Ord>* e = init_geom_ord();
+
+  int result = ERR_SUCCESS;
+  for (unsigned int k = 0; k < sizeof(ord_cases) / sizeof(OrdTestCase); k++)
+  {
+    WeakFormExpression expr(ord_cases[k].text, Hermes::vector<std::string>("w"));
+    int order = expr.ord(expr.is_bilinear() ? &u : NULL, &v, e, &ext).get_order();
+    int expected = ord_cases[k].fn(&u, &v, &w, e).get_order();
+    printf("%-48s %d %d\n", ord_cases[k].text, order, expected);
+    if (order != expected)
+      result = ERR_FAILURE;
+  }
+  delete e;
+  return result;
+}
+
+// The forms of the 'assemble' mode written in C++, w is the external function.
+const double RE_NUM = 2.0, SIGMA = 3.0;
+
+class CustomMatrixFormVol : public WeakForm::MatrixFormVol
+{
+public:
+  CustomMatrixFormVol(MeshFunction* w) : WeakForm::MatrixFormVol(0, 0)
+  {
+    ext.push_back(w);
+  }
+
+  template<typename Real, typename Scalar>
+  Scalar matrix_form(int n, double *wt, Func<Real> *u, Func<Real> *v, Geom<Real> *e,
+                     ExtData<Scalar> *ext) const
+  {
+    Func<Scalar>* w = ext->fn[0];
+    Scalar result = 0;
+    for (int i = 0; i < n; i++)
+      result += wt[i] * ((u->dx[i]*v->dx[i] + u->dy[i]*v->dy[i]) / RE_NUM
+                         + SIGMA * e->x[i] * u->val[i] * v->val[i] + w->dx[i] * u->val[i] * v->dy[i]);
+    return result;
+  }
+
+  virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *u, Func<double> *v,
+                       Geom<double> *e, ExtData<scalar> *ext) const
+  {
+    return matrix_form<double, scalar>(n, wt, u, v, e, ext);
+  }
+
+  virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+                  Geom<Ord> *e, ExtData<Ord> *ext) const
+  {
+    return matrix_form<Ord, Ord>(n, wt, u, v, e, ext);
+  }
+};
+
+class CustomVectorFormVol : public WeakForm::VectorFormVol
+{
+public:
+  CustomVectorFormVol(MeshFunction* w) : WeakForm::VectorFormVol(0)
+  {
+    ext.push_back(w);
+  }
+
+  template<typename Real, typename Scalar>
+  Scalar vector_form(int n, double *wt, Func<Real> *v, Geom<Real> *e, ExtData<Scalar> *ext) const
+  {
+    Func<Scalar>* w = ext->fn[0];
+    Scalar result = 0;
+    for (int i = 0; i < n; i++)
+      result += wt[i] * (w->val[i] * w->val[i] * v->val[i] + exp(e->y[i]) * v->dx[i] + SIGMA * v->val[i]);
+    return result;
+  }
+
+  virtual scalar value(int n, double *wt, Func<scalar> *u_ext[], Func<double> *v,
+                       Geom<double> *e, ExtData<scalar> *ext) const
+  {
+    return vector_form<double, scalar>(n, wt, v, e, ext);
+  }
+
+  virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+                  Geom<Ord> *e, ExtData<Ord> *ext) const
+  {
+    return vector_form<Ord, Ord>(n, wt, v, e, ext);
+  }
+};
+
+// Assembles the system of 'wf' into 'values': the matrix entries (row by row) and the vector.
+static void assemble(WeakForm* wf, Space* space, std::vector<scalar>& values)
+{
+  DiscreteProblem dp(wf, space);
+  UMFPackMatrix mat;
+  UMFPackVector rhs;
+  dp.assemble(&mat, &rhs);
+
+  int ndof = space->get_num_dofs();
+  values.clear();
+  for (int i = 0; i < ndof; i++)
+    for (int j = 0; j < ndof; j++)
+      values.push_back(mat.get(i, j));
+  for (int i = 0; i < ndof; i++)
+    values.push_back(rhs.get(i));
+}
+
+static int assemble()
+{
+  Mesh mesh;
+  H2DReader mloader;
+  mloader.load("square_mixed.mesh", &mesh);
+  mesh.refine_all_elements();
+  H1Space space(&mesh, 3);
+
+  // the external function
+  int ndof = space.get_num_dofs();
+  scalar* coeff_vec = new scalar[ndof];
+  for (int i = 0; i < ndof; i++)
+    coeff_vec[i] = sin((double) i);
+  Solution w;
+  Solution::vector_to_solution(coeff_vec, &space, &w);
+  delete [] coeff_vec;
+
+  WeakForm compiled(1);
+  compiled.add_matrix_form(new CompiledMatrixFormVol(0, 0,
+    "vol u, v: (u_x*v_x + u_y*v_y)/Re_num + sigma_1*x*u*v + w_x*u*v_y", HERMES_ANY, HERMES_NONSYM,
+    Hermes::vector<MeshFunction*>(&w), Hermes::vector<std::string>("w"),
+    Hermes::vector<scalar>(RE_NUM, SIGMA), Hermes::vector<std::string>("Re_num", "sigma_1")));
+  compiled.add_vector_form(new CompiledVectorFormVol(0, "vol v: w^2*v + exp(y)*v_x + sigma_1*v",
+    HERMES_ANY, Hermes::vector<MeshFunction*>(&w), Hermes::vector<std::string>("w"),
+    Hermes::vector<scalar>(SIGMA), Hermes::vector<std::string>("sigma_1")));
+
+  WeakForm hand_written(1);
+  hand_written.add_matrix_form(new CustomMatrixFormVol(&w));
+  hand_written.add_vector_form(new CustomVectorFormVol(&w));
+
+  std::vector<scalar> a, b;
+  assemble(&compiled, &space, a);
+  assemble(&hand_written, &space, b);
+
+  double max_value = 0.0, max_diff = 0.0;
+  for (unsigned int i = 0; i < a.size(); i++)
+  {
+    max_value = std::max(max_value, std::abs(b[i]));
+    max_diff = std::max(max_diff, std::abs(a[i] - b[i]));
+  }
+  printf("compiled and hand-written forms: max. value %g, max. difference %g\n", max_value, max_diff);
+  return (max_value > 0.0 && max_diff <= 1e-12 * max_value) ? ERR_SUCCESS : ERR_FAILURE;
+}
+
+int main(int argc, char* argv[])
+{
+  if (argc < 2) error("Usage: test-weakform_compiler parse|ord|assemble");
+
+  int result;
+  if (strcmp(argv[1], "parse") == 0)
+    result = parse();
+  else if (strcmp(argv[1], "ord") == 0)
+    result = ord();
+  else if (strcmp(argv[1], "assemble") == 0)
+    result = assemble();
+  else
+    error("Unknown mode '%s'.", argv[1]);
+
+  if (result == ERR_SUCCESS)
+    printf("Success!\n");
+  else
+    printf("Failure!\n");
+  return result;
+}
@@ -7,7 +7,6 @@ using Teuchos::rcp;
 using Hermes::EigenSolver;
 
 //  This example solves a simple eigenproblem in a square. 
-//  Python and Pysparse must be installed. 
 //
 //  PDE: -Laplace u + (x*x + y*y)u = lambda_k u,
 //  where lambda_0, lambda_1, ... are the eigenvalues.
@@ -21,10 +20,10 @@ using Hermes::EigenSolver;
 const int NUMBER_OF_EIGENVALUES = 50;             // Desired number of eigenvalues.
 const int P_INIT = 4;                             // Uniform polynomial degree of mesh elements.
 const int INIT_REF_NUM = 3;                       // Number of initial mesh refinements.
-const double TARGET_VALUE = 2.0;                  // PySparse parameter: Eigenvalues in the vicinity of 
+const double TARGET_VALUE = 2.0;                  // Eigensolver parameter: Eigenvalues in the vicinity of 
                                                   // this number will be computed. 
-const double TOL = 1e-10;                         // Pysparse parameter: Error tolerance.
-const int MAX_ITER = 1000;                        // PySparse parameter: Maximum number of iterations.
+const double TOL = 1e-10;                         // Eigensolver parameter: Error tolerance.
+const int MAX_ITER = 1000;                        // Eigensolver parameter: Maximum number of iterations.
 
 // Weak forms.
 #include "definitions.cpp"
@@ -65,9 +64,9 @@ int main(int argc, char* argv[])
   dp_right.assemble(matrix_right.get());
 
   EigenSolver es(matrix_left, matrix_right);
-  info("Calling Pysparse...");
+  info("Calling the eigensolver...");
   es.solve(NUMBER_OF_EIGENVALUES, TARGET_VALUE, TOL, MAX_ITER);
-  info("Pysparse finished.");
+  info("Eigensolver finished.");
   es.print_eigenvalues();
 
   // Initializing solution vector, solution and ScalarView.
@@ -7,9 +7,9 @@
 int NUMBER_OF_EIGENVALUES = 1;                    // Desired number of eigenvalues.
 int P_INIT = 4;                                   // Uniform polynomial degree of mesh elements.
 const int INIT_REF_NUM = 0;                       // Number of initial mesh refinements.
-double TARGET_VALUE = 2.0;                        // PySparse parameter: Eigenvalues in the vicinity of this number will be computed. 
-double TOL = 1e-10;                               // Pysparse parameter: Error tolerance.
-int MAX_ITER = 1000;                              // PySparse parameter: Maximum number of iterations.
+double TARGET_VALUE = 2.0;                        // Eigensolver parameter: Eigenvalues in the vicinity of this number will be computed. 
+double TOL = 1e-10;                               // Eigensolver parameter: Error tolerance.
+int MAX_ITER = 1000;                              // Eigensolver parameter: Maximum number of iterations.
 
 using Teuchos::RCP;
 using Teuchos::rcp;
@@ -58,9 +58,9 @@ int main(int argc, char* argv[])
   dp_right.assemble(matrix_right.get());
 
   EigenSolver es(matrix_left, matrix_right);
-  info("Calling Pysparse...");
+  info("Calling the eigensolver...");
   es.solve(NUMBER_OF_EIGENVALUES, TARGET_VALUE, TOL, MAX_ITER);
-  info("Pysparse finished.");
+  info("Eigensolver finished.");
   es.print_eigenvalues();
 
   // Initializing solution vector, solution and ScalarView.
@@ -17,8 +17,8 @@ using Hermes::EigenSolver;
 int NUMBER_OF_EIGENVALUES = 1;
 //const int INIT_REF_NUM = 0;                       // Number of initial mesh refinements.
 //const int REF_ORIGIN = 5;
-double TOL = 1e-10;                               // Pysparse parameter: Error tolerance.
-int MAX_ITER = 1000;                              // PySparse parameter: Maximum number of iterations.
+double TOL = 1e-10;                               // Eigensolver parameter: Error tolerance.
+int MAX_ITER = 1000;                              // Eigensolver parameter: Maximum number of iterations.
 MatrixSolverType matrix_solver = SOLVER_UMFPACK;  
 
 // Boundary condition types.
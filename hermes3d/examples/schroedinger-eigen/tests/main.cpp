@@ -18,9 +18,9 @@ int P_INIT_X = 4;                                 // Uniform polynomial degree o
 int P_INIT_Y = 4;                                 // Uniform polynomial degree of mesh elements.
 int P_INIT_Z = 4;                                 // Uniform polynomial degree of mesh elements.
 const int INIT_REF_NUM = 3;                       // Number of initial mesh refinements.
-double TARGET_VALUE = 3.0;                        // PySparse parameter: Eigenvalues in the vicinity of this number will be computed. 
-double TOL = 1e-3;                               // Pysparse parameter: Error tolerance.
-int MAX_ITER = 1000;                              // PySparse parameter: Maximum number of iterations.
+double TARGET_VALUE = 3.0;                        // Eigensolver parameter: Eigenvalues in the vicinity of this number will be computed. 
+double TOL = 1e-3;                               // Eigensolver parameter: Error tolerance.
+int MAX_ITER = 1000;                              // Eigensolver parameter: Maximum number of iterations.
 MatrixSolverType matrix_solver = SOLVER_UMFPACK;  // Possibilities: SOLVER_AMESOS, SOLVER_AZTECOO, SOLVER_MUMPS,
                                                   // SOLVER_PETSC, SOLVER_SUPERLU, SOLVER_UMFPACK.
 
@@ -98,7 +98,7 @@ int main(int argc, char* argv[])
   cpu_time.tick();
   info("Total running time for initializing EigenSolver : %g s.", cpu_time.accumulated());
 
-  // Calling Python eigensolver. Solution will be written to "eivecs.dat".
+  // Calling the eigensolver.
   cpu_time.reset();
   info("Using eigensolver...");
   es.solve(NUMBER_OF_EIGENVALUES, TARGET_VALUE, TOL, MAX_ITER);
@@ -109,9 +109,9 @@ int main(int argc, char* argv[])
   double* coeff_vec;
   Solution sln(space.get_mesh());
 
-  // Reading solution vectors from file and visualizing.
+  // Reading solution vectors from the eigensolver and visualizing.
   int neig = es.get_n_eigs();
-  if (neig != NUMBER_OF_EIGENVALUES) error("Mismatched number of eigenvectors in the eigensolver output file.");  
+  if (neig != NUMBER_OF_EIGENVALUES) error("Mismatched number of eigenvectors in the eigensolver.");  
   for (int ieig = 0; ieig < neig; ieig++) {
     int n;
     es.get_eigenvector(ieig, &coeff_vec, &n);
@@ -29,6 +29,9 @@
 #include "h1proj.h"
 #include "hcurlproj.h"
 #include "../../../hermes_common/matrix.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //#define DEBUG_PRINT
 
@@ -139,7 +142,7 @@ void Adapt::set_error_form(int i, int j, biform_val_t bi_form, biform_ord_t bi_o
 }
 
 double Adapt::get_projection_error(Element *e, int split, int son, const Ord3 &order, Solution *rsln,
-                                     Shapeset *ss)
+                                     Shapeset *ss, ProjErrCache &proj_err)
 {
 	_F_
 	ProjKey key(split, son, order);
@@ -348,6 +351,7 @@ void Adapt::get_optimal_refinement(Mesh *mesh, Element *e, const Ord3 &order, So
 		}
 	};
 	Cand cand[MAX_CAND];
+	ProjErrCache proj_err;
 
 #define MAKE_P_CAND(q) { \
     assert(n < MAX_CAND);   \
@@ -526,48 +530,48 @@ void Adapt::get_optimal_refinement(Mesh *mesh, Element *e, const Ord3 &order, So
 		c->error = 0.0;
 		switch (c->split) {
 			case H3D_REFT_HEX_NONE:
-				c->error += get_projection_error(e, c->split, -1, c->p[0], rsln, ss);
+				c->error += get_projection_error(e, c->split, -1, c->p[0], rsln, ss, proj_err);
 				break;
 
 			case H3D_H3D_H3D_REFT_HEX_XYZ:
 				for (int j = 0; j < 8; j++)
-					c->error += get_projection_error(e, c->split, j, c->p[j], rsln, ss);
+					c->error += get_projection_error(e, c->split, j, c->p[j], rsln, ss, proj_err);
 				break;
 
 			case H3D_REFT_HEX_X:
-				c->error += get_projection_error(e, c->split, 20, c->p[0], rsln, ss);
-				c->error += get_projection_error(e, c->split, 21, c->p[1], rsln, ss);
+				c->error += get_projection_error(e, c->split, 20, c->p[0], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 21, c->p[1], rsln, ss, proj_err);
 				break;
 
 			case H3D_REFT_HEX_Y:
-				c->error += get_projection_error(e, c->split, 22, c->p[0], rsln, ss);
-				c->error += get_projection_error(e, c->split, 23, c->p[1], rsln, ss);
+				c->error += get_projection_error(e, c->split, 22, c->p[0], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 23, c->p[1], rsln, ss, proj_err);
 				break;
 
 			case H3D_REFT_HEX_Z:
-				c->error += get_projection_error(e, c->split, 24, c->p[0], rsln, ss);
-				c->error += get_projection_error(e, c->split, 25, c->p[1], rsln, ss);
+				c->error += get_projection_error(e, c->split, 24, c->p[0], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 25, c->p[1], rsln, ss, proj_err);
 				break;
 
 			case H3D_H3D_REFT_HEX_XY:
-				c->error += get_projection_error(e, c->split,  8, c->p[0], rsln, ss);
-				c->error += get_projection_error(e, c->split,  9, c->p[1], rsln, ss);
-				c->error += get_projection_error(e, c->split, 10, c->p[2], rsln, ss);
-				c->error += get_projection_error(e, c->split, 11, c->p[3], rsln, ss);
+				c->error += get_projection_error(e, c->split,  8, c->p[0], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split,  9, c->p[1], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 10, c->p[2], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 11, c->p[3], rsln, ss, proj_err);
 				break;
 
 			case H3D_H3D_REFT_HEX_XZ:
-				c->error += get_projection_error(e, c->split, 12, c->p[0], rsln, ss);
-				c->error += get_projection_error(e, c->split, 13, c->p[1], rsln, ss);
-				c->error += get_projection_error(e, c->split, 14, c->p[2], rsln, ss);
-				c->error += get_projection_error(e, c->split, 15, c->p[3], rsln, ss);
+				c->error += get_projection_error(e, c->split, 12, c->p[0], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 13, c->p[1], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 14, c->p[2], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 15, c->p[3], rsln, ss, proj_err);
 				break;
 
 			case H3D_H3D_REFT_HEX_YZ:
-				c->error += get_projection_error(e, c->split, 16, c->p[0], rsln, ss);
-				c->error += get_projection_error(e, c->split, 17, c->p[1], rsln, ss);
-				c->error += get_projection_error(e, c->split, 18, c->p[2], rsln, ss);
-				c->error += get_projection_error(e, c->split, 19, c->p[3], rsln, ss);
+				c->error += get_projection_error(e, c->split, 16, c->p[0], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 17, c->p[1], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 18, c->p[2], rsln, ss, proj_err);
+				c->error += get_projection_error(e, c->split, 19, c->p[3], rsln, ss, proj_err);
 				break;
 
 			default:
@@ -625,6 +629,43 @@ void Adapt::get_optimal_refinement(Mesh *mesh, Element *e, const Ord3 &order, So
 
 //// adapt /////////////////////////////////////////////////////////////////////////////////////////
 
+// refinement selected for one element (every element of the parallel search has its own slot)
+struct ElementReft {
+	int split;
+	Ord3 p[Hex::NUM_SONS];			// polynomial order of sons
+	int aniso_refts;				// anisotropic refinements allowed when the refinement was selected
+};
+
+static const int aniso_reft[] = {
+	H3D_REFT_HEX_X, H3D_REFT_HEX_Y, H3D_REFT_HEX_Z,
+	H3D_H3D_REFT_HEX_XY, H3D_H3D_REFT_HEX_YZ, H3D_H3D_REFT_HEX_XZ
+};
+
+// the anisotropic candidates of get_optimal_refinement() depend on these
+static int get_aniso_refts(Mesh *mesh, Element *e)
+{
+	int refts = 0;
+	for (unsigned int i = 0; i < countof(aniso_reft); i++)
+		if (mesh->can_refine_element(e->id, aniso_reft[i])) refts |= 1 << i;
+	return refts;
+}
+
+// the index tables of the shapesets are filled on demand, which is not thread-safe, so the ones
+// used by the projections are filled before the parallel search
+static void preload_h1_indices(Shapeset *ss)
+{
+	for (int o = 2; o <= H3D_MAX_ELEMENT_ORDER; o++)
+		for (int iedge = 0; iedge < Hex::NUM_EDGES; iedge++)
+			ss->get_edge_indices(iedge, 0, o);
+	for (int ox = 2; ox <= H3D_MAX_ELEMENT_ORDER; ox++)
+		for (int oy = 2; oy <= H3D_MAX_ELEMENT_ORDER; oy++) {
+			for (int iface = 0; iface < Hex::NUM_FACES; iface++)
+				ss->get_face_indices(iface, 0, Ord2(ox, oy));
+			for (int oz = 2; oz <= H3D_MAX_ELEMENT_ORDER; oz++)
+				ss->get_bubble_indices(Ord3(ox, oy, oz));
+		}
+}
+
 void Adapt::adapt(double thr)
 {
 	_F_
@@ -641,6 +682,7 @@ void Adapt::adapt(double thr)
 
 	if (log_file != NULL) fprintf(log_file, "--\n");
 
+	// select the elements to refine
 	double err0 = 1000.0;
 	double processed_error = 0.0;
 	int i = 0;
@@ -662,25 +704,95 @@ void Adapt::adapt(double thr)
 			break;
 
 		assert(mesh[comp]->elements[id] != NULL);
+
+		err0 = err;
+		processed_error += err;
+	}
+	int n_reft = i;
+
+	// find the optimal refinements (in parallel), the meshes are not changed until all are known
+	ElementReft *reft = new ElementReft[n_reft];
+	MEM_CHECK(reft);
+
+	int n_threads = 1;
+#ifdef _OPENMP
+	// HCurl projections share a cache of projection matrices that is not thread-safe
+	bool parallel = n_reft > 1 && !(h_only && !aniso);
+	for (int j = 0; j < num; j++)
+		if (spaces[j]->get_shapeset()->get_type() != HERMES_H1_SPACE) parallel = false;
+	if (parallel) n_threads = omp_get_max_threads();
+#endif
+	if (n_threads > 1)
+		for (int j = 0; j < num; j++)
+			preload_h1_indices(spaces[j]->get_shapeset());
+
+	// solutions keep their active element, so every worker thread gets its own copies
+	Solution ***tsln = new Solution **[n_threads];
+	MEM_CHECK(tsln);
+	tsln[0] = rsln;
+	for (int t = 1; t < n_threads; t++) {
+		tsln[t] = new Solution *[num];
+		MEM_CHECK(tsln[t]);
+		for (int j = 0; j < num; j++) {
+			tsln[t][j] = new Solution(rsln[j]->get_mesh());
+			MEM_CHECK(tsln[t][j]);
+			tsln[t][j]->copy(rsln[j]);
+			tsln[t][j]->enable_transform(false);
+		}
+	}
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic) num_threads(n_threads)
+#endif
+	for (int k = 0; k < n_reft; k++) {
+		int comp = esort[k][1];
+		int id = esort[k][0];
 		Element *e = mesh[comp]->elements[id];
-#ifdef DEBUG_PRINT
-		printf("  - element #%d", id);
+		ElementReft *r = reft + k;
+
+		int t = 0;
+#ifdef _OPENMP
+		t = omp_get_thread_num();
 #endif
 
-		int split = 0;
-		Ord3 p[8];													// polynomial order of sons
-		for (int k = 0; k < 8; k++) p[k] = Ord3(0, 0, 0);
+		r->split = 0;
+		for (int j = 0; j < Hex::NUM_SONS; j++) r->p[j] = Ord3(0, 0, 0);
+		r->aniso_refts = 0;
 		Ord3 cur_order = spaces[comp]->get_element_order(id);
 
 		if (h_only && !aniso) {
-			p[0] = p[1] = p[2] = p[3] = p[4] = p[5] = p[6] = p[7] = cur_order;
-			split = H3D_H3D_H3D_REFT_HEX_XYZ;
+			r->p[0] = r->p[1] = r->p[2] = r->p[3] = r->p[4] = r->p[5] = r->p[6] = r->p[7] = cur_order;
+			r->split = H3D_H3D_H3D_REFT_HEX_XYZ;
+		}
+		else {
+			if (aniso) r->aniso_refts = get_aniso_refts(mesh[comp], e);
+			get_optimal_refinement(mesh[comp], e, cur_order, tsln[t][comp],
+			                       spaces[comp]->get_shapeset(), r->split, r->p);
+		}
+	}
+
+	for (int t = 1; t < n_threads; t++) {
+		for (int j = 0; j < num; j++)
+			delete tsln[t][j];
+		delete [] tsln[t];
+	}
+	delete [] tsln;
+
+	// apply the refinements in the order of the element errors
+	for (i = 0; i < n_reft; i++) {
+		int comp = esort[i][1];
+		int id = esort[i][0];
+		Element *e = mesh[comp]->elements[id];
+		int split = reft[i].split;
+		Ord3 *p = reft[i].p;
 #ifdef DEBUG_PRINT
-			printf("\n");			// new-line
+		printf("  - element #%d\n", id);
 #endif
-		}
-		else
-			get_optimal_refinement(mesh[comp], e, cur_order, rsln[comp],
+
+		// the refinements of the preceding elements changed the anisotropic refinements
+		// allowed for this one, so the search has to be repeated
+		if (aniso && get_aniso_refts(mesh[comp], e) != reft[i].aniso_refts)
+			get_optimal_refinement(mesh[comp], e, spaces[comp]->get_element_order(id), rsln[comp],
 			                       spaces[comp]->get_shapeset(), split, p);
 
 		if (log_file != NULL)
@@ -717,19 +829,15 @@ void Adapt::adapt(double thr)
 
 			default: assert(false);
 		}
-
-		err0 = err;
-		processed_error += err;
-
-		proj_err.clear();
 	}
+	delete [] reft;
 
 	for (int j = 0; j < num; j++)
 		rsln[j]->enable_transform(true);
 
 	have_errors = false;
 
-	reft_elems = i;
+	reft_elems = n_reft;
 
   tmr.tick();
   adapt_time = tmr.accumulated();
@@ -204,11 +204,17 @@ protected:
 	biform_val_t **form;
 	biform_ord_t **ord;
 
+	struct ProjKey;
+	typedef std::map<ProjKey, double> ProjErrCache;		// cache for projection errors (per element)
+
 	/// Used by adapt(). Can be utilized in specialized adaptivity
 	/// procedures, for which adapt() is not sufficient.
+	/// Does not modify the adaptivity object, so it can be called for more elements in parallel
+	/// as long as every thread has its own copy of 'rsln'.
 	void get_optimal_refinement(Mesh *mesh, Element *e, const Ord3 &order, Solution *rsln,
 	                            Shapeset *ss, int &split, Ord3 p[8]);
-	double get_projection_error(Element *e, int split, int son, const Ord3 &order, Solution *rsln, Shapeset *ss);
+	double get_projection_error(Element *e, int split, int son, const Ord3 &order, Solution *rsln, Shapeset *ss,
+	                            ProjErrCache &proj_err);
 	int get_dof_count(int split, Ord3 order[]);
 
 	Ord3 get_form_order(int marker, const Ord3 &ordu, const Ord3 &ordv, RefMap *ru,
@@ -245,7 +251,6 @@ protected:
 			order = o;
 		}
 	};
-	std::map<ProjKey, double> proj_err;				// cache for projection errors
 
 	// debugging
 	FILE *log_file;
@@ -38,9 +38,13 @@
 bool H1ProjectionIpol::has_prods = false;
 double H1ProjectionIpol::prod_fn[N_FNS][N_FNS];
 double H1ProjectionIpol::prod_dx[N_FNS][N_FNS];
+std::map<unsigned int, H1ProjectionIpol::ProjLU> H1ProjectionIpol::proj_lu;
 
 H1ProjectionIpol::H1ProjectionIpol(Solution *afn, Element *e, Shapeset *ss) : ProjectionIpol(afn, e, ss)
 {
+#ifdef _OPENMP
+#pragma omp critical (h1_proj_ipol_prods)
+#endif
 	if (!has_prods) {
 		H1Projection::precalc_fn_prods(prod_fn);
 		H1Projection::precalc_dx_prods(prod_dx);
@@ -48,6 +52,50 @@ H1ProjectionIpol::H1ProjectionIpol(Solution *afn, Element *e, Shapeset *ss) : Pr
 	}
 }
 
+bool H1ProjectionIpol::find_proj_lu(unsigned int key, ProjLU &lu)
+{
+	bool found = false;
+#ifdef _OPENMP
+#pragma omp critical (h1_proj_ipol_lu)
+#endif
+	{
+		std::map<unsigned int, ProjLU>::iterator it = proj_lu.find(key);
+		if (it != proj_lu.end()) {
+			lu = it->second;
+			found = true;
+		}
+	}
+	return found;
+}
+
+void H1ProjectionIpol::store_proj_lu(unsigned int key, int n, ProjLU &lu)
+{
+	double d;
+	ludcmp(lu.mat, n, lu.iperm, &d);
+
+	bool found = false;
+	ProjLU other;
+#ifdef _OPENMP
+#pragma omp critical (h1_proj_ipol_lu)
+#endif
+	{
+		std::map<unsigned int, ProjLU>::iterator it = proj_lu.find(key);
+		if (it != proj_lu.end()) {
+			other = it->second;
+			found = true;
+		}
+		else
+			proj_lu[key] = lu;
+	}
+
+	// another thread was faster
+	if (found) {
+		delete [] lu.mat;
+		delete [] lu.iperm;
+		lu = other;
+	}
+}
+
 double H1ProjectionIpol::get_error(int split, int son, const Ord3 &order)
 {
 	_F_
@@ -167,34 +215,42 @@ void H1ProjectionIpol::calc_edge_proj(int iedge, int split, int son, const Ord3
 	scalar *proj_rhs = new scalar[edge_fns];
 	MEM_CHECK(proj_rhs);
 	memset(proj_rhs, 0, sizeof(scalar) * edge_fns);
-	double **proj_mat = new_matrix<double>(edge_fns, edge_fns);
-	MEM_CHECK(proj_rhs);
 
 	// local edge vertex numbers
 	const int *edge_vtx = RefHex::get_edge_vertices(iedge);
 	ProjItem vtxp[] = { vertex_proj[edge_vtx[0]], vertex_proj[edge_vtx[1]] };
 
 	int *edge_fn_idx = ss->get_edge_indices(iedge, 0, edge_order);	// indices of edge functions
-	for (int i = 0; i < edge_fns; i++) {
-		int iidx = edge_fn_idx[i];
-		Ord3 oi = ss->get_dcmp(iidx);
-		for (int j = 0; j < edge_fns; j++) {
-			int jidx = edge_fn_idx[j];
-			Ord3 oj = ss->get_dcmp(jidx);
-			double val = 0.0;
-			if (iedge == 0 || iedge == 2 || iedge == 8 || iedge == 10) {
-				val = prod_fn[oi.x][oj.x] + prod_dx[oi.x][oj.x];
-			}
-			else if (iedge == 1 || iedge == 3 || iedge == 9 || iedge == 11) {
-				val = prod_fn[oi.y][oj.y] + prod_dx[oi.y][oj.y];
-			}
-			else if (iedge == 4 || iedge == 5 || iedge == 6 || iedge == 7) {
-				val = prod_fn[oi.z][oj.z] + prod_dx[oi.z][oj.z];
+	unsigned int lu_key = get_proj_lu_key(PROJ_EDGE, iedge, edge_order);
+	ProjLU lu;
+	if (!find_proj_lu(lu_key, lu)) {
+		double **proj_mat = new_matrix<double>(edge_fns, edge_fns);
+		MEM_CHECK(proj_mat);
+		for (int i = 0; i < edge_fns; i++) {
+			int iidx = edge_fn_idx[i];
+			Ord3 oi = ss->get_dcmp(iidx);
+			for (int j = 0; j < edge_fns; j++) {
+				int jidx = edge_fn_idx[j];
+				Ord3 oj = ss->get_dcmp(jidx);
+				double val = 0.0;
+				if (iedge == 0 || iedge == 2 || iedge == 8 || iedge == 10) {
+					val = prod_fn[oi.x][oj.x] + prod_dx[oi.x][oj.x];
+				}
+				else if (iedge == 1 || iedge == 3 || iedge == 9 || iedge == 11) {
+					val = prod_fn[oi.y][oj.y] + prod_dx[oi.y][oj.y];
+				}
+				else if (iedge == 4 || iedge == 5 || iedge == 6 || iedge == 7) {
+					val = prod_fn[oi.z][oj.z] + prod_dx[oi.z][oj.z];
+				}
+				else
+					EXIT("Local edge number out of range.");
+				proj_mat[i][j] += val;
 			}
-			else
-				EXIT("Local edge number out of range.");
-			proj_mat[i][j] += val;
 		}
+		lu.mat = proj_mat;
+		lu.iperm = new int[edge_fns];
+		MEM_CHECK(lu.iperm);
+		store_proj_lu(lu_key, edge_fns, lu);
 	}
 
 	for (int e = 0; e < edge_ns[split][iedge]; e++) {
@@ -304,19 +360,14 @@ void H1ProjectionIpol::calc_edge_proj(int iedge, int split, int son, const Ord3
 		}
 	}
 
-	double d;
-	int * iperm = new int[edge_fns];
-	ludcmp(proj_mat, edge_fns, iperm, &d);
-	lubksb(proj_mat, edge_fns, iperm, proj_rhs);
+	lubksb(lu.mat, edge_fns, lu.iperm, proj_rhs);
 
-  delete [] iperm;
 	// copy functions and coefficients to the basis
 	edge_proj[iedge] = new ProjItem[edge_fns];
 	for (int i = 0; i < edge_fns; i++) {
 		edge_proj[iedge][i].coef = proj_rhs[i];
 		edge_proj[iedge][i].idx = edge_fn_idx[i];
 	}
-	delete [] proj_mat;
 	delete [] proj_rhs;
 }
 
@@ -330,8 +381,6 @@ void H1ProjectionIpol::calc_face_proj(int iface, int split, int son, const Ord3
 	scalar *proj_rhs = new scalar[face_fns];
 	MEM_CHECK(proj_rhs);
 	memset(proj_rhs, 0, sizeof(scalar) * face_fns);
-	double **proj_mat = new_matrix<double>(face_fns, face_fns);
-	MEM_CHECK(proj_mat);
 
 	const int *face_vertex = RefHex::get_face_vertices(iface);
 	const int *face_edge = RefHex::get_face_edges(iface);
@@ -355,35 +404,45 @@ void H1ProjectionIpol::calc_face_proj(int iface, int split, int son, const Ord3
 
 	int face_ori = 0;
 	int *face_fn_idx = ss->get_face_indices(iface, face_ori, face_order);
-	for (int i = 0; i < face_fns; i++) {
-		int iidx = face_fn_idx[i];
-		Ord3 oi = ss->get_dcmp(iidx);
-		for (int j = 0; j < face_fns; j++) {
-			int jidx = face_fn_idx[j];
-			Ord3 oj = ss->get_dcmp(jidx);
-			double val = 0.0;
-			if (iface == 0 || iface == 1) {
-				val =
-					prod_fn[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
-					prod_dx[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
-					prod_fn[oi.y][oj.y] * prod_dx[oi.z][oj.z];
-			}
-			else if (iface == 2 || iface == 3) {
-				val =
-					prod_fn[oi.x][oj.x] * prod_fn[oi.z][oj.z] +
-					prod_dx[oi.x][oj.x] * prod_fn[oi.z][oj.z] +
-					prod_fn[oi.x][oj.x] * prod_dx[oi.z][oj.z];
-			}
-			else if (iface == 4 || iface == 5) {
-				val =
-					prod_fn[oi.x][oj.x] * prod_fn[oi.y][oj.y] +
-					prod_dx[oi.x][oj.x] * prod_fn[oi.y][oj.y] +
-					prod_fn[oi.x][oj.x] * prod_dx[oi.y][oj.y];
+	unsigned int lu_key = get_proj_lu_key(PROJ_FACE, iface, face_order.get_idx());
+	ProjLU lu;
+	if (!find_proj_lu(lu_key, lu)) {
+		double **proj_mat = new_matrix<double>(face_fns, face_fns);
+		MEM_CHECK(proj_mat);
+		for (int i = 0; i < face_fns; i++) {
+			int iidx = face_fn_idx[i];
+			Ord3 oi = ss->get_dcmp(iidx);
+			for (int j = 0; j < face_fns; j++) {
+				int jidx = face_fn_idx[j];
+				Ord3 oj = ss->get_dcmp(jidx);
+				double val = 0.0;
+				if (iface == 0 || iface == 1) {
+					val =
+						prod_fn[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
+						prod_dx[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
+						prod_fn[oi.y][oj.y] * prod_dx[oi.z][oj.z];
+				}
+				else if (iface == 2 || iface == 3) {
+					val =
+						prod_fn[oi.x][oj.x] * prod_fn[oi.z][oj.z] +
+						prod_dx[oi.x][oj.x] * prod_fn[oi.z][oj.z] +
+						prod_fn[oi.x][oj.x] * prod_dx[oi.z][oj.z];
+				}
+				else if (iface == 4 || iface == 5) {
+					val =
+						prod_fn[oi.x][oj.x] * prod_fn[oi.y][oj.y] +
+						prod_dx[oi.x][oj.x] * prod_fn[oi.y][oj.y] +
+						prod_fn[oi.x][oj.x] * prod_dx[oi.y][oj.y];
+				}
+				else
+					EXIT("Local face number out of range.");
+				proj_mat[i][j] += val;
 			}
-			else
-				EXIT("Local face number out of range.");
-			proj_mat[i][j] += val;
 		}
+		lu.mat = proj_mat;
+		lu.iperm = new int[face_fns];
+		MEM_CHECK(lu.iperm);
+		store_proj_lu(lu_key, face_fns, lu);
 	}
 
 	for (int e = 0; e < face_ns[split][iface]; e++) {
@@ -499,12 +558,7 @@ void H1ProjectionIpol::calc_face_proj(int iface, int split, int son, const Ord3
 	}
   delete [] ipol;
 
-	double d;
-	int * iperm = new int[face_fns];
-	ludcmp(proj_mat, face_fns, iperm, &d);
-	lubksb(proj_mat, face_fns, iperm, proj_rhs);
-
-  delete [] iperm;
+	lubksb(lu.mat, face_fns, lu.iperm, proj_rhs);
 
 	face_proj[iface] = new ProjItem [face_fns];
 	for (int i = 0; i < face_fns; i++) {
@@ -512,7 +566,6 @@ void H1ProjectionIpol::calc_face_proj(int iface, int split, int son, const Ord3
 		face_proj[iface][i].idx = face_fn_idx[i];
 	}
 
-	delete [] proj_mat;
 	delete [] proj_rhs;
 }
 
@@ -524,8 +577,6 @@ void H1ProjectionIpol::calc_bubble_proj(int split, int son, const Ord3 &order) {
 	scalar *proj_rhs = new scalar[bubble_fns];
 	MEM_CHECK(proj_rhs);
 	memset(proj_rhs, 0, sizeof(scalar) * bubble_fns);
-	double **proj_mat = new_matrix<double>(bubble_fns, bubble_fns);
-	MEM_CHECK(proj_mat);
 
 	// get total number of functions (vertex + edge + face)
 	int ipol_fns = Hex::NUM_VERTICES;
@@ -559,19 +610,29 @@ void H1ProjectionIpol::calc_bubble_proj(int split, int son, const Ord3 &order) {
 
 	// do it //
 	int *bubble_fn_idx = ss->get_bubble_indices(order);
-	for (int i = 0; i < bubble_fns; i++) {
-		int iidx = bubble_fn_idx[i];
-		Ord3 oi = ss->get_dcmp(iidx);
-		for (int j = 0; j < bubble_fns; j++) {
-			int jidx = bubble_fn_idx[j];
-			Ord3 oj = ss->get_dcmp(jidx);
-			double val =
-				prod_fn[oi.x][oj.x] * prod_fn[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
-				prod_dx[oi.x][oj.x] * prod_fn[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
-				prod_fn[oi.x][oj.x] * prod_dx[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
-				prod_fn[oi.x][oj.x] * prod_fn[oi.y][oj.y] * prod_dx[oi.z][oj.z];
-			proj_mat[i][j] += val;
+	unsigned int lu_key = get_proj_lu_key(PROJ_BUBBLE, 0, order.get_idx());
+	ProjLU lu;
+	if (!find_proj_lu(lu_key, lu)) {
+		double **proj_mat = new_matrix<double>(bubble_fns, bubble_fns);
+		MEM_CHECK(proj_mat);
+		for (int i = 0; i < bubble_fns; i++) {
+			int iidx = bubble_fn_idx[i];
+			Ord3 oi = ss->get_dcmp(iidx);
+			for (int j = 0; j < bubble_fns; j++) {
+				int jidx = bubble_fn_idx[j];
+				Ord3 oj = ss->get_dcmp(jidx);
+				double val =
+					prod_fn[oi.x][oj.x] * prod_fn[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
+					prod_dx[oi.x][oj.x] * prod_fn[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
+					prod_fn[oi.x][oj.x] * prod_dx[oi.y][oj.y] * prod_fn[oi.z][oj.z] +
+					prod_fn[oi.x][oj.x] * prod_fn[oi.y][oj.y] * prod_dx[oi.z][oj.z];
+				proj_mat[i][j] += val;
+			}
 		}
+		lu.mat = proj_mat;
+		lu.iperm = new int[bubble_fns];
+		MEM_CHECK(lu.iperm);
+		store_proj_lu(lu_key, bubble_fns, lu);
 	}
 
 	for (int e = 0; e < int_ns[split]; e++) {
@@ -651,18 +712,13 @@ void H1ProjectionIpol::calc_bubble_proj(int split, int son, const Ord3 &order) {
 	}
   delete [] ipol;
 
-	double d;
-	int *iperm = new int[bubble_fns];
-	ludcmp(proj_mat, bubble_fns, iperm, &d);
-	lubksb(proj_mat, bubble_fns, iperm, proj_rhs);
+	lubksb(lu.mat, bubble_fns, lu.iperm, proj_rhs);
 
-  delete iperm;
 	bubble_proj = new ProjItem [bubble_fns];
 	for (int i = 0; i < bubble_fns; i++) {
 		bubble_proj[i].coef = proj_rhs[i];
 		bubble_proj[i].idx = bubble_fn_idx[i];
 	}
 
-	delete [] proj_mat;
 	delete [] proj_rhs;
 }
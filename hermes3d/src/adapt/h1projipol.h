@@ -21,6 +21,7 @@
 #define _ADAPT_H1_PROJECTIONIPOL_H_
 
 #include "projipol.h"
+#include <map>
 
 /// H1 projection
 ///
@@ -42,6 +43,25 @@ protected:
 	static double prod_fn[N_FNS][N_FNS];	// precalculated products of fn. values
 	static double prod_dx[N_FNS][N_FNS];	// precalculated products of derivatives
 	static bool has_prods;
+
+	/// LU decomposition of a projection matrix
+	struct ProjLU {
+		double **mat;
+		int *iperm;
+	};
+
+	enum { PROJ_EDGE = 0, PROJ_FACE = 1, PROJ_BUBBLE = 2 };
+
+	/// The projection matrices are assembled on the reference domain, so they depend only on
+	/// the kind of the entity, its local number and its order, not on the element. They are
+	/// decomposed once and shared by all projections (also across threads).
+	static std::map<unsigned int, ProjLU> proj_lu;
+
+	static unsigned int get_proj_lu_key(int kind, int entity, int order_idx) {
+		return (((kind << 4) | entity) << 17) | order_idx;
+	}
+	static bool find_proj_lu(unsigned int key, ProjLU &lu);
+	static void store_proj_lu(unsigned int key, int n, ProjLU &lu);
 };
 
 #endif
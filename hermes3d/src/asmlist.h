@@ -63,6 +63,20 @@ public:
 		cnt++;
 	}
 
+	/// Makes this list a copy of 'src' (allocates only as much memory as needed).
+	void copy(const AsmList *src) {
+		if (src->cnt > cap) {
+			cap = src->cnt;
+			idx = (long int *) realloc(idx, sizeof(long int) * cap); MEM_CHECK(idx);
+			dof = (int *) realloc(dof, sizeof(int) * cap); MEM_CHECK(dof);
+			coef = (scalar *) realloc(coef, sizeof(scalar) * cap); MEM_CHECK(coef);
+		}
+		memcpy(idx, src->idx, sizeof(long int) * src->cnt);
+		memcpy(dof, src->dof, sizeof(int) * src->cnt);
+		memcpy(coef, src->coef, sizeof(scalar) * src->cnt);
+		cnt = src->cnt;
+	}
+
 	void dump(FILE *stream = stdout) {
 		fprintf(stream, "\nasmlist:\n");
 		for (int i = 0; i < cnt; i++)
@@ -39,6 +39,8 @@
 #include "../../hermes_common/solver/solver.h"
 #include "../../hermes_common/solver/umfpack_solver.h"
 #include "../../hermes_common/solver/superlu.h"
+#include "../../hermes_common/solver/banded.h"
+#include "../../hermes_common/solver/mixed_precision.h"
 #include "../../hermes_common/solver/petsc.h"
 #include "../../hermes_common/solver/epetra.h"
 #include "../../hermes_common/solver/amesos.h"
@@ -98,6 +100,7 @@
 #include "output.h"
 #include "output/gmsh.h"
 #include "output/vtk.h"
+#include "output/vtu.h"
 #include "output/graph.h"
 
 #include "asmlist.h"
@@ -46,16 +46,16 @@ class HERMES_API OutputQuad : public Quad3D {
 public:
 	virtual QuadPt3D *get_points(const Ord3 &order) {
 		_F_
-    if (tables->find(order.get_idx()) == tables->end()) 
-      calculate_view_points(order);
-		return (*tables)[order.get_idx()];
+		if (tables[get_slot(order)] == NULL)
+			calculate_view_points(order);
+		return tables[get_slot(order)];
 	}
 
 	virtual int get_num_points(const Ord3 &order) {
 		_F_
-    if (np->find(order.get_idx()) == np->end()) 
-      calculate_view_points(order);
-		return (*np)[order.get_idx()];
+		if (tables[get_slot(order)] == NULL)
+			calculate_view_points(order);
+		return np[get_slot(order)];
 	}
 
 	virtual int *get_subdiv_modes(Ord3 order) {
@@ -119,8 +119,6 @@ OutputQuadTetra::OutputQuadTetra() {
 OutputQuadTetra::~OutputQuadTetra() {
 	_F_
 #ifdef WITH_TETRA
-	for(std::map<unsigned int, QuadPt3D*>::iterator it = tables->begin(); it != tables->end(); it++)
-    delete [] it->second;
 
   for(std::map<unsigned int, int*>::iterator it = subdiv_modes.begin(); it != subdiv_modes.end(); it++)
     delete [] it->second;
@@ -132,6 +130,7 @@ void OutputQuadTetra::calculate_view_points(Ord3 order) {
 	_F_
 #ifdef WITH_TETRA
 	int orderidx = order.get_idx();
+	int slot = get_slot(order);
 	// check if the order is greater than 0, because we are taking log(o)
 	if (order.order == 0) order.order++;
 
@@ -142,7 +141,7 @@ void OutputQuadTetra::calculate_view_points(Ord3 order) {
 	// each refinement level means that a tetrahedron is divided into 8 subtetrahedra
 	// i.e., there are 8^levels resulting tetrahedra
 	subdiv_num[orderidx] = (1 << (3 * levels));
-	(*np)[orderidx] = subdiv_num[orderidx] * Tetra::NUM_VERTICES;
+	np[slot] = subdiv_num[orderidx] * Tetra::NUM_VERTICES;
 
 	// the new subelements are tetrahedra only
 	subdiv_modes[orderidx] = new int[subdiv_num[orderidx]];
@@ -151,10 +150,10 @@ void OutputQuadTetra::calculate_view_points(Ord3 order) {
 		subdiv_modes[orderidx][i] = HERMES_MODE_TET;
 
 	// compute the table of points recursively
-	(*tables)[orderidx] = new QuadPt3D[(*np)[orderidx]];
+	tables[slot] = new QuadPt3D[np[slot]];
 	int idx = 0;
 	const Point3D *ref_vtcs = RefTetra::get_vertices();
-	recursive_division(ref_vtcs, (*tables)[orderidx], levels, idx);
+	recursive_division(ref_vtcs, tables[slot], levels, idx);
 #endif
 }
 
@@ -224,8 +223,6 @@ OutputQuadHex::OutputQuadHex() {
 OutputQuadHex::~OutputQuadHex() {
 	_F_
 #ifdef WITH_HEX
-	for(std::map<unsigned int, QuadPt3D*>::iterator it = tables->begin(); it != tables->end(); it++)
-    delete [] it->second;
 
   for(std::map<unsigned int, int*>::iterator it = subdiv_modes.begin(); it != subdiv_modes.end(); it++)
     delete [] it->second;
@@ -241,7 +238,8 @@ void OutputQuadHex::calculate_view_points(Ord3 order) {
 	int levels = 3;
 
 	subdiv_num[o] = (1 << (3 * levels));
-	(*np)[o] = subdiv_num[o] * Hex::NUM_VERTICES;
+	int slot = get_slot(order);
+	np[slot] = subdiv_num[o] * Hex::NUM_VERTICES;
 
 	subdiv_modes[o] = new int[subdiv_num[o]];
 	MEM_CHECK(subdiv_modes[o]);
@@ -250,10 +248,10 @@ void OutputQuadHex::calculate_view_points(Ord3 order) {
 		subdiv_modes[o][i] = HERMES_MODE_HEX;
 
 	// compute the table of points recursively
-	(*tables)[o] = new QuadPt3D[(*np)[o]];
+	tables[slot] = new QuadPt3D[np[slot]];
 	int idx = 0;
 	const Point3D *ref_vtcs = RefHex::get_vertices();
-	recursive_division(ref_vtcs, (*tables)[o], levels, idx);
+	recursive_division(ref_vtcs, tables[slot], levels, idx);
 #endif
 }
 
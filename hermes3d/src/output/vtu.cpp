@@ -0,0 +1,655 @@
+// This file is part of Hermes3D
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes3D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes3D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+//
+// vtu.cpp
+//
+// Binary (appended raw) VTU and parallel VTU output
+//
+
+#include "vtu.h"
+#include "../refdomain.h"
+#include "../h3d_common.h"
+#include "../shapeset/common.h"
+#include "../shapeset/refmapss.h"
+
+#include <stdio.h>
+#include "../../../hermes_common/utils.h"
+#include "../../../hermes_common/error.h"
+#include "../../../hermes_common/callstack.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#define VTK_TETRA						10
+#define VTK_HEXAHEDRON					12
+
+// number of subdivisions of a hex in one direction (indexed by the order in that direction)
+static int divs[] = { 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6 };
+static const int MAX_DIVS_ORDER = countof(divs) - 1;
+
+#ifdef WITH_TETRA
+static RefMapShapesetTetra vtu_ref_map_ss_tetra;
+#endif
+#ifdef WITH_HEX
+static RefMapShapesetHex vtu_ref_map_ss_hex;
+#endif
+
+namespace Vtu {
+
+//// Pattern ///////////////////////////////////////////////////////////////////////////////////////
+
+/// Linearization of the reference element for one (mode, order) pair
+///
+/// Besides the output points, the pattern holds the values of the vertex functions of the
+/// reference map at these points, so that the physical coordinates are just a weighted sum
+/// of the element vertices and no (shared) RefMap is needed to obtain them.
+struct Pattern {
+	Pattern() : np(0), pt(NULL), nv(0), vtx_wt(NULL), nc(0), cv(0), cells(NULL), type(0) { }
+	~Pattern() {
+		delete [] pt;
+		delete [] vtx_wt;
+		delete [] cells;
+	}
+
+	int np;					// number of output points
+	QuadPt3D *pt;			// output points on the reference element
+	int nv;					// number of element vertices
+	double *vtx_wt;			// vertex functions of the reference map at the points [np][nv]
+	int nc;					// number of linear cells
+	int cv;					// number of vertices of one cell
+	int *cells;				// connectivity of the cells (indices into pt) [nc][cv]
+	unsigned char type;		// VTK type of the cells
+};
+
+/// Table of patterns
+///
+/// Patterns are created during the serial part of the output, the parallel part only reads them.
+class PatternTable {
+public:
+	PatternTable() { }
+	~PatternTable();
+
+	Pattern *get(ElementMode3D mode, const Ord3 &order);
+
+protected:
+	std::map<unsigned int, Pattern *> patterns;
+
+	Pattern *create_tetra();
+	Pattern *create_hex(int dx, int dy, int dz);
+	void calc_vertex_weights(Pattern *p, Shapeset *ss);
+};
+
+PatternTable::~PatternTable()
+{
+	for (std::map<unsigned int, Pattern *>::iterator it = patterns.begin(); it != patterns.end(); it++)
+		delete it->second;
+}
+
+Pattern *PatternTable::get(ElementMode3D mode, const Ord3 &order)
+{
+	_F_
+	Ord3 key;
+	switch (mode) {
+		case HERMES_MODE_TET: key = Ord3(0); break;
+		case HERMES_MODE_HEX:
+			key = Ord3(std::min((int) order.x, MAX_DIVS_ORDER), std::min((int) order.y, MAX_DIVS_ORDER),
+			           std::min((int) order.z, MAX_DIVS_ORDER));
+			break;
+		default: EXIT(HERMES_ERR_NOT_IMPLEMENTED); break;
+	}
+
+	std::map<unsigned int, Pattern *>::iterator it = patterns.find(key.get_idx());
+	if (it != patterns.end()) return it->second;
+
+	Pattern *p = NULL;
+	switch (mode) {
+		case HERMES_MODE_TET: p = create_tetra(); break;
+		case HERMES_MODE_HEX: p = create_hex(divs[key.x], divs[key.y], divs[key.z]); break;
+		default: EXIT(HERMES_ERR_NOT_IMPLEMENTED); break;
+	}
+	patterns[key.get_idx()] = p;
+	return p;
+}
+
+void PatternTable::calc_vertex_weights(Pattern *p, Shapeset *ss)
+{
+	_F_
+	p->vtx_wt = new double[p->np * p->nv];
+	MEM_CHECK(p->vtx_wt);
+	for (int i = 0; i < p->np; i++)
+		for (int iv = 0; iv < p->nv; iv++)
+			p->vtx_wt[i * p->nv + iv] = ss->get_fn_value(ss->get_vertex_index(iv), p->pt[i].x, p->pt[i].y, p->pt[i].z, 0);
+}
+
+Pattern *PatternTable::create_tetra()
+{
+	_F_
+#ifdef WITH_TETRA
+	Pattern *p = new Pattern;
+	MEM_CHECK(p);
+	p->np = Tetra::NUM_VERTICES;
+	p->pt = new QuadPt3D[p->np];
+	const Point3D *ref_vtcs = RefTetra::get_vertices();
+	for (int i = 0; i < p->np; i++)
+		p->pt[i] = QuadPt3D(ref_vtcs[i].x, ref_vtcs[i].y, ref_vtcs[i].z, 1.0);
+
+	p->nv = Tetra::NUM_VERTICES;
+	calc_vertex_weights(p, &vtu_ref_map_ss_tetra);
+
+	p->nc = 1;
+	p->cv = Tetra::NUM_VERTICES;
+	p->cells = new int[p->nc * p->cv];
+	for (int i = 0; i < p->cv; i++)
+		p->cells[i] = i;
+	p->type = VTK_TETRA;
+	return p;
+#else
+	EXIT(H3D_ERR_TETRA_NOT_COMPILED);
+	return NULL;
+#endif
+}
+
+Pattern *PatternTable::create_hex(int dx, int dy, int dz)
+{
+	_F_
+#ifdef WITH_HEX
+	Pattern *p = new Pattern;
+	MEM_CHECK(p);
+	p->np = (dx + 1) * (dy + 1) * (dz + 1);
+	p->pt = new QuadPt3D[p->np];
+	double step_x = 2.0 / dx, step_y = 2.0 / dy, step_z = 2.0 / dz;
+	int n = 0;
+	for (int k = 0; k <= dz; k++)
+		for (int l = 0; l <= dy; l++)
+			for (int m = 0; m <= dx; m++, n++)
+				p->pt[n] = QuadPt3D((step_x * m) - 1, (step_y * l) - 1, (step_z * k) - 1, 1.0);
+
+	p->nv = Hex::NUM_VERTICES;
+	calc_vertex_weights(p, &vtu_ref_map_ss_hex);
+
+	p->nc = dx * dy * dz;
+	p->cv = Hex::NUM_VERTICES;
+	p->cells = new int[p->nc * p->cv];
+	int row = dx + 1;				// points in one row
+	int pl = (dx + 1) * (dy + 1);	// points in one plane
+	int *cell = p->cells;
+	for (int i = 0; i < dz; i++)
+		for (int j = 0; j < dy; j++)
+			for (int o = 0; o < dx; o++, cell += Hex::NUM_VERTICES) {
+				int base = (pl * i) + (row * j) + o;
+				cell[0] = base;
+				cell[1] = base + 1;
+				cell[2] = base + row + 1;
+				cell[3] = base + row;
+				cell[4] = base + pl;
+				cell[5] = base + pl + 1;
+				cell[6] = base + pl + row + 1;
+				cell[7] = base + pl + row;
+			}
+	p->type = VTK_HEXAHEDRON;
+	return p;
+#else
+	EXIT(H3D_ERR_HEX_NOT_COMPILED);
+	return NULL;
+#endif
+}
+
+//// Linearizer ////////////////////////////////////////////////////////////////////////////////////
+
+/// Linearized active elements of a mesh
+///
+/// Elements are stored in a flat form: element i owns the points pt_off[i]..pt_off[i + 1] and
+/// the cells cell_off[i]..cell_off[i + 1], so any range of elements forms a piece on its own.
+class Linearizer {
+public:
+	Linearizer(PatternTable *table);
+
+	/// Add an element (serial); its output points are pattern->pt
+	Pattern *add_element(Element *e, const Ord3 &order);
+	/// Calculate the coordinates and the connectivity of all elements (parallel)
+	void process(Mesh *mesh);
+
+	int get_num_elements() const { return elems.size(); }
+
+	std::vector<Element *> elems;
+	std::vector<Pattern *> pattern;
+	std::vector<int> pt_off;		// [num elements + 1]
+	std::vector<int> cell_off;		// [num elements + 1]
+	std::vector<int> conn_off;		// [num elements + 1], offsets into conn
+
+	std::vector<float> points;		// [num points][3]
+	std::vector<int> conn;			// connectivity (global point indices)
+	std::vector<unsigned char> types;
+
+	int n_data;						// number of components of the data
+	bool cell_data;					// data is given per cell (true) or per point (false)
+	std::vector<float> data;
+
+protected:
+	PatternTable *table;
+};
+
+Linearizer::Linearizer(PatternTable *table)
+{
+	_F_
+	this->table = table;
+	n_data = 0;
+	cell_data = false;
+	pt_off.push_back(0);
+	cell_off.push_back(0);
+	conn_off.push_back(0);
+}
+
+Pattern *Linearizer::add_element(Element *e, const Ord3 &order)
+{
+	_F_
+	Pattern *p = table->get(e->get_mode(), order);
+	elems.push_back(e);
+	pattern.push_back(p);
+	pt_off.push_back(pt_off.back() + p->np);
+	cell_off.push_back(cell_off.back() + p->nc);
+	conn_off.push_back(conn_off.back() + p->nc * p->cv);
+	return p;
+}
+
+void Linearizer::process(Mesh *mesh)
+{
+	_F_
+	int ne = elems.size();
+	if (ne == 0) return;
+
+	points.resize(3 * pt_off[ne]);
+	conn.resize(conn_off[ne]);
+	types.resize(cell_off[ne]);
+
+	// the loop body only reads the mesh and the patterns
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 64)
+#endif
+	for (int i = 0; i < ne; i++) {
+		Element *e = elems[i];
+		Pattern *p = pattern[i];
+
+		Vertex *vtx[Hex::NUM_VERTICES];
+		for (int iv = 0; iv < p->nv; iv++)
+			vtx[iv] = mesh->vertices[e->get_vertex(iv)];
+
+		float *pts = &points[3 * pt_off[i]];
+		for (int k = 0; k < p->np; k++) {
+			const double *wt = p->vtx_wt + k * p->nv;
+			double x = 0.0, y = 0.0, z = 0.0;
+			for (int iv = 0; iv < p->nv; iv++) {
+				x += wt[iv] * vtx[iv]->x;
+				y += wt[iv] * vtx[iv]->y;
+				z += wt[iv] * vtx[iv]->z;
+			}
+			pts[3 * k] = (float) x;
+			pts[3 * k + 1] = (float) y;
+			pts[3 * k + 2] = (float) z;
+		}
+
+		int *c = &conn[conn_off[i]];
+		for (int k = 0; k < p->nc * p->cv; k++)
+			c[k] = pt_off[i] + p->cells[k];
+		for (int k = cell_off[i]; k < cell_off[i + 1]; k++)
+			types[k] = p->type;
+	}
+}
+
+//// Writer ////////////////////////////////////////////////////////////////////////////////////////
+
+static const char *get_byte_order()
+{
+	unsigned int one = 1;
+	return *(unsigned char *) &one == 1 ? "LittleEndian" : "BigEndian";
+}
+
+// writes one block of appended data (preceded by its size)
+static void write_block(FILE *file, const void *data, uint64 size)
+{
+	fwrite(&size, sizeof(size), 1, file);
+	if (size > 0) fwrite(data, 1, size, file);
+}
+
+/// Write elements e0..e1 of the linearization as one piece into a .vtu file
+///
+/// NOTE: called from a parallel region, must not use the (shared) call stack
+static bool write_piece(FILE *file, Linearizer *l, int e0, int e1, const char *name)
+{
+	int np = l->pt_off[e1] - l->pt_off[e0];
+	int nc = l->cell_off[e1] - l->cell_off[e0];
+	int nconn = l->conn_off[e1] - l->conn_off[e0];
+
+	// piece-local connectivity and offsets
+	std::vector<int> conn(nconn);
+	std::vector<int> offsets(nc);
+	int base = l->pt_off[e0];
+	for (int k = 0; k < nconn; k++)
+		conn[k] = l->conn[l->conn_off[e0] + k] - base;
+	for (int i = e0, k = 0; i < e1; i++) {
+		Pattern *p = l->pattern[i];
+		int off = l->conn_off[i] - l->conn_off[e0];
+		for (int c = 0; c < p->nc; c++, k++)
+			offsets[k] = off + (c + 1) * p->cv;
+	}
+
+	uint64 sz_data = (uint64) l->n_data * (l->cell_data ? nc : np) * sizeof(float);
+	uint64 sz_points = (uint64) 3 * np * sizeof(float);
+	uint64 sz_conn = (uint64) nconn * sizeof(int);
+	uint64 sz_offsets = (uint64) nc * sizeof(int);
+	uint64 sz_types = (uint64) nc * sizeof(unsigned char);
+
+	uint64 offset = 0;
+	fprintf(file, "<?xml version=\"1.0\"?>\n");
+	fprintf(file, "<VTKFile type=\"UnstructuredGrid\" version=\"1.0\" byte_order=\"%s\" header_type=\"UInt64\">\n",
+	        get_byte_order());
+	fprintf(file, "  <UnstructuredGrid>\n");
+	fprintf(file, "    <Piece NumberOfPoints=\"%d\" NumberOfCells=\"%d\">\n", np, nc);
+	if (l->n_data > 0) {
+		const char *tag = l->cell_data ? "CellData" : "PointData";
+		fprintf(file, "      <%s %s=\"%s\">\n", tag, l->n_data == 1 ? "Scalars" : "Vectors", name);
+		fprintf(file, "        <DataArray type=\"Float32\" Name=\"%s\" NumberOfComponents=\"%d\" format=\"appended\" offset=\"%llu\"/>\n",
+		        name, l->n_data, (unsigned long long) offset);
+		fprintf(file, "      </%s>\n", tag);
+		offset += sizeof(uint64) + sz_data;
+	}
+	fprintf(file, "      <Points>\n");
+	fprintf(file, "        <DataArray type=\"Float32\" NumberOfComponents=\"3\" format=\"appended\" offset=\"%llu\"/>\n",
+	        (unsigned long long) offset);
+	fprintf(file, "      </Points>\n");
+	offset += sizeof(uint64) + sz_points;
+	fprintf(file, "      <Cells>\n");
+	fprintf(file, "        <DataArray type=\"Int32\" Name=\"connectivity\" format=\"appended\" offset=\"%llu\"/>\n",
+	        (unsigned long long) offset);
+	offset += sizeof(uint64) + sz_conn;
+	fprintf(file, "        <DataArray type=\"Int32\" Name=\"offsets\" format=\"appended\" offset=\"%llu\"/>\n",
+	        (unsigned long long) offset);
+	offset += sizeof(uint64) + sz_offsets;
+	fprintf(file, "        <DataArray type=\"UInt8\" Name=\"types\" format=\"appended\" offset=\"%llu\"/>\n",
+	        (unsigned long long) offset);
+	fprintf(file, "      </Cells>\n");
+	fprintf(file, "    </Piece>\n");
+	fprintf(file, "  </UnstructuredGrid>\n");
+	fprintf(file, "  <AppendedData encoding=\"raw\">\n");
+	fprintf(file, "_");
+
+	if (l->n_data > 0) {
+		int first = l->cell_data ? l->cell_off[e0] : l->pt_off[e0];
+		write_block(file, sz_data > 0 ? &l->data[l->n_data * first] : NULL, sz_data);
+	}
+	write_block(file, np > 0 ? &l->points[3 * l->pt_off[e0]] : NULL, sz_points);
+	write_block(file, nconn > 0 ? &conn[0] : NULL, sz_conn);
+	write_block(file, nc > 0 ? &offsets[0] : NULL, sz_offsets);
+	write_block(file, nc > 0 ? &l->types[l->cell_off[e0]] : NULL, sz_types);
+
+	fprintf(file, "\n  </AppendedData>\n");
+	fprintf(file, "</VTKFile>\n");
+	return !ferror(file);
+}
+
+/// Write the linearization into a .vtu file (n_pieces == 1), or into pieces indexed by a .pvtu file
+static void write(const char *file_name, int n_pieces, Linearizer *l, const char *name)
+{
+	_F_
+	int ne = l->get_num_elements();
+	if (n_pieces == 1) {
+		FILE *file = fopen(file_name, "wb");
+		if (file == NULL) {
+			warning("Could not open file '%s' for writing.", file_name);
+			return;
+		}
+		if (!write_piece(file, l, 0, ne, name))
+			warning("Error while writing '%s'.", file_name);
+		fclose(file);
+		return;
+	}
+
+	// pieces are named <base>_<n>.vtu, where <base> is the name of the index file without the extension
+	std::string base(file_name);
+	std::string::size_type dot = base.rfind('.');
+	if (dot != std::string::npos && base.find('/', dot) == std::string::npos) base.erase(dot);
+
+	if (n_pieces > ne) n_pieces = ne;
+	if (n_pieces < 1) n_pieces = 1;
+	std::vector<std::string> piece_names(n_pieces);
+	for (int k = 0; k < n_pieces; k++) {
+		char suffix[32];
+		sprintf(suffix, "_%d.vtu", k);
+		piece_names[k] = base + suffix;
+	}
+
+	int n_failed = 0;
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic, 1) reduction(+:n_failed)
+#endif
+	for (int k = 0; k < n_pieces; k++) {
+		int e0 = (int) ((long long) ne * k / n_pieces);
+		int e1 = (int) ((long long) ne * (k + 1) / n_pieces);
+		FILE *file = fopen(piece_names[k].c_str(), "wb");
+		if (file == NULL) {
+			n_failed++;
+			continue;
+		}
+		if (!write_piece(file, l, e0, e1, name)) n_failed++;
+		fclose(file);
+	}
+	if (n_failed > 0)
+		warning("Could not write %d out of %d pieces of '%s'.", n_failed, n_pieces, file_name);
+
+	// the index
+	FILE *file = fopen(file_name, "w");
+	if (file == NULL) {
+		warning("Could not open file '%s' for writing.", file_name);
+		return;
+	}
+	fprintf(file, "<?xml version=\"1.0\"?>\n");
+	fprintf(file, "<VTKFile type=\"PUnstructuredGrid\" version=\"1.0\" byte_order=\"%s\" header_type=\"UInt64\">\n",
+	        get_byte_order());
+	fprintf(file, "  <PUnstructuredGrid GhostLevel=\"0\">\n");
+	if (l->n_data > 0) {
+		const char *tag = l->cell_data ? "PCellData" : "PPointData";
+		fprintf(file, "    <%s %s=\"%s\">\n", tag, l->n_data == 1 ? "Scalars" : "Vectors", name);
+		fprintf(file, "      <PDataArray type=\"Float32\" Name=\"%s\" NumberOfComponents=\"%d\"/>\n", name, l->n_data);
+		fprintf(file, "    </%s>\n", tag);
+	}
+	fprintf(file, "    <PPoints>\n");
+	fprintf(file, "      <PDataArray type=\"Float32\" NumberOfComponents=\"3\"/>\n");
+	fprintf(file, "    </PPoints>\n");
+	for (int k = 0; k < n_pieces; k++) {
+		// sources are relative to the index file
+		std::string::size_type slash = piece_names[k].rfind('/');
+		const char *src = piece_names[k].c_str() + (slash == std::string::npos ? 0 : slash + 1);
+		fprintf(file, "    <Piece Source=\"%s\"/>\n", src);
+	}
+	fprintf(file, "  </PUnstructuredGrid>\n");
+	fprintf(file, "</VTKFile>\n");
+	fclose(file);
+}
+
+} // namespace
+
+static Vtu::PatternTable vtu_patterns;
+
+VtuOutputEngine::VtuOutputEngine(const char *file_name, int n_pieces)
+{
+	_F_
+	this->file_name = new char[strlen(file_name) + 1];
+	strcpy(this->file_name, file_name);
+	this->n_pieces = n_pieces;
+}
+
+VtuOutputEngine::~VtuOutputEngine()
+{
+	_F_
+	delete [] file_name;
+}
+
+int VtuOutputEngine::get_num_pieces() const
+{
+	if (n_pieces > 0) return n_pieces;
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+void VtuOutputEngine::out(MeshFunction *fn, const char *name, int item)
+{
+	_F_
+	assert(fn->get_num_components() == 1 || fn->get_num_components() == 3);
+
+	int comp[COMPONENTS];		// components to output
+	int nc;						// number of components to output
+	int a = 0, b = 0;
+	if (fn->get_num_components() == COMPONENTS) {
+		if ((item & FN_COMPONENT_0) && (item & FN_COMPONENT_1) && (item & FN_COMPONENT_2)) {
+			mask_to_comp_val(item, a, b);
+			for (int i = 0; i < COMPONENTS; i++) comp[i] = i;
+			nc = 3;
+		}
+		else if (item & FN_COMPONENT_0) { mask_to_comp_val(item & FN_COMPONENT_0, a, b); comp[0] = 0; nc = 1; }
+		else if (item & FN_COMPONENT_1) { mask_to_comp_val(item & FN_COMPONENT_1, a, b); comp[0] = 1; nc = 1; }
+		else if (item & FN_COMPONENT_2) { mask_to_comp_val(item & FN_COMPONENT_2, a, b); comp[0] = 2; nc = 1; }
+		else {
+			warning("Unable to satisfy the output request (item = %d).", item);
+			return;
+		}
+	}
+	else {
+		mask_to_comp_val(item & FN_COMPONENT_0, comp[0], b);
+		nc = 1;
+	}
+
+	Vtu::Linearizer l(&vtu_patterns);
+	l.n_data = nc;
+
+	// evaluation of the function is serial (a mesh function has a single active element)
+	Mesh *mesh = fn->get_mesh();
+	for (std::map<unsigned int, Element*>::iterator it = mesh->elements.begin(); it != mesh->elements.end(); it++)
+		if (it->second->used && it->second->active) {
+			Element *e = it->second;
+			fn->set_active_element(e);
+			Vtu::Pattern *p = l.add_element(e, fn->get_order());
+
+			fn->precalculate(p->np, p->pt, item);
+			scalar *val[COMPONENTS];
+			for (int ic = 0; ic < nc; ic++)
+				val[ic] = fn->get_values(comp[ic], b);
+			for (int i = 0; i < p->np; i++)
+				for (int ic = 0; ic < nc; ic++)
+					l.data.push_back((float) REAL(val[ic][i]));
+		}
+
+	l.process(mesh);
+	Vtu::write(file_name, n_pieces == 1 ? 1 : get_num_pieces(), &l, name);
+}
+
+void VtuOutputEngine::out(MeshFunction *fn1, MeshFunction *fn2, MeshFunction *fn3, const char *name, int item)
+{
+	_F_
+	MeshFunction *fn[] = { fn1, fn2, fn3 };
+	int a = 0, b = 0;
+	mask_to_comp_val(item, a, b);
+
+	Vtu::Linearizer l(&vtu_patterns);
+	l.n_data = COMPONENTS;
+
+	// NOTE: the functions are visualized on the mesh of the first one (no union mesh is built)
+	Mesh *mesh = fn1->get_mesh();
+	for (std::map<unsigned int, Element*>::iterator it = mesh->elements.begin(); it != mesh->elements.end(); it++)
+		if (it->second->used && it->second->active) {
+			Element *e = it->second;
+			for (int i = 0; i < COMPONENTS; i++)
+				fn[i]->set_active_element(e);
+			Ord3 order = max(fn1->get_order(), max(fn2->get_order(), fn3->get_order()));
+			Vtu::Pattern *p = l.add_element(e, order);
+
+			scalar *val[COMPONENTS];
+			for (int ic = 0; ic < COMPONENTS; ic++) {
+				fn[ic]->precalculate(p->np, p->pt, item);
+				val[ic] = fn[ic]->get_values(0, b);
+			}
+			for (int i = 0; i < p->np; i++)
+				for (int ic = 0; ic < COMPONENTS; ic++)
+					l.data.push_back((float) REAL(val[ic][i]));
+		}
+
+	l.process(mesh);
+	Vtu::write(file_name, n_pieces == 1 ? 1 : get_num_pieces(), &l, name);
+}
+
+void VtuOutputEngine::out(Mesh *mesh)
+{
+	_F_
+	Vtu::Linearizer l(&vtu_patterns);
+	l.n_data = 1;
+	l.cell_data = true;
+
+	for (std::map<unsigned int, Element*>::iterator it = mesh->elements.begin(); it != mesh->elements.end(); it++)
+		if (it->second->used && it->second->active) {
+			Element *e = it->second;
+			Ord3 order = e->get_mode() == HERMES_MODE_HEX ? Ord3(1, 1, 1) : Ord3(1);
+			l.add_element(e, order);
+			l.data.push_back((float) e->marker);
+		}
+
+	l.process(mesh);
+	Vtu::write(file_name, n_pieces == 1 ? 1 : get_num_pieces(), &l, "elem-markers");
+}
+
+
+/// Functions facilitating output in the format displayable by e.g. Paraview.
+static void vtu_file_name(char *fname, const char *name, int iter, int n_pieces)
+{
+	const char *ext = n_pieces == 1 ? "vtu" : "pvtu";
+	if (iter == -1)
+		sprintf(fname, "%s.%s", name, ext);
+	else
+		sprintf(fname, "iter-%s-%d.%s", name, iter, ext);
+}
+
+// Solution output for one solution component.
+void out_fn_vtu(MeshFunction *fn, const char *name, int iter, int n_pieces)
+{
+	char fname[1024];
+	vtu_file_name(fname, name, iter, n_pieces);
+	VtuOutputEngine vtu(fname, n_pieces);
+	vtu.out(fn, name);
+}
+
+// Solution output for three solution components.
+void out_fn_vtu(MeshFunction *x, MeshFunction *y, MeshFunction *z, const char *name, int iter, int n_pieces)
+{
+	char fname[1024];
+	vtu_file_name(fname, name, iter, n_pieces);
+	VtuOutputEngine vtu(fname, n_pieces);
+	vtu.out(x, y, z, name);
+}
+
+// Mesh output.
+void out_mesh_vtu(Mesh *mesh, const char *name, int iter, int n_pieces)
+{
+	char fname[1024];
+	vtu_file_name(fname, name, iter, n_pieces);
+	VtuOutputEngine vtu(fname, n_pieces);
+	vtu.out(mesh);
+}
@@ -0,0 +1,68 @@
+// This file is part of Hermes3D
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes3D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes3D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _VTU_OUTPUT_ENGINE_H_
+#define _VTU_OUTPUT_ENGINE_H_
+
+#include "../output.h"
+
+/// VTU output engine.
+///
+/// Writes the XML unstructured grid format of VTK (.vtu) with the data appended as raw
+/// binary. Elements are linearized with output point patterns that are calculated only
+/// once for every (mode, order) pair, and the points are not merged across elements, so
+/// the geometry and connectivity of the elements are built in parallel (OpenMP).
+///
+/// If more than one piece is requested, every piece is written into its own .vtu file
+/// (in parallel) and the file passed to the constructor becomes a .pvtu index of them.
+///
+/// @ingroup visualization
+class HERMES_API VtuOutputEngine : public OutputEngine {
+public:
+	/// @param[in] file_name - name of the output file (.vtu for one piece, .pvtu otherwise)
+	/// @param[in] n_pieces - number of pieces to write, 0 means one piece per thread
+	VtuOutputEngine(const char *file_name, int n_pieces = 1);
+	virtual ~VtuOutputEngine();
+
+	/// Run the output with specified output engine
+	///
+	/// @param[in] fn A function that will be visualized
+	virtual void out(MeshFunction *fn, const char *name, int item = FN_VAL);
+	virtual void out(MeshFunction *fn1, MeshFunction *fn2, MeshFunction *fn3, const char *name, int item = FN_VAL_0);
+	virtual void out(Mesh *mesh);
+
+	/// @return the number of pieces that will be written
+	int get_num_pieces() const;
+
+protected:
+	/// name of the output file
+	char *file_name;
+	/// number of requested pieces
+	int n_pieces;
+};
+
+/// Functions facilitating output in the binary VTU format (displayable by e.g. Paraview).
+// Solution output for one solution component.
+void HERMES_API out_fn_vtu(MeshFunction *fn, const char *name, int iter = -1, int n_pieces = 1);
+// Solution output for three solution components.
+void HERMES_API out_fn_vtu(MeshFunction *x, MeshFunction *y, MeshFunction *z, const char *name, int iter = -1, int n_pieces = 1);
+// Mesh output.
+void HERMES_API out_mesh_vtu(Mesh *mesh, const char *name, int iter = -1, int n_pieces = 1);
+
+#endif
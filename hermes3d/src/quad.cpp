@@ -0,0 +1,97 @@
+// This file is part of Hermes3D
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes3D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes3D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+
+#include "h3d_common.h"
+#include "quad.h"
+
+#include "../../hermes_common/error.h"
+#include "../../hermes_common/callstack.h"
+
+//// Quad3D ////////////////////////////////////////////////////////////////////////////////////////
+
+Quad3D::Quad3D() {
+	_F_
+	tables = new QuadPt3D *[H3D_QUAD_NUM_SLOTS];
+	MEM_CHECK(tables);
+	memset(tables, 0, H3D_QUAD_NUM_SLOTS * sizeof(QuadPt3D *));
+	np = new int[H3D_QUAD_NUM_SLOTS];
+	MEM_CHECK(np);
+	memset(np, 0, H3D_QUAD_NUM_SLOTS * sizeof(int));
+
+	for (int edge = 0; edge < H3D_QUAD_MAX_EDGES; edge++) {
+		edge_tables[edge] = new QuadPt3D *[H3D_QUAD_NUM_EDGE_SLOTS];
+		MEM_CHECK(edge_tables[edge]);
+		memset(edge_tables[edge], 0, H3D_QUAD_NUM_EDGE_SLOTS * sizeof(QuadPt3D *));
+	}
+	np_edge = new int[H3D_QUAD_NUM_EDGE_SLOTS];
+	MEM_CHECK(np_edge);
+	memset(np_edge, 0, H3D_QUAD_NUM_EDGE_SLOTS * sizeof(int));
+
+	for (int face = 0; face < H3D_QUAD_MAX_FACES; face++) {
+		face_tables[face] = new QuadPt3D *[H3D_QUAD_NUM_FACE_SLOTS];
+		MEM_CHECK(face_tables[face]);
+		memset(face_tables[face], 0, H3D_QUAD_NUM_FACE_SLOTS * sizeof(QuadPt3D *));
+	}
+	np_face = new int[H3D_QUAD_NUM_FACE_SLOTS];
+	MEM_CHECK(np_face);
+	memset(np_face, 0, H3D_QUAD_NUM_FACE_SLOTS * sizeof(int));
+
+	vertex_table = NULL;
+	np_vertex = 0;
+}
+
+Quad3D::~Quad3D() {
+	for (int i = 0; i < H3D_QUAD_NUM_SLOTS; i++)
+		delete [] tables[i];
+	delete [] tables;
+	delete [] np;
+
+	for (int edge = 0; edge < H3D_QUAD_MAX_EDGES; edge++) {
+		for (int i = 0; i < H3D_QUAD_NUM_EDGE_SLOTS; i++)
+			delete [] edge_tables[edge][i];
+		delete [] edge_tables[edge];
+	}
+	delete [] np_edge;
+
+	for (int face = 0; face < H3D_QUAD_MAX_FACES; face++) {
+		for (int i = 0; i < H3D_QUAD_NUM_FACE_SLOTS; i++)
+			delete [] face_tables[face][i];
+		delete [] face_tables[face];
+	}
+	delete [] np_face;
+
+	delete [] vertex_table;
+}
+
+QuadPt3D *Quad3D::publish_table(QuadPt3D *&table, QuadPt3D *pt) {
+	_F_
+	// the table is filled before it becomes visible to other threads
+#ifdef _OPENMP
+#pragma omp critical (quad_3d_tables)
+#endif
+	{
+		if (table == NULL) {
+			table = pt;
+			pt = NULL;
+		}
+	}
+	delete [] pt;
+	return table;
+}
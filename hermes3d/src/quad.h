@@ -173,31 +173,36 @@ protected:
 
 #define CHECK_MODE assert(order.type == mode)
 
+/// Number of slots in the flat tables of Quad3D. An order is stored in the slot given by
+/// its index (Ord3::get_idx(), Ord2::get_idx()) without the mode bits.
+#define H3D_QUAD_NUM_SLOTS					(1 << 15)
+#define H3D_QUAD_NUM_FACE_SLOTS				(1 << 10)
+#define H3D_QUAD_NUM_EDGE_SLOTS				(H3D_MAX_QUAD_ORDER + 1)
+
+/// Maximal number of edges and faces of an element (hex)
+#define H3D_QUAD_MAX_EDGES					12
+#define H3D_QUAD_MAX_FACES					6
+
 /// Numerical quadratures in 3D
 ///
+/// The points are kept in flat tables indexed by the encoded order (see get_slot()), so
+/// the access is a plain array lookup. Tables that are generated on demand (like in QuadStdHex)
+/// are published only when they are complete, so the tables can be read by more threads.
+///
 /// @ingroup quadratures
 class HERMES_API Quad3D {
 public:
-  Quad3D() {
-    tables = new std::map<unsigned int, QuadPt3D *>;
-    edge_tables = new std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>;
-    face_tables = new std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>;
-	  np = new std::map<unsigned int, int>;
-	  np_edge = new std::map<unsigned int, int>;
-	  np_face = new std::map<unsigned int, int>;
-  }
-	virtual ~Quad3D() {
-    
-  }
-
-	virtual QuadPt3D *get_points(const Ord3 &order) { CHECK_MODE; return (*tables)[order.get_idx()]; }
-	virtual int get_num_points(const Ord3 &order) { CHECK_MODE; return (*np)[order.get_idx()]; }
-
-	virtual QuadPt3D *get_edge_points(int edge, const Ord1 &order) { return (*(*edge_tables)[edge])[order]; }
-  int get_edge_num_points(int edge, const Ord1 &order) const { return (*np_edge).at(order); }
-
-	virtual QuadPt3D *get_face_points(int face, const Ord2 &order) { return (*(*face_tables)[face])[order.get_idx()]; }
-  int get_face_num_points(int face, const Ord2 &order) const { return (*np_face).at(order.get_idx()); }
+	Quad3D();
+	virtual ~Quad3D();
+
+	virtual QuadPt3D *get_points(const Ord3 &order) { CHECK_MODE; return tables[get_slot(order)]; }
+	virtual int get_num_points(const Ord3 &order) { CHECK_MODE; return np[get_slot(order)]; }
+
+	virtual QuadPt3D *get_edge_points(int edge, const Ord1 &order) { assert(order < H3D_QUAD_NUM_EDGE_SLOTS); return edge_tables[edge][order]; }
+	int get_edge_num_points(int edge, const Ord1 &order) const { assert(order < H3D_QUAD_NUM_EDGE_SLOTS); return np_edge[order]; }
+
+	virtual QuadPt3D *get_face_points(int face, const Ord2 &order) { return face_tables[face][get_face_slot(order)]; }
+	int get_face_num_points(int face, const Ord2 &order) const { return np_face[get_face_slot(order)]; }
 
 	virtual QuadPt3D *get_vertex_points() { return vertex_table; }
 	int get_vertex_num_points() const { return np_vertex; }
@@ -216,14 +221,32 @@ protected:
 	Ord2 max_face_order;
 	Ord3 max_order;
 
-	std::map<unsigned int, QuadPt3D *>* tables;
-	std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*> *edge_tables;
-	std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*> *face_tables;
+	/// tables with integration points
+	/// indexing: [slot][point no.]
+	QuadPt3D **tables;
+	/// tables with integration points on edges
+	/// indexing: [edge][order][point no.]
+	QuadPt3D **edge_tables[H3D_QUAD_MAX_EDGES];
+	/// tables with integration points on faces
+	/// indexing: [face][face slot][point no.]
+	QuadPt3D **face_tables[H3D_QUAD_MAX_FACES];
 	QuadPt3D *vertex_table;
-	std::map<unsigned int, int> *np;
-	std::map<unsigned int, int> *np_edge;
-	std::map<unsigned int, int> *np_face;
+	/// number of integration points
+	/// indexing: [slot], [order] for edges, [face slot] for faces
+	int *np;
+	int *np_edge;
+	int *np_face;
 	int np_vertex;
+
+	/// @return the slot of the element order 'order' in the tables
+	static int get_slot(const Ord3 &order) { return order.get_idx() & (H3D_QUAD_NUM_SLOTS - 1); }
+	/// @return the slot of the face order 'order' in the face tables
+	static int get_face_slot(const Ord2 &order) { return order.get_idx() & (H3D_QUAD_NUM_FACE_SLOTS - 1); }
+
+	/// Store the table 'pt' into 'table' unless some other thread was faster. In that case 'pt'
+	/// is deleted.
+	/// @return the stored table
+	static QuadPt3D *publish_table(QuadPt3D *&table, QuadPt3D *pt);
 };
 
 
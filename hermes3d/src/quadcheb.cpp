@@ -39,17 +39,15 @@ QuadChebTetra::QuadChebTetra() {
 
 	QuadPt3D *pt;
 	for (int o = 0; o < 10; o++) {
-		Ord3 ord(o);
-		int idx = ord.get_idx();
-		(*np)[idx] = (o + 1) * (o + 2) * (o + 3) / 6;
-    if((*tables)[idx] != NULL)
-      delete [] (*tables)[idx];
-		(*tables)[idx] = pt = new QuadPt3D[(*np)[idx]];
+		int slot = get_slot(Ord3(o));
+		np[slot] = (o + 1) * (o + 2) * (o + 3) / 6;
+		tables[slot] = pt = new QuadPt3D[np[slot]];
+		MEM_CHECK(pt);
 
 		for (int i = o, m = 0; i >= 0; i--)				// z
 			for (int j = o; j >= o - i; j--)			// y
 				for (int k = o; k >= o - j + o - i; k--, m++) {	// x
-					assert(m < (*np)[idx]);
+					assert(m < np[slot]);
 					pt[m].x = o ? cos(k * M_PI / o) : 1.0;
 					pt[m].y = o ? cos(j * M_PI / o) : 1.0;
 					pt[m].z = o ? cos(i * M_PI / o) : 1.0;
@@ -61,26 +59,6 @@ QuadChebTetra::QuadChebTetra() {
 
 QuadChebTetra::~QuadChebTetra() {
 	_F_
-  for(std::map<unsigned int, QuadPt3D *>::iterator it = tables->begin(); it != tables->end(); it++)
-    delete [] it->second;
-  for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = edge_tables->begin(); it != edge_tables->end(); it++) {
-    for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-      delete [] it_inner->second;
-    delete it->second;
-  }
-  for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = face_tables->begin(); it != face_tables->end(); it++) {
-    for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-      delete [] it_inner->second;
-    delete it->second;
-  }
-  if(vertex_table != NULL)
-    delete [] vertex_table;
-  np->clear();
-  delete np;
-  np_edge->clear();
-  delete np_edge;
-  np_face->clear();
-  delete np_face;
 }
 
 //// QuadChebHex  /////////////////////////////////////////////////////////////////////////////////
@@ -97,46 +75,21 @@ QuadChebHex::QuadChebHex() {
 	int i, j, k;
 	for (i = 0; i <= 10; i++)
 		for (j = 0; j <= 10; j++)
-			for (k = 0; k <= 10; k++) {
-				Ord3 o(i, j, k);
-				(*np)[o.get_idx()] = (i + 1) * (j + 1) * (k + 1);
-			}
+			for (k = 0; k <= 10; k++)
+				np[get_slot(Ord3(i, j, k))] = (i + 1) * (j + 1) * (k + 1);
 #endif
 }
 
 QuadChebHex::~QuadChebHex() {
 	_F_
-  for(std::map<unsigned int, QuadPt3D *>::iterator it = tables->begin(); it != tables->end(); it++)
-    delete [] it->second;
-  for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = edge_tables->begin(); it != edge_tables->end(); it++) {
-    for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-      delete [] it_inner->second;
-    delete it->second;
-  }
-  for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = face_tables->begin(); it != face_tables->end(); it++) {
-    for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-      delete [] it_inner->second;
-    delete it->second;
-  }
-  if(vertex_table != NULL)
-    delete [] vertex_table;
-  np->clear();
-  delete np;
-  np_edge->clear();
-  delete np_edge;
-  np_face->clear();
-  delete np_face;
 }
 
-void QuadChebHex::calc_table(const Ord3 &order) {
+QuadPt3D *QuadChebHex::calc_table(const Ord3 &order) {
 	_F_
 #ifdef WITH_HEX
-	QuadPt3D *pt;
-
-	int idx = order.get_idx();
-  if((*tables)[idx] != NULL)
-    delete [] (*tables)[idx];
-	(*tables)[idx] = pt = new QuadPt3D[(*np)[idx]];
+	int slot = get_slot(order);
+	QuadPt3D *pt = new QuadPt3D[np[slot]];
+	MEM_CHECK(pt);
 
 	for (int i = order.z, m = 0; i >= 0; i--)
 		for (int j = order.y; j >= 0; j--)
@@ -146,5 +99,9 @@ void QuadChebHex::calc_table(const Ord3 &order) {
 				pt[m].z = order.z ? cos(i * M_PI / order.z) : 1.0;
 				pt[m].w = 1.0;
 			}
+
+	return publish_table(tables[slot], pt);
+#else
+	return NULL;
 #endif
 }
@@ -43,13 +43,12 @@ public:
 	~QuadChebHex();
 
 	virtual QuadPt3D *get_points(const Ord3 &order) {
-    if (tables->find(order.get_idx()) == tables->end()) 
-      calc_table(order);
-		return (*tables)[order.get_idx()];
+		QuadPt3D *pt = tables[get_slot(order)];
+		return (pt != NULL) ? pt : calc_table(order);
 	}
 
 protected:
-	void calc_table(const Ord3 &order);
+	QuadPt3D *calc_table(const Ord3 &order);
 };
 
 #endif
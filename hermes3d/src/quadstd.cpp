@@ -4168,40 +4168,37 @@ QuadStdTetra::QuadStdTetra() {
 	max_face_order = H3D_MAX_QUAD_ORDER_TRI;
 
 	for (int i = 0; i <= H3D_MAX_QUAD_ORDER_TETRA; i++) {
-		Ord3 o(i);
-		unsigned int oi = o.get_idx();
-    tables->insert(std::make_pair(oi, std_tables_3d_tet[i]));
-		(*np)[oi] = std_np_3d_tet[i];
+		int slot = get_slot(Ord3(i));
+		np[slot] = std_np_3d_tet[i];
+		tables[slot] = new QuadPt3D[np[slot]];
+		MEM_CHECK(tables[slot]);
+		memcpy(tables[slot], std_tables_3d_tet[i], np[slot] * sizeof(QuadPt3D));
 	}
 
 	const Point3D *ref_vtcs = RefTetra::get_vertices();
 	assert(ref_vtcs != NULL);
 
 	// edge points
+	for (int order = 0; order <= H3D_MAX_QUAD_ORDER; order++)
+		np_edge[order] = std_np_1d[order];
+
 	for (int iedge = 0; iedge < Tetra::NUM_EDGES; iedge++) {
 		const int *tet_edge_vtcs = RefTetra::get_edge_vertices(iedge);
 		assert(tet_edge_vtcs != NULL);
 
 		for (int order = 0; order <= H3D_MAX_QUAD_ORDER; order++) {
-			Ord3 o(order);
-			unsigned int oi = o.get_idx();
-			int num = std_np_1d[oi];
-			(*np_edge)[oi] = num;
-
-      if((*edge_tables)[iedge] == NULL)
-        (*edge_tables)[iedge] = new std::map<unsigned int, QuadPt3D *>;
-      if((*(*edge_tables)[iedge])[oi] != NULL)
-        delete (*(*edge_tables)[iedge])[oi];
-      (*(*edge_tables)[iedge])[oi] = new QuadPt3D[num];
-
-			QuadPt1D *pts1d = std_tables_1d[oi];
+			int num = np_edge[order];
+			QuadPt3D *pt = edge_tables[iedge][order] = new QuadPt3D[num];
+			MEM_CHECK(pt);
+
+			QuadPt1D *pts1d = std_tables_1d[order];
 			for (int p = 0; p < num; p++) {
 				double t = (pts1d[p].x + 1.0) * 0.5;
 				double s = 1.0 - t;
-				(*(*edge_tables)[iedge])[oi][p].x = ref_vtcs[tet_edge_vtcs[0]].x * s + ref_vtcs[tet_edge_vtcs[1]].x * t;
-				(*(*edge_tables)[iedge])[oi][p].y = ref_vtcs[tet_edge_vtcs[0]].y * s + ref_vtcs[tet_edge_vtcs[1]].y * t;
-				(*(*edge_tables)[iedge])[oi][p].z = ref_vtcs[tet_edge_vtcs[0]].z * s + ref_vtcs[tet_edge_vtcs[1]].z * t;
-				(*(*edge_tables)[iedge])[oi][p].w = pts1d[p].w;
+				pt[p].x = ref_vtcs[tet_edge_vtcs[0]].x * s + ref_vtcs[tet_edge_vtcs[1]].x * t;
+				pt[p].y = ref_vtcs[tet_edge_vtcs[0]].y * s + ref_vtcs[tet_edge_vtcs[1]].y * t;
+				pt[p].z = ref_vtcs[tet_edge_vtcs[0]].z * s + ref_vtcs[tet_edge_vtcs[1]].z * t;
+				pt[p].w = pts1d[p].w;
 			}
 		}
 	}
@@ -4209,47 +4206,44 @@ QuadStdTetra::QuadStdTetra() {
 
 	// face points
 	for (int order = 0; order <= quad_std_tri.get_max_order(); order++) {
-		Ord3 o(order);
-		unsigned int oi = o.get_idx();
+		int slot = get_face_slot(Ord2(order));
 		int num = quad_std_tri.get_num_points(order);
-		(*np_face)[oi] = num;
+		np_face[slot] = num;
 
-    for(int i = 0; i < 4; i++) {
-      if((*face_tables)[i] == NULL)
-        (*face_tables)[i] = new std::map<unsigned int, QuadPt3D *>;
-      if((*(*face_tables)[i])[oi] != NULL)
-        delete (*(*face_tables)[i])[oi];
-      (*(*face_tables)[i])[oi] = new QuadPt3D[num];
-    }
+		QuadPt3D *pt[4];
+		for (int i = 0; i < 4; i++) {
+			pt[i] = face_tables[i][slot] = new QuadPt3D[num];
+			MEM_CHECK(pt[i]);
+		}
 
 		QuadPt2D *pts2d = quad_std_tri.get_points(order);
 		for (int p = 0; p < num; p++) {
 			// face 0
-			(*(*face_tables)[0])[oi][p].x =  pts2d[p].x;
-			(*(*face_tables)[0])[oi][p].y = -1;
-			(*(*face_tables)[0])[oi][p].z =  pts2d[p].y;
-			(*(*face_tables)[0])[oi][p].w =  pts2d[p].w;
+			pt[0][p].x =  pts2d[p].x;
+			pt[0][p].y = -1;
+			pt[0][p].z =  pts2d[p].y;
+			pt[0][p].w =  pts2d[p].w;
 
 			// face 1
-			(*(*face_tables)[1])[oi][p].x =
+			pt[1][p].x =
 				 lambda2(pts2d[p].x, pts2d[p].y, -1.0) - lambda1(pts2d[p].x, pts2d[p].y, -1.0) - lambda0(pts2d[p].x, pts2d[p].y, -1.0);
-			(*(*face_tables)[1])[oi][p].y =
+			pt[1][p].y =
 				- lambda2(pts2d[p].x, pts2d[p].y, -1.0) + lambda1(pts2d[p].x, pts2d[p].y, -1.0) - lambda0(pts2d[p].x, pts2d[p].y, -1.0);
-			(*(*face_tables)[1])[oi][p].z =
+			pt[1][p].z =
 				- lambda2(pts2d[p].x, pts2d[p].y, -1.0) - lambda1(pts2d[p].x, pts2d[p].y, -1.0) + lambda0(pts2d[p].x, pts2d[p].y, -1.0);
-			(*(*face_tables)[1])[oi][p].w =  sqrt(3.0) * pts2d[p].w;
+			pt[1][p].w =  sqrt(3.0) * pts2d[p].w;
 
 			// face 2
-			(*(*face_tables)[2])[oi][p].x = -1;
-			(*(*face_tables)[2])[oi][p].y =  pts2d[p].x;
-			(*(*face_tables)[2])[oi][p].z =  pts2d[p].y;
-			(*(*face_tables)[2])[oi][p].w =  pts2d[p].w;
+			pt[2][p].x = -1;
+			pt[2][p].y =  pts2d[p].x;
+			pt[2][p].z =  pts2d[p].y;
+			pt[2][p].w =  pts2d[p].w;
 
 			// face 3
-			(*(*face_tables)[3])[oi][p].x =  pts2d[p].x;
-			(*(*face_tables)[3])[oi][p].y =  pts2d[p].y;
-			(*(*face_tables)[3])[oi][p].z = -1;
-			(*(*face_tables)[3])[oi][p].w =  pts2d[p].w;
+			pt[3][p].x =  pts2d[p].x;
+			pt[3][p].y =  pts2d[p].y;
+			pt[3][p].z = -1;
+			pt[3][p].w =  pts2d[p].w;
 		}
 
 	}
@@ -4271,22 +4265,6 @@ QuadStdTetra::QuadStdTetra() {
 
 QuadStdTetra::~QuadStdTetra() {
 	_F_
-  for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = edge_tables->begin(); it != edge_tables->end(); it++) {
-    for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-      delete [] it_inner->second;
-    delete it->second;
-  }
-  for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = face_tables->begin(); it != face_tables->end(); it++) {
-    for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-      delete [] it_inner->second;
-    delete it->second;
-  }
-  if(vertex_table != NULL)
-    delete [] vertex_table;
-  np_edge->clear();
-  delete np_edge;
-  np_face->clear();
-  delete np_face;
 }
 
 // QuadStdHex /////////////////////////////////////////////////////////////////
@@ -4300,25 +4278,20 @@ QuadStdHex::QuadStdHex() {
 	max_face_order = Ord2(H3D_MAX_QUAD_ORDER, H3D_MAX_QUAD_ORDER);
 	max_order = Ord3(H3D_MAX_QUAD_ORDER, H3D_MAX_QUAD_ORDER, H3D_MAX_QUAD_ORDER);
 
-	// element points
+	// element points (the tables are generated on demand)
 	for (int i = 0; i <= H3D_MAX_QUAD_ORDER; i++)
 		for (int j = 0; j <= H3D_MAX_QUAD_ORDER; j++)
-			for (int k = 0; k <= H3D_MAX_QUAD_ORDER; k++) {
-				Ord3 m(i, j, k);
-				(*np)[m.get_idx()] = std_np_1d[i] * std_np_1d[j] * std_np_1d[k];
-			}
+			for (int k = 0; k <= H3D_MAX_QUAD_ORDER; k++)
+				np[get_slot(Ord3(i, j, k))] = std_np_1d[i] * std_np_1d[j] * std_np_1d[k];
 
 	// faces
 	for (int i = 0; i <= H3D_MAX_QUAD_ORDER; i++)
-		for (int j = 0; j <= H3D_MAX_QUAD_ORDER; j++) {
-			Ord2 m(i, j);
-			(*np_face)[m.get_idx()] = std_np_1d[i] * std_np_1d[j];
-//			if (i ==24 && j==24) printf("AAA = %d\n", m.get_idx());
-		}
+		for (int j = 0; j <= H3D_MAX_QUAD_ORDER; j++)
+			np_face[get_face_slot(Ord2(i, j))] = std_np_1d[i] * std_np_1d[j];
 
 	// edges
 	for (int order = 0; order <= H3D_MAX_QUAD_ORDER; order++)
-		(*np_edge)[order] = std_np_1d[order];
+		np_edge[order] = std_np_1d[order];
 
 	const Point3D *ref_vtcs = RefHex::get_vertices();
 	assert(ref_vtcs != NULL);
@@ -4327,19 +4300,16 @@ QuadStdHex::QuadStdHex() {
 		const int *hex_edge_vtcs = RefHex::get_edge_vertices(iedge);
 		assert(hex_edge_vtcs != NULL);
 		for (int order = 0; order <= H3D_MAX_QUAD_ORDER; order++) {
-      if((*edge_tables)[iedge] == NULL)
-        (*edge_tables)[iedge] = new std::map<unsigned int, QuadPt3D *>;
-      if((*(*edge_tables)[iedge])[order] != NULL)
-        delete (*(*edge_tables)[iedge])[order];
-      (*(*edge_tables)[iedge])[order] = new QuadPt3D[(*np_edge)[order]];
+			QuadPt3D *pt = edge_tables[iedge][order] = new QuadPt3D[np_edge[order]];
+			MEM_CHECK(pt);
 			QuadPt1D *pts1d = std_tables_1d[order];
-			for (int p = 0; p < (*np_edge)[order]; p++) {
+			for (int p = 0; p < np_edge[order]; p++) {
 				double t = (pts1d[p].x + 1.0) * 0.5;
 				double s = 1.0 - t;
-				(*(*edge_tables)[iedge])[order][p].x = ref_vtcs[hex_edge_vtcs[0]].x * s + ref_vtcs[hex_edge_vtcs[1]].x * t;
-				(*(*edge_tables)[iedge])[order][p].y = ref_vtcs[hex_edge_vtcs[0]].y * s + ref_vtcs[hex_edge_vtcs[1]].y * t;
-				(*(*edge_tables)[iedge])[order][p].z = ref_vtcs[hex_edge_vtcs[0]].z * s + ref_vtcs[hex_edge_vtcs[1]].z * t;
-				(*(*edge_tables)[iedge])[order][p].w = pts1d[p].w;
+				pt[p].x = ref_vtcs[hex_edge_vtcs[0]].x * s + ref_vtcs[hex_edge_vtcs[1]].x * t;
+				pt[p].y = ref_vtcs[hex_edge_vtcs[0]].y * s + ref_vtcs[hex_edge_vtcs[1]].y * t;
+				pt[p].z = ref_vtcs[hex_edge_vtcs[0]].z * s + ref_vtcs[hex_edge_vtcs[1]].z * t;
+				pt[p].w = pts1d[p].w;
 			}
 		}
 	}
@@ -4360,61 +4330,53 @@ QuadStdHex::QuadStdHex() {
 
 QuadStdHex::~QuadStdHex() {
 	_F_
-	for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = edge_tables->begin(); it != edge_tables->end(); it++) {
-    for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-      delete [] it_inner->second;
-    delete it->second;
-  }
-  if(vertex_table != NULL)
-    delete [] vertex_table;
 }
 
-void QuadStdHex::calc_table(const Ord3 &order) {
+QuadPt3D *QuadStdHex::calc_table(const Ord3 &order) {
 	_F_
 #ifdef WITH_HEX
 	assert(order.type == mode);
-	int idx = order.get_idx();
-	if((*tables)[idx] != NULL)
-    delete (*tables)[idx];
-  (*tables)[idx] = new QuadPt3D[(*np)[idx]];
-	MEM_CHECK((*tables)[idx]);
+	int slot = get_slot(order);
+	QuadPt3D *pt = new QuadPt3D[np[slot]];
+	MEM_CHECK(pt);
 
 	int i = order.x, j = order.y, o = order.z;
 	for (int k = 0, n = 0; k < std_np_1d[i]; k++) {
 		for (int l = 0; l < std_np_1d[j]; l++) {
 			for (int p = 0; p < std_np_1d[o]; p++, n++) {
-				assert(n < (*np)[idx]);
-				(*tables)[idx][n].x = std_tables_1d[i][k].x;
-				(*tables)[idx][n].y = std_tables_1d[j][l].x;
-				(*tables)[idx][n].z = std_tables_1d[o][p].x;
-				(*tables)[idx][n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w * std_tables_1d[o][p].w;
+				assert(n < np[slot]);
+				pt[n].x = std_tables_1d[i][k].x;
+				pt[n].y = std_tables_1d[j][l].x;
+				pt[n].z = std_tables_1d[o][p].x;
+				pt[n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w * std_tables_1d[o][p].w;
 			}
 		}
 	}
+
+	return publish_table(tables[slot], pt);
+#else
+	return NULL;
 #endif
 }
 
-void QuadStdHex::calc_face_table(int face, const Ord2 &order) {
+QuadPt3D *QuadStdHex::calc_face_table(int face, const Ord2 &order) {
 	_F_
 #ifdef WITH_HEX
-	int idx = order.get_idx();
-  if((*face_tables)[face] == NULL)
-    (*face_tables)[face] = new std::map<unsigned int, QuadPt3D *>;
-  if((*(*face_tables)[face])[idx] != NULL)
-    delete (*(*face_tables)[face])[idx];
-  (*(*face_tables)[face])[idx] = new QuadPt3D[(*np_face)[idx]];
-	
+	int slot = get_face_slot(order);
+	QuadPt3D *pt = new QuadPt3D[np_face[slot]];
+	MEM_CHECK(pt);
+
 	int i = order.x, j = order.y;
 	switch (face) {
 		case 0:
 		case 1:
 			for (int k = 0, n = 0; k < std_np_1d[i]; k++) {
 				for (int l = 0; l < std_np_1d[j]; l++, n++) {
-					assert(n < (*np_face)[idx]);
-					(*(*face_tables)[face])[idx][n].x = (face == 0) ? -1 : 1;
-					(*(*face_tables)[face])[idx][n].y = std_tables_1d[i][k].x;
-					(*(*face_tables)[face])[idx][n].z = std_tables_1d[j][l].x;
-					(*(*face_tables)[face])[idx][n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w;
+					assert(n < np_face[slot]);
+					pt[n].x = (face == 0) ? -1 : 1;
+					pt[n].y = std_tables_1d[i][k].x;
+					pt[n].z = std_tables_1d[j][l].x;
+					pt[n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w;
 				}
 			}
 			break;
@@ -4423,11 +4385,11 @@ void QuadStdHex::calc_face_table(int face, const Ord2 &order) {
 		case 3:
 			for (int k = 0, n = 0; k < std_np_1d[i]; k++) {
 				for (int l = 0; l < std_np_1d[j]; l++, n++) {
-					assert(n < (*np_face)[idx]);
-					(*(*face_tables)[face])[idx][n].x = std_tables_1d[i][k].x;
-					(*(*face_tables)[face])[idx][n].y = (face == 2) ? -1 : 1;
-					(*(*face_tables)[face])[idx][n].z = std_tables_1d[j][l].x;
-					(*(*face_tables)[face])[idx][n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w;
+					assert(n < np_face[slot]);
+					pt[n].x = std_tables_1d[i][k].x;
+					pt[n].y = (face == 2) ? -1 : 1;
+					pt[n].z = std_tables_1d[j][l].x;
+					pt[n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w;
 				}
 			}
 			break;
@@ -4436,11 +4398,11 @@ void QuadStdHex::calc_face_table(int face, const Ord2 &order) {
 		case 5:
 			for (int k = 0, n = 0; k < std_np_1d[i]; k++) {
 				for (int l = 0; l < std_np_1d[j]; l++, n++) {
-					assert(n < (*np_face)[idx]);
-					(*(*face_tables)[face])[idx][n].x = std_tables_1d[i][k].x;
-					(*(*face_tables)[face])[idx][n].y = std_tables_1d[j][l].x;
-					(*(*face_tables)[face])[idx][n].z = (face == 4) ? -1 : 1;
-					(*(*face_tables)[face])[idx][n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w;
+					assert(n < np_face[slot]);
+					pt[n].x = std_tables_1d[i][k].x;
+					pt[n].y = std_tables_1d[j][l].x;
+					pt[n].z = (face == 4) ? -1 : 1;
+					pt[n].w = std_tables_1d[i][k].w * std_tables_1d[j][l].w;
 				}
 			}
 			break;
@@ -4449,6 +4411,10 @@ void QuadStdHex::calc_face_table(int face, const Ord2 &order) {
 			EXIT("Invalid face number %d. Can be 0 - 5.", face);
 			break;
 	}
+
+	return publish_table(face_tables[face][slot], pt);
+#else
+	return NULL;
 #endif
 }
 
@@ -4480,8 +4446,6 @@ QuadStdPrism::QuadStdPrism() {
 	// FIXME: some faces have triangles, some have quads
 	max_face_order = MAKE_QUAD_ORDER(H3D_MAX_QUAD_ORDER, H3D_MAX_QUAD_ORDER);
 
-	int num = max_order + 1;
-
 	// number of integration points
 	for (int i = 0; i <= H3D_MAX_QUAD_ORDER_TRI; i++) {
 		for (int j = 0; j <= H3D_MAX_QUAD_ORDER; j++) {
@@ -4490,7 +4454,6 @@ QuadStdPrism::QuadStdPrism() {
 	}
 
 	// tables with points
-	memset(tables, 0, num * sizeof(QuadPt3D *));
 	for (int i = 0; i <= H3D_MAX_QUAD_ORDER_TRI; i++) {
 		for (int j = 0; j <= H3D_MAX_QUAD_ORDER; j++) {
 			int m = MAKE_PRISM_ORDER(i, j);
@@ -4512,12 +4475,8 @@ QuadStdPrism::QuadStdPrism() {
 
 
 	// TODO: edge tables
-	(*edge_tables) = NULL;
-	(*np_edge) = NULL;
 
 	// TODO: face tables
-	(*face_tables) = NULL;
-	(*np_face) = NULL;
 #endif
 }
 
@@ -52,22 +52,19 @@ public:
 
 	virtual QuadPt3D *get_points(const Ord3 &order) {
 		CHECK_MODE;
-		if ((*tables)[order.get_idx()] == NULL) 
-      calc_table(order);
-		return (*tables)[order.get_idx()];
+		QuadPt3D *pt = tables[get_slot(order)];
+		return (pt != NULL) ? pt : calc_table(order);
 	}
 
 	virtual QuadPt3D *get_face_points(int face, const Ord2 &order) {
-		if ((*face_tables)[face] == NULL)
-      (*face_tables)[face] = new std::map<unsigned int, QuadPt3D *>;
-    if((*(*face_tables)[face])[order.get_idx()] == NULL) 
-      calc_face_table(face, order);
-		return (*(*face_tables)[face])[order.get_idx()];
+		QuadPt3D *pt = face_tables[face][get_face_slot(order)];
+		return (pt != NULL) ? pt : calc_face_table(face, order);
 	}
 
 protected:
-	void calc_table(const Ord3 &order);
-	void calc_face_table(int face, const Ord2 &order);
+	/// generate the tensor-product rule of order 'order' from the 1D Gauss rules
+	QuadPt3D *calc_table(const Ord3 &order);
+	QuadPt3D *calc_face_table(int face, const Ord2 &order);
 	///
 	Ord3 lower_order_same_accuracy(const Ord3 &ord);
 };
@@ -28,6 +28,9 @@
 #include "shapeset/common.h"
 #include "shapeset/refmapss.h"
 #include "determinant.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 //
 
@@ -54,6 +57,38 @@
 // TODO: prisms
 
 static ShapeFunction *ref_map_pss[] = { H3D_REFMAP_PSS_TETRA, H3D_REFMAP_PSS_HEX, NULL };
+static Shapeset *ref_map_shapeset[] = { H3D_REFMAP_SHAPESET_TETRA, H3D_REFMAP_SHAPESET_HEX, NULL };
+
+#ifdef _OPENMP
+// The shape functions above keep the active element, so the worker threads of a parallel
+// region get their own copies (allocated on the first use and kept for the thread's lifetime).
+static ShapeFunction *thread_ref_map_pss[] = { NULL, NULL, NULL };
+#pragma omp threadprivate(thread_ref_map_pss)
+
+// The copies of all threads, they are freed at exit.
+static struct ThreadRefMapPssList {
+	std::vector<ShapeFunction *> pss;
+	~ThreadRefMapPssList() {
+		for (unsigned int i = 0; i < pss.size(); i++)
+			delete pss[i];
+	}
+} thread_ref_map_pss_list;
+#endif
+
+static ShapeFunction *get_ref_map_pss(ElementMode3D mode) {
+#ifdef _OPENMP
+	if (omp_in_parallel() && omp_get_thread_num() > 0) {
+		if (thread_ref_map_pss[mode] == NULL) {
+			thread_ref_map_pss[mode] = new ShapeFunction(ref_map_shapeset[mode]);
+			MEM_CHECK(thread_ref_map_pss[mode]);
+#pragma omp critical (thread_ref_map_pss)
+			thread_ref_map_pss_list.pss.push_back(thread_ref_map_pss[mode]);
+		}
+		return thread_ref_map_pss[mode];
+	}
+#endif
+	return ref_map_pss[mode];
+}
 
 // RefMap /////////////////////////////////////////////////////////////////////////////////////////
 
@@ -79,7 +114,7 @@ void RefMap::set_active_element(Element *e) {
 
 	ElementMode3D mode = e->get_mode();
 
-	pss = ref_map_pss[mode];
+	pss = get_ref_map_pss(mode);
 	pss->set_active_element(e);
 
 	if (e == element) return;
@@ -48,6 +48,10 @@ void ShapeFunction::set_active_shape(int index) {
 	free_cur_node();
 	this->index = index;
 	this->order = shapeset->get_order(index);
+#ifdef _OPENMP
+#pragma omp critical (shape_tables)
+#endif
+	slot = shapeset->get_shape_slot(index);
 }
 
 
@@ -92,22 +96,28 @@ void ShapeFunction::precalculate(const int np, const QuadPt3D *pt, int mask) {
 	int newmask = mask | oldmask;
 	Node *node = new_node(newmask, np);
 
-	// precalculate all required tables
-	for (int ic = 0; ic < num_components; ic++) {
-		for (int j = 0; j < VALUE_TYPES; j++) {
-			if (newmask & idx2mask[j][ic]) {
-				// transform quadrature points
-				QuadPt3D *trans_pt = new QuadPt3D[np];
-				for (int k = 0; k < np; k++) {
-					trans_pt[k].x = ctm->m[0] * pt[k].x + ctm->t[0];
-					trans_pt[k].y = ctm->m[1] * pt[k].y + ctm->t[1];
-					trans_pt[k].z = ctm->m[2] * pt[k].z + ctm->t[2];
-				}
-				shapeset->get_values(j, index, np, trans_pt, ic, node->values[ic][j]);
-        delete [] trans_pt;
+	// transform quadrature points
+	QuadPt3D *trans_pt = new QuadPt3D[np];
+	for (int k = 0; k < np; k++) {
+		trans_pt[k].x = ctm->m[0] * pt[k].x + ctm->t[0];
+		trans_pt[k].y = ctm->m[1] * pt[k].y + ctm->t[1];
+		trans_pt[k].z = ctm->m[2] * pt[k].z + ctm->t[2];
+	}
+
+	// copy all required rows of the table shared by the users of the shapeset
+#ifdef _OPENMP
+#pragma omp critical (shape_tables)
+#endif
+	{
+		ShapeTable *tab = shapeset->get_table(np, trans_pt);
+		for (int ic = 0; ic < num_components; ic++) {
+			for (int j = 0; j < VALUE_TYPES; j++) {
+				if (newmask & idx2mask[j][ic])
+					memcpy(node->values[ic][j], tab->get_row(j, slot, index, ic), np * sizeof(double));
 			}
 		}
 	}
+	delete [] trans_pt;
 
 	replace_cur_node(node);
 }
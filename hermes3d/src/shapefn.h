@@ -22,6 +22,7 @@
 
 #include "function.h"
 #include "shapeset/shapeset.h"
+#include "shapeset/shapetab.h"
 
 // Represents a shape function on a ref. domain
 //
@@ -67,6 +68,7 @@ public:
 protected:
 	Shapeset *shapeset;
 	int index;					/// index of active shape function
+	int slot;					/// row of the active shape function in the tables of the shapeset
 
 	/// Forces a transform without using push_transform() etc.
 	/// Used by the Solution class. <b>For internal use only</b>.
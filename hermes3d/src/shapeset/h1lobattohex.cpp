@@ -23,6 +23,7 @@
 
 #include "lobatto.h"
 #include "h1lobattohex.h"
+#include "shapetab.h"
 #include "../../../hermes_common/error.h"
 #include "../../../hermes_common/matrix.h"
 #include "../../../hermes_common/callstack.h"
@@ -258,6 +259,39 @@ H1ShapesetLobattoHex::~H1ShapesetLobattoHex() {
 #endif
 }
 
+void H1ShapesetLobattoHex::get_tab_values(int n, int index, ShapeTable *tab, int component, double *vals) {
+	_F_
+#ifdef WITH_HEX
+	if (index >= 0 && n >= FN && n <= DZ) {
+		// the same products as calc_*_values() do, but of the 1D values tabulated in 'tab'
+		h1_hex_index_t idx(index);
+		int indices[3];
+		int oris[3];
+
+		decompose(idx, indices, oris);
+
+		double *f[3];
+		for (int i = 0; i < 3; i++) {
+			shape_fn_1d_t *tab_1d = lobatto_fn_tab_1d;
+			if (n == DX + i) {
+				assert((oris[i] == 0) || (indices[i] >= 2));
+				tab_1d = lobatto_der_tab_1d;
+			}
+			f[i] = tab->get_1d_values(tab_1d, indices[i], i, oris[i]);
+		}
+
+		int np = tab->get_num_points();
+		for (int k = 0; k < np; k++)
+			vals[k] = f[0][k] * f[1][k] * f[2][k];
+		if (n != FN && oris[n - DX] == 1)
+			for (int k = 0; k < np; k++)
+				vals[k] = -vals[k];
+		return;
+	}
+#endif
+	Shapeset::get_tab_values(n, index, tab, component, vals);
+}
+
 Ord3 H1ShapesetLobattoHex::get_order(int index) const {
 	_F_
 #ifdef WITH_HEX
@@ -84,6 +84,8 @@ public:
 		else get_constrained_values(n, index, np, pt, component, vals);
 	}
 
+	virtual void get_tab_values(int n, int index, ShapeTable *tab, int component, double *vals);
+
 	virtual double get_value(int n, int index, double x, double y, double z, int component) {
 		QuadPt3D one(x, y, z, 1.0);
 		double val = 0.0;
@@ -18,6 +18,7 @@
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 
 #include "shapeset.h"
+#include "shapetab.h"
 #include "refdomain.h"
 #include "../../../hermes_common/error.h"
 #include "../../../hermes_common/trace.h"
@@ -130,6 +131,8 @@ Shapeset::Shapeset(int id) : id(id)
 	mode = 0;
 	ced_idx = -1;
 	num_components = -1;
+	memset(tables, 0, sizeof(tables));
+	next_table = 0;
 
 #ifdef PRELOADING
 	fn_prods = NULL;
@@ -148,6 +151,7 @@ Shapeset::~Shapeset() {
 	delete [] dz_prods;
 #endif
 	free_constrained_combinations();
+	free_tables();
 }
 
 int Shapeset::get_constrained_edge_index(int edge, int ori, Ord1 order, Part part) {
@@ -262,6 +266,64 @@ void Shapeset::get_constrained_values(int n, int index, int np, QuadPt3D *pt, in
   delete [] tmp;
 }
 
+void Shapeset::get_tab_values(int n, int index, ShapeTable *tab, int component, double *vals) {
+	_F_
+	if (index >= 0) {
+		get_values(n, index, tab->get_num_points(), tab->get_points(), component, vals);
+		return;
+	}
+
+	// constrained function: combine the tabulated values of the unconstrained ones
+  assert(ced_key.find(-1 - index) != ced_key.end());
+	CEDKey key = ced_key[-1 - index];
+
+	CEDComb *comb = get_ced_comb(key);
+	assert(comb != NULL);
+	int *idx = get_ced_indices(key);
+	assert(idx != NULL);
+
+	int np = tab->get_num_points();
+	memset(vals, 0, np * sizeof(double));
+	for (int i = 0; i < comb->n; i++) {
+		double *tmp = tab->get_values(n, idx[i], component);
+		for (int j = 0; j < np; j++)
+			vals[j] += comb->coef[i] * tmp[j];
+	}
+}
+
+int Shapeset::get_shape_slot(int index) {
+	std::map<int, int>::iterator it = shape_slot.find(index);
+	if (it != shape_slot.end()) return it->second;
+	int slot = (int) shape_slot.size();
+	shape_slot[index] = slot;
+	return slot;
+}
+
+ShapeTable *Shapeset::get_table(int np, const QuadPt3D *pt) {
+	_F_
+	unsigned int hash = ShapeTable::hash_points(np, pt);
+	for (int i = 0; i < NUM_TABLES; i++)
+		if (tables[i] != NULL && tables[i]->matches(np, pt, hash))
+			return tables[i];
+
+	// replace the oldest table
+	ShapeTable *tab = new ShapeTable(this, np, pt);
+	MEM_CHECK(tab);
+	delete tables[next_table];
+	tables[next_table] = tab;
+	next_table = (next_table + 1) % NUM_TABLES;
+	return tab;
+}
+
+void Shapeset::free_tables() {
+	_F_
+	for (int i = 0; i < NUM_TABLES; i++) {
+		delete tables[i];
+		tables[i] = NULL;
+	}
+	next_table = 0;
+}
+
 double Shapeset::get_constrained_value(int n, int index, double x, double y, double z, int component) {
 	_F_
   assert(ced_key.find(-1 - index) != ced_key.end());
@@ -23,6 +23,8 @@
 #include "common.h"
 #include "function.h"
 
+class ShapeTable;
+
 /// @defgroup shapesets Shapesets
 ///
 /// TODO: description
@@ -273,6 +275,21 @@ public:
 	/// Evaluate function 'index' in points 'pt'
 	virtual double get_value(int n, int index, double x, double y, double z, int component) = 0;
 
+	/// Evaluate function in the points of a table (used by ShapeTable to fill itself)
+	/// The default implementation calls get_values(), tensor-product shapesets can combine the
+	/// 1D values tabulated by the table instead.
+	virtual void get_tab_values(int n, int index, ShapeTable *tab, int component, double *vals);
+
+	/// @return the dense number of the shape function 'index' (constrained ones included), the
+	/// row of the function in the tables of the shapeset
+	/// Not thread safe, ShapeFunction calls it in a critical section.
+	int get_shape_slot(int index);
+
+	/// @return the table of the values of the shape functions in the points 'pt', shared by all
+	/// users of the shapeset; the shapeset keeps the tables of the last NUM_TABLES sets of points
+	/// Not thread safe, ShapeFunction calls it in a critical section.
+	ShapeTable *get_table(int np, const QuadPt3D *pt);
+
 	inline void get_fn_values (int index, int np, QuadPt3D *pt, int component, double *vals) { get_values(FN,  index, np, pt, component, vals); }
 	inline void get_dx_values (int index, int np, QuadPt3D *pt, int component, double *vals) { get_values(DX,  index, np, pt, component, vals); }
 	inline void get_dy_values (int index, int np, QuadPt3D *pt, int component, double *vals) { get_values(DY,  index, np, pt, component, vals); }
@@ -320,6 +337,13 @@ protected:
 	CEDComb *get_ced_comb(const CEDKey &key);
 	int *get_ced_indices(const CEDKey &key);
 
+	// tabulated values
+	static const int NUM_TABLES = 16;
+	ShapeTable *tables[NUM_TABLES];
+	int next_table;								// the table to be replaced next
+	std::map<int, int> shape_slot;				// mapping: shape index => slot
+	void free_tables();
+
 #ifdef PRELOADING
 public:
 	bool load_prods(const char *file_name, double *&mat);
@@ -0,0 +1,121 @@
+// This file is part of Hermes3D
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes3D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes3D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#include "shapetab.h"
+#include "../../../hermes_common/error.h"
+#include "../../../hermes_common/callstack.h"
+
+ShapeTable::ShapeTable(Shapeset *ss, int np, const QuadPt3D *pt) {
+	_F_
+	this->ss = ss;
+	this->np = np;
+	this->pt = new QuadPt3D[np];
+	MEM_CHECK(this->pt);
+	memcpy(this->pt, pt, np * sizeof(QuadPt3D));
+	this->hash = hash_points(np, pt);
+	memset(values, 0, sizeof(values));
+	memset(filled, 0, sizeof(filled));
+	memset(capacity, 0, sizeof(capacity));
+}
+
+ShapeTable::~ShapeTable() {
+	_F_
+	for (int ic = 0; ic < COMPONENTS; ic++)
+		for (int j = 0; j < VALUE_TYPES; j++) {
+			delete [] values[ic][j];
+			delete [] filled[ic][j];
+		}
+	for (std::map<std::pair<shape_fn_1d_t *, int>, double *>::iterator it = values_1d.begin(); it != values_1d.end(); it++)
+		delete [] it->second;
+	delete [] pt;
+}
+
+unsigned int ShapeTable::hash_points(int np, const QuadPt3D *pt) {
+	// FNV-1a over the coordinates (the weights do not change the values)
+	unsigned int h = 2166136261u;
+	for (int k = 0; k < np; k++) {
+		const unsigned char *c = (const unsigned char *) &pt[k].x;
+		for (unsigned int b = 0; b < 3 * sizeof(double); b++) {
+			h ^= c[b];
+			h *= 16777619u;
+		}
+	}
+	return h;
+}
+
+bool ShapeTable::matches(int np, const QuadPt3D *pt, unsigned int hash) const {
+	if (this->np != np || this->hash != hash) return false;
+	for (int k = 0; k < np; k++)
+		if (this->pt[k].x != pt[k].x || this->pt[k].y != pt[k].y || this->pt[k].z != pt[k].z)
+			return false;
+	return true;
+}
+
+double *ShapeTable::get_values(int n, int index, int component) {
+	return get_row(n, ss->get_shape_slot(index), index, component);
+}
+
+double *ShapeTable::fill_row(int n, int slot, int index, int component) {
+	_F_
+	// evaluate first, the values of constrained functions are combined from other rows
+	// (which can reallocate the table)
+	double *vals = new double[np];
+	MEM_CHECK(vals);
+	ss->get_tab_values(n, index, this, component, vals);
+
+	int &cap = capacity[component][n];
+	if (slot >= cap) {
+		int new_cap = std::max(slot + 1, 2 * cap);
+		double *new_values = new double[new_cap * np];
+		MEM_CHECK(new_values);
+		bool *new_filled = new bool[new_cap];
+		MEM_CHECK(new_filled);
+		if (cap > 0) {
+			memcpy(new_values, values[component][n], cap * np * sizeof(double));
+			memcpy(new_filled, filled[component][n], cap * sizeof(bool));
+		}
+		memset(new_filled + cap, 0, (new_cap - cap) * sizeof(bool));
+		delete [] values[component][n];
+		delete [] filled[component][n];
+		values[component][n] = new_values;
+		filled[component][n] = new_filled;
+		cap = new_cap;
+	}
+
+	double *row = values[component][n] + slot * np;
+	memcpy(row, vals, np * sizeof(double));
+	filled[component][n][slot] = true;
+	delete [] vals;
+	return row;
+}
+
+double *ShapeTable::get_1d_values(shape_fn_1d_t *tab, int i, int dir, int ori) {
+	std::pair<shape_fn_1d_t *, int> key(tab, (i << 3) | (dir << 1) | ori);
+	std::map<std::pair<shape_fn_1d_t *, int>, double *>::iterator it = values_1d.find(key);
+	if (it != values_1d.end()) return it->second;
+
+	double *vals = new double[np];
+	MEM_CHECK(vals);
+	for (int k = 0; k < np; k++) {
+		double c = (dir == 0) ? pt[k].x : (dir == 1) ? pt[k].y : pt[k].z;
+		vals[k] = tab[i]((ori == 0) ? c : -c);
+	}
+	values_1d[key] = vals;
+	return vals;
+}
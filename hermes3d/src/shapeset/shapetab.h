@@ -0,0 +1,83 @@
+// This file is part of Hermes3D
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes3D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes3D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _SHAPESET_SHAPETAB_H_
+#define _SHAPESET_SHAPETAB_H_
+
+#include "shapeset.h"
+
+/// Tabulated values of the shape functions of one shapeset in one set of points.
+///
+/// For every component and value type the table is one contiguous array [slot][point], where
+/// 'slot' is the dense number the shapeset gives to a shape index (see
+/// Shapeset::get_shape_slot()). The row of a shape function is evaluated on the first request
+/// only. Shapesets made of products of 1D functions (like H1ShapesetLobattoHex) build the rows
+/// from tabulated 1D factors, see get_1d_values(). The tables are owned and shared by the
+/// shapeset (see Shapeset::get_table()).
+///
+/// @ingroup shapesets
+class HERMES_API ShapeTable {
+public:
+	/// @param[in] ss - the shapeset
+	/// @param[in] np - the number of points
+	/// @param[in] pt - the points (on the reference domain), the table keeps a copy of them
+	ShapeTable(Shapeset *ss, int np, const QuadPt3D *pt);
+	~ShapeTable();
+
+	int get_num_points() const { return np; }
+	QuadPt3D *get_points() const { return pt; }
+
+	/// @return the hash of the coordinates of the points (see matches())
+	static unsigned int hash_points(int np, const QuadPt3D *pt);
+
+	/// @return true if the table was built for the points 'pt' (with the hash 'hash')
+	bool matches(int np, const QuadPt3D *pt, unsigned int hash) const;
+
+	/// @return the values of type 'n' of the component 'component' of the shape function
+	/// 'index' with the slot 'slot' in the points of the table (a row of the table, valid
+	/// until another row is evaluated)
+	double *get_row(int n, int slot, int index, int component) {
+		if (slot < capacity[component][n] && filled[component][n][slot])
+			return values[component][n] + slot * np;
+		return fill_row(n, slot, index, component);
+	}
+
+	/// @return the values of type 'n' of the component 'component' of the shape function
+	/// 'index' in the points of the table (see get_row())
+	double *get_values(int n, int index, int component);
+
+	/// @return the values of the 1D function 'tab[i]' in the 'dir'-th coordinates of the points,
+	/// the coordinates are mirrored (x -> -x) if 'ori' is 1 (the array is owned by the table)
+	double *get_1d_values(shape_fn_1d_t *tab, int i, int dir, int ori);
+
+protected:
+	Shapeset *ss;
+	int np;
+	QuadPt3D *pt;
+	unsigned int hash;
+
+	double *values[COMPONENTS][VALUE_TYPES];	// indexing: [component][value type][slot * np + point]
+	bool *filled[COMPONENTS][VALUE_TYPES];		// indexing: [component][value type][slot]
+	int capacity[COMPONENTS][VALUE_TYPES];		// number of slots allocated
+	std::map<std::pair<shape_fn_1d_t *, int>, double *> values_1d;	// (tab, i|dir|ori) => values
+
+	double *fill_row(int n, int slot, int index, int component);
+};
+
+#endif
@@ -71,6 +71,7 @@ Space *H1Space::dup(Mesh *mesh_ext) const
   // FIXME; this only works for hexahedra.
   H1Space *space = new H1Space(mesh_ext, NULL, NULL, Ord3(1, 1, 1), this->shapeset);
   space->copy_callbacks(this);
+  space->dof_ordering = dof_ordering;
   
   // enumerate basis functions
   space->assign_dofs();
@@ -117,9 +118,9 @@ int H1Space::get_element_ndofs(Ord3 order) {
 
 void H1Space::assign_dofs_internal() {
 	_F_
-	std::map<unsigned int, bool> init_vertices;
-	std::map<Edge::Key, bool> init_edges;
-	std::map<Facet::Key, bool> init_faces;
+	NodeArray<bool> init_vertices;
+	NodeHashTable<Edge::Key, bool> init_edges;
+	NodeHashTable<Facet::Key, bool> init_faces;
 
 	for(std::map<unsigned int, Element*>::iterator it = mesh->elements.begin(); it != mesh->elements.end(); it++)
 		if (it->second->used && it->second->active) {
@@ -173,7 +174,7 @@ void H1Space::assign_dofs_internal() {
 
 // assembly lists ////
 
-void H1Space::get_element_assembly_list(Element *e, AsmList *al) {
+void H1Space::calc_element_assembly_list(Element *e, AsmList *al) {
 	_F_
 	al->clear();
 	for (int i = 0; i < e->get_num_vertices(); i++) get_vertex_assembly_list(e, i, al);
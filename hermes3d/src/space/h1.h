@@ -36,10 +36,11 @@ public:
 
   virtual void set_shapeset(Shapeset* shapeset);
 
-   	virtual void get_element_assembly_list(Element *e, AsmList *al);
 	virtual void get_boundary_assembly_list(Element *e, int face, AsmList *al);
 
 protected:
+	virtual void calc_element_assembly_list(Element *e, AsmList *al);
+
 	virtual int get_vertex_ndofs();
 	virtual int get_edge_ndofs(Ord1 order);
 	virtual int get_face_ndofs(Ord2 order);
@@ -50,6 +50,7 @@ Space *HcurlSpace::dup(Mesh *mesh) const {
 	_F_
 	  HcurlSpace *space = new HcurlSpace(mesh, NULL, NULL, Ord3(-1,-1,-1), shapeset);
 	space->copy_callbacks(this);
+	space->dof_ordering = dof_ordering;
 	return space;
 }
 
@@ -91,8 +92,8 @@ int HcurlSpace::get_element_ndofs(Ord3 order) {
 
 void HcurlSpace::assign_dofs_internal() {
 	_F_
-	std::map<Edge::Key, bool> init_edges;
-	std::map<Facet::Key, bool> init_faces;
+	NodeHashTable<Edge::Key, bool> init_edges;
+	NodeHashTable<Facet::Key, bool> init_faces;
 
 	// edge dofs
   for(std::map<unsigned int, Element*>::iterator it = mesh->elements.begin(); it != mesh->elements.end(); it++)
@@ -132,7 +133,7 @@ void HcurlSpace::assign_dofs_internal() {
 
 // assembly lists ////
 
-void HcurlSpace::get_element_assembly_list(Element *e, AsmList *al) {
+void HcurlSpace::calc_element_assembly_list(Element *e, AsmList *al) {
 	_F_
 	al->clear();
 	for (int i = 0; i < e->get_num_edges(); i++) get_edge_assembly_list(e, i, al);
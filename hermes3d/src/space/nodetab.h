@@ -0,0 +1,215 @@
+// This file is part of Hermes3D
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes3D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes3D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes3D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef _NODE_TABLE_H_
+#define _NODE_TABLE_H_
+
+#include "../h3d_common.h"
+
+/// Table of node data indexed directly by the ID of a vertex or an element.
+///
+/// Vertex and element IDs are small consecutive integers, so the data are kept in a dense
+/// array that grows on demand. Like std::map, operator[] creates the (default-initialized)
+/// item if it is not present yet; get() only looks the item up.
+///
+/// @ingroup spaces
+template<typename T>
+class NodeArray {
+public:
+	NodeArray() {
+		data = NULL;
+		cap = 0;
+	}
+
+	~NodeArray() {
+		delete [] data;
+	}
+
+	T &operator[](unsigned int id) {
+		if (id >= cap) enlarge(id);
+		return data[id];
+	}
+
+	/// @return the item with ID 'id' or the default value if there is no such item
+	T get(unsigned int id) const {
+		return id < cap ? data[id] : T();
+	}
+
+	/// @return the upper bound for IDs stored in the table
+	unsigned int size() const { return cap; }
+
+	void clear() {
+		for (unsigned int i = 0; i < cap; i++)
+			data[i] = T();
+	}
+
+protected:
+	T *data;
+	unsigned int cap;
+
+	void enlarge(unsigned int id) {
+		unsigned int new_cap = cap ? cap : 64;
+		while (new_cap <= id) new_cap *= 2;
+
+		T *new_data = new T[new_cap];
+		MEM_CHECK(new_data);
+		for (unsigned int i = 0; i < cap; i++) new_data[i] = data[i];
+		for (unsigned int i = cap; i < new_cap; i++) new_data[i] = T();
+		delete [] data;
+
+		data = new_data;
+		cap = new_cap;
+	}
+
+private:
+	NodeArray(const NodeArray &);
+	NodeArray &operator=(const NodeArray &);
+};
+
+/// Open-addressing hash table for node data keyed by Edge::Key or Facet::Key.
+///
+/// Keys are hashed by their (sorted) vertex IDs and collisions are resolved by linear
+/// probing in a power-of-two table that is kept at most half full. Items are never removed
+/// one by one, only the whole table can be cleared. The interface mimics std::map as far
+/// as Space needs it: operator[] inserts the default value for a missing key and the
+/// iterator exposes 'first' (key) and 'second' (value).
+///
+/// @ingroup spaces
+template<typename KEY, typename T>
+class NodeHashTable {
+public:
+	struct Slot {
+		KEY first;
+		T second;
+		bool used;
+
+		Slot() : second(T()), used(false) { }
+	};
+
+	class iterator {
+	public:
+		iterator() : slot(NULL), end(NULL) { }
+		iterator(Slot *slot, Slot *end) : slot(slot), end(end) { skip(); }
+
+		Slot *operator->() const { return slot; }
+		Slot &operator*() const { return *slot; }
+		iterator &operator++() { slot++; skip(); return *this; }
+		iterator operator++(int) { iterator it = *this; ++(*this); return it; }
+		bool operator==(const iterator &o) const { return slot == o.slot; }
+		bool operator!=(const iterator &o) const { return slot != o.slot; }
+
+	protected:
+		Slot *slot, *end;
+
+		void skip() { while (slot != end && !slot->used) slot++; }
+	};
+
+	NodeHashTable() {
+		slots = NULL;
+		cap = 0;
+		count = 0;
+	}
+
+	~NodeHashTable() {
+		delete [] slots;
+	}
+
+	T &operator[](const KEY &key) {
+		if (2 * (count + 1) > cap) rehash(cap ? 2 * cap : 64);
+
+		Slot *s = lookup(key);
+		if (!s->used) {
+			s->first = key;
+			s->second = T();
+			s->used = true;
+			count++;
+		}
+		return s->second;
+	}
+
+	/// @return the value for 'key' or the default value if the key is not present
+	T get(const KEY &key) const {
+		if (cap == 0) return T();
+		Slot *s = lookup(key);
+		return s->used ? s->second : T();
+	}
+
+	bool exists(const KEY &key) const {
+		return cap > 0 && lookup(key)->used;
+	}
+
+	unsigned int size() const { return count; }
+
+	void clear() {
+		for (unsigned int i = 0; i < cap; i++) {
+			slots[i].used = false;
+			slots[i].second = T();
+		}
+		count = 0;
+	}
+
+	iterator begin() { return iterator(slots, slots + cap); }
+	iterator end() { return iterator(slots + cap, slots + cap); }
+
+protected:
+	Slot *slots;
+	unsigned int cap;					/// always a power of 2
+	unsigned int count;					/// number of used slots
+
+	static unsigned int hash(const KEY &key) {
+		unsigned int h = 2166136261u;
+		for (unsigned int i = 0; i < key.size; i++) {
+			h ^= key.vtcs[i];
+			h *= 16777619u;
+		}
+		return h ^ (h >> 15);
+	}
+
+	/// @return the slot holding 'key' or the empty slot where 'key' belongs
+	Slot *lookup(const KEY &key) const {
+		unsigned int mask = cap - 1;
+		unsigned int i = hash(key) & mask;
+		while (slots[i].used && slots[i].first != key)
+			i = (i + 1) & mask;
+		return slots + i;
+	}
+
+	void rehash(unsigned int new_cap) {
+		Slot *old_slots = slots;
+		unsigned int old_cap = cap;
+
+		slots = new Slot[new_cap];
+		MEM_CHECK(slots);
+		cap = new_cap;
+		for (unsigned int i = 0; i < old_cap; i++)
+			if (old_slots[i].used) {
+				Slot *s = lookup(old_slots[i].first);
+				s->first = old_slots[i].first;
+				s->second = old_slots[i].second;
+				s->used = true;
+			}
+		delete [] old_slots;
+	}
+
+private:
+	NodeHashTable(const NodeHashTable &);
+	NodeHashTable &operator=(const NodeHashTable &);
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "space.h"
 #include "../../../hermes_common/matrix.h"
 #include "../../../hermes_common/error.h"
+#include "../../../hermes_common/dof_ordering.h"
 
 #define PRINTF(...)
 //#define PRINTF printf
@@ -122,8 +123,10 @@ Space::Space(Mesh *mesh, Shapeset *shapeset, BCType (*bc_type_callback)(int),
   //this->set_essential_bc_values((scalar3 &(*)(int, double, double, double)) NULL);
   this->mesh_seq = -1;
   this->seq = 0;
+  this->al_seq = -1;
   this->was_assigned = false;
   this->ndof = 0;
+  this->dof_ordering = HERMES_NATURAL_DOF_ORDERING;
 
   init_data_tables();
 }
@@ -151,12 +154,12 @@ void Space::init_data_tables() {
 void Space::free_data_tables() {
 	_F_
 
-  for(std::map<unsigned int, VertexData*>::iterator it = vn_data.begin(); it != vn_data.end(); it++)
-    if(it->second->ced)
-      ::free(it->second->baselist);
+  for (unsigned int i = 0; i < vn_data.size(); i++)
+    if (vn_data[i] != NULL && vn_data[i]->ced)
+      ::free(vn_data[i]->baselist);
   vn_data.clear();
 
-  for(std::map<Edge::Key, EdgeData*>::iterator it = en_data.begin(); it != en_data.end(); it++) {
+  for(NodeHashTable<Edge::Key, EdgeData*>::iterator it = en_data.begin(); it != en_data.end(); it++) {
 		delete [] it->second->bc_proj;
     if (it->second->ced) {
 	    ::free(it->second->edge_baselist);
@@ -165,14 +168,15 @@ void Space::free_data_tables() {
   }
   en_data.clear();
 
-  for(std::map<Facet::Key, FaceData*>::iterator it = fn_data.begin(); it != fn_data.end(); it++)
+  for(NodeHashTable<Facet::Key, FaceData*>::iterator it = fn_data.begin(); it != fn_data.end(); it++)
     delete [] it->second->bc_proj;
   fn_data.clear();
 
-  for(std::map<unsigned int, ElementData*>::iterator it = elm_data.begin(); it != elm_data.end(); it++)
-		delete it->second;
+  for (unsigned int i = 0; i < elm_data.size(); i++)
+		delete elm_data[i];
   elm_data.clear();
 
+  free_assembly_lists();
 }
 
 // element orders ///////////////////////////////////////////////////////////////////////////////
@@ -183,7 +187,7 @@ void Space::set_element_order(unsigned int eid, Ord3 order) {
 	CHECK_ELEMENT_ID(eid);
 
 	// TODO: check for validity of order
-  if (elm_data.find(eid) == elm_data.end()) {
+  if (elm_data[eid] == NULL) {
 		elm_data[eid] = new ElementData;
 		MEM_CHECK(elm_data[eid]);
 	}
@@ -197,8 +201,8 @@ Ord3 Space::get_element_order(unsigned int eid) const
 {
   _F_
   CHECK_ELEMENT_ID(eid);
-  assert(elm_data.at(eid) != NULL);
-  return elm_data.at(eid)->order;
+  assert(elm_data.get(eid) != NULL);
+  return elm_data.get(eid)->order;
 }
 
 void Space::set_uniform_order_internal(Ord3 order, int marker) {
@@ -393,8 +397,112 @@ void Space::assign_bubble_dofs(unsigned int idx) {
 	next_dof += ndofs * stride;
 }
 
+void Space::set_dof_ordering(EDofOrdering ordering) {
+	_F_
+	this->dof_ordering = ordering;
+	seq++;
+
+	// since space changed, enumerate basis functions
+	this->assign_dofs();
+}
+
+void Space::reorder_dofs() {
+	_F_
+	// The blocks are the DOFs of the unconstrained vertices, edges and faces and the bubble
+	// DOFs of the elements, 'block_dof' points to the first DOF of the block in the node data.
+	std::vector<int *> block_dof;
+	std::vector<int> block_size;
+	std::map<int *, int> blocks;
+	std::vector<int> elem_ptr(1, 0), elem_blocks;
+	std::vector<double> centers;
+
+	for (std::map<unsigned int, Element*>::iterator it = mesh->elements.begin(); it != mesh->elements.end(); it++)
+		if (it->second->used && it->second->active) {
+			Element *e = it->second;
+			std::vector<std::pair<int *, int> > eb;
+
+			double c[3] = { 0.0, 0.0, 0.0 };
+			for (int iv = 0; iv < e->get_num_vertices(); iv++) {
+				unsigned int vid = e->get_vertex(iv);
+				VertexData *vd = vn_data[vid];
+				if (!vd->ced) eb.push_back(std::make_pair(&vd->dof, vd->n));
+				Vertex *v = mesh->vertices[vid];
+				c[0] += v->x;
+				c[1] += v->y;
+				c[2] += v->z;
+			}
+			for (int iedge = 0; iedge < e->get_num_edges(); iedge++) {
+				EdgeData *ed = en_data[mesh->get_edge_id(e, iedge)];
+				if (!ed->ced) eb.push_back(std::make_pair(&ed->dof, ed->n));
+			}
+			for (int iface = 0; iface < e->get_num_faces(); iface++) {
+				FaceData *fd = fn_data[mesh->get_facet_id(e, iface)];
+				if (!fd->ced) eb.push_back(std::make_pair(&fd->dof, fd->n));
+			}
+			ElementData *bd = elm_data[it->first];
+			eb.push_back(std::make_pair(&bd->dof, bd->n));
+
+			for (unsigned int i = 0; i < eb.size(); i++) {
+				if (*eb[i].first < 0 || eb[i].second <= 0) continue;
+				std::map<int *, int>::iterator b = blocks.find(eb[i].first);
+				if (b == blocks.end()) {
+					b = blocks.insert(std::make_pair(eb[i].first, (int) block_dof.size())).first;
+					block_dof.push_back(eb[i].first);
+					block_size.push_back(eb[i].second);
+				}
+				elem_blocks.push_back(b->second);
+			}
+			elem_ptr.push_back(elem_blocks.size());
+			for (int k = 0; k < 3; k++) centers.push_back(c[k] / e->get_num_vertices());
+		}
+	if (block_dof.empty()) return;
+
+	std::vector<int> order(block_dof.size());
+	dof_block_ordering(dof_ordering, block_dof.size(), elem_ptr.size() - 1, &elem_ptr[0],
+	                   &elem_blocks[0], &centers[0], 3, &order[0]);
+
+	// number the blocks from 'first_dof' again, in the new order
+	int dof = first_dof;
+	for (unsigned int i = 0; i < order.size(); i++) {
+		*block_dof[order[i]] = dof;
+		dof += block_size[order[i]] * stride;
+	}
+	if (dof != next_dof) error("Inconsistent DOF blocks in Space::reorder_dofs().");
+}
+
 // assembly lists ////
 
+void Space::get_element_assembly_list(Element *e, AsmList *al) {
+	_F_
+	// DOFs are not valid for the current mesh, do not cache anything
+	if (!is_up_to_date()) {
+		calc_element_assembly_list(e, al);
+		return;
+	}
+
+	if (al_seq != seq) {
+		free_assembly_lists();
+		al_seq = seq;
+	}
+
+	AsmList *&cached = al_data[e->id];
+	if (cached == NULL) {
+		calc_element_assembly_list(e, al);
+		cached = new AsmList;
+		MEM_CHECK(cached);
+		cached->copy(al);
+	}
+	else
+		al->copy(cached);
+}
+
+void Space::free_assembly_lists() {
+	_F_
+	for (unsigned int i = 0; i < al_data.size(); i++)
+		delete al_data[i];
+	al_data.clear();
+}
+
 void Space::get_vertex_assembly_list(Element *e, int ivertex, AsmList *al) {
 	_F_
 	unsigned int vtx = e->get_vertex(ivertex);
@@ -2177,19 +2285,19 @@ void Space::uc_face(unsigned int eid, int iface) {
 			calc_edge_face_ced(mid_edge_id, edge_id, cng_face_id, cng_face_ori, iface, part_ori, sub_fi[1]->h_part, fi->v_part);
 
 			// face by face
-      if(fn_data.find(sub_fid[0]) == fn_data.end()) {
+      if(!fn_data.exists(sub_fid[0])) {
         fn_data[sub_fid[0]] = new FaceData;
         fn_data[sub_fid[0]]->order = fn_data[fid]->order;
       }
-      if(fn_data.find(sub_fid[1]) == fn_data.end()) {
+      if(!fn_data.exists(sub_fid[1])) {
         fn_data[sub_fid[1]] = new FaceData;
         fn_data[sub_fid[1]]->order = fn_data[fid]->order;
       }
-      if(fn_data.find(sub_fid[2]) == fn_data.end()) {
+      if(!fn_data.exists(sub_fid[2])) {
         fn_data[sub_fid[2]] = new FaceData;
         fn_data[sub_fid[2]]->order = fn_data[fid]->order;
       }
-      if(fn_data.find(sub_fid[3]) == fn_data.end()) {
+      if(!fn_data.exists(sub_fid[3])) {
         fn_data[sub_fid[3]] = new FaceData;
         fn_data[sub_fid[3]]->order = fn_data[fid]->order;
       }
@@ -2258,12 +2366,12 @@ int Space::assign_dofs(int first_dof, int stride) {
 	this->stride = stride;
 
 	// free data
-	for(std::map<unsigned int, VertexData*>::iterator it = vn_data.begin(); it != vn_data.end(); it++)
-    if(it->second->ced)
-      ::free(it->second->baselist);
+	for (unsigned int i = 0; i < vn_data.size(); i++)
+    if (vn_data[i] != NULL && vn_data[i]->ced)
+      ::free(vn_data[i]->baselist);
   vn_data.clear();
 
-  for(std::map<Edge::Key, EdgeData*>::iterator it = en_data.begin(); it != en_data.end(); it++) {
+  for(NodeHashTable<Edge::Key, EdgeData*>::iterator it = en_data.begin(); it != en_data.end(); it++) {
 		delete [] it->second->bc_proj;
     if (it->second->ced) {
 	    ::free(it->second->edge_baselist);
@@ -2272,7 +2380,7 @@ int Space::assign_dofs(int first_dof, int stride) {
   }
   en_data.clear();
 
-  for(std::map<Facet::Key, FaceData*>::iterator it = fn_data.begin(); it != fn_data.end(); it++)
+  for(NodeHashTable<Facet::Key, FaceData*>::iterator it = fn_data.begin(); it != fn_data.end(); it++)
     delete [] it->second->bc_proj;
   fn_data.clear();
 
@@ -2287,6 +2395,8 @@ int Space::assign_dofs(int first_dof, int stride) {
 	set_bc_information();
 
 	assign_dofs_internal();
+	if (dof_ordering != HERMES_NATURAL_DOF_ORDERING)
+		reorder_dofs();
 	update_constraints();
 
 	mesh_seq = mesh->get_seq();
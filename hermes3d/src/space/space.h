@@ -24,6 +24,7 @@
 #include "../../../hermes_common/vector.h"
 #include "shapeset/shapeset.h"
 #include "asmlist.h"
+#include "nodetab.h"
 #include "quad.h"
 #include "order.h"
 
@@ -75,6 +76,15 @@ public:
   virtual void enforce_minimum_rule();
   virtual int assign_dofs(int first_dof = 0, int stride = 1);
 
+  /// Selects the ordering of the DOFs (see EDofOrdering and dof_ordering.h in hermes_common)
+  /// and assigns the DOFs again. The default, HERMES_NATURAL_DOF_ORDERING, numbers the vertex,
+  /// edge, face and bubble DOFs one kind after another as assign_dofs_internal() walks the
+  /// elements. The other orderings renumber them afterwards to reduce the fill-in of direct
+  /// solvers (reverse Cuthill-McKee) or to improve the locality of the matrix (element-wise,
+  /// space-filling curve).
+  void set_dof_ordering(EDofOrdering ordering);
+  EDofOrdering get_dof_ordering() const { return dof_ordering; }
+
   /// \brief Returns the number of basis functions contained in the space.
   int get_num_dofs() { return ndof; }
 
@@ -85,7 +95,9 @@ public:
   Shapeset *get_shapeset() const { return shapeset; }
   Mesh *get_mesh() const { return mesh; }
 
-  virtual void get_element_assembly_list(Element *e, AsmList *al) = 0;
+  /// Fills 'al' with the assembly list of the element 'e'. The lists are calculated by
+  /// calc_element_assembly_list() and cached per element until the space changes (seq).
+  virtual void get_element_assembly_list(Element *e, AsmList *al);
   virtual void get_boundary_assembly_list(Element *e, int face, AsmList *al) = 0;
 
   void dump();
@@ -116,6 +128,7 @@ protected:
 
   int seq, mesh_seq;
   bool was_assigned;
+  EDofOrdering dof_ordering;
 
   // CED
   struct BaseVertexComponent {
@@ -255,10 +268,13 @@ protected:
     void dump(int id);
   };
 
-  std::map<unsigned int, VertexData *> vn_data;		/// Vertex node hash table
-  std::map<Edge::Key, EdgeData *> en_data;		/// Edge node hash table
-  std::map<Facet::Key, FaceData *> fn_data;		/// Face node hash table
-  std::map<unsigned int, ElementData *> elm_data;		/// Element node hash table
+  NodeArray<VertexData *> vn_data;		/// Vertex node table (indexed by vertex ID)
+  NodeHashTable<Edge::Key, EdgeData *> en_data;		/// Edge node hash table
+  NodeHashTable<Facet::Key, FaceData *> fn_data;		/// Face node hash table
+  NodeArray<ElementData *> elm_data;		/// Element node table (indexed by element ID)
+
+  NodeArray<AsmList *> al_data;		/// Cached element assembly lists (indexed by element ID)
+  int al_seq;				/// seq of the space the cached assembly lists belong to
 
   void set_order_recurrent(unsigned int eid, Ord3 order);
 
@@ -273,11 +289,16 @@ protected:
   virtual void assign_bubble_dofs(unsigned int eid);
 
   virtual void assign_dofs_internal() = 0;
+  /// Renumbers the assigned DOFs according to 'dof_ordering'.
+  void reorder_dofs();
 
   virtual void get_vertex_assembly_list(Element *e, int ivertex, AsmList *al);
   virtual void get_edge_assembly_list(Element *e, int iedge, AsmList *al);
   virtual void get_face_assembly_list(Element *e, int iface, AsmList *al);
   virtual void get_bubble_assembly_list(Element *e, AsmList *al);
+  /// Calculates the assembly list of the element 'e' (uncached).
+  virtual void calc_element_assembly_list(Element *e, AsmList *al) = 0;
+  void free_assembly_lists();
 
   virtual void calc_boundary_projections();
   virtual void calc_vertex_boundary_projection(Element *elem, int ivertex) = 0;
@@ -0,0 +1,159 @@
+#define HERMES_REPORT_WARN
+#define HERMES_REPORT_INFO
+#define HERMES_REPORT_VERBOSE
+#include "config.h"
+#include <hermes3d.h>
+
+// This test checks the DOF orderings of Space (see hermes_common/dof_ordering.h). A Poisson
+// problem with an exact quadratic solution is solved on eight hexahedra, one of them refined
+// to get hanging nodes, once for each ordering. For each ordering the test checks that
+//  - the DOFs of the element assembly lists are exactly 0, ..., ndof - 1,
+//  - the solution is exact,
+//  - dup() keeps the ordering: the duplicated space numbers the DOFs as a new space with
+//    the same ordering does.
+
+MatrixSolverType matrix_solver = SOLVER_UMFPACK;  // Possibilities: SOLVER_AMESOS, SOLVER_AZTECOO, SOLVER_MUMPS,
+                                                  // SOLVER_PETSC, SOLVER_SUPERLU, SOLVER_UMFPACK.
+
+// The error should be smaller than this epsilon.
+const double EPS = 1e-10;
+
+// First two Lobatto shape functions.
+#define l0(x) ((1.0 - (x)) * 0.5)
+#define l1(x) ((1.0 + (x)) * 0.5)
+
+// Exact solution.
+double exact_solution(double x, double y, double z, double &dx, double &dy, double &dz) {
+	dx = -0.5 * x * l0(y) * l1(y) * l0(z) * l1(z);
+	dy = -0.5 * y * l0(x) * l1(x) * l0(z) * l1(z);
+	dz = -0.5 * z * l0(x) * l1(x) * l0(y) * l1(y);
+
+	return l0(x) * l1(x) * l0(y) * l1(y) * l0(z) * l1(z);
+}
+
+// Boundary condition types.
+BCType bc_types(int marker) {
+	return H3D_BC_ESSENTIAL;
+}
+
+template<typename Real, typename Scalar>
+Scalar bilinear_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v, Geom<Real> *e, ExtData<Scalar> *data) {
+	return int_grad_u_grad_v<Real, Scalar>(n, wt, u, v, e);
+}
+
+template<typename T>
+T f(T x, T y, T z) {
+	return
+		0.5 * l0(y) * l1(y) * l0(z) * l1(z) +
+		0.5 * l0(x) * l1(x) * l0(z) * l1(z) +
+		0.5 * l0(x) * l1(x) * l0(y) * l1(y);
+}
+
+template<typename Real, typename Scalar>
+Scalar linear_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Geom<Real> *e, ExtData<Scalar> *data) {
+	return int_F_v<Real, Scalar>(n, wt, f, u, e);
+}
+
+// DOFs of the active elements, element by element (the Dirichlet ones are negative).
+std::vector<int> element_dofs(Mesh *mesh, Space *space) {
+	std::vector<int> dofs;
+	for (std::map<unsigned int, Element*>::iterator it = mesh->elements.begin(); it != mesh->elements.end(); it++)
+		if (it->second->used && it->second->active) {
+			AsmList al;
+			space->get_element_assembly_list(it->second, &al);
+			for (int i = 0; i < al.cnt; i++)
+				dofs.push_back(al.dof[i]);
+		}
+	return dofs;
+}
+
+// Checks that the DOFs of the assembly lists are exactly 0, ..., ndof - 1.
+bool is_permutation(Mesh *mesh, Space *space) {
+	int ndof = space->get_num_dofs();
+	std::vector<int> dofs = element_dofs(mesh, space);
+	std::vector<bool> used(ndof, false);
+	for (unsigned int i = 0; i < dofs.size(); i++) {
+		if (dofs[i] >= ndof) return false;
+		if (dofs[i] >= 0) used[dofs[i]] = true;
+	}
+	return std::count(used.begin(), used.end(), true) == ndof;
+}
+
+bool test_ordering(Mesh *mesh, EDofOrdering ordering) {
+	H1Space space(mesh, bc_types, NULL, Ord3(2, 2, 2));
+	space.set_dof_ordering(ordering);
+	if (space.get_dof_ordering() != ordering) return false;
+	if (!is_permutation(mesh, &space)) {
+		info("The DOFs are not a permutation.");
+		return false;
+	}
+
+	// dup() creates a space of order 1.
+	Space *dup = space.dup(mesh);
+	H1Space linear(mesh, bc_types, NULL, Ord3(1, 1, 1));
+	linear.set_dof_ordering(ordering);
+	bool same = dup->get_dof_ordering() == ordering && is_permutation(mesh, dup)
+	            && element_dofs(mesh, dup) == element_dofs(mesh, &linear);
+	delete dup;
+	if (!same) {
+		info("dup() does not keep the DOF ordering.");
+		return false;
+	}
+
+	WeakForm wf;
+	wf.add_matrix_form(callback(bilinear_form), HERMES_SYM);
+	wf.add_vector_form(callback(linear_form));
+	bool is_linear = true;
+	DiscreteProblem dp(&wf, &space, is_linear);
+
+	SparseMatrix* matrix = create_matrix(matrix_solver);
+	Vector* rhs = create_vector(matrix_solver);
+	Solver* solver = create_linear_solver(matrix_solver, matrix, rhs);
+
+	info("Assembling (ndof: %d).", Space::get_num_dofs(&space));
+	dp.assemble(matrix, rhs);
+
+	Solution sln(mesh);
+	if (solver->solve()) Solution::vector_to_solution(solver->get_solution(), &space, &sln);
+	else error ("Matrix solver failed.\n");
+
+	ExactSolution ex_sln(mesh, exact_solution);
+	Adapt *adaptivity = new Adapt(&space, HERMES_H1_NORM);
+	bool solutions_for_adapt = false;
+	double err_exact = adaptivity->calc_err_exact(&sln, &ex_sln, solutions_for_adapt, HERMES_TOTAL_ERROR_ABS);
+	info("Exact error: %g.", err_exact);
+
+	delete matrix;
+	delete rhs;
+	delete solver;
+	delete adaptivity;
+
+	return err_exact < EPS;
+}
+
+int main(int argc, char **args)
+{
+	if (argc < 2) error("Not enough parameters.");
+
+	// Load the mesh.
+	Mesh mesh;
+	H3DReader mloader;
+	if (!mloader.load(args[1], &mesh)) error("Loading mesh file '%s'.", args[1]);
+
+	// Hanging nodes.
+	mesh.refine_element(1, H3D_H3D_H3D_REFT_HEX_XYZ);
+
+	EDofOrdering orderings[] = { HERMES_NATURAL_DOF_ORDERING, HERMES_RCM_DOF_ORDERING,
+	                             HERMES_ELEMENT_DOF_ORDERING, HERMES_SFC_DOF_ORDERING };
+	const char *names[] = { "natural", "RCM", "element", "SFC" };
+	for (int i = 0; i < 4; i++) {
+		info("%s ordering.", names[i]);
+		if (!test_ordering(&mesh, orderings[i])) {
+			info("Failure!");
+			return ERR_FAILURE;
+		}
+	}
+
+	info("Success!");
+	return ERR_SUCCESS;
+}
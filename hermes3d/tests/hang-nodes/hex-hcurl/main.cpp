@@ -207,78 +207,65 @@ public:
     for (unsigned int order = 0; order < NUM_RULES; order++) {
       int ord1 = order / (MAX_LEVEL + 1);
       int ord2 = order % (MAX_LEVEL + 1);
-      (*np_face)[order] = my_np_1d[ord1] * my_np_1d[ord2];
-      for (int face = 0; face < Hex::NUM_FACES; face++) {
-        if((*face_tables)[face] == NULL)
-          (*face_tables)[face] = new std::map<unsigned int, QuadPt3D *>;
-        (*(*face_tables)[face])[order] = new QuadPt3D[(*np_face)[order]];
-      }
+      np_face[order] = my_np_1d[ord1] * my_np_1d[ord2];
+      for (int face = 0; face < Hex::NUM_FACES; face++)
+        face_tables[face][order] = new QuadPt3D[np_face[order]];
 
       for (int k = 0, n = 0; k < my_np_1d[ord1]; k++) {
         for (int l = 0; l < my_np_1d[ord2]; l++, n++) {
-          assert(n < (*np_face)[order]);
-          (*(*face_tables)[0])[order][n].x = -1;
-          (*(*face_tables)[0])[order][n].y = my_tables_1d[ord1][k];
-          (*(*face_tables)[0])[order][n].z = my_tables_1d[ord2][l];
+          assert(n < np_face[order]);
+          face_tables[0][order][n].x = -1;
+          face_tables[0][order][n].y = my_tables_1d[ord1][k];
+          face_tables[0][order][n].z = my_tables_1d[ord2][l];
         }
       }
 
       for (int k = 0, n = 0; k < my_np_1d[ord1]; k++) {
         for (int l = 0; l < my_np_1d[ord2]; l++, n++) {
-          assert(n < (*np_face)[order]);
-          (*(*face_tables)[1])[order][n].x = 1;
-          (*(*face_tables)[1])[order][n].y = my_tables_1d[ord1][k];
-          (*(*face_tables)[1])[order][n].z = my_tables_1d[ord2][l];
+          assert(n < np_face[order]);
+          face_tables[1][order][n].x = 1;
+          face_tables[1][order][n].y = my_tables_1d[ord1][k];
+          face_tables[1][order][n].z = my_tables_1d[ord2][l];
         }
       }
 
       for (int k = 0, n = 0; k < my_np_1d[ord1]; k++) {
         for (int l = 0; l < my_np_1d[ord2]; l++, n++) {
-          assert(n < (*np_face)[order]);
-          (*(*face_tables)[2])[order][n].x = my_tables_1d[ord1][k];
-          (*(*face_tables)[2])[order][n].y = -1;
-          (*(*face_tables)[2])[order][n].z = my_tables_1d[ord2][l];
+          assert(n < np_face[order]);
+          face_tables[2][order][n].x = my_tables_1d[ord1][k];
+          face_tables[2][order][n].y = -1;
+          face_tables[2][order][n].z = my_tables_1d[ord2][l];
         }
       }
 
       for (int k = 0, n = 0; k < my_np_1d[ord1]; k++) {
         for (int l = 0; l < my_np_1d[ord2]; l++, n++) {
-          assert(n < (*np_face)[order]);
-          (*(*face_tables)[3])[order][n].x = my_tables_1d[ord1][k];
-          (*(*face_tables)[3])[order][n].y = 1;
-          (*(*face_tables)[3])[order][n].z = my_tables_1d[ord2][l];
+          assert(n < np_face[order]);
+          face_tables[3][order][n].x = my_tables_1d[ord1][k];
+          face_tables[3][order][n].y = 1;
+          face_tables[3][order][n].z = my_tables_1d[ord2][l];
         }
       }
 
       for (int k = 0, n = 0; k < my_np_1d[ord1]; k++) {
         for (int l = 0; l < my_np_1d[ord2]; l++, n++) {
-          assert(n < (*np_face)[order]);
-          (*(*face_tables)[4])[order][n].x = my_tables_1d[ord1][k];
-          (*(*face_tables)[4])[order][n].y = my_tables_1d[ord2][l];
-          (*(*face_tables)[4])[order][n].z = -1;
+          assert(n < np_face[order]);
+          face_tables[4][order][n].x = my_tables_1d[ord1][k];
+          face_tables[4][order][n].y = my_tables_1d[ord2][l];
+          face_tables[4][order][n].z = -1;
         }
       }
 
       for (int k = 0, n = 0; k < my_np_1d[ord1]; k++) {
         for (int l = 0; l < my_np_1d[ord2]; l++, n++) {
-          assert(n < (*np_face)[order]);
-          (*(*face_tables)[5])[order][n].x = my_tables_1d[ord1][k];
-          (*(*face_tables)[5])[order][n].y = my_tables_1d[ord2][l];
-          (*(*face_tables)[5])[order][n].z = 1;
+          assert(n < np_face[order]);
+          face_tables[5][order][n].x = my_tables_1d[ord1][k];
+          face_tables[5][order][n].y = my_tables_1d[ord2][l];
+          face_tables[5][order][n].z = 1;
         }
       }
     }
   }
-
-  ~ContQuad() {
-    _F_
-    for(std::map<unsigned int, std::map<unsigned int, QuadPt3D *>*>::iterator it = face_tables->begin(); it != face_tables->end(); it++) {
-      for(std::map<unsigned int, QuadPt3D *>::iterator it_inner = it->second->begin(); it_inner != it->second->end(); it_inner++)
-        delete [] it_inner->second;
-      delete it->second;
-    }
-    delete face_tables;
-  }
 };
 
 struct Point {
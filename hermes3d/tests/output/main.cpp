@@ -17,6 +17,8 @@ const char* preconditioner = "jacobi";            // Name of the preconditioner
 	GmshOutputEngine output(stdout);
 #elif defined VTK
 	VtkOutputEngine output(stdout, 1);
+#elif defined VTU
+	VtuOutputEngine output("test-output.pvtu", 2);
 #endif
 
 
@@ -238,6 +240,8 @@ int main(int argc, char **args)
 		output.out_orders_gmsh(&space, "orders_gmsh");
 #elif defined VTK
 		output.out_orders_vtk(&space, "orders_vtk");
+#else
+		error(HERMES_ERR_NOT_IMPLEMENTED);
 #endif
 	}
 	else if (strcmp(type, "bc") == 0) {
@@ -246,13 +250,20 @@ int main(int argc, char **args)
 		output.out_bc_gmsh(&mesh);
 #elif defined VTK
 		output.out_bc_vtk(&mesh);
+#else
+		error(HERMES_ERR_NOT_IMPLEMENTED);
 #endif
 	}
+	else if (strcmp(type, "mesh") == 0) {
+		output.out(&mesh);
+	}
+#if defined GMSH || defined VTK
 	else if (strcmp(type, "mat") == 0) {
 		StiffMatrix mat;
 		test_mat(&mesh, mat);
 		output.out(&mat);
 	}
+#endif
 	else if (strcmp(type, "mm") == 0) {
 		test_mm(&mesh);
 	}
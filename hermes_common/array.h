@@ -110,7 +110,7 @@ public:
     TYPE* item;
     if (unused.empty() || append_only)
     {
-      if (!(size & HERMES_PAGE_MASK))
+      if ((size >> HERMES_PAGE_BITS) >= (int) pages.size())
       {
         TYPE* new_page = new TYPE[HERMES_PAGE_SIZE];
         pages.push_back(new_page);
@@ -130,6 +130,15 @@ public:
     return item;
   }
 
+  /// Allocates the pages for items with ids up to 'n' in advance, so that
+  /// adding them later does not allocate memory.
+  void reserve(int n)
+  {
+    pages.reserve((n + HERMES_PAGE_MASK) >> HERMES_PAGE_BITS);
+    while ((int) pages.size() * HERMES_PAGE_SIZE < n)
+      pages.push_back(new TYPE[HERMES_PAGE_SIZE]);
+  }
+
   /// Removes the given item from the array, ie., marks it as unused.
   /// Note that the array is never physically shrinked. This should not
   /// be a problem, since meshes tend to grow rather than become smaller.
@@ -245,7 +254,7 @@ public:
   /// This is a special-purpose function used to create empty element slots.
   void skip_slot()
   {
-    if (!(size & HERMES_PAGE_MASK))
+    if ((size >> HERMES_PAGE_BITS) >= (int) pages.size())
     {
       TYPE* new_page = new TYPE[HERMES_PAGE_SIZE];
       pages.push_back(new_page);
@@ -83,18 +83,22 @@ enum MatrixSolverType
    SOLVER_MUMPS,
    SOLVER_SUPERLU,
    SOLVER_AMESOS,
-   SOLVER_AZTECOO
+   SOLVER_AZTECOO,
+   SOLVER_BANDED,
+   SOLVER_MIXED_PRECISION
 };
 
 // Should be in the same order as MatrixSolverTypes above, so that the
 // names may be accessed by the same enumeration variable.
-const std::string MatrixSolverNames[6] = {
+const std::string MatrixSolverNames[8] = {
   "UMFPACK",
   "PETSc",
   "MUMPS",
   "SuperLU",
   "Trilinos/Amesos",
-  "Trilinos/AztecOO"
+  "Trilinos/AztecOO",
+  "Banded LU",
+  "Mixed-precision LU"
 };
 
 #define UMFPACK_NOT_COMPILED  HERMES " was not built with UMFPACK support."
@@ -117,6 +121,14 @@ enum ESpaceType {
   HERMES_INVALID_SPACE = -9999
 };
 
+// DOF orderings of spaces (see dof_ordering.h).
+enum EDofOrdering {
+  HERMES_NATURAL_DOF_ORDERING = 0,  // as the DOFs are assigned (mesh node and element order)
+  HERMES_RCM_DOF_ORDERING = 1,      // reverse Cuthill-McKee
+  HERMES_ELEMENT_DOF_ORDERING = 2,  // element by element
+  HERMES_SFC_DOF_ORDERING = 3       // element by element along a space-filling curve
+};
+
 
 // Solutions.
 enum ESolutionType {
@@ -0,0 +1,137 @@
+// This file is part of Hermes
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, see <http://www.gnu.prg/licenses/>.
+
+#include "dof_ordering.h"
+#include "callstack.h"
+#include "error.h"
+#include "solver/banded.h"
+
+#include <algorithm>
+#include <vector>
+
+// Number of bits of a coordinate on the Hilbert curve.
+static const int HILBERT_BITS = 20;
+
+// Index of the point 'x' (dim integer coordinates < 2^HILBERT_BITS) on the Hilbert curve,
+// by Skilling's algorithm (Programming the Hilbert curve, AIP Conf. Proc. 707, 2004).
+static unsigned long long hilbert_index(unsigned int *x, int dim)
+{
+  // transform the coordinates to the "transposed" Hilbert index
+  unsigned int m = 1u << (HILBERT_BITS - 1);
+  for (unsigned int q = m; q > 1; q >>= 1) {
+    unsigned int p = q - 1;
+    for (int i = 0; i < dim; i++) {
+      if (x[i] & q)
+        x[0] ^= p;
+      else {
+        unsigned int t = (x[0] ^ x[i]) & p;
+        x[0] ^= t;
+        x[i] ^= t;
+      }
+    }
+  }
+  for (int i = 1; i < dim; i++) x[i] ^= x[i - 1];
+  unsigned int t = 0;
+  for (unsigned int q = m; q > 1; q >>= 1)
+    if (x[dim - 1] & q) t ^= q - 1;
+  for (int i = 0; i < dim; i++) x[i] ^= t;
+
+  // interleave the bits
+  unsigned long long h = 0;
+  for (int b = HILBERT_BITS - 1; b >= 0; b--)
+    for (int i = 0; i < dim; i++)
+      h = (h << 1) | ((x[i] >> b) & 1);
+  return h;
+}
+
+// Sorts the elements by the Hilbert index of their centers.
+static void hilbert_sort(int n_elems, const double *centers, int dim, int *elems)
+{
+  double lo[3], hi[3];
+  for (int d = 0; d < dim; d++) {
+    lo[d] = hi[d] = n_elems ? centers[d] : 0.0;
+    for (int i = 1; i < n_elems; i++) {
+      lo[d] = std::min(lo[d], centers[i * dim + d]);
+      hi[d] = std::max(hi[d], centers[i * dim + d]);
+    }
+  }
+  // the same scale in all directions, so that the curve is not distorted
+  double size = 0.0;
+  for (int d = 0; d < dim; d++) size = std::max(size, hi[d] - lo[d]);
+  double scale = (size > 0.0) ? ((1u << HILBERT_BITS) - 1) / size : 0.0;
+
+  std::vector<std::pair<unsigned long long, int> > keys(n_elems);
+  for (int i = 0; i < n_elems; i++) {
+    unsigned int x[3];
+    for (int d = 0; d < dim; d++)
+      x[d] = (unsigned int) ((centers[i * dim + d] - lo[d]) * scale);
+    keys[i] = std::make_pair(hilbert_index(x, dim), i);
+  }
+  std::sort(keys.begin(), keys.end());
+  for (int i = 0; i < n_elems; i++) elems[i] = keys[i].second;
+}
+
+void dof_block_ordering(EDofOrdering ordering, int n_blocks, int n_elems,
+                        const int *elem_ptr, const int *elem_blocks,
+                        const double *centers, int dim, int *order)
+{
+  _F_
+  if (ordering == HERMES_RCM_DOF_ORDERING) {
+    // pattern of the block graph, column by column: the column of a block holds the blocks
+    // of all elements containing it (with repetitions, band_ordering() removes them)
+    std::vector<int> Ap(n_blocks + 1, 0);
+    for (int i = 0; i < n_elems; i++)
+      for (int k = elem_ptr[i]; k < elem_ptr[i + 1]; k++)
+        Ap[elem_blocks[k] + 1] += elem_ptr[i + 1] - elem_ptr[i];
+    for (int j = 0; j < n_blocks; j++) Ap[j + 1] += Ap[j];
+    std::vector<int> Ai(Ap[n_blocks] + 1), pos(Ap.begin(), Ap.end() - 1);
+    for (int i = 0; i < n_elems; i++)
+      for (int k = elem_ptr[i]; k < elem_ptr[i + 1]; k++)
+        for (int l = elem_ptr[i]; l < elem_ptr[i + 1]; l++)
+          Ai[pos[elem_blocks[k]]++] = elem_blocks[l];
+
+    std::vector<int> perm(n_blocks);
+    int kl, ku;
+    band_ordering(n_blocks, &Ap[0], &Ai[0], &perm[0], order, kl, ku);
+    return;
+  }
+
+  if (ordering == HERMES_ELEMENT_DOF_ORDERING || ordering == HERMES_SFC_DOF_ORDERING) {
+    std::vector<int> elems(n_elems);
+    if (ordering == HERMES_SFC_DOF_ORDERING) {
+      if (dim < 1 || dim > 3) error("Invalid dimension of the element centers.");
+      hilbert_sort(n_elems, centers, dim, &elems[0]);
+    }
+    else
+      for (int i = 0; i < n_elems; i++) elems[i] = i;
+
+    // the blocks in the order of the first element containing them, then the rest
+    std::vector<bool> numbered(n_blocks, false);
+    int cnt = 0;
+    for (int i = 0; i < n_elems; i++)
+      for (int k = elem_ptr[elems[i]]; k < elem_ptr[elems[i] + 1]; k++) {
+        int b = elem_blocks[k];
+        if (!numbered[b]) {
+          numbered[b] = true;
+          order[cnt++] = b;
+        }
+      }
+    for (int b = 0; b < n_blocks; b++)
+      if (!numbered[b]) order[cnt++] = b;
+    return;
+  }
+
+  for (int b = 0; b < n_blocks; b++) order[b] = b;
+}
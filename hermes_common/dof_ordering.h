@@ -0,0 +1,46 @@
+// This file is part of Hermes
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, see <http://www.gnu.prg/licenses/>.
+
+#ifndef __HERMES_COMMON_DOF_ORDERING_H_
+#define __HERMES_COMMON_DOF_ORDERING_H_
+
+#include "common.h"
+
+// Orderings of the DOFs of a finite element space, shared by the Spaces of Hermes2D and
+// Hermes3D. The DOFs are ordered in blocks: a block is the set of DOFs of a node (vertex,
+// edge, face) or the bubble DOFs of an element. The DOFs of a block keep being numbered
+// consecutively, only the blocks are permuted.
+//
+// The space is described by its 'n_elems' active elements, the element i consists of the
+// blocks elem_blocks[elem_ptr[i]], ..., elem_blocks[elem_ptr[i + 1] - 1] (blocks which
+// do not belong to any element are allowed). 'centers' are the coordinates of the element
+// centers ('dim' numbers per element), only HERMES_SFC_DOF_ORDERING uses them.
+//
+// The orderings:
+// - HERMES_RCM_DOF_ORDERING: reverse Cuthill-McKee ordering of the graph whose vertices
+//   are the blocks and in which the blocks of each element are connected. Gives a small
+//   profile of the matrix, which helps the fill-in of direct solvers.
+// - HERMES_ELEMENT_DOF_ORDERING: the elements are walked in the given order and each one
+//   gets the blocks not numbered yet, so the DOFs of an element are (mostly) contiguous.
+// - HERMES_SFC_DOF_ORDERING: like the previous one, but the elements are walked along the
+//   Hilbert curve through their centers, so the DOFs of neighboring elements are also
+//   close, which improves the locality of matrix-vector products.
+//
+// Returns the blocks in the new order in 'order' (n_blocks entries).
+HERMES_API void dof_block_ordering(EDofOrdering ordering, int n_blocks, int n_elems,
+                                   const int *elem_ptr, const int *elem_blocks,
+                                   const double *centers, int dim, int *order);
+
+#endif
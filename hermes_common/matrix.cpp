@@ -26,6 +26,8 @@
 #include "solver/solver.h"
 #include "solver/umfpack_solver.h"
 #include "solver/superlu.h"
+#include "solver/banded.h"
+#include "solver/mixed_precision.h"
 #include "solver/amesos.h"
 #include "solver/petsc.h"
 #include "solver/mumps.h"
@@ -233,6 +235,7 @@ SparseMatrix* create_matrix(MatrixSolverType matrix_solver)
         break;
       }
     case SOLVER_UMFPACK: 
+    case SOLVER_MIXED_PRECISION: 
       {
         return new UMFPackMatrix;
         break;
@@ -242,6 +245,11 @@ SparseMatrix* create_matrix(MatrixSolverType matrix_solver)
       return new SuperLUMatrix;
       break;
     }
+    case SOLVER_BANDED: 
+    {
+      return new BandMatrix;
+      break;
+    }
     default: 
       error("Unknown matrix solver requested.");
   }
@@ -296,6 +304,20 @@ Solver* create_linear_solver(MatrixSolverType matrix_solver, Matrix* matrix, Vec
       else return new SuperLUSolver(static_cast<SuperLUMatrix*>(matrix), static_cast<SuperLUVector*>(rhs_dummy)); 
       break;
     }
+    case SOLVER_BANDED: 
+    {
+      info("Using banded LU.");       
+      if (rhs != NULL) return new BandLinearSolver(static_cast<BandMatrix*>(matrix), static_cast<BandVector*>(rhs)); 
+      else return new BandLinearSolver(static_cast<BandMatrix*>(matrix), static_cast<BandVector*>(rhs_dummy)); 
+      break;
+    }
+    case SOLVER_MIXED_PRECISION: 
+    {
+      info("Using mixed-precision LU.");       
+      if (rhs != NULL) return new MixedPrecisionLinearSolver(static_cast<UMFPackMatrix*>(matrix), static_cast<UMFPackVector*>(rhs)); 
+      else return new MixedPrecisionLinearSolver(static_cast<UMFPackMatrix*>(matrix), static_cast<UMFPackVector*>(rhs_dummy)); 
+      break;
+    }
     default: 
       error("Unknown matrix solver requested.");
   }
@@ -324,6 +346,7 @@ Vector* create_vector(MatrixSolverType matrix_solver)
         break;
       }
     case SOLVER_UMFPACK: 
+    case SOLVER_MIXED_PRECISION: 
       {
         return new UMFPackVector;
         break;
@@ -333,6 +356,11 @@ Vector* create_vector(MatrixSolverType matrix_solver)
       return new SuperLUVector;
       break;
     }
+    case SOLVER_BANDED: 
+    {
+      return new BandVector;
+      break;
+    }
     default: 
       error("Unknown matrix solver requested.");
   }
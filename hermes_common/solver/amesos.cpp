@@ -134,6 +134,54 @@ bool AmesosSolver::solve()
 #endif
 }
 
+bool AmesosSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs)
+{
+  _F_
+#ifdef HAVE_AMESOS
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+  
+  TimePeriod tmr;  
+
+#ifdef HERMES_COMMON_COMPLEX
+  error("AmesosSolver::solve_multiple_rhs() not yet implemented for complex problems");
+#else
+  int n = m->size;
+  delete [] sln;
+  sln = new scalar[n * num_rhs]; MEM_CHECK(sln);
+  memset(sln, 0, n * num_rhs * sizeof(scalar));
+
+  // All right-hand sides are solved by one call of the solver, the multivectors are views
+  // of the (column-wise stored) blocks.
+  Epetra_MultiVector b(View, *m->std_map, rhs_block, n, num_rhs);
+  Epetra_MultiVector x(View, *m->std_map, sln, n, num_rhs);
+  problem.SetOperator(m->mat);
+  problem.SetRHS(&b);
+  problem.SetLHS(&x);
+#endif
+
+  if (!setup_factorization())
+  {
+    warning("AmesosSolver: LU factorization could not be completed");
+    return false;
+  }
+
+  int status = solver->Solve();
+  if (status != 0) 
+  {
+    error("AmesosSolver: Solution failed.");
+    return false;
+  }
+  
+  tmr.tick();
+  time = tmr.accumulated();
+
+  return true;
+#else
+  return false;
+#endif
+}
+
 bool AmesosSolver::setup_factorization()
 {
   _F_
@@ -43,6 +43,7 @@ public:
   /// If set true, X will be set to the solution of A^T X = B (not A X = B).
   void set_use_transpose(bool use_transpose);
   virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
 
 protected:
 #ifdef HAVE_AMESOS
@@ -170,6 +170,60 @@ bool AztecOOSolver::solve()
 #endif
 }
 
+bool AztecOOSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs)
+{
+  _F_
+#ifdef HAVE_AZTECOO
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+
+#ifndef HERMES_COMMON_COMPLEX
+  TimePeriod tmr;
+
+  // no output
+  aztec.SetAztecOption(AZ_output, AZ_none);	// AZ_all | AZ_warnings | AZ_last | AZ_summary
+
+  // AztecOO has no block Krylov methods, the right-hand sides are solved one by one with
+  // the same matrix and preconditioner operator.
+  int n = m->size;
+  delete [] sln;
+  sln = new scalar[n * num_rhs];
+  MEM_CHECK(sln);
+  memset(sln, 0, n * num_rhs * sizeof(scalar));
+
+  aztec.SetUserMatrix(m->mat);
+#ifdef HAVE_TEUCHOS
+  if (!pc.is_null())
+#else
+  if (pc != NULL)
+#endif
+  {
+    Epetra_Operator *op = pc->get_obj();
+    assert(op != NULL);		// can work only with Epetra_Operators
+    aztec.SetPrecOperator(op);
+  }
+
+  for (int k = 0; k < num_rhs; k++) {
+    Epetra_Vector b(View, *m->std_map, rhs_block + k * n);
+    Epetra_Vector x(View, *m->std_map, sln + k * n);
+    aztec.SetRHS(&b);
+    aztec.SetLHS(&x);
+    aztec.Iterate(max_iters, tolerance);
+  }
+
+  tmr.tick();
+  time = tmr.accumulated();
+
+  return true;
+#else
+  error("AztecOOSolver::solve_multiple_rhs() not yet implemented for complex problems");
+  return false;
+#endif
+#else
+  return false;
+#endif
+}
+
 int AztecOOSolver::get_num_iters()
 {
   _F_
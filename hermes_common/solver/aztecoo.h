@@ -37,6 +37,7 @@ public:
   virtual ~AztecOOSolver();
 
   virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
 
   virtual int get_num_iters();
   virtual double get_residual();
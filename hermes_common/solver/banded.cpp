@@ -0,0 +1,576 @@
+// This file is part of Hermes
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#include "banded.h"
+
+#include "../error.h"
+#include "../utils.h"
+#include "../callstack.h"
+#include "../common_time_period.h"
+
+void qsort_int(int* pbase, size_t total_elems); // defined in qsort.cpp
+
+// Reverse Cuthill-McKee ordering ///////////////////////////////////////////////////////////////
+
+// Breadth-first search from 'root' in the graph given by adjacency lists (adj_ptr, adj, deg).
+// Visited vertices are stored in 'queue' level by level, the last level starts at 'last_level'.
+// Returns the number of visited vertices.
+static int bfs(int root, int *adj_ptr, int *adj, int *deg, int *mark, int stamp,
+               int *queue, int &last_level, int &depth)
+{
+  int n = 0;
+  queue[n++] = root;
+  mark[root] = stamp;
+  int level_start = 0;
+  depth = 0;
+  while (true) {
+    int level_end = n;
+    for (int k = level_start; k < level_end; k++) {
+      int v = queue[k];
+      for (int a = adj_ptr[v]; a < adj_ptr[v] + deg[v]; a++)
+        if (mark[adj[a]] != stamp) {
+          mark[adj[a]] = stamp;
+          queue[n++] = adj[a];
+        }
+    }
+    if (n == level_end) {
+      last_level = level_start;
+      return n;
+    }
+    level_start = level_end;
+    depth++;
+  }
+}
+
+// Calculates the reverse Cuthill-McKee ordering, order[k] is the vertex placed at position k.
+// The search in every connected component starts from a pseudo-peripheral vertex.
+static void reverse_cuthill_mckee(int n, int *adj_ptr, int *adj, int *deg, int *order)
+{
+  _F_
+  int *mark = new int[n];
+  int *queue = new int[n];
+  bool *numbered = new bool[n];
+  MEM_CHECK(mark);
+  MEM_CHECK(queue);
+  MEM_CHECK(numbered);
+  memset(mark, 0, n * sizeof(int));
+  memset(numbered, 0, n * sizeof(bool));
+  int stamp = 0;
+
+  int count = 0;
+  for (int s = 0; s < n; s++) {
+    if (numbered[s]) continue;
+
+    // find a pseudo-peripheral vertex (George-Liu)
+    int root = s, last_level, depth, old_depth = -1;
+    for (int it = 0; it < 8; it++) {
+      int nv = bfs(root, adj_ptr, adj, deg, mark, ++stamp, queue, last_level, depth);
+      if (depth <= old_depth) break;
+      old_depth = depth;
+      int best = queue[last_level];
+      for (int k = last_level + 1; k < nv; k++)
+        if (deg[queue[k]] < deg[best]) best = queue[k];
+      if (best == root) break;
+      root = best;
+    }
+
+    // Cuthill-McKee numbering of the component, neighbors by increasing degree
+    int head = count;
+    order[count++] = root;
+    numbered[root] = true;
+    while (head < count) {
+      int v = order[head++];
+      int first = count;
+      for (int a = adj_ptr[v]; a < adj_ptr[v] + deg[v]; a++)
+        if (!numbered[adj[a]]) {
+          numbered[adj[a]] = true;
+          int w = adj[a], k = count++;
+          while (k > first && deg[order[k - 1]] > deg[w]) { order[k] = order[k - 1]; k--; }
+          order[k] = w;
+        }
+    }
+  }
+
+  // reverse
+  for (int k = 0; k < n / 2; k++) {
+    int tmp = order[k];
+    order[k] = order[n - 1 - k];
+    order[n - 1 - k] = tmp;
+  }
+
+  delete [] mark;
+  delete [] queue;
+  delete [] numbered;
+}
+
+void band_ordering(int n, int *Ap, int *Ai, int *perm, int *iperm, int &kl, int &ku)
+{
+  _F_
+  int i;
+
+  // adjacency lists of the symmetrized pattern (without the diagonal)
+  int *deg = new int[n];
+  int *adj_ptr = new int[n + 1];
+  MEM_CHECK(deg);
+  MEM_CHECK(adj_ptr);
+  memset(deg, 0, n * sizeof(int));
+  for (int j = 0; j < n; j++)
+    for (int k = Ap[j]; k < Ap[j + 1]; k++)
+      if (Ai[k] != j) { deg[Ai[k]]++; deg[j]++; }
+  adj_ptr[0] = 0;
+  for (i = 0; i < n; i++) adj_ptr[i + 1] = adj_ptr[i] + deg[i];
+  int *adj = new int[adj_ptr[n] + 1];
+  MEM_CHECK(adj);
+  memset(deg, 0, n * sizeof(int));
+  for (int j = 0; j < n; j++)
+    for (int k = Ap[j]; k < Ap[j + 1]; k++)
+      if (Ai[k] != j) {
+        adj[adj_ptr[Ai[k]] + deg[Ai[k]]++] = j;
+        adj[adj_ptr[j] + deg[j]++] = Ai[k];
+      }
+  for (i = 0; i < n; i++) {
+    int *a = adj + adj_ptr[i];
+    qsort_int(a, deg[i]);
+    int *q = a;
+    for (int *p = a, last = -1; p < a + deg[i]; p++) if (*p != last) *q++ = last = *p;
+    deg[i] = q - a;
+  }
+
+  reverse_cuthill_mckee(n, adj_ptr, adj, deg, iperm);
+  for (i = 0; i < n; i++) perm[iperm[i]] = i;
+
+  kl = ku = 0;
+  for (int j = 0; j < n; j++)
+    for (int k = Ap[j]; k < Ap[j + 1]; k++) {
+      int d = perm[Ai[k]] - perm[j];
+      if (d > kl) kl = d;
+      if (-d > ku) ku = -d;
+    }
+
+  delete [] deg;
+  delete [] adj_ptr;
+  delete [] adj;
+}
+
+// BandMatrix //////////////////////////////////////////////////////////////////////////////////
+
+BandMatrix::BandMatrix()
+{
+  _F_
+  size = 0;
+  kl = ku = 0;
+  ldab = 0;
+  ab = NULL;
+  perm = NULL;
+  iperm = NULL;
+}
+
+BandMatrix::~BandMatrix()
+{
+  _F_
+  free();
+}
+
+void BandMatrix::alloc()
+{
+  _F_
+  assert(pages != NULL);
+
+  // gather the sparsity pattern (column-wise)
+  int *Ap = new int[size + 1];
+  MEM_CHECK(Ap);
+  int aisize = get_num_indices();
+  int *Ai = new int[aisize];
+  MEM_CHECK(Ai);
+  unsigned int i;
+  int pos = 0;
+  for (i = 0; i < size; i++) {
+    Ap[i] = pos;
+    pos += sort_and_store_indices(pages[i], Ai + pos, Ai + aisize);
+  }
+  Ap[i] = pos;
+
+  delete [] pages;
+  pages = NULL;
+
+  // reorder to reduce the bandwidth
+  perm = new int[size];
+  iperm = new int[size];
+  MEM_CHECK(perm);
+  MEM_CHECK(iperm);
+  band_ordering(size, Ap, Ai, perm, iperm, kl, ku);
+
+  delete [] Ap;
+  delete [] Ai;
+
+  ldab = kl + ku + 1;
+  ab = new scalar[ldab * size];
+  MEM_CHECK(ab);
+  memset(ab, 0, sizeof(scalar) * ldab * size);
+}
+
+void BandMatrix::free()
+{
+  _F_
+  if (ab != NULL) { delete [] ab; ab = NULL; }
+  if (perm != NULL) { delete [] perm; perm = NULL; }
+  if (iperm != NULL) { delete [] iperm; iperm = NULL; }
+  kl = ku = 0;
+  ldab = 0;
+}
+
+scalar *BandMatrix::entry(unsigned int m, unsigned int n)
+{
+  int i = perm[m], j = perm[n];
+  if (i - j > kl || j - i > ku) return NULL;
+  return ab + j * ldab + ku + i - j;
+}
+
+scalar BandMatrix::get(unsigned int m, unsigned int n)
+{
+  _F_
+  scalar *e = entry(m, n);
+  return (e != NULL) ? *e : 0.0;
+}
+
+void BandMatrix::zero()
+{
+  _F_
+  memset(ab, 0, sizeof(scalar) * ldab * size);
+}
+
+void BandMatrix::add(unsigned int m, unsigned int n, scalar v)
+{
+  _F_
+  if (v != 0.0)   // ignore zero values.
+  {
+    scalar *e = entry(m, n);
+    if (e == NULL) {
+      info("BandMatrix::add(): i = %d, j = %d.", m, n);
+      error("Band matrix entry outside of the band (not in the sparsity pattern).");
+    }
+    *e += v;
+  }
+}
+
+void BandMatrix::add_to_diagonal(scalar v)
+{
+  _F_
+  for (unsigned int i = 0; i < size; i++) ab[i * ldab + ku] += v;
+}
+
+void BandMatrix::add(unsigned int m, unsigned int n, scalar **mat, int *rows, int *cols)
+{
+  _F_
+  for (unsigned int i = 0; i < m; i++)       // rows
+    for (unsigned int j = 0; j < n; j++)     // cols
+      if(rows[i] >= 0 && cols[j] >= 0) // not Dir. dofs.
+        add(rows[i], cols[j], mat[i][j]);
+}
+
+bool BandMatrix::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt)
+{
+  _F_
+  switch (fmt)
+  {
+    case DF_MATLAB_SPARSE:
+    case DF_PLAIN_ASCII:
+    {
+      int nnz = 0;
+      for (int j = 0; j < (int) size; j++)
+        for (int i = std::max(0, j - ku); i <= std::min((int) size - 1, j + kl); i++)
+          if (ab[j * ldab + ku + i - j] != 0.0) nnz++;
+
+      if (fmt == DF_MATLAB_SPARSE)
+        fprintf(file, "%% Size: %dx%d\n%% Nonzeros: %d\ntemp = zeros(%d, 3);\ntemp = [\n",
+                size, size, nnz, nnz);
+      for (int j = 0; j < (int) size; j++)
+        for (int i = std::max(0, j - ku); i <= std::min((int) size - 1, j + kl); i++)
+          if (ab[j * ldab + ku + i - j] != 0.0)
+            fprintf(file, "%d %d " SCALAR_FMT "\n", iperm[i] + 1, iperm[j] + 1,
+                    SCALAR(ab[j * ldab + ku + i - j]));
+      if (fmt == DF_MATLAB_SPARSE)
+        fprintf(file, "];\n%s = spconvert(temp);\n", var_name);
+
+      return true;
+    }
+
+    default:
+      return false;
+  }
+}
+
+unsigned int BandMatrix::get_matrix_size() const
+{
+  return ldab * size * sizeof(scalar) + 2 * size * sizeof(int);
+}
+
+double BandMatrix::get_fill_in() const
+{
+  return size > 0 ? ldab / (double) size : 0.0;
+}
+
+void BandMatrix::multiply_with_vector(scalar* vector_in, scalar* vector_out)
+{
+  _F_
+  for (unsigned int i = 0; i < size; i++) vector_out[i] = 0;
+  for (int j = 0; j < (int) size; j++) {
+    scalar x = vector_in[iperm[j]];
+    for (int i = std::max(0, j - ku); i <= std::min((int) size - 1, j + kl); i++)
+      vector_out[iperm[i]] += ab[j * ldab + ku + i - j] * x;
+  }
+}
+
+void BandMatrix::multiply_with_scalar(scalar value)
+{
+  _F_
+  for (unsigned int i = 0; i < ldab * size; i++) ab[i] *= value;
+}
+
+// BandVector //////////////////////////////////////////////////////////////////////////////////
+
+BandVector::BandVector()
+{
+  _F_
+  v = NULL;
+  size = 0;
+}
+
+BandVector::~BandVector()
+{
+  _F_
+  free();
+}
+
+void BandVector::alloc(unsigned int n)
+{
+  _F_
+  free();
+  size = n;
+  v = new scalar[n];
+  MEM_CHECK(v);
+  zero();
+}
+
+void BandVector::zero()
+{
+  _F_
+  memset(v, 0, size * sizeof(scalar));
+}
+
+void BandVector::change_sign()
+{
+  _F_
+  for (unsigned int i = 0; i < size; i++) v[i] *= -1.;
+}
+
+void BandVector::free()
+{
+  _F_
+  delete [] v;
+  v = NULL;
+  size = 0;
+}
+
+void BandVector::set(unsigned int idx, scalar y)
+{
+  _F_
+  v[idx] = y;
+}
+
+void BandVector::add(unsigned int idx, scalar y)
+{
+  _F_
+  v[idx] += y;
+}
+
+void BandVector::add(unsigned int n, unsigned int *idx, scalar *y)
+{
+  _F_
+  for (unsigned int i = 0; i < n; i++)
+    v[idx[i]] += y[i];
+}
+
+bool BandVector::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt)
+{
+  _F_
+  switch (fmt)
+  {
+    case DF_MATLAB_SPARSE:
+      fprintf(file, "%% Size: %dx1\n%s = [\n", size, var_name);
+      for (unsigned int i = 0; i < size; i++)
+        fprintf(file, SCALAR_FMT "\n", SCALAR(v[i]));
+      fprintf(file, " ];\n");
+      return true;
+
+    case DF_PLAIN_ASCII:
+      fprintf(file, "\n");
+      for (unsigned int i = 0; i < size; i++)
+        fprintf(file, SCALAR_FMT "\n", SCALAR(v[i]));
+      return true;
+
+    default:
+      return false;
+  }
+}
+
+// Band solver /////////////////////////////////////////////////////////////////////////////////
+
+BandLinearSolver::BandLinearSolver(BandMatrix *m, BandVector *rhs)
+  : LinearSolver(HERMES_FACTORIZE_FROM_SCRATCH), m(m), rhs(rhs), pivoting(true),
+    lu(NULL), ipiv(NULL), lu_size(0), lu_ldab(0), lu_kl(0), lu_kv(0)
+{
+  _F_
+}
+
+BandLinearSolver::~BandLinearSolver()
+{
+  _F_
+  free_factorization_data();
+}
+
+bool BandLinearSolver::solve()
+{
+  _F_
+  assert(m != NULL);
+  assert(rhs != NULL);
+
+  assert(m->size == rhs->size);
+
+  TimePeriod tmr;
+
+  if ( !setup_factorization() )
+  {
+    warning("LU factorization could not be completed.");
+    return false;
+  }
+
+  int n = m->size;
+
+  if(sln)
+    delete [] sln;
+  sln = new scalar[n];
+  MEM_CHECK(sln);
+  scalar *b = new scalar[n];
+  MEM_CHECK(b);
+  for (int i = 0; i < n; i++) b[m->perm[i]] = rhs->v[i];
+  band_lu_solve(n, lu_kl, lu_kv, lu, lu_ldab, ipiv, b);
+
+  for (int i = 0; i < n; i++) sln[i] = b[m->perm[i]];
+  delete [] b;
+
+  tmr.tick();
+  time = tmr.accumulated();
+
+  return true;
+}
+
+bool BandLinearSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs)
+{
+  _F_
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+
+  TimePeriod tmr;
+
+  if ( !setup_factorization() )
+  {
+    warning("LU factorization could not be completed.");
+    return false;
+  }
+
+  int n = m->size;
+
+  if(sln)
+    delete [] sln;
+  sln = new scalar[n * num_rhs];
+  MEM_CHECK(sln);
+  scalar *b = new scalar[n * num_rhs];
+  MEM_CHECK(b);
+  for (int k = 0; k < num_rhs; k++)
+    for (int i = 0; i < n; i++) b[k * n + m->perm[i]] = rhs_block[k * n + i];
+  band_lu_solve(n, lu_kl, lu_kv, lu, lu_ldab, ipiv, b, num_rhs, n);
+
+  for (int k = 0; k < num_rhs; k++)
+    for (int i = 0; i < n; i++) sln[k * n + i] = b[k * n + m->perm[i]];
+  delete [] b;
+
+  tmr.tick();
+  time = tmr.accumulated();
+
+  return true;
+}
+
+bool BandLinearSolver::setup_factorization()
+{
+  _F_
+  // Factorize for the first time or when the size of the matrix has changed.
+  unsigned int eff_fact_scheme;
+  if (lu == NULL || lu_size != (int) m->size)
+    eff_fact_scheme = HERMES_FACTORIZE_FROM_SCRATCH;
+  else
+    eff_fact_scheme = factorization_scheme;
+
+  if (eff_fact_scheme == HERMES_REUSE_FACTORIZATION_COMPLETELY) return true;
+
+  int n = m->size;
+  int kl = m->kl, ku = m->ku;
+  // with pivoting, the fill-in takes kl superdiagonals in addition to the ku ones
+  int kv = pivoting ? kl + ku : ku;
+  int ld = kv + kl + 1;
+  if (lu == NULL || lu_size != n || lu_ldab != ld || (ipiv == NULL) == pivoting) {
+    free_factorization_data();
+    lu = new scalar[ld * n];
+    MEM_CHECK(lu);
+    if (pivoting) {
+      ipiv = new int[n];
+      MEM_CHECK(ipiv);
+    }
+    lu_size = n;
+    lu_ldab = ld;
+  }
+  // the bandwidths can change while ld stays the same, e.g. (kl, ku) = (2, 1) and (1, 3)
+  lu_kl = kl;
+  lu_kv = kv;
+
+  // copy the band of the matrix (the first kv - ku rows are for the fill-in)
+  memset(lu, 0, sizeof(scalar) * ld * n);
+  for (int j = 0; j < n; j++)
+    memcpy(lu + j * ld + kv - ku, m->ab + j * m->ldab, sizeof(scalar) * m->ldab);
+
+  int j = band_lu_factor(n, kl, ku, kv, lu, ld, ipiv);
+  if (j >= 0) {
+    warning("BandLinearSolver: the matrix is singular (zero pivot in column %d).", j);
+    lu_size = 0;    // force factorization from scratch next time
+    return false;
+  }
+
+  return true;
+}
+
+void BandLinearSolver::free_factorization_data()
+{
+  _F_
+  if (lu != NULL) { delete [] lu; lu = NULL; }
+  if (ipiv != NULL) { delete [] ipiv; ipiv = NULL; }
+  lu_size = 0;
+  lu_ldab = 0;
+  lu_kl = 0;
+  lu_kv = 0;
+}
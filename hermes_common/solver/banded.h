@@ -0,0 +1,230 @@
+// This file is part of Hermes
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef __HERMES_COMMON_BANDED_H_
+#define __HERMES_COMMON_BANDED_H_
+
+#include "solver.h"
+#include "../matrix.h"
+
+/// Reverse Cuthill-McKee ordering of the symmetrized sparsity pattern of an n x n matrix
+/// given column-wise (Ap, Ai). perm[i] is the position of the unknown i in the reordered
+/// matrix, iperm is the inverse of perm; kl and ku are the numbers of subdiagonals and
+/// superdiagonals of the reordered matrix.
+HERMES_API void band_ordering(int n, int *Ap, int *Ai, int *perm, int *iperm, int &kl, int &ku);
+
+/// Unblocked LU factorization of a band matrix in the band storage (see LAPACK's xGBTF2).
+/// The entry (i, j) is lu[j * ld + kv + i - j]. With partial pivoting (ipiv != NULL) kv has
+/// to be kl + ku, the first kl rows are for the fill-in; without pivoting kv = ku.
+/// Returns the column of a zero pivot, -1 if there is none. The element type T is scalar,
+/// or its single precision counterpart for the mixed precision solver. Multipliers and
+/// entries of U smaller than 'tiny' in magnitude are treated as zeros, which keeps the
+/// single precision elimination free of (very slow) denormal numbers.
+template<typename T>
+int band_lu_factor(int n, int kl, int ku, int kv, T *lu, int ld, int *ipiv, double tiny = 0.0)
+{
+  int ju = 0;     // the last column affected by the row interchanges so far
+  for (int j = 0; j < n; j++) {
+    T *col = lu + j * ld + kv;   // col[r] is the entry (j + r, j)
+    int km = std::min(kl, n - 1 - j);
+
+    int jp = 0;
+    if (ipiv != NULL) {
+      for (int r = 1; r <= km; r++)
+        if (std::abs(col[r]) > std::abs(col[jp])) jp = r;
+      ipiv[j] = j + jp;
+    }
+    if (col[jp] == T(0)) return j;
+
+    ju = std::max(ju, std::min(j + ku + jp, n - 1));
+    if (jp != 0)
+      for (int c = j; c <= ju; c++) {
+        T *e = lu + c * ld + kv - c;   // e[i] is the entry (i, c)
+        T tmp = e[j];
+        e[j] = e[j + jp];
+        e[j + jp] = tmp;
+      }
+
+    if (km > 0) {
+      T piv = T(1) / col[0];
+      for (int r = 1; r <= km; r++) {
+        col[r] *= piv;
+        if (std::abs(col[r]) < tiny) col[r] = T(0);
+      }
+      for (int c = j + 1; c <= ju; c++) {
+        T *e = lu + c * ld + kv - c;
+        T t = e[j];
+        if (std::abs(t) > tiny)
+          for (int r = 1; r <= km; r++) e[j + r] -= col[r] * t;
+      }
+    }
+  }
+  return -1;
+}
+
+/// Solves the system with the factorization computed by band_lu_factor() for 'nrhs'
+/// right-hand sides stored column-wise in 'b' with the leading dimension 'ldb' (n if 0),
+/// 'b' is overwritten by the solution. All right-hand sides are processed in one sweep
+/// over the factors.
+template<typename T>
+void band_lu_solve(int n, int kl, int kv, const T *lu, int ld, const int *ipiv, T *b,
+                   int nrhs = 1, int ldb = 0)
+{
+  if (ldb == 0) ldb = n;
+  // solve L y = P b
+  for (int j = 0; j < n - 1; j++) {
+    int lm = std::min(kl, n - 1 - j);
+    const T *l = lu + j * ld + kv;
+    for (int c = 0; c < nrhs; c++) {
+      T *bc = b + c * ldb;
+      if (ipiv != NULL && ipiv[j] != j) {
+        T tmp = bc[ipiv[j]];
+        bc[ipiv[j]] = bc[j];
+        bc[j] = tmp;
+      }
+      T bj = bc[j];
+      if (bj != T(0))
+        for (int r = 1; r <= lm; r++) bc[j + r] -= l[r] * bj;
+    }
+  }
+  // solve U x = y
+  for (int j = n - 1; j >= 0; j--) {
+    const T *u = lu + j * ld + kv - j;   // u[i] is the entry (i, j)
+    int i0 = std::max(0, j - kv);
+    for (int c = 0; c < nrhs; c++) {
+      T *bc = b + c * ldb;
+      bc[j] /= u[j];
+      T bj = bc[j];
+      if (bj != T(0))
+        for (int i = i0; i < j; i++) bc[i] -= u[i] * bj;
+    }
+  }
+}
+
+/// Band matrix.
+///
+/// The sparsity pattern given by pre_add_ij() is reordered by the reverse Cuthill-McKee
+/// algorithm in alloc(), so that the bandwidth is small also when the numbering of unknowns
+/// is not (e.g., in 1D, where vertex and bubble functions are numbered separately).
+/// The entries of the reordered matrix are stored in the LAPACK band format (column-wise,
+/// 'kl' subdiagonals and 'ku' superdiagonals), the memory is O(n * (kl + ku)).
+/// Indices passed to the methods of the class always refer to the original numbering.
+class HERMES_API BandMatrix : public SparseMatrix {
+public:
+  BandMatrix();
+  virtual ~BandMatrix();
+
+  virtual void alloc();
+  virtual void free();
+  virtual scalar get(unsigned int m, unsigned int n);
+  virtual void zero();
+  virtual void add(unsigned int m, unsigned int n, scalar v);
+  virtual void add_to_diagonal(scalar v);
+  virtual void add(unsigned int m, unsigned int n, scalar **mat, int *rows, int *cols);
+  virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE);
+  virtual unsigned int get_matrix_size() const;
+  virtual double get_fill_in() const;
+
+  // Applies the matrix to vector_in and saves result to vector_out.
+  void multiply_with_vector(scalar* vector_in, scalar* vector_out);
+  // Multiplies matrix with a scalar.
+  void multiply_with_scalar(scalar value);
+
+  int get_kl() const { return kl; }
+  int get_ku() const { return ku; }
+
+protected:
+  int kl, ku;     // Number of subdiagonals and superdiagonals (of the reordered matrix).
+  int ldab;       // Leading dimension of ab (= kl + ku + 1).
+  scalar *ab;     // Band entries, (i, j) of the reordered matrix is ab[j * ldab + ku + i - j].
+  int *perm;      // perm[i] = position of the unknown i in the reordered matrix.
+  int *iperm;     // Inverse of perm.
+
+  scalar *entry(unsigned int m, unsigned int n);
+
+  friend class BandLinearSolver;
+};
+
+class HERMES_API BandVector : public Vector {
+public:
+  BandVector();
+  virtual ~BandVector();
+
+  virtual void alloc(unsigned int ndofs);
+  virtual void free();
+  virtual scalar get(unsigned int idx) { return v[idx]; }
+  virtual void extract(scalar *v) const { memcpy(v, this->v, size * sizeof(scalar)); }
+  virtual void zero();
+  virtual void change_sign();
+  virtual void set(unsigned int idx, scalar y);
+  virtual void add(unsigned int idx, scalar y);
+  virtual void add(unsigned int n, unsigned int *idx, scalar *y);
+  virtual void add_vector(Vector* vec) {
+    assert(this->length() == vec->length());
+    for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec->get(i);
+  };
+  virtual void add_vector(scalar* vec) {
+    for (unsigned int i = 0; i < this->length(); i++) this->v[i] += vec[i];
+  };
+  virtual bool dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt = DF_MATLAB_SPARSE);
+
+protected:
+  scalar *v;
+  friend class BandLinearSolver;
+};
+
+
+/// Direct solver for band matrices.
+///
+/// Performs the LU factorization with partial pivoting in the band storage (as LAPACK's
+/// xGBTRF does), which needs kl extra superdiagonals for the fill-in. With pivoting switched
+/// off (set_pivoting(false)) the elimination stays within the band of the matrix; for matrices
+/// with block tridiagonal structure (1D problems) this is the block Thomas algorithm. It is
+/// stable for diagonally dominant and symmetric positive definite matrices.
+/// Both the time and memory are O(n * (kl + ku)^2) and O(n * (kl + ku)), respectively.
+///
+/// The factorization is kept, HERMES_REUSE_FACTORIZATION_COMPLETELY solves with it again,
+/// all other schemes factorize the current matrix (the ordering is reused anyway).
+///
+/// @ingroup solvers
+class HERMES_API BandLinearSolver : public LinearSolver {
+public:
+  BandLinearSolver(BandMatrix *m, BandVector *rhs);
+  virtual ~BandLinearSolver();
+
+  virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
+
+  void set_pivoting(bool pivoting) { this->pivoting = pivoting; }
+
+protected:
+  BandMatrix *m;
+  BandVector *rhs;
+  bool pivoting;
+
+  // LU factorization of the reordered matrix in the band format.
+  scalar *lu;
+  int *ipiv;               // Row interchanges (NULL without pivoting).
+  int lu_size, lu_ldab, lu_kl, lu_kv;
+
+  bool setup_factorization();
+  void free_factorization_data();
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "eigensolver.h"
 #include "umfpack_solver.h"
+#include "banded.h"
+
+#include <algorithm>
 
 namespace Hermes {
 
@@ -10,66 +13,539 @@ using Teuchos::ptr;
 using Teuchos::null;
 using Teuchos::rcp_dynamic_cast;
 
-PyMODINIT_FUNC initeigen(void); /*proto*/
-
-EigenSolver::EigenSolver(const RCP<Matrix> &A, const RCP<Matrix> &B) {
+EigenSolver::EigenSolver(const RCP<Matrix> &A, const RCP<Matrix> &B,
+        EigenSolverMethod method) {
     this->A = A;
     this->B = B;
-    this->n_eigs=0;
+    this->method = method;
+    this->n_eigs = 0;
+    this->num_iters = 0;
+    this->size = 0;
+}
 
-    initeigen();
+#ifndef HERMES_COMMON_COMPLEX
+
+// y = A * x
+static void csc_multiply(CSCMatrix *A, const double *x, double *y)
+{
+    int n = A->get_size();
+    int *Ap = A->get_Ap(), *Ai = A->get_Ai();
+    double *Ax = A->get_Ax();
+    memset(y, 0, n * sizeof(double));
+    for (int j = 0; j < n; j++) {
+        double xj = x[j];
+        if (xj != 0.0)
+            for (int k = Ap[j]; k < Ap[j + 1]; k++) y[Ai[k]] += Ax[k] * xj;
+    }
 }
 
-void wrap_CSC(const Ptr<Python> p, const std::string name,
-        const RCP<CSCMatrix> A)
+static double dot(int n, const double *x, const double *y)
 {
-    p->push_numpy_int_inplace("_IA", A->get_Ai(), A->get_nnz());
-    p->push_numpy_int_inplace("_JA", A->get_Ap(), A->get_size()+1);
-#ifdef HERMES_COMMON_COMPLEX
-    throw std::runtime_error("Eigenproblem with complex numbers is not supported.");
+    double s = 0.0;
+    for (int i = 0; i < n; i++) s += x[i] * y[i];
+    return s;
+}
+
+static void axpy(int n, double a, const double *x, double *y)
+{
+    for (int i = 0; i < n; i++) y[i] += a * x[i];
+}
+
+// y = sum of a[l] * (column l of x), x has 'k' columns of length 'n'
+static void combine(int n, int k, const double *x, const double *a, double *y)
+{
+    memset(y, 0, n * sizeof(double));
+    for (int l = 0; l < k; l++)
+        if (a[l] != 0.0) axpy(n, a[l], x + (size_t) l * n, y);
+}
+
+// Pseudo-random numbers in (-1, 1), the same sequence in every run.
+static double random_number(unsigned int &seed)
+{
+    seed = seed * 1103515245u + 12345u;
+    return ((seed >> 8) & 0xffff) / 32768.0 - 1.0;
+}
+
+// B-orthogonalizes 'w' against the 'k' columns of 'v' by the classical Gram-Schmidt
+// method applied twice; 'bv' = B * v and 'bw' = B * w, which is updated together with
+// 'w'. The coefficients are added to 'h' (if not NULL). Returns the B-norm of the result.
+static double b_orthogonalize(int n, int k, const double *v, const double *bv,
+        double *w, double *bw, double *h)
+{
+    std::vector<double> c(k + 1);
+    for (int pass = 0; pass < 2; pass++) {
+        for (int i = 0; i < k; i++) c[i] = dot(n, bv + (size_t) i * n, w);
+        for (int i = 0; i < k; i++) {
+            axpy(n, -c[i], v + (size_t) i * n, w);
+            axpy(n, -c[i], bv + (size_t) i * n, bw);
+            if (h != NULL) h[i] += c[i];
+        }
+    }
+    return sqrt(std::max(dot(n, w, bw), 0.0));
+}
+
+// Eigenvalues (ascending) and eigenvectors of the symmetric matrix 'a' (n x n, stored
+// column-wise, destroyed) by the cyclic Jacobi method. The eigenvectors are the columns
+// of 'v'.
+static void symmetric_eigen(int n, double *a, double *w, double *v)
+{
+    memset(v, 0, n * n * sizeof(double));
+    for (int i = 0; i < n; i++) v[i * n + i] = 1.0;
+
+    for (int sweep = 0; sweep < 50; sweep++) {
+        double off = 0.0, norm = 0.0;
+        for (int j = 0; j < n; j++)
+            for (int i = 0; i < n; i++) {
+                double e = a[j * n + i] * a[j * n + i];
+                norm += e;
+                if (i != j) off += e;
+            }
+        if (off <= 1e-40 * norm) break;
+
+        for (int p = 0; p < n - 1; p++)
+            for (int q = p + 1; q < n; q++) {
+                double apq = a[q * n + p], app = a[p * n + p], aqq = a[q * n + q];
+                if (fabs(apq) <= 1e-18 * (fabs(app) + fabs(aqq))) {
+                    a[q * n + p] = a[p * n + q] = 0.0;
+                    continue;
+                }
+                double theta = (aqq - app) / (2.0 * apq);
+                double t = (fabs(theta) > 1e150) ? 0.5 / theta
+                         : ((theta >= 0.0) ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0), s = t * c;
+                // A = J^T A J, V = V J
+                for (int k = 0; k < n; k++) {
+                    double akp = a[p * n + k], akq = a[q * n + k];
+                    a[p * n + k] = c * akp - s * akq;
+                    a[q * n + k] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; k++) {
+                    double apk = a[k * n + p], aqk = a[k * n + q];
+                    a[k * n + p] = c * apk - s * aqk;
+                    a[k * n + q] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; k++) {
+                    double vkp = v[p * n + k], vkq = v[q * n + k];
+                    v[p * n + k] = c * vkp - s * vkq;
+                    v[q * n + k] = s * vkp + c * vkq;
+                }
+            }
+    }
+
+    // sort the eigenpairs
+    std::vector<std::pair<double, int> > order(n);
+    for (int i = 0; i < n; i++) order[i] = std::make_pair(a[i * n + i], i);
+    std::sort(order.begin(), order.end());
+    std::vector<double> vs(v, v + n * n);
+    for (int i = 0; i < n; i++) {
+        w[i] = order[i].first;
+        memcpy(v + i * n, &vs[order[i].second * n], n * sizeof(double));
+    }
+}
+
+// Solves (A - sigma * B) x = b with the LU factorization computed in the first solve
+// and reused in the following ones. 'b' and 'x' may hold 'nrhs' vectors one after
+// another, which are solved in one sweep over the factors.
+class ShiftInvertSolver {
+public:
+    ShiftInvertSolver(CSCMatrix *A, CSCMatrix *B, double sigma);
+    ~ShiftInvertSolver() { delete solver; }
+
+    bool solve(const double *b, double *x, int nrhs = 1);
+
+protected:
+#ifdef WITH_UMFPACK
+    UMFPackMatrix mat;
+    UMFPackVector rhs;
 #else
-    p->push_numpy_double_inplace("_A", A->get_Ax(), A->get_nnz());
+    BandMatrix mat;
+    BandVector rhs;
 #endif
-    p->push_int("n", A->get_size());
-    p->exec("from scipy.sparse import csc_matrix\n");
-    p->exec(name + " = csc_matrix((_A, _IA, _JA), shape=(n, n))");
+    Solver *solver;
+    int n;
+    bool factorized;
+};
+
+ShiftInvertSolver::ShiftInvertSolver(CSCMatrix *A, CSCMatrix *B, double sigma)
+{
+    // the pattern of A - sigma * B is the union of the patterns of A and B (the row
+    // indices of each column are sorted, as CSCMatrix::alloc() stores them)
+    n = A->get_size();
+    int *ap = A->get_Ap(), *ai = A->get_Ai(), *bp = B->get_Ap(), *bi = B->get_Ai();
+    double *ax = A->get_Ax(), *bx = B->get_Ax();
+    std::vector<int> cp(n + 1), ci;
+    std::vector<double> cx;
+    ci.reserve(A->get_nnz() + B->get_nnz());
+    cx.reserve(A->get_nnz() + B->get_nnz());
+    cp[0] = 0;
+    for (int j = 0; j < n; j++) {
+        int ka = ap[j], kb = bp[j];
+        while (ka < ap[j + 1] || kb < bp[j + 1]) {
+            int ra = (ka < ap[j + 1]) ? ai[ka] : n;
+            int rb = (kb < bp[j + 1]) ? bi[kb] : n;
+            if (ra == rb) {
+                ci.push_back(ra);
+                cx.push_back(ax[ka++] - sigma * bx[kb++]);
+            }
+            else if (ra < rb) {
+                ci.push_back(ra);
+                cx.push_back(ax[ka++]);
+            }
+            else {
+                ci.push_back(rb);
+                cx.push_back(-sigma * bx[kb++]);
+            }
+        }
+        cp[j + 1] = ci.size();
+    }
+    if (ci.empty()) throw std::runtime_error("The matrices A and B are empty.");
+
+#ifdef WITH_UMFPACK
+    mat.create(n, cp[n], &cp[0], &ci[0], &cx[0]);
+    rhs.alloc(n);
+    solver = new UMFPackLinearSolver(&mat, &rhs);
+#else
+    mat.prealloc(n);
+    for (int j = 0; j < n; j++)
+        for (int k = cp[j]; k < cp[j + 1]; k++) mat.pre_add_ij(ci[k], j);
+    mat.alloc();
+    for (int j = 0; j < n; j++)
+        for (int k = cp[j]; k < cp[j + 1]; k++) mat.add(ci[k], j, cx[k]);
+    rhs.alloc(n);
+    solver = new BandLinearSolver(&mat, &rhs);
+#endif
+    factorized = false;
 }
 
+bool ShiftInvertSolver::solve(const double *b, double *x, int nrhs)
+{
+    std::vector<double> block(b, b + (size_t) nrhs * n);
+    if (!solver->solve_multiple_rhs(&block[0], nrhs)) return false;
+    if (!factorized) {
+        solver->set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+        factorized = true;
+    }
+    memcpy(x, solver->get_solution(), (size_t) nrhs * n * sizeof(double));
+    return true;
+}
+
+// Makes the column 'j' of 'v' B-orthonormal to the previous columns and computes the
+// column 'j' of 'bv' = B * v. The coefficients are added to 'h' (if not NULL). If the
+// column depends on the previous ones, it is replaced by a random vector (or by zero if
+// they span the whole space). Returns the coefficient of the new column.
+static double add_basis_vector(CSCMatrix *B, int n, int j, double *v, double *bv, double *h,
+        unsigned int &seed)
+{
+    double *vj = v + (size_t) j * n, *bvj = bv + (size_t) j * n;
+    csc_multiply(B, vj, bvj);
+    double norm = sqrt(std::max(dot(n, vj, bvj), 0.0));
+    double beta = b_orthogonalize(n, j, v, bv, vj, bvj, h);
+    if (beta <= 1e-10 * norm) {
+        for (int i = 0; i < n; i++) vj[i] = random_number(seed);
+        csc_multiply(B, vj, bvj);
+        norm = sqrt(std::max(dot(n, vj, bvj), 0.0));
+        double nrm = b_orthogonalize(n, j, v, bv, vj, bvj, NULL);
+        double f = (nrm > 1e-10 * norm) ? 1.0 / nrm : 0.0;
+        for (int i = 0; i < n; i++) {
+            vj[i] *= f;
+            bvj[i] *= f;
+        }
+        return 0.0;
+    }
+    for (int i = 0; i < n; i++) {
+        vj[i] /= beta;
+        bvj[i] /= beta;
+    }
+    return beta;
+}
+
+bool EigenSolver::solve_lanczos(CSCMatrix *A, CSCMatrix *B, int nev,
+        double sigma, double tol, int max_iter)
+{
+    // Block Lanczos process for OP = (A - sigma * B)^-1 * B, which is self-adjoint in
+    // the B-inner product. The basis V is B-orthonormal, the column k + p is OP * v_k
+    // orthogonalized against all previous columns (p is the block size), so the
+    // projection H = V^T * B * OP * V is computed directly, including the coupling of
+    // the Ritz vectors kept at a restart (thick restart, Wu and Simon). The blocks make
+    // eigenvalues of multiplicity up to p be found reliably. The Ritz values theta
+    // largest in magnitude give the eigenvalues sigma + 1 / theta closest to sigma.
+    int n = size;
+    int p = std::min(nev, 4);
+    int m = std::min(n, std::max(2 * nev + p, 20));     // dimension of the projection
+    int nb = m + p;                                      // number of basis vectors
+    std::vector<double> V((size_t) nb * n), BV((size_t) nb * n), w(n), bw(n);
+    std::vector<double> H(nb * m), G(m * m), S(m * m), theta(m);
+    unsigned int seed = 1;
+
+    // factorize A - sigma * B, move the shift if it is an eigenvalue
+    ShiftInvertSolver *op = NULL;
+    for (int i = 0; i < n; i++) w[i] = random_number(seed);
+    csc_multiply(B, &w[0], &bw[0]);
+    for (int attempt = 0; op == NULL; attempt++) {
+        op = new ShiftInvertSolver(A, B, sigma);
+        if (!op->solve(&bw[0], &V[0])) {
+            delete op;
+            op = NULL;
+            if (attempt == 2)
+                throw std::runtime_error("EigenSolver: A - target * B could not be factorized.");
+            sigma += 1e-8 * std::max(1.0, fabs(sigma));
+        }
+    }
+
+    // the starting block is OP applied to random vectors
+    add_basis_vector(B, n, 0, &V[0], &BV[0], NULL, seed);
+    for (int j = 1; j < p; j++) {
+        for (int i = 0; i < n; i++) w[i] = random_number(seed);
+        csc_multiply(B, &w[0], &bw[0]);
+        op->solve(&bw[0], &V[(size_t) j * n]);
+        add_basis_vector(B, n, j, &V[0], &BV[0], NULL, seed);
+    }
+
+    std::vector<int> order(m);
+    std::vector<std::pair<double, int> > mag(m);
+    bool converged = false;
+    int k = 0;
+    for (num_iters = 0; ; num_iters++) {
+        for (int solved = k; k < m; k++) {
+            // OP is applied to the columns k, ..., k + p - 1 (all of them are known before
+            // the column k + p is added) at once
+            if (k == solved) {
+                int nrhs = std::min(p, m - k);
+                if (!op->solve(&BV[(size_t) k * n], &V[(size_t) (k + p) * n], nrhs)) {
+                    delete op;
+                    throw std::runtime_error("EigenSolver: solution with A - target * B failed.");
+                }
+                solved += nrhs;
+            }
+            double *h = &H[(size_t) k * nb];
+            std::fill(h, h + nb, 0.0);
+            h[k + p] = add_basis_vector(B, n, k + p, &V[0], &BV[0], h, seed);
+        }
+
+        // Ritz pairs of the symmetric projection
+        for (int j = 0; j < m; j++)
+            for (int i = 0; i < m; i++) G[j * m + i] = (i <= j) ? H[j * nb + i] : H[i * nb + j];
+        symmetric_eigen(m, &G[0], &theta[0], &S[0]);
+        for (int i = 0; i < m; i++) mag[i] = std::make_pair(-fabs(theta[i]), i);
+        std::sort(mag.begin(), mag.end());
+        for (int i = 0; i < m; i++) order[i] = mag[i].second;
+
+        // the residual of the Ritz pair (theta, V * s) is |E * s|, E are the rows
+        // m, ..., m + p - 1 of H
+        int nconv = 0;
+        for (int i = 0; i < nev; i++) {
+            double *s = &S[order[i] * m], res = 0.0;
+            for (int r = m; r < nb; r++) {
+                double e = 0.0;
+                for (int j = std::max(0, r - p); j < m; j++) e += H[j * nb + r] * s[j];
+                res += e * e;
+            }
+            if (sqrt(res) <= tol * fabs(theta[order[i]])) nconv++;
+        }
+        if (nconv == nev) converged = true;
+        if (converged || num_iters >= max_iter) break;
+
+        // restart with the wanted Ritz vectors and the last block of the basis
+        int nkeep = std::max(1, std::min(m - p, nev + (m - nev) / 2));
+        std::vector<double> X((size_t) nkeep * n), BX((size_t) nkeep * n);
+        for (int i = 0; i < nkeep; i++) {
+            combine(n, m, &V[0], &S[order[i] * m], &X[(size_t) i * n]);
+            combine(n, m, &BV[0], &S[order[i] * m], &BX[(size_t) i * n]);
+        }
+        memmove(&V[(size_t) nkeep * n], &V[(size_t) m * n], (size_t) p * n * sizeof(double));
+        memmove(&BV[(size_t) nkeep * n], &BV[(size_t) m * n], (size_t) p * n * sizeof(double));
+        memcpy(&V[0], &X[0], X.size() * sizeof(double));
+        memcpy(&BV[0], &BX[0], BX.size() * sizeof(double));
+        std::fill(H.begin(), H.end(), 0.0);
+        for (int i = 0; i < nkeep; i++) H[i * nb + i] = theta[order[i]];
+        k = nkeep;
+    }
+    delete op;
+
+    // eigenpairs sorted by the eigenvalues
+    std::vector<std::pair<double, int> > eigs(nev);
+    for (int i = 0; i < nev; i++)
+        eigs[i] = std::make_pair(sigma + 1.0 / theta[order[i]], order[i]);
+    std::sort(eigs.begin(), eigs.end());
+    eigenvalues.resize(nev);
+    eigenvectors.resize((size_t) nev * n);
+    for (int i = 0; i < nev; i++) {
+        eigenvalues[i] = eigs[i].first;
+        combine(n, m, &V[0], &S[eigs[i].second * m], &eigenvectors[(size_t) i * n]);
+    }
+    return converged;
+}
+
+// B-orthonormal basis S of the LOBPCG search space with A * S and B * S.
+class LobpcgBasis {
+public:
+    LobpcgBasis(CSCMatrix *A, CSCMatrix *B, int max_ns)
+        : A(A), B(B), n(A->get_size()), max_ns(max_ns), ns(0),
+          S((size_t) max_ns * n), AS((size_t) max_ns * n), BS((size_t) max_ns * n) { }
+
+    void clear() { ns = 0; }
+    int get_size() const { return ns; }
+
+    // Adds 'w' to the basis unless it (nearly) depends on it.
+    void add(const double *w)
+    {
+        if (ns >= max_ns) return;
+        double *s = &S[(size_t) ns * n], *bs = &BS[(size_t) ns * n];
+        memcpy(s, w, n * sizeof(double));
+        csc_multiply(B, s, bs);
+        double norm = sqrt(std::max(dot(n, s, bs), 0.0));
+        double nrm = b_orthogonalize(n, ns, &S[0], &BS[0], s, bs, NULL);
+        if (nrm <= 1e-10 * norm) return;
+        for (int i = 0; i < n; i++) {
+            s[i] /= nrm;
+            bs[i] /= nrm;
+        }
+        csc_multiply(A, s, &AS[(size_t) ns * n]);
+        ns++;
+    }
+
+    // Rayleigh-Ritz step: the 'k' Ritz pairs with the smallest Ritz values ('lambda', 'x'
+    // with 'ax' = A * x and 'bx' = B * x) and the components 'p' of the Ritz vectors
+    // outside of the first 'nx' basis vectors.
+    void rayleigh_ritz(int k, int nx, double *lambda, double *x, double *ax, double *bx, double *p)
+    {
+        std::vector<double> G(ns * ns), C(ns * ns), theta(ns);
+        for (int j = 0; j < ns; j++)
+            for (int i = 0; i <= j; i++)
+                G[j * ns + i] = G[i * ns + j] = 0.5 * (dot(n, &S[(size_t) i * n], &AS[(size_t) j * n]) +
+                                                       dot(n, &S[(size_t) j * n], &AS[(size_t) i * n]));
+        symmetric_eigen(ns, &G[0], &theta[0], &C[0]);
+        for (int i = 0; i < k; i++) {
+            lambda[i] = theta[i];
+            combine(n, ns, &S[0], &C[i * ns], x + (size_t) i * n);
+            combine(n, ns, &AS[0], &C[i * ns], ax + (size_t) i * n);
+            combine(n, ns, &BS[0], &C[i * ns], bx + (size_t) i * n);
+            combine(n, ns - nx, &S[(size_t) nx * n], &C[i * ns + nx], p + (size_t) i * n);
+        }
+    }
+
+protected:
+    CSCMatrix *A, *B;
+    int n, max_ns, ns;
+    std::vector<double> S, AS, BS;
+};
+
+bool EigenSolver::solve_lobpcg(CSCMatrix *A, CSCMatrix *B, int nev, double tol,
+        int max_iter)
+{
+    // Each iteration finds the Ritz vectors of A * x = lambda * B * x in the space
+    // spanned by the current block X, the preconditioned residuals of its unconverged
+    // columns and their previous search directions P. The basis of the space is made
+    // B-orthonormal explicitly, which keeps the Rayleigh-Ritz step stable.
+    int n = size;
+    int bs = std::min(n, nev + std::max(2, nev / 4));   // a few guard vectors
+    LobpcgBasis basis(A, B, std::min(n, 3 * bs));
+    std::vector<double> X((size_t) bs * n), AX((size_t) bs * n), BX((size_t) bs * n);
+    std::vector<double> P((size_t) bs * n), lambda(bs), w(n);
+    unsigned int seed = 1;
+
+    // Jacobi preconditioner
+    std::vector<double> inv_diag(n, 1.0);
+    int *Ap = A->get_Ap(), *Ai = A->get_Ai();
+    double *Ax = A->get_Ax();
+    for (int j = 0; j < n; j++)
+        for (int k = Ap[j]; k < Ap[j + 1]; k++)
+            if (Ai[k] == j && Ax[k] != 0.0) inv_diag[j] = 1.0 / fabs(Ax[k]);
+
+    // random initial block
+    for (int j = 0; j < bs; j++) {
+        for (int i = 0; i < n; i++) w[i] = random_number(seed);
+        basis.add(&w[0]);
+    }
+    if (basis.get_size() < bs)
+        throw std::runtime_error("EigenSolver: LOBPCG could not create the initial block.");
+    basis.rayleigh_ritz(bs, bs, &lambda[0], &X[0], &AX[0], &BX[0], &P[0]);
+
+    bool converged = false;
+    std::vector<int> active;
+    for (num_iters = 0; ; num_iters++) {
+        // residuals
+        active.clear();
+        int nconv = 0;
+        for (int i = 0; i < bs; i++) {
+            double *ax = &AX[(size_t) i * n], *bx = &BX[(size_t) i * n];
+            double rn = 0.0;
+            for (int l = 0; l < n; l++) {
+                double r = ax[l] - lambda[i] * bx[l];
+                rn += r * r;
+            }
+            double scale = sqrt(dot(n, ax, ax)) + fabs(lambda[i]) * sqrt(dot(n, bx, bx));
+            if (sqrt(rn) <= tol * scale) {
+                if (i < nev) nconv++;
+            }
+            else active.push_back(i);
+        }
+        if (nconv == nev) converged = true;
+        if (converged || num_iters >= max_iter) break;
+
+        basis.clear();
+        for (int i = 0; i < bs; i++) basis.add(&X[(size_t) i * n]);
+        int nx = basis.get_size();
+        for (unsigned int a = 0; a < active.size(); a++) {
+            double *ax = &AX[(size_t) active[a] * n], *bx = &BX[(size_t) active[a] * n];
+            for (int l = 0; l < n; l++) w[l] = inv_diag[l] * (ax[l] - lambda[active[a]] * bx[l]);
+            basis.add(&w[0]);
+        }
+        if (num_iters > 0)
+            for (unsigned int a = 0; a < active.size(); a++) basis.add(&P[(size_t) active[a] * n]);
+        if (nx < bs)
+            throw std::runtime_error("EigenSolver: LOBPCG lost the rank of the block.");
+        basis.rayleigh_ritz(bs, nx, &lambda[0], &X[0], &AX[0], &BX[0], &P[0]);
+    }
+
+    eigenvalues.assign(lambda.begin(), lambda.begin() + nev);
+    eigenvectors.assign(X.begin(), X.begin() + (size_t) nev * n);
+    return converged;
+}
+
+#endif
+
 void EigenSolver::solve(int n_eigs, double target_value, double tol,
         int max_iter) {
+#ifdef HERMES_COMMON_COMPLEX
+    throw std::runtime_error("Eigenproblem with complex numbers is not supported.");
+#else
     // Support CSCMatrix only for now:
     RCP<CSCMatrix> A = rcp_dynamic_cast<CSCMatrix>(this->A, true);
     RCP<CSCMatrix> B = rcp_dynamic_cast<CSCMatrix>(this->B, true);
-    wrap_CSC(ptr(&p), "A", A);
-    wrap_CSC(ptr(&p), "B", B);
-    this->p.exec("from eigen import solve_eig_pysparse");
-    this->p.push_double("target_value", target_value);
-    this->p.push_int("n_eigs", n_eigs);
-    this->p.push_double("jdtol", tol);
-    this->p.push_int("max_iter", max_iter);
+    if (A->get_size() != B->get_size())
+        throw std::runtime_error("The matrices A and B must have the same size.");
+    this->size = A->get_size();
+    this->n_eigs = 0;
+    this->num_iters = 0;
+    n_eigs = std::min(n_eigs, this->size);
+    if (n_eigs <= 0) return;
 
     printf("Solving the system A * x = lambda * B * x\n");
-    this->p.exec("eigs = solve_eig_pysparse(A, B, target_value=target_value, n_eigs=n_eigs, jdtol=jdtol, max_iter=max_iter)");
-    this->p.exec("n_eigs = len(eigs)");
-    this->n_eigs = this->p.pull_int("n_eigs");
+    bool converged;
+    if (this->method == EIGEN_LOBPCG)
+        converged = solve_lobpcg(A.get(), B.get(), n_eigs, tol, max_iter);
+    else
+        converged = solve_lanczos(A.get(), B.get(), n_eigs, target_value, tol, max_iter);
+    if (!converged)
+        warning("EigenSolver: not all eigenpairs converged in %d iterations.", max_iter);
+    this->n_eigs = n_eigs;
+#endif
 }
 
 double EigenSolver::get_eigenvalue(int i)
 {
-    if (i >= 0 && i < this->n_eigs) {
-        this->p.push_int("i", i);
-        this->p.exec("E = eigs[i][0]");
-        return this->p.pull_double("E");
-    } else
+    if (i >= 0 && i < this->n_eigs)
+        return this->eigenvalues[i];
+    else
         throw std::runtime_error("'i' must obey 0 <= i < n_eigs");
 }
 
 void EigenSolver::get_eigenvector(int i, double **vec, int *n)
 {
     if (i >= 0 && i < this->n_eigs) {
-        this->p.push_int("i", i);
-        this->p.exec("vec = eigs[i][1]");
-        this->p.pull_numpy_double_inplace("vec", vec, n);
+        *vec = &this->eigenvectors[(size_t) i * this->size];
+        *n = this->size;
     } else
         throw std::runtime_error("'i' must obey 0 <= i < n_eigs");
 }
@@ -2,8 +2,7 @@
 #define __HERMES_EIGENSOLVER_H
 
 #include "../matrix.h"
-
-#include "../python/python_api.h"
+#include "umfpack_solver.h"
 
 #include "../config.h"
 // RCP
@@ -13,6 +12,8 @@
 #include "Teuchos_RCP.hpp"
 #endif
 
+#include <vector>
+
 namespace Hermes {
 
 using Teuchos::RCP;
@@ -20,14 +21,36 @@ using Teuchos::Ptr;
 using Teuchos::rcp;
 using Teuchos::null;
 
+// Methods for the generalized eigenproblem A * x = lambda * B * x.
+enum EigenSolverMethod {
+    // Lanczos method for the operator (A - target * B)^-1 * B with thick restarts,
+    // computes the eigenvalues closest to the target. Each step solves with the LU
+    // factorization of A - target * B (UMFPACK, or the band solver if Hermes is built
+    // without UMFPACK).
+    EIGEN_SHIFT_INVERT_LANCZOS,
+    // Locally optimal block preconditioned conjugate gradients (Knyazev) with the
+    // Jacobi preconditioner, computes the smallest eigenvalues (the target is not used).
+    // Needs no factorization, only products with A and B.
+    EIGEN_LOBPCG
+};
+
+// Native solver of the generalized eigenproblem A * x = lambda * B * x with
+// symmetric A and symmetric positive definite B, both given as CSCMatrix
+// (UMFPackMatrix). The eigenvectors are B-orthonormal.
 class HERMES_API EigenSolver {
 public:
-    EigenSolver(const RCP<Matrix> &A, const RCP<Matrix> &B);
+    EigenSolver(const RCP<Matrix> &A, const RCP<Matrix> &B,
+                EigenSolverMethod method = EIGEN_SHIFT_INVERT_LANCZOS);
 
+    void set_method(EigenSolverMethod method) {
+        this->method = method;
+    }
 
     // Solves for 'n_eigs' eigenvectors, around the 'target_value'. Use
     // 'get_eigenvalue' and 'get_eigenvector' to retrieve the
-    // eigenvalues/eigenvectors:
+    // eigenvalues/eigenvectors (sorted by the eigenvalues). 'tol' is the
+    // relative residual of the eigenpairs, 'max_iter' the maximum number of
+    // restarts (Lanczos) or iterations (LOBPCG):
     void solve(int n_eigs=4, double target_value=-1, double tol=1e-6,
                int max_iter=150);
 
@@ -35,6 +58,10 @@ public:
     int get_n_eigs() {
         return this->n_eigs;
     }
+    // Returns the number of restarts/iterations of the last solve()
+    int get_num_iters() {
+        return this->num_iters;
+    }
     // Returns the i-th eigenvalue
     double get_eigenvalue(int i);
     // Returns the i-th eigenvector. A pointer will be returned into an
@@ -52,8 +79,16 @@ public:
 
 private:
     RCP<Matrix> A, B;
-    int n_eigs;
-    Python p;
+    EigenSolverMethod method;
+    int n_eigs, num_iters;
+    int size;
+    std::vector<double> eigenvalues;
+    std::vector<double> eigenvectors;   // n_eigs vectors of length 'size'
+
+    bool solve_lanczos(CSCMatrix *A, CSCMatrix *B, int n_eigs, double target_value,
+                       double tol, int max_iter);
+    bool solve_lobpcg(CSCMatrix *A, CSCMatrix *B, int n_eigs, double tol,
+                      int max_iter);
 };
 
 }
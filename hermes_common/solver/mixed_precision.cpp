@@ -0,0 +1,417 @@
+// This file is part of Hermes
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#include "mixed_precision.h"
+#include "banded.h"
+
+#include "../error.h"
+#include "../utils.h"
+#include "../callstack.h"
+#include "../common_time_period.h"
+
+// Relative tolerance of GMRES in a refinement step. The corrections need not be accurate,
+// the outer refinement takes care of the rest.
+static const double GMRES_TOLERANCE = 1e-6;
+
+// Entries below this value are dropped in the single precision factorization of the scaled
+// matrix (their products would be denormal numbers); the error is far below the single
+// precision roundoff and is corrected by the refinement anyway.
+static const double SINGLE_DROP_TOLERANCE = 1e-19;
+
+static double max_norm(const scalar *x, int n)
+{
+  double nrm = 0.0;
+  for (int i = 0; i < n; i++) nrm = std::max(nrm, magn(x[i]));
+  return nrm;
+}
+
+MixedPrecisionLinearSolver::MixedPrecisionLinearSolver(CSCMatrix *m, UMFPackVector *rhs)
+  : LinearSolver(HERMES_FACTORIZE_FROM_SCRATCH), m(m), rhs(rhs), tolerance(0.0), max_steps(30),
+    max_gmres_iters(30), num_steps(0), num_gmres_iters(0), backward_error(0.0),
+    perm(NULL), iperm(NULL), kl(0), ku(0), lu_size(0), lu_ldab(0), lu_kv(0), lu_scale(1.0),
+    lu(NULL), dlu(NULL), ipiv(NULL)
+{
+  _F_
+}
+
+MixedPrecisionLinearSolver::~MixedPrecisionLinearSolver()
+{
+  _F_
+  free_factorization_data();
+  delete [] perm;
+  delete [] iperm;
+}
+
+bool MixedPrecisionLinearSolver::solve()
+{
+  _F_
+  assert(m != NULL);
+  assert(rhs != NULL);
+
+  assert(m->get_size() == rhs->length());
+
+  scalar *b = new scalar[rhs->length()];
+  MEM_CHECK(b);
+  rhs->extract(b);
+  bool ret = solve_multiple_rhs(b, 1);
+  delete [] b;
+  return ret;
+}
+
+bool MixedPrecisionLinearSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs)
+{
+  _F_
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+
+  TimePeriod tmr;
+
+  int n = m->get_size();
+  bool have_factors = (lu != NULL || dlu != NULL) && lu_size == n;
+  bool reused = have_factors && factorization_scheme == HERMES_REUSE_FACTORIZATION_COMPLETELY;
+  if (!reused) {
+    if (!have_factors || factorization_scheme == HERMES_FACTORIZE_FROM_SCRATCH) reorder();
+    if (!factorize(false)) {
+      warning("Single precision LU factorization failed, factorizing in double precision.");
+      if (!factorize(true)) {
+        warning("LU factorization could not be completed.");
+        return false;
+      }
+    }
+  }
+
+  if(sln)
+    delete [] sln;
+  sln = new scalar[n * num_rhs];
+  MEM_CHECK(sln);
+
+  // infinity norm of the matrix
+  double *row_sum = new double[n];
+  MEM_CHECK(row_sum);
+  memset(row_sum, 0, n * sizeof(double));
+  int *Ap = m->get_Ap(), *Ai = m->get_Ai();
+  scalar *Ax = m->get_Ax();
+  for (int j = 0; j < n; j++)
+    for (int k = Ap[j]; k < Ap[j + 1]; k++) row_sum[Ai[k]] += magn(Ax[k]);
+  double anorm = 0.0;
+  for (int i = 0; i < n; i++) anorm = std::max(anorm, row_sum[i]);
+  delete [] row_sum;
+
+  double tol = tolerance > 0.0 ? tolerance : sqrt((double) n) * DBL_EPSILON;
+  num_steps = num_gmres_iters = 0;
+  backward_error = 0.0;
+  for (int k = 0; k < num_rhs; k++) {
+    scalar *b = rhs_block + k * n, *x = sln + k * n;
+    double omega = refine(b, x, anorm, tol);
+    // the factors of a different matrix or in single precision may not be good enough,
+    // the remaining right-hand sides are solved with the new ones
+    if (omega > tol && (reused || dlu == NULL)) {
+      warning("Iterative refinement did not converge (backward error %g), "
+              "factorizing in double precision.", omega);
+      reused = false;
+      if (!factorize(true)) {
+        warning("LU factorization could not be completed.");
+        return false;
+      }
+      omega = refine(b, x, anorm, tol);
+    }
+    backward_error = std::max(backward_error, omega);
+  }
+
+  tmr.tick();
+  time = tmr.accumulated();
+
+  if (backward_error > tol) {
+    warning("Iterative refinement did not reach the tolerance %g (backward error %g).", tol, backward_error);
+    return false;
+  }
+  return true;
+}
+
+void MixedPrecisionLinearSolver::reorder()
+{
+  _F_
+  int n = m->get_size();
+  delete [] perm;
+  delete [] iperm;
+  perm = new int[n];
+  iperm = new int[n];
+  MEM_CHECK(perm);
+  MEM_CHECK(iperm);
+  band_ordering(n, m->get_Ap(), m->get_Ai(), perm, iperm, kl, ku);
+  // the factors belong to the previous ordering
+  free_factorization_data();
+}
+
+bool MixedPrecisionLinearSolver::factorize(bool double_precision)
+{
+  _F_
+  free_factorization_data();
+
+  int n = m->get_size();
+  int kv = kl + ku;       // the fill-in takes kl superdiagonals (partial pivoting)
+  int ld = kv + kl + 1;
+  if (double_precision) {
+    dlu = new scalar[ld * n];
+    MEM_CHECK(dlu);
+    memset(dlu, 0, sizeof(scalar) * ld * n);
+  }
+  else {
+    lu = new lowp[ld * n];
+    MEM_CHECK(lu);
+    memset(lu, 0, sizeof(lowp) * ld * n);
+  }
+  ipiv = new int[n];
+  MEM_CHECK(ipiv);
+
+  // the matrix is scaled so that its largest entry is 1 to keep it in the range of floats
+  int *Ap = m->get_Ap(), *Ai = m->get_Ai();
+  scalar *Ax = m->get_Ax();
+  double amax = 0.0;
+  for (int k = 0; k < Ap[n]; k++) amax = std::max(amax, magn(Ax[k]));
+  lu_scale = amax > 0.0 ? 1.0 / amax : 1.0;
+
+  for (int j = 0; j < n; j++) {
+    int pj = perm[j];
+    for (int k = Ap[j]; k < Ap[j + 1]; k++) {
+      int idx = pj * ld + kv + perm[Ai[k]] - pj;
+      if (double_precision)
+        dlu[idx] += Ax[k] * lu_scale;
+      else
+        lu[idx] += lowp(Ax[k] * lu_scale);
+    }
+  }
+
+  int j;
+  if (double_precision)
+    j = band_lu_factor(n, kl, ku, kv, dlu, ld, ipiv);
+  else {
+    j = band_lu_factor(n, kl, ku, kv, lu, ld, ipiv, SINGLE_DROP_TOLERANCE);
+    // overflow in the single precision elimination
+    for (int i = 0; i < n && j < 0; i++)
+      if (!(std::abs(lu[i * ld + kv]) <= FLT_MAX)) j = i;
+  }
+  if (j >= 0) {
+    free_factorization_data();
+    return false;
+  }
+
+  lu_size = n;
+  lu_ldab = ld;
+  lu_kv = kv;
+  return true;
+}
+
+void MixedPrecisionLinearSolver::free_factorization_data()
+{
+  _F_
+  delete [] lu;
+  delete [] dlu;
+  delete [] ipiv;
+  lu = NULL;
+  dlu = NULL;
+  ipiv = NULL;
+  lu_size = 0;
+}
+
+void MixedPrecisionLinearSolver::precondition(const scalar *r, scalar *z)
+{
+  _F_
+  int n = lu_size;
+  // r is scaled to avoid underflow of the small residuals in single precision
+  double rnorm = max_norm(r, n);
+  if (rnorm == 0.0) {
+    for (int i = 0; i < n; i++) z[i] = 0.0;
+    return;
+  }
+  double factor = lu_scale * rnorm;
+
+  if (dlu != NULL) {
+    scalar *w = new scalar[n];
+    MEM_CHECK(w);
+    for (int i = 0; i < n; i++) w[perm[i]] = r[i] / rnorm;
+    band_lu_solve(n, kl, lu_kv, dlu, lu_ldab, ipiv, w);
+    for (int i = 0; i < n; i++) z[i] = w[perm[i]] * factor;
+    delete [] w;
+  }
+  else {
+    lowp *w = new lowp[n];
+    MEM_CHECK(w);
+    for (int i = 0; i < n; i++) w[perm[i]] = lowp(r[i] / rnorm);
+    band_lu_solve(n, kl, lu_kv, lu, lu_ldab, ipiv, w);
+    for (int i = 0; i < n; i++) z[i] = scalar(w[perm[i]]) * factor;
+    delete [] w;
+  }
+}
+
+void MixedPrecisionLinearSolver::multiply(const scalar *x, scalar *y)
+{
+  _F_
+  int n = m->get_size();
+  int *Ap = m->get_Ap(), *Ai = m->get_Ai();
+  scalar *Ax = m->get_Ax();
+  for (int i = 0; i < n; i++) y[i] = 0.0;
+  for (int j = 0; j < n; j++) {
+    scalar xj = x[j];
+    for (int k = Ap[j]; k < Ap[j + 1]; k++) y[Ai[k]] += Ax[k] * xj;
+  }
+}
+
+double MixedPrecisionLinearSolver::refine(const scalar *b, scalar *x, double anorm, double tol)
+{
+  _F_
+  int n = m->get_size();
+  scalar *r = new scalar[n];
+  scalar *d = new scalar[n];
+  MEM_CHECK(r);
+  MEM_CHECK(d);
+
+  double bnorm = max_norm(b, n);
+  precondition(b, x);
+
+  bool use_gmres = false;
+  double omega, omega_prev = HUGE_VAL;
+  for (int step = 0; ; step++) {
+    multiply(x, r);
+    for (int i = 0; i < n; i++) r[i] = b[i] - r[i];
+    double denom = anorm * max_norm(x, n) + bnorm;
+    omega = denom > 0.0 ? max_norm(r, n) / denom : 0.0;
+    if (omega <= tol || step >= max_steps) break;
+
+    // the refinement stagnates, switch to GMRES-IR (or give up if it already is used)
+    if (omega > 0.5 * omega_prev) {
+      if (use_gmres || max_gmres_iters <= 0) break;
+      use_gmres = true;
+    }
+
+    if (use_gmres)
+      num_gmres_iters += gmres(r, d, GMRES_TOLERANCE);
+    else
+      precondition(r, d);
+    for (int i = 0; i < n; i++) x[i] += d[i];
+    num_steps++;
+    omega_prev = omega;
+  }
+
+  delete [] r;
+  delete [] d;
+  return omega;
+}
+
+int MixedPrecisionLinearSolver::gmres(const scalar *r, scalar *d, double tol)
+{
+  _F_
+  int n = m->get_size();
+  int mk = max_gmres_iters;
+
+  double beta = 0.0;
+  for (int i = 0; i < n; i++) beta += sqr(magn(r[i]));
+  beta = sqrt(beta);
+  if (beta == 0.0) {
+    for (int i = 0; i < n; i++) d[i] = 0.0;
+    return 0;
+  }
+
+  // Arnoldi basis v, preconditioned basis vectors z_k = M^-1 v_k (kept, since the single
+  // precision solves are not accurate enough to be repeated on their combination when the
+  // matrix is ill-conditioned, i.e., this is the flexible GMRES), Hessenberg matrix
+  // (column-wise) reduced to the upper triangular form by Givens rotations (c, s) and
+  // the rotated right-hand side g
+  scalar *v = new scalar[(mk + 1) * n];
+  scalar *z = new scalar[mk * n];
+  scalar *h = new scalar[(mk + 1) * mk];
+  double *c = new double[mk];
+  scalar *s = new scalar[mk];
+  scalar *g = new scalar[mk + 1];
+  MEM_CHECK(v);
+  MEM_CHECK(z);
+  MEM_CHECK(h);
+  MEM_CHECK(c);
+  MEM_CHECK(s);
+  MEM_CHECK(g);
+
+  for (int i = 0; i < n; i++) v[i] = r[i] / beta;
+  g[0] = beta;
+
+  int its = 0;
+  while (its < mk) {
+    int k = its++;
+    scalar *hk = h + k * (mk + 1);
+    scalar *w = v + (k + 1) * n;
+
+    // w = A M^-1 v_k, orthogonalized by the modified Gram-Schmidt
+    precondition(v + k * n, z + k * n);
+    multiply(z + k * n, w);
+    for (int i = 0; i <= k; i++) {
+      scalar *vi = v + i * n;
+      scalar dot = 0.0;
+      for (int l = 0; l < n; l++) dot += conj(vi[l]) * w[l];
+      hk[i] = dot;
+      for (int l = 0; l < n; l++) w[l] -= dot * vi[l];
+    }
+    double hnorm = 0.0;
+    for (int l = 0; l < n; l++) hnorm += sqr(magn(w[l]));
+    hnorm = sqrt(hnorm);
+    hk[k + 1] = hnorm;
+    if (hnorm != 0.0)
+      for (int l = 0; l < n; l++) w[l] /= hnorm;
+
+    // apply the previous rotations to the new column and eliminate its subdiagonal entry
+    for (int i = 0; i < k; i++) {
+      scalar t = c[i] * hk[i] + s[i] * hk[i + 1];
+      hk[i + 1] = -conj(s[i]) * hk[i] + c[i] * hk[i + 1];
+      hk[i] = t;
+    }
+    double a = magn(hk[k]);
+    if (a == 0.0) {
+      c[k] = 0.0;
+      s[k] = 1.0;
+      hk[k] = hk[k + 1];
+    }
+    else {
+      double t = sqrt(sqr(a) + sqr(hnorm));
+      scalar alpha = hk[k] / a;
+      c[k] = a / t;
+      s[k] = alpha * hnorm / t;
+      hk[k] = alpha * t;
+    }
+    hk[k + 1] = 0.0;
+    g[k + 1] = -conj(s[k]) * g[k];
+    g[k] = c[k] * g[k];
+
+    if (magn(g[k + 1]) <= tol * beta || hnorm == 0.0) break;
+  }
+
+  // y = H^-1 g (stored in g), d = Z y
+  for (int i = its - 1; i >= 0; i--) {
+    for (int j = i + 1; j < its; j++) g[i] -= h[j * (mk + 1) + i] * g[j];
+    g[i] /= h[i * (mk + 1) + i];
+  }
+  for (int l = 0; l < n; l++) d[l] = 0.0;
+  for (int i = 0; i < its; i++)
+    for (int l = 0; l < n; l++) d[l] += g[i] * z[i * n + l];
+
+  delete [] v;
+  delete [] h;
+  delete [] c;
+  delete [] s;
+  delete [] g;
+  delete [] z;
+  return its;
+}
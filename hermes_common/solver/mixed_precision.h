@@ -0,0 +1,125 @@
+// This file is part of Hermes
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+
+#ifndef __HERMES_COMMON_MIXED_PRECISION_H_
+#define __HERMES_COMMON_MIXED_PRECISION_H_
+
+#include "solver.h"
+#include "umfpack_solver.h"
+
+/// Direct solver with a single precision factorization and iterative refinement.
+///
+/// The matrix (a CSCMatrix, e.g. UMFPackMatrix) is reordered by the reverse Cuthill-McKee
+/// algorithm and a single precision copy of it (float, std::complex<float> in the complex
+/// build) is factorized by the band LU with partial pivoting. The solution is then refined
+/// to the double precision accuracy: the
+/// residual r = b - A x is computed in double precision with the original matrix and the
+/// correction is obtained from the single precision factors. If the refinement stagnates
+/// (the backward error is not at least halved in a step), the corrections are computed by
+/// GMRES with the factors as a (right) preconditioner instead (GMRES-IR), which converges
+/// also for matrices whose condition number is close to the reciprocal of the single
+/// precision unit roundoff. If the matrix cannot be factorized in single precision or
+/// the refinement fails anyway, it is factorized in double precision.
+///
+/// The refinement stops when the normwise backward error ||r|| / (||A|| ||x|| + ||b||)
+/// (infinity norms) drops below the tolerance, by default sqrt(n) times the double
+/// precision machine epsilon (as in LAPACK's dsgesv).
+///
+/// The factorization is kept. HERMES_REUSE_FACTORIZATION_COMPLETELY solves with it also
+/// when the matrix has changed since, the refinement against the current matrix corrects
+/// for the difference (slower convergence is the only price of a matrix that differs much).
+/// HERMES_REUSE_MATRIX_REORDERING (and _AND_SCALING) factorize the current matrix in the
+/// existing ordering, which assumes the same sparsity pattern.
+///
+/// Memory: the factors take n * (2 kl + ku + 1) floats, where kl and ku are the bandwidths
+/// after the reordering. This is half of what the double precision band LU
+/// (BandLinearSolver) needs, but it is not a saving over the sparse factorization of
+/// UMFPACK: the bandwidth of 2D meshes grows like sqrt(n) and that of 3D meshes like n^(2/3),
+/// so the band takes O(n^1.5) and O(n^(5/3)) entries, respectively, which is usually much
+/// more than the sparse double precision factors. The solver thus suits problems with
+/// a small bandwidth (1D, thin domains, systems that are narrow after the reordering); it
+/// does not make large 2D/3D problems fit into memory.
+///
+/// @ingroup solvers
+class HERMES_API MixedPrecisionLinearSolver : public LinearSolver {
+public:
+  MixedPrecisionLinearSolver(CSCMatrix *m, UMFPackVector *rhs);
+  virtual ~MixedPrecisionLinearSolver();
+
+  /// Returns false if the required accuracy has not been reached (the best solution found
+  /// is available anyway).
+  virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
+
+  /// Tolerance of the backward error, a nonpositive value selects the default one.
+  void set_tolerance(double tol) { this->tolerance = tol; }
+  /// Maximum number of refinement steps (after the initial solve).
+  void set_max_refinement_steps(int steps) { this->max_steps = steps; }
+  /// Maximum number of GMRES iterations in a refinement step.
+  void set_max_gmres_iters(int iters) { this->max_gmres_iters = iters; }
+
+  /// Statistics of the last solve() (the backward error is the largest one for multiple
+  /// right-hand sides).
+  int get_num_refinement_steps() const { return num_steps; }
+  int get_num_gmres_iters() const { return num_gmres_iters; }
+  double get_backward_error() const { return backward_error; }
+  /// True if the factorization is in double precision (the single precision one failed).
+  bool is_double_precision() const { return dlu != NULL; }
+
+protected:
+#ifdef HERMES_COMMON_COMPLEX
+  typedef std::complex<float> lowp;
+#else
+  typedef float lowp;
+#endif
+
+  CSCMatrix *m;
+  UMFPackVector *rhs;
+
+  double tolerance;
+  int max_steps, max_gmres_iters;
+  int num_steps, num_gmres_iters;
+  double backward_error;
+
+  // Ordering and the LU factorization of the reordered matrix (scaled by 'lu_scale') in the
+  // band format, see BandLinearSolver; 'lu' in single, 'dlu' in double precision (only one
+  // of them is allocated).
+  int *perm, *iperm;
+  int kl, ku, lu_size, lu_ldab, lu_kv;
+  double lu_scale;
+  lowp *lu;
+  scalar *dlu;
+  int *ipiv;
+
+  void reorder();
+  bool factorize(bool double_precision);
+  void free_factorization_data();
+
+  // z = A^-1 r using the factors.
+  void precondition(const scalar *r, scalar *z);
+  // y = A x.
+  void multiply(const scalar *x, scalar *y);
+  // Computes d such that ||r - A d|| <= tol ||r|| by GMRES preconditioned (from the right)
+  // by the factors, returns the number of iterations.
+  int gmres(const scalar *r, scalar *d, double tol);
+  // Solves A x = b with the factors and refines x, returns the backward error reached.
+  double refine(const scalar *b, scalar *x, double anorm, double tol);
+};
+
+#endif
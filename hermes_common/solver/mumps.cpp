@@ -611,10 +611,23 @@ bool MumpsSolver::solve()
 {
   _F_
 #ifdef WITH_MUMPS
-  bool ret = false;
   assert(m != NULL);
   assert(rhs != NULL);
 
+  return solve_multiple_rhs(rhs->v, 1);
+#else
+  return false;
+#endif
+}
+
+bool MumpsSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs)
+{
+  _F_
+#ifdef WITH_MUMPS
+  bool ret = false;
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+
   TimePeriod tmr;
 
   // Prepare the MUMPS data structure with input for the solver driver 
@@ -626,9 +639,13 @@ bool MumpsSolver::solve()
     return false;
   }
   
-  // Specify the right-hand side (will be replaced by the solution).
-  param.rhs = new mumps_scalar[m->size];
-  memcpy(param.rhs, rhs->v, m->size * sizeof(mumps_scalar));
+  // Specify the right-hand sides (will be replaced by the solutions), stored column-wise
+  // with the leading dimension equal to the size of the system.
+  int size = m->size * num_rhs;
+  param.rhs = new mumps_scalar[size];
+  memcpy(param.rhs, rhs_block, size * sizeof(mumps_scalar));
+  param.nrhs = num_rhs;
+  param.lrhs = m->size;
   
   // Do the jobs specified in setup_factorization().
   MUMPS(&param);
@@ -638,12 +655,12 @@ bool MumpsSolver::solve()
   if (ret) 
   {
     delete [] sln;
-    sln = new scalar[m->size];
+    sln = new scalar[size];
 #ifndef HERMES_COMMON_COMPLEX
-    for (unsigned int i = 0; i < rhs->size; i++)
+    for (int i = 0; i < size; i++)
       sln[i] = param.rhs[i];
 #else
-    for (unsigned int i = 0; i < rhs->size; i++)
+    for (int i = 0; i < size; i++)
       sln[i] = cplx(param.rhs[i].r, param.rhs[i].i);
 #endif
   }
@@ -653,6 +670,7 @@ bool MumpsSolver::solve()
 
   delete [] param.rhs;
   param.rhs = NULL;
+  param.nrhs = 1;
 
   return ret;
 #else
@@ -141,6 +141,7 @@ public:
   virtual ~MumpsSolver();
 
   virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
 
 protected:
   MumpsMatrix *m;
@@ -463,3 +463,59 @@ bool PetscLinearSolver::solve() {
   return false;
 #endif
 }
+
+bool PetscLinearSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs) {
+  _F_
+#ifdef WITH_PETSC
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+
+  PetscErrorCode ec;
+  KSP ksp;
+  Vec b, x;
+
+  TimePeriod tmr;
+
+  // One solver context for all right-hand sides, so the preconditioner is set up only once.
+  KSPCreate(PETSC_COMM_WORLD, &ksp);
+
+  KSPSetOperators(ksp, m->matrix, m->matrix, DIFFERENT_NONZERO_PATTERN);
+  KSPSetFromOptions(ksp);
+  MatGetVecs(m->matrix, &x, &b);
+
+  // allocate memory for solution vectors
+  int n = m->size;
+  delete [] sln;
+  sln = new scalar [n * num_rhs];
+  MEM_CHECK(sln);
+  memset(sln, 0, n * num_rhs * sizeof(scalar));
+
+  // index map vector (basic serial code uses the map sln[i] = x[i] for all dofs.
+  int *idx = new int [n];
+  MEM_CHECK(idx);
+  for (int i = 0; i < n; i++) idx[i] = i;
+
+  bool ret = true;
+  for (int k = 0; k < num_rhs && ret; k++) {
+    VecSetValues(b, n, idx, (PetscScalar *) (rhs_block + k * n), INSERT_VALUES);
+    VecAssemblyBegin(b);
+    VecAssemblyEnd(b);
+
+    ec = KSPSolve(ksp, b, x);
+    if (ec) ret = false;
+    else VecGetValues(x, n, idx, (PetscScalar *) (sln + k * n));
+  }
+  delete [] idx;
+
+  KSPDestroy(ksp);
+  VecDestroy(x);
+  VecDestroy(b);
+
+  tmr.tick();
+  time = tmr.accumulated();
+
+  return ret;
+#else
+  return false;
+#endif
+}
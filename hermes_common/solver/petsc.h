@@ -120,6 +120,7 @@ public:
   virtual ~PetscLinearSolver();
 
   virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
 
 protected:
   PetscMatrix *m;
@@ -93,6 +93,14 @@ public:
   virtual bool solve() = 0;
   scalar *get_solution() { return sln; }
 
+  /// Solves the system with 'num_rhs' right-hand sides stored one after another in
+  /// 'rhs_block' (an n x num_rhs dense block stored column-wise, n being the size of the
+  /// system); the right-hand side vector of the solver is not used. The matrix is factorized
+  /// (or the preconditioner set up) only once, according to the factorization scheme.
+  /// The solutions are returned by get_solution() in the same layout.
+  /// Returns false if the solution failed or the solver does not support it.
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs) { return false; }
+
   int get_error() { return error; }
   double get_time() { return time; }
   
@@ -570,6 +570,19 @@ bool SuperLUSolver::solve()
   assert(m != NULL);
   assert(rhs != NULL);
   
+  return solve_multiple_rhs(rhs->v, 1);
+#else
+  return false;
+#endif
+}
+
+bool SuperLUSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs)
+{
+  _F_
+#ifdef WITH_SUPERLU
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+  
   TimePeriod tmr;
   
   // Initialize the statistics variable.
@@ -582,9 +595,9 @@ bool SuperLUSolver::solve()
                             // (unused, see below).
   int lwork = 0;            // Space for the factorization will be allocated 
                             // internally by system malloc.
-  double ferr = 1.0;        // Estimated relative forward error 
+  double *ferr = new double[num_rhs]; // Estimated relative forward errors 
                             // (unused unless iterative refinement is performed).
-  double berr = 1.0;        // Estimated relative backward error 
+  double *berr = new double[num_rhs]; // Estimated relative backward errors 
                             // (unused unless iterative refinement is performed).
   slu_memusage_t memusage;  // Record the memory usage statistics.
   double rpivot_growth;     // The reciprocal pivot growth factor.
@@ -597,6 +610,8 @@ bool SuperLUSolver::solve()
   if ( !setup_factorization() )
   {
     warning("LU factorization could not be completed.");
+    delete [] ferr;
+    delete [] berr;
     return false;
   }
   
@@ -632,23 +647,24 @@ bool SuperLUSolver::solve()
     }
   }
 
-  // Recreate the input rhs for the solver driver from a local copy of the new value array.
+  // Recreate the input rhs for the solver driver from a local copy of the new value array
+  // (all right-hand sides are solved by one call of the driver).
   free_rhs();
  
   if (local_rhs) delete [] local_rhs;
-  local_rhs = new slu_scalar [rhs->size];
-  memcpy(local_rhs, rhs->v, rhs->size * sizeof(slu_scalar));
+  local_rhs = new slu_scalar [m->size * num_rhs];
+  memcpy(local_rhs, rhs_block, m->size * num_rhs * sizeof(slu_scalar));
   
-  SLU_CREATE_DENSE_MATRIX(&B, rhs->size, 1, local_rhs, rhs->size, SLU_DN, SLU_DTYPE, SLU_GE);
+  SLU_CREATE_DENSE_MATRIX(&B, m->size, num_rhs, local_rhs, m->size, SLU_DN, SLU_DTYPE, SLU_GE);
   
   has_B = true;
   
   // Initialize the solution variable.
   SuperMatrix X;
   slu_scalar *x;
-  if ( !(x = SLU_SCALAR_MALLOC(m->size)) ) 
+  if ( !(x = SLU_SCALAR_MALLOC(m->size * num_rhs)) ) 
     error("Malloc fails for x[].");
-  SLU_CREATE_DENSE_MATRIX(&X, m->size, 1, x, m->size, SLU_DN, SLU_DTYPE, SLU_GE);
+  SLU_CREATE_DENSE_MATRIX(&X, m->size, num_rhs, x, m->size, SLU_DN, SLU_DTYPE, SLU_GE);
     
   // Solve the system.
   int info;
@@ -694,7 +710,7 @@ bool SuperLUSolver::solve()
 */
 #else
   SLU_SOLVER_DRIVER(&options, &A, perm_c, perm_r, etree, equed, R, C, &L, &U,
-                    work, lwork, &B, &X, &rpivot_growth, &rcond, &ferr, &berr,
+                    work, lwork, &B, &X, &rpivot_growth, &rcond, ferr, berr,
                     &memusage, &stat, &info);
 #endif
                     
@@ -713,11 +729,11 @@ bool SuperLUSolver::solve()
   if (factorized) 
   {
     delete [] sln;
-    sln = new scalar[m->size];
+    sln = new scalar[m->size * num_rhs];
     
     slu_scalar *sol = (slu_scalar*) ((DNformat*) X.Store)->nzval; 
     
-    for (unsigned int i = 0; i < rhs->size; i++)
+    for (unsigned int i = 0; i < m->size * num_rhs; i++)
 #ifndef HERMES_COMMON_COMPLEX      
       sln[i] = sol[i];
 #else
@@ -732,6 +748,8 @@ bool SuperLUSolver::solve()
   StatFree(&stat);
   SUPERLU_FREE (x);
   Destroy_SuperMatrix_Store(&X);
+  delete [] ferr;
+  delete [] berr;
   
   tmr.tick();
   time = tmr.accumulated();
@@ -987,16 +1005,19 @@ void slu_mt_solver_driver(slu_options_t *options, SuperMatrix *A,
   /* ------------------------------------------------------------
   Scale the right hand side.
   ------------------------------------------------------------*/
+  int nrhs = B->ncol, ldb = Bstore->lda, ldx = Xstore->lda;
   if ( notran ) 
   {
     if ( rowequ ) 
-      for (int i = 0; i < A->nrow; ++i) 
-        SLU_MULT(Bmat[i], R[i]);
+      for (int j = 0; j < nrhs; ++j)
+        for (int i = 0; i < A->nrow; ++i) 
+          SLU_MULT(Bmat[i + j * ldb], R[i]);
   } 
   else if ( colequ ) 
   {
-    for (int i = 0; i < A->nrow; ++i)
-      SLU_MULT(Bmat[i], C[i]);
+    for (int j = 0; j < nrhs; ++j)
+      for (int i = 0; i < A->nrow; ++i)
+        SLU_MULT(Bmat[i + j * ldb], C[i]);
   }
   
   /* ------------------------------------------------------------
@@ -1069,7 +1090,8 @@ void slu_mt_solver_driver(slu_options_t *options, SuperMatrix *A,
       Compute the solution matrix X.
       ------------------------------------------------------------*/
     // Save a copy of the right hand side.
-    memcpy(Xmat, Bmat, B->nrow * sizeof(slu_scalar)); 
+    for (int j = 0; j < nrhs; ++j)
+      memcpy(Xmat + j * ldx, Bmat + j * ldb, B->nrow * sizeof(slu_scalar)); 
             
     t0 = SuperLU_timer_();
     SLU_GSTRS(options->trans, L, U, perm_r, perm_c, X, stat, info);
@@ -1095,13 +1117,15 @@ void slu_mt_solver_driver(slu_options_t *options, SuperMatrix *A,
     if ( notran ) 
     {
       if ( colequ ) 
-        for (int i = 0; i < A->nrow; ++i)
-          SLU_MULT(Xmat[i], C[i]);
+        for (int j = 0; j < nrhs; ++j)
+          for (int i = 0; i < A->nrow; ++i)
+            SLU_MULT(Xmat[i + j * ldx], C[i]);
     } 
     else if ( rowequ ) 
     {
-      for (int i = 0; i < A->nrow; ++i)
-        SLU_MULT(Xmat[i], R[i]);
+      for (int j = 0; j < nrhs; ++j)
+        for (int i = 0; i < A->nrow; ++i)
+          SLU_MULT(Xmat[i + j * ldx], R[i]);
     }
 
     /* Set INFO = A->ncol+1 if the matrix is singular to 
@@ -218,6 +218,7 @@ public:
   virtual ~SuperLUSolver();
 
   virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
   
 protected:
   SuperLUMatrix *m;       
@@ -0,0 +1,148 @@
+#define HERMES_REPORT_WARN
+#define HERMES_REPORT_INFO
+
+#include "common.h"
+#include "config.h"
+
+#include "solver/eigensolver.h"
+
+#include <algorithm>
+#include <vector>
+
+// Test of the eigensolver.
+// Solves the generalized eigenproblem K x = lambda M x of the Laplace operator
+// discretized by linear elements on an n x n grid of the unit square with zero
+// boundary values. The stiffness and mass matrices are the tensor products
+// K = K1 x M1 + M1 x K1, M = M1 x M1 of the 1D matrices, so the eigenvalues are
+// the sums lambda_i + lambda_j of the 1D ones, which are known exactly. Several
+// eigenvalues are double. The computed eigenvalues are compared with the exact
+// ones closest to the target (the smallest ones for LOBPCG) and the residuals
+// of the eigenpairs are checked.
+
+using Hermes::EigenSolver;
+using Hermes::RCP;
+using Hermes::rcp;
+
+// 1D matrices: 'd' on the diagonal, 'o' off the diagonal.
+static void entries_1d(double h, double &kd, double &ko, double &md, double &mo)
+{
+  kd = 2.0 / h;  ko = -1.0 / h;
+  md = 4.0 * h / 6.0;  mo = h / 6.0;
+}
+
+static double entry_1d(int i, int j, double d, double o)
+{
+  if (i == j) return d;
+  if (abs(i - j) == 1) return o;
+  return 0.0;
+}
+
+static void build_matrices(int n, CSCMatrix *K, CSCMatrix *M)
+{
+  // interior nodes of the grid
+  int m = n - 1, size = m * m;
+  double kd, ko, md, mo;
+  entries_1d(1.0 / n, kd, ko, md, mo);
+
+  K->prealloc(size);
+  M->prealloc(size);
+  for (int iy = 0; iy < m; iy++)
+    for (int ix = 0; ix < m; ix++)
+      for (int jy = std::max(iy - 1, 0); jy <= std::min(iy + 1, m - 1); jy++)
+        for (int jx = std::max(ix - 1, 0); jx <= std::min(ix + 1, m - 1); jx++) {
+          K->pre_add_ij(iy * m + ix, jy * m + jx);
+          M->pre_add_ij(iy * m + ix, jy * m + jx);
+        }
+  K->alloc();
+  M->alloc();
+  for (int iy = 0; iy < m; iy++)
+    for (int ix = 0; ix < m; ix++)
+      for (int jy = std::max(iy - 1, 0); jy <= std::min(iy + 1, m - 1); jy++)
+        for (int jx = std::max(ix - 1, 0); jx <= std::min(ix + 1, m - 1); jx++) {
+          int r = iy * m + ix, c = jy * m + jx;
+          K->add(r, c, entry_1d(ix, jx, kd, ko) * entry_1d(iy, jy, md, mo)
+                     + entry_1d(ix, jx, md, mo) * entry_1d(iy, jy, kd, ko));
+          M->add(r, c, entry_1d(ix, jx, md, mo) * entry_1d(iy, jy, md, mo));
+        }
+}
+
+// y = A * x
+static void multiply(CSCMatrix *A, double *x, double *y)
+{
+  int n = A->get_size();
+  for (int i = 0; i < n; i++) y[i] = 0.0;
+  for (int j = 0; j < n; j++)
+    for (int k = A->get_Ap()[j]; k < A->get_Ap()[j + 1]; k++)
+      y[A->get_Ai()[k]] += A->get_Ax()[k] * x[j];
+}
+
+struct CloserTo {
+  CloserTo(double target) : target(target) {}
+  bool operator()(double a, double b) const { return fabs(a - target) < fabs(b - target); }
+  double target;
+};
+
+int main(int argc, char *argv[]) {
+  if (argc < 5) error("Usage: test-eigensolver lanczos|lobpcg n n_eigs target");
+  int n = atoi(argv[2]), n_eigs = atoi(argv[3]);
+  double target = atof(argv[4]);
+  bool lobpcg = strcasecmp(argv[1], "lobpcg") == 0;
+
+  CSCMatrix *K = new CSCMatrix(), *M = new CSCMatrix();
+  build_matrices(n, K, M);
+  RCP<Matrix> matrix_K = rcp(K), matrix_M = rcp(M);
+  int size = K->get_size();
+
+  // exact eigenvalues
+  double h = 1.0 / n;
+  std::vector<double> lambda_1d(n - 1), exact;
+  for (int i = 1; i < n; i++)
+    lambda_1d[i - 1] = 6.0 / (h * h) * (1.0 - cos(i * M_PI * h)) / (2.0 + cos(i * M_PI * h));
+  for (int i = 0; i < n - 1; i++)
+    for (int j = 0; j < n - 1; j++)
+      exact.push_back(lambda_1d[i] + lambda_1d[j]);
+  if (lobpcg)
+    std::sort(exact.begin(), exact.end());
+  else
+    std::sort(exact.begin(), exact.end(), CloserTo(target));
+  exact.resize(n_eigs);
+  std::sort(exact.begin(), exact.end());
+
+  EigenSolver es(matrix_K, matrix_M, lobpcg ? Hermes::EIGEN_LOBPCG : Hermes::EIGEN_SHIFT_INVERT_LANCZOS);
+  TimePeriod timer;
+  es.solve(n_eigs, target, 1e-10, 500);
+  timer.tick();
+  info("%d unknowns, %d eigenvalues, %d iterations, %g s", size, es.get_n_eigs(),
+       es.get_num_iters(), timer.last());
+  if (es.get_n_eigs() != n_eigs) error("Wrong number of eigenvalues.");
+
+  int ret = ERR_SUCCESS;
+  std::vector<double> kx(size), mx(size);
+  for (int i = 0; i < n_eigs; i++) {
+    double lambda = es.get_eigenvalue(i);
+    double *x;
+    int len;
+    es.get_eigenvector(i, &x, &len);
+    if (len != size) error("Wrong size of the eigenvector.");
+
+    multiply(K, x, &kx[0]);
+    multiply(M, x, &mx[0]);
+    double res = 0.0, nkx = 0.0, xmx = 0.0;
+    for (int l = 0; l < size; l++) {
+      res += sqr(kx[l] - lambda * mx[l]);
+      nkx += sqr(kx[l]);
+      xmx += x[l] * mx[l];
+    }
+    res = sqrt(res / nkx);
+
+    printf("%3d: %.12f (exact %.12f), residual %g, x^T M x = %g\n", i, lambda, exact[i], res, xmx);
+    if (fabs(lambda - exact[i]) > 1e-8 * exact[i] || res > 1e-7 || fabs(xmx - 1.0) > 1e-8)
+      ret = ERR_FAILURE;
+  }
+
+  if (ret == ERR_SUCCESS)
+    printf("Success!\n");
+  else
+    printf("Failure!\n");
+  return ret;
+}
@@ -14,6 +14,8 @@
 #include "solver/amesos.h"
 #include "solver/aztecoo.h"
 #include "solver/mumps.h"
+#include "solver/mixed_precision.h"
+#include "solver/banded.h"
 
 #include <iostream>
 
@@ -303,6 +305,34 @@ void solve(Solver &solver, int n) {
   }
 }
 
+// Solves with the right-hand sides b and 2 b at once, prints the first solution and
+// checks that the second one is twice the first.
+void solve_multiple(Solver &solver, int n, std::map<unsigned int, scalar> &ar_rhs) {
+  scalar *block = new scalar[2 * n];
+  memset(block, 0, 2 * n * sizeof(scalar));
+  for (std::map<unsigned int, scalar>::iterator it = ar_rhs.begin(); it != ar_rhs.end(); it++) {
+    block[it->first] = it->second;
+    block[n + it->first] = 2.0 * it->second;
+  }
+  if (solver.solve_multiple_rhs(block, 2)) {
+    scalar *sln = solver.get_solution();
+    double max = 0.0, diff = 0.0;
+    for (int i = 0; i < n; i++) {
+      max = std::max(max, std::abs(sln[i]));
+      diff = std::max(diff, std::abs(sln[n + i] - 2.0 * sln[i]));
+    }
+    for (int i = 0; i < n; i++) {
+      printf(SCALAR_FMT"\n", SCALAR(sln[i]));
+    }
+    if (diff > 1e-8 * max)
+      printf("Inconsistent solutions.\n");
+  }
+  else {
+    printf("Unable to solve.\n");
+  }
+  delete [] block;
+}
+
 int main(int argc, char *argv[]) {
   int ret = ERR_SUCCESS;
 
@@ -369,6 +399,16 @@ int main(int argc, char *argv[]) {
 
     UMFPackLinearSolver solver(&mat, &rhs);
     solve(solver, n);
+#endif
+  }
+  else if (strcasecmp(argv[1], "umfpack-multi") == 0) {
+#ifdef WITH_UMFPACK
+    UMFPackMatrix mat;
+    UMFPackVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    UMFPackLinearSolver solver(&mat, &rhs);
+    solve_multiple(solver, n, ar_rhs);
 #endif
   }
   else if (strcasecmp(argv[1], "aztecoo") == 0) {
@@ -389,6 +429,16 @@ int main(int argc, char *argv[]) {
 
     AztecOOSolver solver(&mat, &rhs);
     solve(solver, n);
+#endif
+  }
+  else if (strcasecmp(argv[1], "aztecoo-multi") == 0) {
+#ifdef WITH_TRILINOS
+    EpetraMatrix mat;
+    EpetraVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    AztecOOSolver solver(&mat, &rhs);
+    solve_multiple(solver, n, ar_rhs);
 #endif
   }
   else if (strcasecmp(argv[1], "amesos") == 0) {
@@ -413,6 +463,18 @@ int main(int argc, char *argv[]) {
       AmesosSolver solver("Klu", &mat, &rhs);
       solve(solver, n);
     } 
+#endif
+  }
+  else if (strcasecmp(argv[1], "amesos-multi") == 0) {
+#ifdef WITH_TRILINOS
+    EpetraMatrix mat;
+    EpetraVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    if (AmesosSolver::is_available("Klu")) {
+      AmesosSolver solver("Klu", &mat, &rhs);
+      solve_multiple(solver, n, ar_rhs);
+    }
 #endif
   }
   else if (strcasecmp(argv[1], "mumps") == 0) {
@@ -435,6 +497,87 @@ int main(int argc, char *argv[]) {
     solve(solver, n);
 #endif
   }  
+  else if (strcasecmp(argv[1], "mumps-multi") == 0) {
+#ifdef WITH_MUMPS
+    MumpsMatrix mat;
+    MumpsVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    MumpsSolver solver(&mat, &rhs);
+    solve_multiple(solver, n, ar_rhs);
+#endif
+  }
+  else if (strcasecmp(argv[1], "mixed-precision") == 0) {
+    UMFPackMatrix mat;
+    UMFPackVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    MixedPrecisionLinearSolver solver(&mat, &rhs);
+    solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "mixed-precision-block") == 0) {
+    UMFPackMatrix mat;
+    UMFPackVector rhs;
+    build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    MixedPrecisionLinearSolver solver(&mat, &rhs);
+    solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "mixed-precision-multi") == 0) {
+    UMFPackMatrix mat;
+    UMFPackVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    MixedPrecisionLinearSolver solver(&mat, &rhs);
+    solve_multiple(solver, n, ar_rhs);
+  }
+  else if (strcasecmp(argv[1], "band") == 0) {
+    BandMatrix mat;
+    BandVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    BandLinearSolver solver(&mat, &rhs);
+    solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "band-block") == 0) {
+    BandMatrix mat;
+    BandVector rhs;
+    build_matrix_block(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    BandLinearSolver solver(&mat, &rhs);
+    solve(solver, n);
+  }
+  else if (strcasecmp(argv[1], "band-multi") == 0) {
+    BandMatrix mat;
+    BandVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    BandLinearSolver solver(&mat, &rhs);
+    solve_multiple(solver, n, ar_rhs);
+  }
+  else if (strcasecmp(argv[1], "band-refactor") == 0) {
+    // Solves the system from the second file with the same solver; its band has the same
+    // leading dimension as the first one, but different kl and ku.
+    if (argc < 4) error("Not enough parameters.");
+    BandMatrix mat;
+    BandVector rhs;
+    build_matrix(n, ar_mat, ar_rhs, &mat, &rhs);
+
+    BandLinearSolver solver(&mat, &rhs);
+    solve(solver, n);
+
+    std::map<unsigned int, MatrixEntry> ar_mat_2;
+    std::map<unsigned int, scalar> ar_rhs_2;
+    bool no_cplx_2_real = false;
+    if (read_matrix_and_rhs(argv[3], n, nnz, ar_mat_2, ar_rhs_2, no_cplx_2_real) != ERR_SUCCESS)
+      error("Failed to read the matrix and rhs.");
+    int ld = 2 * mat.get_kl() + mat.get_ku();
+    mat.free();
+    build_matrix(n, ar_mat_2, ar_rhs_2, &mat, &rhs);
+    if (2 * mat.get_kl() + mat.get_ku() != ld)
+      printf("The bands have different leading dimensions.\n");
+    solve(solver, n);
+  }
   else
     ret = ERR_FAILURE;
 
@@ -0,0 +1,187 @@
+#define HERMES_REPORT_WARN
+#define HERMES_REPORT_INFO
+
+#include "common.h"
+#include "config.h"
+
+#include "solver/mixed_precision.h"
+
+#include <vector>
+
+// Test of the mixed precision solver.
+// The matrices are tridiag(-1, d, -1) of size n (the 1D Laplacian for d = 2, its condition
+// number grows like n^2) and the right-hand sides are computed from a known solution. The
+// modes check the statistics the solver reports:
+//   refine    - a well-conditioned matrix is solved by the plain iterative refinement,
+//   gmres     - the plain refinement stagnates for an ill-conditioned matrix and GMRES-IR
+//               takes over, without GMRES the solver falls back to double precision,
+//   fallback  - a matrix that is singular in single precision is factorized in double,
+//   reuse     - HERMES_REUSE_FACTORIZATION_COMPLETELY with a changed matrix: the old factors
+//               need more refinement steps, the factors of a very different matrix are
+//               replaced by a double precision factorization,
+//   reorder   - HERMES_REUSE_MATRIX_REORDERING refactorizes the changed matrix, which takes
+//               the same steps as a new solver.
+
+static void build_matrix(int n, double d, CSCMatrix *A)
+{
+  A->prealloc(n);
+  for (int i = 0; i < n; i++)
+    for (int j = std::max(i - 1, 0); j <= std::min(i + 1, n - 1); j++)
+      A->pre_add_ij(i, j);
+  A->alloc();
+  for (int i = 0; i < n; i++)
+    for (int j = std::max(i - 1, 0); j <= std::min(i + 1, n - 1); j++)
+      A->add(i, j, i == j ? d : -1.0);
+  A->finish();
+}
+
+// Sets the right-hand side to A x for x_i = 1 + i / n.
+static void build_rhs(CSCMatrix *A, UMFPackVector *rhs, std::vector<double> &x)
+{
+  int n = A->get_size();
+  x.resize(n);
+  for (int i = 0; i < n; i++) x[i] = 1.0 + (double) i / n;
+  std::vector<double> b(n);
+  A->multiply_with_vector(&x[0], &b[0]);
+  rhs->alloc(n);
+  for (int i = 0; i < n; i++) rhs->set(i, b[i]);
+  rhs->finish();
+}
+
+// Solves the system, prints the statistics and checks the solution, the backward error
+// (compared with the one recomputed here) and the precision of the factorization.
+static bool solve(MixedPrecisionLinearSolver &solver, CSCMatrix *A, UMFPackVector *rhs,
+                  std::vector<double> &x, bool double_precision, const char *msg)
+{
+  bool ok = solver.solve();
+  int n = A->get_size();
+  double *sln = solver.get_solution();
+
+  std::vector<double> r(n);
+  A->multiply_with_vector(sln, &r[0]);
+  double rnorm = 0.0, anorm = 0.0, snorm = 0.0, bnorm = 0.0, err = 0.0, xnorm = 0.0;
+  for (int i = 0; i < n; i++) {
+    rnorm = std::max(rnorm, fabs(rhs->get(i) - r[i]));
+    snorm = std::max(snorm, fabs(sln[i]));
+    bnorm = std::max(bnorm, fabs(rhs->get(i)));
+    err = std::max(err, fabs(sln[i] - x[i]));
+    xnorm = std::max(xnorm, fabs(x[i]));
+    double row = 0.0;
+    for (int j = std::max(i - 1, 0); j <= std::min(i + 1, n - 1); j++) row += fabs(A->get(i, j));
+    anorm = std::max(anorm, row);
+  }
+  double omega = rnorm / (anorm * snorm + bnorm);
+  double tol = sqrt((double) n) * DBL_EPSILON;
+
+  printf("%s: %d refinement steps, %d GMRES iterations, backward error %g (%g), %s precision, "
+         "error %g\n", msg, solver.get_num_refinement_steps(), solver.get_num_gmres_iters(),
+         solver.get_backward_error(), omega, solver.is_double_precision() ? "double" : "single",
+         err / xnorm);
+
+  return ok && solver.get_backward_error() <= tol && omega <= 2.0 * tol &&
+         fabs(omega - solver.get_backward_error()) <= 0.5 * tol &&
+         solver.is_double_precision() == double_precision;
+}
+
+int main(int argc, char *argv[]) {
+  if (argc < 2) error("Usage: test-mixed-precision refine|gmres|fallback|reuse|reorder");
+
+  bool ok = true;
+  std::vector<double> x;
+  if (strcasecmp(argv[1], "refine") == 0) {
+    UMFPackMatrix A;
+    UMFPackVector rhs;
+    build_matrix(100, 3.0, &A);
+    build_rhs(&A, &rhs, x);
+
+    MixedPrecisionLinearSolver solver(&A, &rhs);
+    ok = solve(solver, &A, &rhs, x, false, "well-conditioned") &&
+         solver.get_num_refinement_steps() >= 1 && solver.get_num_refinement_steps() <= 3 &&
+         solver.get_num_gmres_iters() == 0;
+  }
+  else if (strcasecmp(argv[1], "gmres") == 0) {
+    UMFPackMatrix A;
+    UMFPackVector rhs;
+    build_matrix(20000, 2.0, &A);
+    build_rhs(&A, &rhs, x);
+
+    MixedPrecisionLinearSolver solver(&A, &rhs);
+    ok = solve(solver, &A, &rhs, x, false, "GMRES-IR") && solver.get_num_gmres_iters() > 0;
+
+    MixedPrecisionLinearSolver plain(&A, &rhs);
+    plain.set_max_gmres_iters(0);
+    ok = solve(plain, &A, &rhs, x, true, "without GMRES") && ok &&
+         plain.get_num_gmres_iters() == 0;
+  }
+  else if (strcasecmp(argv[1], "fallback") == 0) {
+    // the last pivot 1e-10 is lost in single precision
+    UMFPackMatrix A;
+    UMFPackVector rhs;
+    A.prealloc(2);
+    for (int i = 0; i < 2; i++)
+      for (int j = 0; j < 2; j++)
+        A.pre_add_ij(i, j);
+    A.alloc();
+    A.add(0, 0, 1.0);
+    A.add(0, 1, 1.0);
+    A.add(1, 0, 1.0);
+    A.add(1, 1, 1.0 + 1e-10);
+    A.finish();
+    build_rhs(&A, &rhs, x);
+
+    MixedPrecisionLinearSolver solver(&A, &rhs);
+    ok = solve(solver, &A, &rhs, x, true, "singular in single precision");
+  }
+  else if (strcasecmp(argv[1], "reuse") == 0) {
+    UMFPackMatrix A;
+    UMFPackVector rhs;
+    build_matrix(100, 3.0, &A);
+    build_rhs(&A, &rhs, x);
+
+    MixedPrecisionLinearSolver solver(&A, &rhs);
+    ok = solve(solver, &A, &rhs, x, false, "initial");
+    int initial_steps = solver.get_num_refinement_steps();
+
+    // a slightly different matrix, the refinement corrects for the difference
+    static_cast<Solver &>(solver).set_factorization_scheme(HERMES_REUSE_FACTORIZATION_COMPLETELY);
+    for (int i = 0; i < 100; i++) A.add(i, i, 0.01);
+    build_rhs(&A, &rhs, x);
+    ok = solve(solver, &A, &rhs, x, false, "changed matrix, reused factors") && ok &&
+         solver.get_num_refinement_steps() > initial_steps;
+
+    // a very different one, the refinement diverges and the matrix is factorized again
+    for (int i = 0; i < 100; i++) A.add(i, i, -2.5);
+    build_rhs(&A, &rhs, x);
+    ok = solve(solver, &A, &rhs, x, true, "very different matrix") && ok;
+  }
+  else if (strcasecmp(argv[1], "reorder") == 0) {
+    UMFPackMatrix A;
+    UMFPackVector rhs;
+    build_matrix(100, 3.0, &A);
+    build_rhs(&A, &rhs, x);
+
+    MixedPrecisionLinearSolver solver(&A, &rhs);
+    ok = solve(solver, &A, &rhs, x, false, "initial");
+
+    static_cast<Solver &>(solver).set_factorization_scheme(HERMES_REUSE_MATRIX_REORDERING);
+    for (int i = 0; i < 100; i++) A.add(i, i, -0.9);
+    build_rhs(&A, &rhs, x);
+    ok = solve(solver, &A, &rhs, x, false, "changed matrix, reused ordering") && ok;
+
+    MixedPrecisionLinearSolver fresh(&A, &rhs);
+    ok = solve(fresh, &A, &rhs, x, false, "changed matrix, new solver") && ok &&
+         solver.get_num_refinement_steps() == fresh.get_num_refinement_steps() &&
+         solver.get_backward_error() == fresh.get_backward_error();
+  }
+  else
+    error("Unknown mode '%s'.", argv[1]);
+
+  if (ok) {
+    printf("Success!\n");
+    return ERR_SUCCESS;
+  }
+  else {
+    printf("Failure!\n");
+    return ERR_FAILURE;
+  }
+}
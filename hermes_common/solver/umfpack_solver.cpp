@@ -506,6 +506,8 @@ bool UMFPackVector::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt
   #define umfpack_symbolic(m, n, Ap, Ai, Ax, S, C, I)   umfpack_di_symbolic(m, n, Ap, Ai, Ax, S, C, I)
   #define umfpack_numeric(Ap, Ai, Ax, S, N, C, I)       umfpack_di_numeric(Ap, Ai, Ax, S, N, C, I)
   #define umfpack_solve(sys, Ap, Ai, Ax, X, B, N, C, I) umfpack_di_solve(sys, Ap, Ai, Ax, X, B, N, C, I)
+  #define umfpack_wsolve(sys, Ap, Ai, Ax, X, B, N, C, I, Wi, W) umfpack_di_wsolve(sys, Ap, Ai, Ax, X, B, N, C, I, Wi, W)
+  #define UMFPACK_WSOLVE_WORKSPACE                      5   // size of W (times n) with iterative refinement
   #define umfpack_free_symbolic                         umfpack_di_free_symbolic
   #define umfpack_free_numeric                          umfpack_di_free_numeric
   #define umfpack_defaults                              umfpack_di_defaults
@@ -514,6 +516,8 @@ bool UMFPackVector::dump(FILE *file, const char *var_name, EMatrixDumpFormat fmt
   #define umfpack_symbolic(m, n, Ap, Ai, Ax, S, C, I)   umfpack_zi_symbolic(m, n, Ap, Ai, (double *) (Ax), NULL, S, C, I)
   #define umfpack_numeric(Ap, Ai, Ax, S, N, C, I)       umfpack_zi_numeric(Ap, Ai, (double *) (Ax), NULL, S, N, C, I)
   #define umfpack_solve(sys, Ap, Ai, Ax, X, B, N, C, I) umfpack_zi_solve(sys, Ap, Ai, (double *) (Ax), NULL, (double *) (X), NULL, (double *) (B), NULL, N, C, I)
+  #define umfpack_wsolve(sys, Ap, Ai, Ax, X, B, N, C, I, Wi, W) umfpack_zi_wsolve(sys, Ap, Ai, (double *) (Ax), NULL, (double *) (X), NULL, (double *) (B), NULL, N, C, I, Wi, W)
+  #define UMFPACK_WSOLVE_WORKSPACE                      10
   #define umfpack_free_symbolic                         umfpack_di_free_symbolic
   #define umfpack_free_numeric                          umfpack_zi_free_numeric
   #define umfpack_defaults                              umfpack_zi_defaults
@@ -597,6 +601,55 @@ bool UMFPackLinearSolver::solve() {
 #endif
 }
 
+bool UMFPackLinearSolver::solve_multiple_rhs(scalar *rhs_block, int num_rhs) {
+  _F_
+#ifdef WITH_UMFPACK
+  assert(m != NULL);
+  assert(rhs_block != NULL);
+
+  TimePeriod tmr;
+
+  int status;
+
+  if ( !setup_factorization() )
+  {
+    warning("LU factorization could not be completed.");
+    return false;
+  }
+
+  int n = m->size;
+  if(sln)
+    delete [] sln;
+  sln = new scalar[n * num_rhs];
+  MEM_CHECK(sln);
+  memset(sln, 0, n * num_rhs * sizeof(scalar));
+
+  // UMFPACK solves for one right-hand side at a time, but the workspace is allocated
+  // only once for all of them.
+  int *Wi = new int[n];
+  double *W = new double[UMFPACK_WSOLVE_WORKSPACE * n];
+  MEM_CHECK(Wi);
+  MEM_CHECK(W);
+  bool ret = true;
+  for (int k = 0; k < num_rhs && ret; k++) {
+    status = umfpack_wsolve(UMFPACK_A, m->Ap, m->Ai, m->Ax, sln + k * n, rhs_block + k * n, numeric, NULL, NULL, Wi, W);
+    if (status != UMFPACK_OK) {
+      check_status("umfpack_di_wsolve", status);
+      ret = false;
+    }
+  }
+  delete [] Wi;
+  delete [] W;
+
+  tmr.tick();
+  time = tmr.accumulated();
+
+  return ret;
+#else
+  return false;
+#endif
+}
+
 bool UMFPackLinearSolver::setup_factorization()
 {
   _F_
@@ -127,6 +127,7 @@ public:
   virtual ~UMFPackLinearSolver();
 
   virtual bool solve();
+  virtual bool solve_multiple_rhs(scalar *rhs_block, int num_rhs);
     
 protected:
   UMFPackMatrix *m;